@@ -8,7 +8,9 @@
  *
  */
 
+#include <cmath>
 #include <iostream>
+#include <sstream>
 
 #include <giomm.h>  // Not <gtkmm.h>! To eventually allow a headless version!
 #include <glibmm/i18n.h>
@@ -24,7 +26,13 @@
 #include "path-prefix.h"          // Extension directory
 #include "selection.h"            // Selection
 #include "object/sp-root.h"       // query_all()
+#include "object/sp-image.h"      // query_render_stats()
+#include "display/drawing.h"
+#include "display/drawing-context.h"
+#include "display/cairo-utils.h"
+#include "util/scope_exit.h"
 #include "file.h"                 // dpi convert method
+#include "preferences.h"
 #include "io/resource.h"
 
 void
@@ -160,6 +168,62 @@ query_all(InkscapeApplication* app)
     }
 }
 
+// Render the document offscreen as the canvas would, with the canvas's cache budget, and print
+// the render counters of every drawing item as JSON. The document is rendered twice, so that the
+// second render shows how well the cache works.
+void
+query_render_stats(InkscapeApplication* app)
+{
+    SPDocument* document = app->get_active_document();
+    if (!document) {
+        show_output("query_render_stats: no document!");
+        return;
+    }
+
+    document->ensureUpToDate();
+    sp_image_wait_for_decoding(document);
+    document->ensureUpToDate();
+
+    auto const area = document->preferredBounds();
+    if (!area || area->hasZeroArea()) {
+        show_output("query_render_stats: empty document!");
+        return;
+    }
+    auto const final_area = Geom::IntRect::from_xywh(0, 0, std::ceil(area->width()), std::ceil(area->height()));
+
+    unsigned dkey = SPItem::display_key_new(1);
+    Inkscape::Drawing drawing;
+    drawing.setRoot(document->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+    auto invoke_hide_guard = scope_exit([&] { document->getRoot()->invoke_hide(dkey); });
+    drawing.root()->setTransform(Geom::Translate(-area->min()));
+
+    auto prefs = Inkscape::Preferences::get();
+    drawing.setCacheBudget((size_t{1} << 20) * prefs->getIntLimited("/options/renderingcache/size", 64, 0, 4096));
+    drawing.setCacheLimit(final_area);
+    drawing.setRecordStats(true);
+    drawing.update(final_area);
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, final_area.width(), final_area.height());
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        show_output("query_render_stats: not enough memory!");
+        cairo_surface_destroy(surface);
+        return;
+    }
+    // The first rendering fills the caches; count only the second, as the canvas would redraw.
+    for (int i = 0; i < 2; i++) {
+        if (i == 1) {
+            drawing.resetStats();
+        }
+        Inkscape::DrawingContext dc(surface, Geom::Point(0, 0));
+        drawing.render(dc, final_area);
+    }
+    cairo_surface_destroy(surface);
+
+    std::ostringstream out;
+    drawing.writeStats(out);
+    show_output(out.str(), false);
+}
+
 void
 pdf_page(int page)
 {
@@ -219,7 +283,8 @@ std::vector<std::vector<Glib::ustring>> raw_data_base =
     {"app.query-y",                   N_("Query Y"),                 "Query",      N_("Query 'y' value(s) of selected objects")            },
     {"app.query-width",               N_("Query Width"),             "Query",      N_("Query 'width' value(s) of object(s)")               },
     {"app.query-height",              N_("Query Height"),            "Query",      N_("Query 'height' value(s) of object(s)")              },
-    {"app.query-all",                 N_("Query All"),               "Query",      N_("Query 'x', 'y', 'width', and 'height'")             }
+    {"app.query-all",                 N_("Query All"),               "Query",      N_("Query 'x', 'y', 'width', and 'height'")             },
+    {"app.query-render-stats",        N_("Query Render Statistics"), "Query",      N_("Print render counts, cache hits and render times of all objects as JSON")}
     // clang-format on
 };
 
@@ -250,6 +315,7 @@ add_actions_base(InkscapeApplication* app)
     gapp->add_action(               "query-width",        sigc::bind(sigc::ptr_fun(&query_width),               app)        );
     gapp->add_action(               "query-height",       sigc::bind(sigc::ptr_fun(&query_height),              app)        );
     gapp->add_action(               "query-all",          sigc::bind(sigc::ptr_fun(&query_all),                 app)        );
+    gapp->add_action(               "query-render-stats", sigc::bind(sigc::ptr_fun(&query_render_stats),        app)        );
     // clang-format on
 
     // Revision string is going to be added to the actions interface so it can be queried for existance by GApplication
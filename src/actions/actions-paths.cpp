@@ -9,18 +9,27 @@
  */
 
 #include <iostream>
+#include <map>
+#include <set>
 
 #include <giomm.h>  // Not <gtkmm.h>! To eventually allow a headless version!
 #include <glibmm/i18n.h>
 
 #include "actions-paths.h"
+#include "actions-helper.h"
 #include "actions-tools.h"
+#include "document.h"
 #include "document-undo.h"
 #include "inkscape-application.h"
 #include "inkscape-window.h"
 #include "selection.h"            // Selection
 #include "selection-chemistry.h"  // SelectionHelper
+#include "object/sp-path.h"
+#include "path/path-boolop.h"
 #include "path/path-offset.h"
+#include "path/path-util.h"
+#include "style.h"
+#include "svg/svg.h"
 #include "ui/icon-names.h"
 #include "ui/tools/booleans-builder.h"
 
@@ -212,6 +221,110 @@ select_path_reverse(InkscapeWindow* win)
     Inkscape::SelectionHelper::reverse(dt);
 }
 
+/*
+ * Run a batch of boolean operations given as "op:target,operand,...|op:...", where op is union,
+ * difference, intersection or exclusion. Each operation replaces the path with id target by the
+ * result of combining it with the objects with the given ids, which are left unchanged.
+ *
+ * All the operations run on geometry in memory, those independent of each other in parallel, and
+ * the targets are written back to the document once at the end, as a single undo step.
+ */
+void
+path_boolean_batch(Glib::VariantBase const &value, InkscapeApplication *app)
+{
+    auto const argument = Glib::VariantBase::cast_dynamic<Glib::Variant<Glib::ustring>>(value).get();
+
+    SPDocument *document = nullptr;
+    Inkscape::Selection *selection = nullptr;
+    if (!get_document_and_selection(app, &document, &selection)) {
+        return;
+    }
+
+    static std::map<Glib::ustring, BooleanOp> const ops = {
+        {"union",        bool_op_union},
+        {"difference",   bool_op_diff},
+        {"intersection", bool_op_inters},
+        {"exclusion",    bool_op_symdiff},
+    };
+
+    // Number the objects in order of appearance.
+    std::vector<SPItem *> items;
+    std::map<SPItem *, int> index_of_item;
+    auto const index_of = [&] (Glib::ustring const &id) {
+        auto item = cast<SPItem>(document->getObjectById(id.raw()));
+        if (!item) {
+            show_output("action:path_boolean_batch: no object with id: " + id);
+            return -1;
+        }
+        auto [it, inserted] = index_of_item.emplace(item, items.size());
+        if (inserted) {
+            items.push_back(item);
+        }
+        return it->second;
+    };
+
+    std::vector<BoolOpBatchStep> steps;
+    for (auto const &token : Glib::Regex::split_simple("\\s*\\|\\s*", argument)) {
+        if (token.empty()) {
+            continue;
+        }
+        auto const colon_position = token.find(':');
+        auto const op = ops.find(token.substr(0, colon_position));
+        auto const ids = colon_position == Glib::ustring::npos ? std::vector<Glib::ustring>()
+                                                                : Glib::Regex::split_simple("\\s*,\\s*", token.substr(colon_position + 1));
+        if (op == ops.end() || ids.size() < 2) {
+            show_output("action:path_boolean_batch: requires 'operation:target,operand,...', got: " + token);
+            return;
+        }
+
+        BoolOpBatchStep step{op->second, index_of(ids.front()), {}};
+        if (step.target < 0) {
+            return;
+        }
+        if (!is<SPPath>(items[step.target])) {
+            show_output("action:path_boolean_batch: target is not a path: " + ids.front());
+            return;
+        }
+        for (auto it = ids.begin() + 1; it != ids.end(); ++it) {
+            auto const i = index_of(*it);
+            if (i < 0) {
+                return;
+            }
+            step.operands.push_back(i);
+        }
+        steps.push_back(std::move(step));
+    }
+
+    if (steps.empty()) {
+        show_output("action:path_boolean_batch: no operations given");
+        return;
+    }
+
+    // Read the geometry of all objects in document coordinates.
+    std::vector<Geom::PathVector> pathvs(items.size());
+    std::vector<FillRule> fill_rules(items.size());
+    for (std::size_t i = 0; i < items.size(); i++) {
+        if (auto curve = curve_for_item(items[i])) {
+            pathvs[i] = curve->get_pathvector() * items[i]->i2doc_affine();
+        }
+        fill_rules[i] = items[i]->style->fill_rule.computed == SP_WIND_RULE_EVENODD ? fill_oddEven : fill_nonZero;
+    }
+
+    auto const results = sp_pathvector_boolop_batch(std::move(pathvs), std::move(fill_rules), steps);
+
+    // Write each target once.
+    std::set<int> targets;
+    for (auto const &step : steps) {
+        targets.insert(step.target);
+    }
+    for (auto i : targets) {
+        auto const pathv = results[i] * items[i]->i2doc_affine().inverse();
+        items[i]->setAttribute("d", sp_svg_write_path(pathv));
+    }
+
+    Inkscape::DocumentUndo::done(document, "Boolean operations", INKSCAPE_ICON("path-union"));
+}
+
 void
 shape_builder_mode(int value, InkscapeWindow* win)
 {
@@ -254,6 +367,7 @@ static const std::vector<std::vector<Glib::ustring>> raw_data_path =
     {"app.path-flatten",             NC_("Path flatten", "Flatten"), "Path", N_("Flatten one or more overlapping objects into their visible parts")},
     {"app.path-fill-between-paths",  N_("Fill between paths"),   "Path",   N_("Create a fill object using the selected paths")},
     {"app.path-simplify",            N_("Simplify"),             "Path",   N_("Simplify selected paths (remove extra nodes)")},
+    {"app.path-boolean-batch",       N_("Boolean Operations"),   "Path",   N_("Run boolean operations given as 'op:target,operand,...|...' (op: union, difference, intersection, exclusion) on paths by id")},
 
     {"win.path-inset",               N_("Inset"),                "Path",   N_("Inset selected paths")},
     {"win.path-offset",              N_("Offset"),               "Path",   N_("Offset selected paths")},
@@ -272,6 +386,8 @@ static const std::vector<std::vector<Glib::ustring>> raw_data_path =
 
 void add_actions_path(InkscapeApplication *app)
 {
+    auto const String = Glib::VariantType(Glib::VARIANT_TYPE_STRING);
+
     auto *gapp = app->gio_app();
 
     // clang-format off
@@ -288,6 +404,7 @@ void add_actions_path(InkscapeApplication *app)
     gapp->add_action(               "path-flatten",            sigc::bind(sigc::ptr_fun(&select_path_flatten) ,      app));
     gapp->add_action(               "path-fill-between-paths", sigc::bind(sigc::ptr_fun(&fill_between_paths),        app));
     gapp->add_action(               "path-simplify",           sigc::bind(sigc::ptr_fun(&select_path_simplify),      app));
+    gapp->add_action_with_parameter("path-boolean-batch", String, sigc::bind(sigc::ptr_fun(&path_boolean_batch),   app));
     // clang-format on
 
     app->get_action_extra_data().add_data(raw_data_path);
@@ -124,7 +124,7 @@ public:
     Dest(Dest const &) = delete;
     Dest &operator=(Dest const &) = delete;
     Dest(Dest &&) = default;
-    Dest &operator=(Dest &&) = default;
+    Dest &operator=(Dest &&other) { if (this != &other) { close(); shared = std::move(other.shared); } return *this; }
     ~Dest() { close(); }
 
     /**
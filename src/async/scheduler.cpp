@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "scheduler.h"
+
+#include <utility>
+#include <glib.h>
+
+#include "util/statics.h"
+
+namespace {
+
+// The scheduler and index of the worker running on this thread, if any.
+thread_local Inkscape::Async::Scheduler const *current_scheduler = nullptr;
+thread_local int current_worker = -1;
+
+int default_concurrency()
+{
+    auto const n = std::thread::hardware_concurrency();
+    return n == 0 ? 4 : n; // Sensible fallback if not reported.
+}
+
+} // namespace
+
+namespace Inkscape {
+namespace Async {
+
+Scheduler &Scheduler::get()
+{
+    // Using Static<Scheduler> to join the worker threads before main() exits.
+    static Util::Static<Scheduler> instance;
+    return instance.get();
+}
+
+Scheduler::Scheduler()
+    : _limit(default_concurrency())
+{
+}
+
+Scheduler::~Scheduler()
+{
+    {
+        auto lock = std::lock_guard(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+
+    for (int i = 0; i < _started.load(); ++i) {
+        _workers[i]->thread.join();
+    }
+}
+
+void Scheduler::setConcurrency(int n)
+{
+    _limit.store(std::clamp(n, 1, MAX_WORKERS), std::memory_order_relaxed);
+    {
+        auto lock = std::lock_guard(_mutex);
+        _generation.fetch_add(1);
+    }
+    // Wake up parked workers, if the limit was raised.
+    _cond.notify_all();
+}
+
+void Scheduler::post(std::function<void ()> task)
+{
+    _push({std::move(task), nullptr});
+}
+
+void Scheduler::_push(Task task)
+{
+    _ensureWorkers();
+    _queued.fetch_add(1);
+
+    if (current_scheduler == this && task.group) {
+        // Work spawned by a worker stays with it, unless stolen.
+        auto &worker = *_workers[current_worker];
+        auto lock = std::lock_guard(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    } else {
+        auto lock = std::lock_guard(_mutex);
+        _injected.push_back(std::move(task));
+    }
+
+    {
+        auto lock = std::lock_guard(_mutex);
+        _generation.fetch_add(1);
+    }
+    if (_started.load(std::memory_order_acquire) > _limit.load(std::memory_order_relaxed)) {
+        // A single wakeup could go to a worker above the limit, which would ignore it.
+        _cond.notify_all();
+    } else {
+        _cond.notify_one();
+    }
+}
+
+void Scheduler::_ensureWorkers()
+{
+    if (_started.load(std::memory_order_acquire) >= _limit.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    auto lock = std::lock_guard(_mutex);
+    for (int i = _started.load(); i < _limit.load() && !_stop; ++i) {
+        _workers[i] = std::make_unique<Worker>();
+        _workers[i]->thread = std::thread([this, i] { _workerLoop(i); });
+        _started.store(i + 1, std::memory_order_release);
+    }
+}
+
+bool Scheduler::_popTask(int self, Task &task)
+{
+    // Newest task of our own queue first.
+    if (self >= 0) {
+        auto &worker = *_workers[self];
+        auto lock = std::lock_guard(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then tasks posted from outside.
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (!_injected.empty()) {
+            task = std::move(_injected.front());
+            _injected.pop_front();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another worker, which is likely to be the largest.
+    int const started = _started.load(std::memory_order_acquire);
+    for (int i = 1; i < started; ++i) {
+        auto &victim = *_workers[(self + i) % started];
+        auto lock = std::lock_guard(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Scheduler::_popGroupTask(TaskGroup const *group, Task &task)
+{
+    auto take = [&] (std::deque<Task> &tasks, bool newest_first) {
+        auto const matches = [=] (Task const &t) { return t.group == group; };
+        if (newest_first) {
+            auto it = std::find_if(tasks.rbegin(), tasks.rend(), matches);
+            if (it == tasks.rend()) {
+                return false;
+            }
+            task = std::move(*it);
+            tasks.erase(std::next(it).base());
+        } else {
+            auto it = std::find_if(tasks.begin(), tasks.end(), matches);
+            if (it == tasks.end()) {
+                return false;
+            }
+            task = std::move(*it);
+            tasks.erase(it);
+        }
+        _queued.fetch_sub(1);
+        return true;
+    };
+
+    int const self = current_scheduler == this ? current_worker : -1;
+    if (self >= 0) {
+        auto &worker = *_workers[self];
+        auto lock = std::lock_guard(worker.mutex);
+        if (take(worker.tasks, true)) {
+            return true;
+        }
+    }
+
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (take(_injected, false)) {
+            return true;
+        }
+    }
+
+    int const started = _started.load(std::memory_order_acquire);
+    for (int i = 0; i < started; ++i) {
+        if (i == self) {
+            continue;
+        }
+        auto &victim = *_workers[i];
+        auto lock = std::lock_guard(victim.mutex);
+        if (take(victim.tasks, false)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Scheduler::_execute(Task &task)
+{
+    std::exception_ptr error;
+    if (!task.group || !task.group->is_cancelled()) {
+        try {
+            task.run();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    // Release whatever the task holds before its group can be considered finished.
+    task.run = nullptr;
+
+    if (task.group) {
+        task.group->_finished(error);
+    } else if (error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (std::exception const &e) {
+            g_warning("Uncaught exception in background task: %s", e.what());
+        } catch (...) {
+            g_warning("Uncaught exception in background task");
+        }
+    }
+}
+
+void Scheduler::_workerLoop(int index)
+{
+    current_scheduler = this;
+    current_worker = index;
+
+    Task task;
+    while (true) {
+        // Read before looking for work, so that any task pushed after a failed look is noticed.
+        auto const seen = _generation.load();
+        if (index < _limit.load(std::memory_order_relaxed) && _popTask(index, task)) {
+            _execute(task);
+            continue;
+        }
+
+        // Sleep even if _queued is non-zero, as another worker may just have taken the task.
+        auto lock = std::unique_lock(_mutex);
+        _cond.wait(lock, [&] {
+            return _stop || (index < _limit.load(std::memory_order_relaxed) && _generation.load() != seen);
+        });
+        if (_stop) {
+            break;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(Scheduler &scheduler)
+    : _scheduler(scheduler)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try {
+        wait();
+    } catch (...) {
+        // Exceptions are only reported to an explicit wait().
+    }
+}
+
+void TaskGroup::run(std::function<void ()> task)
+{
+    {
+        auto lock = std::lock_guard(_mutex);
+        _pending++;
+    }
+    _scheduler._push({std::move(task), this});
+}
+
+void TaskGroup::wait()
+{
+    Scheduler::Task task;
+    while (true) {
+        {
+            auto lock = std::lock_guard(_mutex);
+            if (_pending == 0) {
+                break;
+            }
+        }
+
+        // Rather than blocking, run our own queued tasks.
+        if (_scheduler._popGroupTask(this, task)) {
+            _scheduler._execute(task);
+            continue;
+        }
+
+        // All remaining tasks are running on other threads.
+        auto lock = std::unique_lock(_mutex);
+        _cond.wait(lock, [this] { return _pending == 0; });
+    }
+
+    std::exception_ptr error;
+    {
+        auto lock = std::lock_guard(_mutex);
+        error = std::exchange(_error, nullptr);
+        _cancelled.store(false, std::memory_order_relaxed);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::_finished(std::exception_ptr error)
+{
+    auto lock = std::lock_guard(_mutex);
+    if (error && !_error) {
+        _error = std::move(error);
+    }
+    if (--_pending == 0) {
+        // Notify under the lock, as the waiter may destroy the group as soon as it is released.
+        _cond.notify_all();
+    }
+}
+
+} // namespace Async
+} // namespace Inkscape
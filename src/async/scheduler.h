@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** \file Scheduler
+ * Process-wide work-stealing task scheduler.
+ *
+ * All parallel rendering work (canvas tiles, filter primitives, export) is submitted to a single
+ * pool of worker threads, so that nested parallelism, such as a blur inside a canvas tile, does
+ * not oversubscribe the CPU with several independent thread pools.
+ */
+#ifndef INKSCAPE_ASYNC_SCHEDULER_H
+#define INKSCAPE_ASYNC_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Inkscape {
+namespace Async {
+
+class TaskGroup;
+
+/**
+ * A pool of worker threads, each with its own queue of tasks.
+ *
+ * Tasks spawned by a worker go to the back of its own queue and are run last-in first-out, which
+ * keeps nested work close to the data it was spawned from. Idle workers steal from the front of
+ * the other queues. Tasks posted from outside the pool go to a shared queue.
+ *
+ * A thread waiting for a TaskGroup runs the queued tasks of that group itself rather than
+ * blocking, which makes nested parallel loops safe however many workers are busy.
+ */
+class Scheduler
+{
+public:
+    /// The process-wide scheduler. Must first be called from the main thread.
+    static Scheduler &get();
+
+    Scheduler();
+    ~Scheduler();
+    Scheduler(Scheduler const &) = delete;
+    Scheduler &operator=(Scheduler const &) = delete;
+
+    /// Number of worker threads that run tasks.
+    int concurrency() const { return _limit.load(std::memory_order_relaxed); }
+
+    /// Change the number of worker threads. Threads are started on demand.
+    void setConcurrency(int n);
+
+    /// Run a task in the background, without waiting for it.
+    void post(std::function<void ()> task);
+
+    /**
+     * Call f(first, last) on disjoint subranges covering [begin, end), in parallel, and wait
+     * for all of them. Subranges have at least min_size elements, except possibly the last one.
+     * The calling thread takes part in the work. Exceptions are propagated to the caller.
+     */
+    template <typename F>
+    void parallel_for_ranges(int begin, int end, F &&f, int min_size = 1);
+
+    /// Call f(i) for every i in [begin, end), in parallel, and wait for all of them.
+    template <typename F>
+    void parallel_for(int begin, int end, F &&f, int min_size = 1)
+    {
+        parallel_for_ranges(begin, end, [&f] (int first, int last) {
+            for (int i = first; i < last; ++i) {
+                f(i);
+            }
+        }, min_size);
+    }
+
+private:
+    struct Task
+    {
+        std::function<void ()> run;
+        TaskGroup *group;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void _push(Task task);
+    bool _popGroupTask(TaskGroup const *group, Task &task);
+    bool _popTask(int self, Task &task);
+    void _execute(Task &task);
+    void _ensureWorkers();
+    void _workerLoop(int index);
+
+    static constexpr int MAX_WORKERS = 256;
+
+    std::atomic<int> _limit;             ///< Number of workers allowed to run tasks.
+    std::atomic<int> _started = 0;       ///< Number of worker threads created so far.
+    std::atomic<int> _queued = 0;        ///< Number of tasks in all queues.
+    std::atomic<unsigned> _generation = 0; ///< Bumped under _mutex whenever there may be new work.
+    std::unique_ptr<Worker> _workers[MAX_WORKERS];
+
+    std::mutex _mutex;                   ///< Protects _injected, _stop and worker creation.
+    std::condition_variable _cond;       ///< Wakes up idle workers.
+    std::deque<Task> _injected;          ///< Tasks posted from outside the pool.
+    bool _stop = false;
+
+    friend class TaskGroup;
+};
+
+/**
+ * A set of tasks that can be waited for and cancelled together.
+ *
+ * Cancelling a group skips its tasks that have not started yet; running tasks can poll
+ * is_cancelled() to stop early. The group must be waited for before it is destroyed, which
+ * the destructor does if necessary.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(Scheduler &scheduler = Scheduler::get());
+    ~TaskGroup();
+    TaskGroup(TaskGroup const &) = delete;
+    TaskGroup &operator=(TaskGroup const &) = delete;
+
+    /// Queue a task. From a worker thread, it goes to the worker's own queue.
+    void run(std::function<void ()> task);
+
+    /// Wait for all tasks of the group, running queued ones on this thread. Rethrows the first
+    /// exception thrown by a task. Afterwards the group can be reused, and is no longer cancelled.
+    void wait();
+
+    void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+    bool is_cancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+private:
+    void _finished(std::exception_ptr error);
+
+    Scheduler &_scheduler;
+    std::atomic<bool> _cancelled = false;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    int _pending = 0;                    ///< Tasks not yet finished, protected by _mutex.
+    std::exception_ptr _error;           ///< First exception thrown by a task, protected by _mutex.
+
+    friend class Scheduler;
+};
+
+template <typename F>
+void Scheduler::parallel_for_ranges(int begin, int end, F &&f, int min_size)
+{
+    int const count = end - begin;
+    if (count <= 0) {
+        return;
+    }
+
+    // A few chunks per worker, so that stealing can even out chunks of uneven cost.
+    int const chunks = std::clamp(count / std::max(min_size, 1), 1, 4 * concurrency());
+    if (chunks == 1) {
+        f(begin, end);
+        return;
+    }
+
+    auto bound = [=] (int chunk) { return begin + static_cast<int>(static_cast<long long>(count) * chunk / chunks); };
+
+    TaskGroup group(*this);
+    for (int chunk = chunks - 1; chunk > 0; --chunk) {
+        group.run([&f, first = bound(chunk), last = bound(chunk + 1)] { f(first, last); });
+    }
+
+    std::exception_ptr error;
+    try {
+        f(begin, bound(1));
+    } catch (...) {
+        error = std::current_exception();
+        group.cancel();
+    }
+    group.wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace Async
+} // namespace Inkscape
+
+#endif // INKSCAPE_ASYNC_SCHEDULER_H
@@ -10,11 +10,14 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include <glib/gstdio.h>
 #include <glibmm/i18n.h> // Internationalization
 
 #include "auto-save.h"
@@ -22,7 +25,8 @@
 #include "inkscape-application.h"
 #include "preferences.h"
 
-#include "extension/output.h"
+#include "async/async.h"
+#include "inkgc/gc-core.h"
 #include "io/sys.h"
 #include "xml/repr.h"
 
@@ -62,6 +66,72 @@ AutoSave::start()
     }
 }
 
+namespace {
+
+/// A document to autosave, copied on the main thread.
+struct AutoSaveJob
+{
+    SPDocument *document; ///< Only to identify the document when reporting back.
+    std::string path;
+    Inkscape::XML::Document *snapshot;
+};
+
+double milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Make room for new_files more autosaves, deleting the oldest beyond autosave_max.
+ */
+void prune_autosaves(std::string const &autosave_dir, std::string const &base_name, int autosave_max, int new_files)
+{
+    // Open directory
+    Glib::Dir directory(autosave_dir);
+    std::vector<std::string> file_names(directory.begin(), directory.end());
+
+    // Sort them so that oldest are last (file name encodes time).
+    std::sort(file_names.begin(), file_names.end(), std::greater<std::string>());
+
+    // Delete oldest files.
+    int count = 0;
+    for (auto &file_name : file_names) {
+        if (file_name.compare(0, base_name.size(), base_name) == 0) {
+            ++count;
+            if (count > autosave_max - new_files) {
+                std::string path = Glib::build_filename(autosave_dir, file_name);
+                if (unlink(path.c_str()) == -1) {
+                    std::cerr << "InkscapeApplication::document_autosave: Failed to unlink file: "
+                              << path << ": " << strerror(errno) << std::endl;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Write a document to a temporary file next to path, then rename it, so that path never holds a
+ * partially written document.
+ */
+bool write_autosave(AutoSaveJob const &job, SPReprSaveOptions const &options, bool compress)
+{
+    std::string const temp_path = job.path + ".tmp";
+
+    FILE *file = Inkscape::IO::fopen_utf8name(temp_path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    sp_repr_save_stream(job.snapshot, file, options, SP_SVG_NS_URI, compress);
+    bool const written = !ferror(file);
+    if (fclose(file) != 0 || !written || g_rename(temp_path.c_str(), job.path.c_str()) != 0) {
+        g_unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
 bool
 AutoSave::save()
 {
@@ -71,22 +141,22 @@ AutoSave::save()
         return true;
     }
 
+    if (_saving) {
+        // The modified documents stay marked as such, so are saved next time.
+        g_info("AutoSave::save: previous autosave still being written, skipping");
+        return true;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+
     Inkscape::Preferences *prefs = Inkscape::Preferences::get();
 
-    // Find/create autosave directory
+    // Find autosave directory
     std::string autosave_dir = prefs->getString("/options/autosave/path"); // Filenames should be std::string
     if (autosave_dir.empty()) {
         autosave_dir = Glib::build_filename(Glib::get_user_cache_dir(), "inkscape");
     }
 
-    Glib::RefPtr<Gio::File> dir_file = Gio::File::create_for_path(autosave_dir);
-    if (!dir_file->query_exists()) {
-        if (!dir_file->make_directory_with_parents()) {
-            std::cerr << "InkscapeApplication::document_autosave: Failed to create autosave directory: " << autosave_dir << std::endl;
-            return true;
-        }
-    }
-
     // Get unique info
     uid_t uid = getuid(); // Avoid naming conflicts between users
     int pid = ::getpid(); // Avoid naming conflicts between processes
@@ -97,78 +167,104 @@ AutoSave::save()
     std::stringstream datetime;
     datetime << std::put_time(&tm, "%Y_%m_%d_%H_%M_%S");
 
-    int docnum = 0;
+    std::string base_name = "automatic-save-" + std::to_string(uid);
     int autosave_max = prefs->getInt("/options/autosave/max", 10);
+    bool compress = prefs->getBool("/options/autosave/compress", true);
+    auto options = sp_repr_save_options();
+
+    // Copy the modified documents, which is all that is done on the main thread.
+    std::vector<AutoSaveJob> jobs;
+    int docnum = 0;
     for (auto document : documents) {
 
         ++docnum; // Give each document a unique number.
 
         if (document->isModifiedSinceAutoSave()) {
+            // Construct save file path
+            // datetime MUST happen first, otherwise the sorting in prune_autosaves() will fail
+            std::string filename = base_name + "-" + datetime.str() + "-" + std::to_string(pid) + "-" +
+                                   std::to_string(docnum) + (compress ? ".svgz" : ".svg");
+            jobs.push_back({document, Glib::build_filename(autosave_dir, filename),
+                            sp_repr_document_copy(document->getReprDoc())});
 
-            std::string base_name = "automatic-save-" + std::to_string(uid);
-
-            // The following we do for each document (rather wasteful...) so that
-            // we make room for each document that needs saving. We probably should
-            // be counting per document and not overall documents.
-
-            // Open directory
-            Glib::Dir directory(autosave_dir);
-            std::vector<std::string> file_names(directory.begin(), directory.end());
-
-            // Sort them so that oldest are last (file name encodes time).
-            std::sort(file_names.begin(), file_names.end(), std::greater<std::string>());
-
-            // Delete oldest files.
-            int count = 0;
-            for (auto &file_name : file_names) {
-                if (file_name.compare(0, base_name.size(), base_name) == 0) {
-                    ++count;
-                    if (count >= autosave_max) {
-                        // Delete (making room for one more).
-                        std::string path = Glib::build_filename(autosave_dir, file_name);
-                        if (unlink(path.c_str()) == -1) {
-                            std::cerr << "InkscapeApplication::document_autosave: Failed to unlink file: "
-                                      << path << ": " << strerror(errno) << std::endl;
-                        }
-                    }
-                }
+            // Changes made from now on are saved next time.
+            document->setModifiedSinceAutoSaveFalse();
+        }
+    } // Loop over documents
+
+    if (jobs.empty()) {
+        return true;
+    }
+
+    g_info("AutoSave::save: copied %zu documents in %.1f ms on the main thread", jobs.size(),
+           milliseconds_since(start));
+
+    auto [src, dst] = Async::Channel::create();
+    _channel = std::move(dst);
+    _saving = true;
+
+    Async::fire_and_forget([this, autosave_dir, base_name, autosave_max, compress, options,
+                            jobs = std::move(jobs), src = std::move(src)] {
+        // The copies are made of collected memory.
+        auto const gc = Inkscape::GC::ThreadRegistration();
+        auto const start = std::chrono::steady_clock::now();
+
+        std::vector<SPDocument *> failed;
+
+        try {
+            Glib::RefPtr<Gio::File> dir_file = Gio::File::create_for_path(autosave_dir);
+            if (!dir_file->query_exists()) {
+                dir_file->make_directory_with_parents();
             }
 
-            // Construct save file path
-            // datetime MUST happen first, otherwise the above sorting will fail
-            std::string filename = base_name + "-" + datetime.str() + "-" + std::to_string(pid) + "-" + std::to_string(docnum) + ".svg";
-            std::string path = Glib::build_filename(autosave_dir, filename.c_str());
-
-            // Try to save the file
-            // Following code needs to be reviewed
-            FILE *file = Inkscape::IO::fopen_utf8name(path.c_str(), "w");
-            gchar *errortext = nullptr;
-            if (file) {
-                try {
-                    Inkscape::XML::Node *repr = document->getReprRoot();
-                    sp_repr_save_stream(repr->document(), file, SP_SVG_NS_URI);
-                } catch (Inkscape::Extension::Output::no_extension_found &e) {
-                    errortext = g_strdup(_("Autosave failed! Could not find inkscape extension to save document."));
-                } catch (Inkscape::Extension::Output::save_failed &e) {
-                    gchar *safeUri = Inkscape::IO::sanitizeString(path.c_str());
-                    errortext = g_strdup_printf(_("Autosave failed! File %s could not be saved."), safeUri);
+            // Make room for all the documents of this autosave at once.
+            prune_autosaves(autosave_dir, base_name, autosave_max, jobs.size());
+
+            for (auto const &job : jobs) {
+                if (!write_autosave(job, options, compress)) {
+                    gchar *safeUri = Inkscape::IO::sanitizeString(job.path.c_str());
+                    gchar *errortext = g_strdup_printf(_("Autosave failed! File %s could not be saved."), safeUri);
+                    g_warning("%s", errortext);
+                    g_free(errortext);
                     g_free(safeUri);
+                    failed.push_back(job.document);
                 }
-                fclose(file);
-            } else {
-                gchar *safeUri = Inkscape::IO::sanitizeString(path.c_str());
-                errortext = g_strdup_printf(_("Autosave failed! File %s could not be saved."), safeUri);
-                g_free(safeUri);
             }
-
-            if (errortext) {
-                g_warning("%s", errortext);
-                g_free(errortext);
-            } else {
-                document->setModifiedSinceAutoSaveFalse();
+        } catch (Glib::Error const &e) {
+            std::cerr << "InkscapeApplication::document_autosave: Failed to access autosave directory: "
+                      << autosave_dir << ": " << e.what() << std::endl;
+            failed.clear();
+            for (auto const &job : jobs) {
+                failed.push_back(job.document);
+            }
+        } catch (...) {
+            // Anything else must still reach the main thread below, or autosave would stay disabled.
+            g_warning("Autosave failed!");
+            failed.clear();
+            for (auto const &job : jobs) {
+                failed.push_back(job.document);
             }
         }
-    } // Loop over documents
+
+        for (auto const &job : jobs) {
+            Inkscape::GC::release(job.snapshot);
+        }
+
+        g_info("AutoSave::save: wrote %zu documents in %.1f ms in the background", jobs.size(),
+               milliseconds_since(start));
+
+        src.run([this, failed = std::move(failed)] {
+            _saving = false;
+
+            // Try again next time.
+            auto const documents = _app->get_documents();
+            for (auto document : failed) {
+                if (std::find(documents.begin(), documents.end(), document) != documents.end()) {
+                    document->setModifiedSinceAutoSaveTrue();
+                }
+            }
+        });
+    });
 
     return true;
 }
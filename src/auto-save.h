@@ -13,6 +13,8 @@
 #ifndef INKSCAPE_AUTOSAVE_H
 #define INKSCAPE_AUTOSAVE_H
 
+#include "async/channel.h"
+
 class InkscapeApplication;
 
 namespace Inkscape {
@@ -40,6 +42,10 @@ public:
 
 private:
     InkscapeApplication* _app = nullptr;
+
+    // Documents are copied on the main thread and written on a background thread.
+    bool _saving = false; ///< Whether the documents of the last autosave are still being written.
+    Async::Channel::Dest _channel;
 };
 
 } // namespace Inkscape
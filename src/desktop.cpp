@@ -594,6 +594,7 @@ SPDesktop::set_display_area (bool log)
     _widget->update_rotation();
 
     signal_zoom_changed.emit(_current_affine.getZoom());  // Observed by path-manipulator to update arrows.
+    signal_display_area_changed.emit();
 }
 
 
@@ -994,6 +995,8 @@ SPDesktop::scroll_absolute (Geom::Point const &point)
 
     _widget->update_rulers();
     _widget->update_scrollbars(_current_affine.getZoom());
+
+    signal_display_area_changed.emit();
 }
 
 
@@ -243,6 +243,9 @@ public:
     /// The parameter is the new zoom factor
     sigc::signal<void (double)> signal_zoom_changed;
 
+    /// Emitted when the part of the drawing in view changes: on zoom, rotation, scrolling and resizing.
+    sigc::signal<void ()> signal_display_area_changed;
+
     sigc::connection connectDestroy(const sigc::slot<void (SPDesktop*)> &slot)
     {
         return _destroy_signal.connect(slot);
@@ -0,0 +1,624 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Vectorized pixel kernels for premultiplied ARGB32 surfaces.
+ *
+ * Every kernel exists in a scalar version and, on x86, in SSE4.1 and AVX2 versions selected at
+ * runtime. The vector versions unpack the pixels into one 32-bit lane per channel, so that they
+ * can use exactly the same integer arithmetic as the scalar code. Divisions are done in floating
+ * point where the result is provably exact, or corrected afterwards where it is not.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "display/cairo-simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "display/cairo-utils.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define INK_SIMD_X86 1
+# include <immintrin.h>
+# define INK_TARGET_SSE41 __attribute__((target("sse4.1")))
+# define INK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Inkscape {
+namespace Display {
+
+namespace {
+
+/*
+ * Lookup tables for color interpolation conversion, indexed by unpremultiplied channel value.
+ */
+struct ColorTables
+{
+    ColorTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            double cc = i / 255.0;
+            if (cc < 0.04045) {
+                cc /= 12.92;
+            } else {
+                cc = pow((cc + 0.055) / 1.055, 2.4);
+            }
+            srgb_to_linear[i] = (int)(cc * 255.0);
+
+            cc = i / 255.0;
+            if (cc < 0.0031308) {
+                cc *= 12.92;
+            } else {
+                cc = pow(cc, 1.0 / 2.4) * 1.055 - 0.055;
+            }
+            linear_to_srgb[i] = (int)(cc * 255.0);
+        }
+    }
+
+    guint32 srgb_to_linear[256];
+    guint32 linear_to_srgb[256];
+};
+
+ColorTables const &color_tables()
+{
+    static ColorTables const tables;
+    return tables;
+}
+
+struct Kernels
+{
+    void (*premultiply)(guint32 const *in, guint32 *out, int n);
+    void (*unpremultiply)(guint32 const *in, guint32 *out, int n);
+    void (*color_matrix)(gint32 const *matrix, guint32 const *in, guint32 *out, int n);
+    void (*composite_arithmetic)(gint32 const *k, guint32 const *in1, guint32 const *in2, guint32 *out, int n);
+    void (*convert)(guint32 const *table, guint32 const *in, guint32 *out, int n);
+};
+
+/*
+ * Scalar kernels.
+ */
+namespace scalar {
+
+guint32 convert_pixel(guint32 const *table, guint32 in)
+{
+    EXTRACT_ARGB32(in, a, r, g, b)
+    if (a != 0) {
+        r = premul_alpha(table[unpremul_alpha(r, a)], a);
+        g = premul_alpha(table[unpremul_alpha(g, a)], a);
+        b = premul_alpha(table[unpremul_alpha(b, a)], a);
+    }
+    ASSEMBLE_ARGB32(out, a, r, g, b)
+    return out;
+}
+
+void premultiply(guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        EXTRACT_ARGB32(in[i], a, r, g, b)
+        ASSEMBLE_ARGB32(px, a, premul_alpha(r, a), premul_alpha(g, a), premul_alpha(b, a))
+        out[i] = px;
+    }
+}
+
+void unpremultiply(guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        EXTRACT_ARGB32(in[i], a, r, g, b)
+        if (a != 0) {
+            r = unpremul_alpha(r, a);
+            g = unpremul_alpha(g, a);
+            b = unpremul_alpha(b, a);
+        }
+        ASSEMBLE_ARGB32(px, a, r, g, b)
+        out[i] = px;
+    }
+}
+
+void color_matrix(gint32 const *matrix, guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = color_matrix_pixel(matrix, in[i]);
+    }
+}
+
+void composite_arithmetic(gint32 const *k, guint32 const *in1, guint32 const *in2, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = composite_arithmetic_pixel(k, in1[i], in2[i]);
+    }
+}
+
+void convert(guint32 const *table, guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = convert_pixel(table, in[i]);
+    }
+}
+
+Kernels const kernels = {premultiply, unpremultiply, color_matrix, composite_arithmetic, convert};
+
+} // namespace scalar
+
+#ifdef INK_SIMD_X86
+
+/*
+ * SSE4.1 kernels, processing 4 pixels at a time.
+ */
+namespace sse41 {
+
+struct Channels
+{
+    __m128i a, r, g, b;
+};
+
+INK_TARGET_SSE41 inline Channels unpack(__m128i px)
+{
+    __m128i const mask = _mm_set1_epi32(0xff);
+    return {_mm_srli_epi32(px, 24),
+            _mm_and_si128(_mm_srli_epi32(px, 16), mask),
+            _mm_and_si128(_mm_srli_epi32(px, 8), mask),
+            _mm_and_si128(px, mask)};
+}
+
+INK_TARGET_SSE41 inline __m128i pack(__m128i a, __m128i r, __m128i g, __m128i b)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16)),
+                        _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+/// Same as premul_alpha(). Both factors are 8-bit, so a 16-bit multiply gives the exact product.
+INK_TARGET_SSE41 inline __m128i premul(__m128i c, __m128i a)
+{
+    __m128i t = _mm_add_epi32(_mm_mullo_epi16(c, a), _mm_set1_epi32(128));
+    return _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+}
+
+/// Same as unpremul_alpha(), except that c is returned unchanged where a is 0.
+/// The float division is exact: the quotient is below 256 and at least 1/255 from the next integer.
+INK_TARGET_SSE41 inline __m128i unpremul(__m128i c, __m128i a)
+{
+    __m128i num = _mm_add_epi32(_mm_mullo_epi16(c, _mm_set1_epi32(255)), _mm_srli_epi32(a, 1));
+    __m128i den = _mm_max_epi32(a, _mm_set1_epi32(1));
+    __m128i q = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(num), _mm_cvtepi32_ps(den)));
+    __m128i result = _mm_blendv_epi8(_mm_set1_epi32(255), q, _mm_cmpgt_epi32(a, c));
+    return _mm_blendv_epi8(result, c, _mm_cmpeq_epi32(a, _mm_setzero_si128()));
+}
+
+/// Divide non-negative values below 2^24 by d. The float estimate is off by at most one.
+INK_TARGET_SSE41 inline __m128i divide(__m128i x, int d)
+{
+    __m128i q = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(1.0f / d)));
+    __m128i rem = _mm_sub_epi32(x, _mm_mullo_epi32(q, _mm_set1_epi32(d)));
+    q = _mm_sub_epi32(q, _mm_cmpgt_epi32(rem, _mm_set1_epi32(d - 1)));
+    return _mm_add_epi32(q, _mm_cmpgt_epi32(_mm_setzero_si128(), rem));
+}
+
+INK_TARGET_SSE41 inline __m128i clamp(__m128i x, __m128i low, __m128i high)
+{
+    return _mm_min_epi32(_mm_max_epi32(x, low), high);
+}
+
+INK_TARGET_SSE41 inline __m128i lookup(guint32 const *table, __m128i index)
+{
+    alignas(16) guint32 i[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(i), index);
+    return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+}
+
+INK_TARGET_SSE41 void premultiply(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto p = unpack(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i)));
+        __m128i px = pack(p.a, premul(p.r, p.a), premul(p.g, p.a), premul(p.b, p.a));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), px);
+    }
+    scalar::premultiply(in + i, out + i, n - i);
+}
+
+INK_TARGET_SSE41 void unpremultiply(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto p = unpack(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i)));
+        __m128i px = pack(p.a, unpremul(p.r, p.a), unpremul(p.g, p.a), unpremul(p.b, p.a));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), px);
+    }
+    scalar::unpremultiply(in + i, out + i, n - i);
+}
+
+INK_TARGET_SSE41 inline __m128i matrix_channel(Channels const &p, __m128i const *v)
+{
+    __m128i x = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(p.r, v[0]), _mm_mullo_epi32(p.g, v[1])),
+                              _mm_add_epi32(_mm_mullo_epi32(p.b, v[2]), _mm_mullo_epi32(p.a, v[3])));
+    x = clamp(_mm_add_epi32(x, v[4]), _mm_setzero_si128(), _mm_set1_epi32(255 * 255));
+    return divide(_mm_add_epi32(x, _mm_set1_epi32(127)), 255);
+}
+
+INK_TARGET_SSE41 void color_matrix(gint32 const *matrix, guint32 const *in, guint32 *out, int n)
+{
+    __m128i v[20];
+    for (int k = 0; k < 20; ++k) {
+        v[k] = _mm_set1_epi32(matrix[k]);
+    }
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto p = unpack(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i)));
+        p.r = unpremul(p.r, p.a);
+        p.g = unpremul(p.g, p.a);
+        p.b = unpremul(p.b, p.a);
+
+        __m128i ao = matrix_channel(p, v + 15);
+        __m128i ro = premul(matrix_channel(p, v), ao);
+        __m128i go = premul(matrix_channel(p, v + 5), ao);
+        __m128i bo = premul(matrix_channel(p, v + 10), ao);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), pack(ao, ro, go, bo));
+    }
+    scalar::color_matrix(matrix, in + i, out + i, n - i);
+}
+
+INK_TARGET_SSE41 inline __m128i arithmetic_channel(__m128i x, __m128i y, __m128i const *k)
+{
+    return _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_mullo_epi32(k[0], x), y), _mm_mullo_epi32(k[1], x)),
+                         _mm_add_epi32(_mm_mullo_epi32(k[2], y), k[3]));
+}
+
+INK_TARGET_SSE41 void composite_arithmetic(gint32 const *k, guint32 const *in1, guint32 const *in2, guint32 *out, int n)
+{
+    __m128i const kv[4] = {_mm_set1_epi32(k[0]), _mm_set1_epi32(k[1]), _mm_set1_epi32(k[2]), _mm_set1_epi32(k[3])};
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const bias = _mm_set1_epi32(255 * 255 / 2);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto p = unpack(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in1 + i)));
+        auto q = unpack(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in2 + i)));
+
+        __m128i ao = clamp(arithmetic_channel(p.a, q.a, kv), zero, _mm_set1_epi32(255 * 255 * 255));
+        __m128i ro = clamp(arithmetic_channel(p.r, q.r, kv), zero, ao);
+        __m128i go = clamp(arithmetic_channel(p.g, q.g, kv), zero, ao);
+        __m128i bo = clamp(arithmetic_channel(p.b, q.b, kv), zero, ao);
+
+        __m128i px = pack(divide(_mm_add_epi32(ao, bias), 255 * 255), divide(_mm_add_epi32(ro, bias), 255 * 255),
+                          divide(_mm_add_epi32(go, bias), 255 * 255), divide(_mm_add_epi32(bo, bias), 255 * 255));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), px);
+    }
+    scalar::composite_arithmetic(k, in1 + i, in2 + i, out + i, n - i);
+}
+
+INK_TARGET_SSE41 void convert(guint32 const *table, guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+        auto p = unpack(px);
+        __m128i ro = premul(lookup(table, unpremul(p.r, p.a)), p.a);
+        __m128i go = premul(lookup(table, unpremul(p.g, p.a)), p.a);
+        __m128i bo = premul(lookup(table, unpremul(p.b, p.a)), p.a);
+        __m128i transparent = _mm_cmpeq_epi32(p.a, _mm_setzero_si128());
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_blendv_epi8(pack(p.a, ro, go, bo), px, transparent));
+    }
+    scalar::convert(table, in + i, out + i, n - i);
+}
+
+Kernels const kernels = {premultiply, unpremultiply, color_matrix, composite_arithmetic, convert};
+
+} // namespace sse41
+
+/*
+ * AVX2 kernels, processing 8 pixels at a time. These mirror the SSE4.1 kernels.
+ */
+namespace avx2 {
+
+struct Channels
+{
+    __m256i a, r, g, b;
+};
+
+INK_TARGET_AVX2 inline Channels unpack(__m256i px)
+{
+    __m256i const mask = _mm256_set1_epi32(0xff);
+    return {_mm256_srli_epi32(px, 24),
+            _mm256_and_si256(_mm256_srli_epi32(px, 16), mask),
+            _mm256_and_si256(_mm256_srli_epi32(px, 8), mask),
+            _mm256_and_si256(px, mask)};
+}
+
+INK_TARGET_AVX2 inline __m256i pack(__m256i a, __m256i r, __m256i g, __m256i b)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a, 24), _mm256_slli_epi32(r, 16)),
+                           _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+}
+
+INK_TARGET_AVX2 inline __m256i premul(__m256i c, __m256i a)
+{
+    __m256i t = _mm256_add_epi32(_mm256_mullo_epi16(c, a), _mm256_set1_epi32(128));
+    return _mm256_srli_epi32(_mm256_add_epi32(t, _mm256_srli_epi32(t, 8)), 8);
+}
+
+INK_TARGET_AVX2 inline __m256i unpremul(__m256i c, __m256i a)
+{
+    __m256i num = _mm256_add_epi32(_mm256_mullo_epi16(c, _mm256_set1_epi32(255)), _mm256_srli_epi32(a, 1));
+    __m256i den = _mm256_max_epi32(a, _mm256_set1_epi32(1));
+    __m256i q = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(num), _mm256_cvtepi32_ps(den)));
+    __m256i result = _mm256_blendv_epi8(_mm256_set1_epi32(255), q, _mm256_cmpgt_epi32(a, c));
+    return _mm256_blendv_epi8(result, c, _mm256_cmpeq_epi32(a, _mm256_setzero_si256()));
+}
+
+INK_TARGET_AVX2 inline __m256i divide(__m256i x, int d)
+{
+    __m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(x), _mm256_set1_ps(1.0f / d)));
+    __m256i rem = _mm256_sub_epi32(x, _mm256_mullo_epi32(q, _mm256_set1_epi32(d)));
+    q = _mm256_sub_epi32(q, _mm256_cmpgt_epi32(rem, _mm256_set1_epi32(d - 1)));
+    return _mm256_add_epi32(q, _mm256_cmpgt_epi32(_mm256_setzero_si256(), rem));
+}
+
+INK_TARGET_AVX2 inline __m256i clamp(__m256i x, __m256i low, __m256i high)
+{
+    return _mm256_min_epi32(_mm256_max_epi32(x, low), high);
+}
+
+INK_TARGET_AVX2 inline __m256i lookup(guint32 const *table, __m256i index)
+{
+    return _mm256_i32gather_epi32(reinterpret_cast<int const *>(table), index, 4);
+}
+
+INK_TARGET_AVX2 void premultiply(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto p = unpack(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i)));
+        __m256i px = pack(p.a, premul(p.r, p.a), premul(p.g, p.a), premul(p.b, p.a));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), px);
+    }
+    scalar::premultiply(in + i, out + i, n - i);
+}
+
+INK_TARGET_AVX2 void unpremultiply(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto p = unpack(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i)));
+        __m256i px = pack(p.a, unpremul(p.r, p.a), unpremul(p.g, p.a), unpremul(p.b, p.a));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), px);
+    }
+    scalar::unpremultiply(in + i, out + i, n - i);
+}
+
+INK_TARGET_AVX2 inline __m256i matrix_channel(Channels const &p, __m256i const *v)
+{
+    __m256i x = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(p.r, v[0]), _mm256_mullo_epi32(p.g, v[1])),
+                                 _mm256_add_epi32(_mm256_mullo_epi32(p.b, v[2]), _mm256_mullo_epi32(p.a, v[3])));
+    x = clamp(_mm256_add_epi32(x, v[4]), _mm256_setzero_si256(), _mm256_set1_epi32(255 * 255));
+    return divide(_mm256_add_epi32(x, _mm256_set1_epi32(127)), 255);
+}
+
+INK_TARGET_AVX2 void color_matrix(gint32 const *matrix, guint32 const *in, guint32 *out, int n)
+{
+    __m256i v[20];
+    for (int k = 0; k < 20; ++k) {
+        v[k] = _mm256_set1_epi32(matrix[k]);
+    }
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto p = unpack(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i)));
+        p.r = unpremul(p.r, p.a);
+        p.g = unpremul(p.g, p.a);
+        p.b = unpremul(p.b, p.a);
+
+        __m256i ao = matrix_channel(p, v + 15);
+        __m256i ro = premul(matrix_channel(p, v), ao);
+        __m256i go = premul(matrix_channel(p, v + 5), ao);
+        __m256i bo = premul(matrix_channel(p, v + 10), ao);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), pack(ao, ro, go, bo));
+    }
+    scalar::color_matrix(matrix, in + i, out + i, n - i);
+}
+
+INK_TARGET_AVX2 inline __m256i arithmetic_channel(__m256i x, __m256i y, __m256i const *k)
+{
+    return _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(k[0], x), y), _mm256_mullo_epi32(k[1], x)),
+                            _mm256_add_epi32(_mm256_mullo_epi32(k[2], y), k[3]));
+}
+
+INK_TARGET_AVX2 void composite_arithmetic(gint32 const *k, guint32 const *in1, guint32 const *in2, guint32 *out, int n)
+{
+    __m256i const kv[4] = {_mm256_set1_epi32(k[0]), _mm256_set1_epi32(k[1]), _mm256_set1_epi32(k[2]), _mm256_set1_epi32(k[3])};
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const bias = _mm256_set1_epi32(255 * 255 / 2);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto p = unpack(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in1 + i)));
+        auto q = unpack(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in2 + i)));
+
+        __m256i ao = clamp(arithmetic_channel(p.a, q.a, kv), zero, _mm256_set1_epi32(255 * 255 * 255));
+        __m256i ro = clamp(arithmetic_channel(p.r, q.r, kv), zero, ao);
+        __m256i go = clamp(arithmetic_channel(p.g, q.g, kv), zero, ao);
+        __m256i bo = clamp(arithmetic_channel(p.b, q.b, kv), zero, ao);
+
+        __m256i px = pack(divide(_mm256_add_epi32(ao, bias), 255 * 255), divide(_mm256_add_epi32(ro, bias), 255 * 255),
+                          divide(_mm256_add_epi32(go, bias), 255 * 255), divide(_mm256_add_epi32(bo, bias), 255 * 255));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), px);
+    }
+    scalar::composite_arithmetic(k, in1 + i, in2 + i, out + i, n - i);
+}
+
+INK_TARGET_AVX2 void convert(guint32 const *table, guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+        auto p = unpack(px);
+        __m256i ro = premul(lookup(table, unpremul(p.r, p.a)), p.a);
+        __m256i go = premul(lookup(table, unpremul(p.g, p.a)), p.a);
+        __m256i bo = premul(lookup(table, unpremul(p.b, p.a)), p.a);
+        __m256i transparent = _mm256_cmpeq_epi32(p.a, _mm256_setzero_si256());
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_blendv_epi8(pack(p.a, ro, go, bo), px, transparent));
+    }
+    scalar::convert(table, in + i, out + i, n - i);
+}
+
+Kernels const kernels = {premultiply, unpremultiply, color_matrix, composite_arithmetic, convert};
+
+} // namespace avx2
+
+#endif // INK_SIMD_X86
+
+SimdLevel detect_simd_level()
+{
+#ifdef INK_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SimdLevel::SSE41;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+std::atomic<SimdLevel> &current_level()
+{
+    static std::atomic<SimdLevel> level{simd_level_supported()};
+    return level;
+}
+
+Kernels const &kernels()
+{
+    switch (current_level().load(std::memory_order_relaxed)) {
+#ifdef INK_SIMD_X86
+        case SimdLevel::AVX2:
+            return avx2::kernels;
+        case SimdLevel::SSE41:
+            return sse41::kernels;
+#endif
+        default:
+            return scalar::kernels;
+    }
+}
+
+} // namespace
+
+SimdLevel simd_level()
+{
+    return current_level().load(std::memory_order_relaxed);
+}
+
+SimdLevel simd_level_supported()
+{
+    static SimdLevel const level = detect_simd_level();
+    return level;
+}
+
+void set_simd_level(SimdLevel level)
+{
+    current_level().store(std::min(level, simd_level_supported()), std::memory_order_relaxed);
+}
+
+void premultiply_row(guint32 const *in, guint32 *out, int n)
+{
+    kernels().premultiply(in, out, n);
+}
+
+void unpremultiply_row(guint32 const *in, guint32 *out, int n)
+{
+    kernels().unpremultiply(in, out, n);
+}
+
+void color_matrix_row(gint32 const matrix[20], guint32 const *in, guint32 *out, int n)
+{
+    kernels().color_matrix(matrix, in, out, n);
+}
+
+guint32 color_matrix_pixel(gint32 const matrix[20], guint32 in)
+{
+    EXTRACT_ARGB32(in, a, r, g, b)
+    // we need to un-premultiply alpha values for this type of matrix
+    // TODO: unpremul can be ignored if there is an identity mapping on the alpha channel
+    if (a != 0) {
+        r = unpremul_alpha(r, a);
+        g = unpremul_alpha(g, a);
+        b = unpremul_alpha(b, a);
+    }
+
+    gint32 ro = r*matrix[0]  + g*matrix[1]  + b*matrix[2]  + a*matrix[3]  + matrix[4];
+    gint32 go = r*matrix[5]  + g*matrix[6]  + b*matrix[7]  + a*matrix[8]  + matrix[9];
+    gint32 bo = r*matrix[10] + g*matrix[11] + b*matrix[12] + a*matrix[13] + matrix[14];
+    gint32 ao = r*matrix[15] + g*matrix[16] + b*matrix[17] + a*matrix[18] + matrix[19];
+    ro = (std::clamp(ro, 0, 255*255) + 127) / 255;
+    go = (std::clamp(go, 0, 255*255) + 127) / 255;
+    bo = (std::clamp(bo, 0, 255*255) + 127) / 255;
+    ao = (std::clamp(ao, 0, 255*255) + 127) / 255;
+
+    ro = premul_alpha(ro, ao);
+    go = premul_alpha(go, ao);
+    bo = premul_alpha(bo, ao);
+
+    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
+    return pxout;
+}
+
+void composite_arithmetic_row(gint32 const k[4], guint32 const *in1, guint32 const *in2, guint32 *out, int n)
+{
+    kernels().composite_arithmetic(k, in1, in2, out, n);
+}
+
+guint32 composite_arithmetic_pixel(gint32 const k[4], guint32 in1, guint32 in2)
+{
+    EXTRACT_ARGB32(in1, aa, ra, ga, ba)
+    EXTRACT_ARGB32(in2, ab, rb, gb, bb)
+
+    gint32 ao = k[0]*aa*ab + k[1]*aa + k[2]*ab + k[3];
+    gint32 ro = k[0]*ra*rb + k[1]*ra + k[2]*rb + k[3];
+    gint32 go = k[0]*ga*gb + k[1]*ga + k[2]*gb + k[3];
+    gint32 bo = k[0]*ba*bb + k[1]*ba + k[2]*bb + k[3];
+
+    ao = std::clamp(ao, 0, 255*255*255); // r, g and b are premultiplied, so should be clamped to the alpha channel
+    ro = (std::clamp(ro, 0, ao) + (255*255/2)) / (255*255);
+    go = (std::clamp(go, 0, ao) + (255*255/2)) / (255*255);
+    bo = (std::clamp(bo, 0, ao) + (255*255/2)) / (255*255);
+    ao = (ao + (255*255/2)) / (255*255);
+
+    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
+    return pxout;
+}
+
+void srgb_to_linear_row(guint32 const *in, guint32 *out, int n)
+{
+    kernels().convert(color_tables().srgb_to_linear, in, out, n);
+}
+
+void linear_to_srgb_row(guint32 const *in, guint32 *out, int n)
+{
+    kernels().convert(color_tables().linear_to_srgb, in, out, n);
+}
+
+guint32 srgb_to_linear_pixel(guint32 in)
+{
+    return scalar::convert_pixel(color_tables().srgb_to_linear, in);
+}
+
+guint32 linear_to_srgb_pixel(guint32 in)
+{
+    return scalar::convert_pixel(color_tables().linear_to_srgb, in);
+}
+
+} // namespace Display
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
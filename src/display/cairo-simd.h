@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Vectorized pixel kernels for premultiplied ARGB32 surfaces.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+#define SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+
+#include <glib.h>
+
+namespace Inkscape {
+namespace Display {
+
+/**
+ * Instruction sets available to the row kernels below, from least to most capable.
+ *
+ * The best level supported by the CPU is selected at runtime; every level produces exactly
+ * the same pixels as the scalar code.
+ */
+enum class SimdLevel
+{
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+/// The instruction set currently used by the row kernels.
+SimdLevel simd_level();
+
+/// The most capable instruction set supported by this CPU.
+SimdLevel simd_level_supported();
+
+/// Restrict the row kernels to the given instruction set, e.g. to compare them in benchmarks.
+/// Levels the CPU does not support are lowered to the best supported one.
+void set_simd_level(SimdLevel level);
+
+/*
+ * Row kernels. Each processes n consecutive premultiplied ARGB32 pixels. The output may be the
+ * same buffer as an input, but must not otherwise overlap with it.
+ */
+
+/// Multiply the color channels by alpha.
+void premultiply_row(guint32 const *in, guint32 *out, int n);
+
+/// Divide the color channels by alpha. Fully transparent pixels are left as they are.
+void unpremultiply_row(guint32 const *in, guint32 *out, int n);
+
+/**
+ * Apply a feColorMatrix matrix to unpremultiplied colors. The coefficients are scaled by 255,
+ * except for the offsets in the last column, which are scaled by 255*255.
+ */
+void color_matrix_row(gint32 const matrix[20], guint32 const *in, guint32 *out, int n);
+guint32 color_matrix_pixel(gint32 const matrix[20], guint32 in);
+
+/**
+ * Compute k1*in1*in2 + k2*in1 + k3*in2 + k4 as the feComposite arithmetic operator does.
+ * k1 is scaled by 255, k2 and k3 by 255*255 and k4 by 255*255*255.
+ */
+void composite_arithmetic_row(gint32 const k[4], guint32 const *in1, guint32 const *in2, guint32 *out, int n);
+guint32 composite_arithmetic_pixel(gint32 const k[4], guint32 in1, guint32 in2);
+
+/// Convert between the sRGB and linearRGB color interpolation spaces.
+void srgb_to_linear_row(guint32 const *in, guint32 *out, int n);
+void linear_to_srgb_row(guint32 const *in, guint32 *out, int n);
+guint32 srgb_to_linear_pixel(guint32 in);
+guint32 linear_to_srgb_pixel(guint32 in);
+
+} // namespace Display
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
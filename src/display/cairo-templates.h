@@ -19,18 +19,61 @@
 
 #include <glib.h>
 
-#ifdef HAVE_OPENMP
-#include <omp.h>
-// single-threaded operation if the number of pixels is below this threshold
-static const int OPENMP_THRESHOLD = 2048;
-#endif
-
 #include <cmath>
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 #include <cairo.h>
+#include "async/scheduler.h"
 #include "display/nr-3dutils.h"
 #include "display/cairo-utils.h"
 
+// single-threaded operation if the number of pixels is below this threshold
+static const int PARALLEL_THRESHOLD = 2048;
+
+/**
+ * Call f(i) for every i in [begin, end). If the surface has enough pixels, the loop is split
+ * between the threads of the render scheduler; this also works from within a canvas tile.
+ */
+template <typename F>
+void ink_cairo_parallel_for(int begin, int end, int pixels, F &&f)
+{
+    if (pixels > PARALLEL_THRESHOLD) {
+        Inkscape::Async::Scheduler::get().parallel_for(begin, end, f);
+    } else {
+        for (int i = begin; i < end; ++i) {
+            f(i);
+        }
+    }
+}
+
+/**
+ * Functors passed to ink_cairo_surface_blend() and ink_cairo_surface_filter() may also process
+ * a whole row of ARGB32 pixels at once, typically using the vectorized kernels from
+ * display/cairo-simd.h, by providing the corresponding method:
+ *
+ *     void blend_row(guint32 const *in1, guint32 const *in2, guint32 *out, int n);
+ *     void filter_row(guint32 const *in, guint32 *out, int n);
+ *
+ * It is used instead of the per-pixel operator whenever all the surfaces involved are ARGB32,
+ * and must give the same results. The output row may be the same as an input row.
+ */
+template <typename Blend, typename = void>
+struct ink_cairo_has_blend_row : std::false_type {};
+
+template <typename Blend>
+struct ink_cairo_has_blend_row<Blend, std::void_t<decltype(std::declval<Blend &>().blend_row(
+    std::declval<guint32 const *>(), std::declval<guint32 const *>(), std::declval<guint32 *>(), 0))>>
+    : std::true_type {};
+
+template <typename Filter, typename = void>
+struct ink_cairo_has_filter_row : std::false_type {};
+
+template <typename Filter>
+struct ink_cairo_has_filter_row<Filter, std::void_t<decltype(std::declval<Filter &>().filter_row(
+    std::declval<guint32 const *>(), std::declval<guint32 *>(), 0))>>
+    : std::true_type {};
+
 /**
  * Blend two surfaces using the supplied functor.
  * This template blends two Cairo image surfaces using a blending functor that takes
@@ -71,28 +114,19 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
     guint32 *const in2_data = reinterpret_cast<guint32*>(cairo_image_surface_get_data(in2));
     guint32 *const out_data = reinterpret_cast<guint32*>(cairo_image_surface_get_data(out));
 
-    // NOTE
-    // OpenMP probably doesn't help much here.
-    // It would be better to render more than 1 tile at a time.
-    #if HAVE_OPENMP
-    int numOfThreads = get_num_filter_threads();
-    #endif
-
     // The number of code paths here is evil.
     if (bpp1 == 4) {
         if (bpp2 == 4) {
-            if (fast_path) {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < limit; ++i) {
+            if constexpr (ink_cairo_has_blend_row<Blend>::value) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
+                    blend.blend_row(in1_data + i * stride1/4, in2_data + i * stride2/4, out_data + i * strideout/4, w);
+                });
+            } else if (fast_path) {
+                ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                     *(out_data + i) = blend(*(in1_data + i), *(in2_data + i));
-                }
+                });
             } else {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < h; ++i) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                     guint32 *in1_p = in1_data + i * stride1/4;
                     guint32 *in2_p = in2_data + i * stride2/4;
                     guint32 *out_p = out_data + i * strideout/4;
@@ -100,14 +134,11 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                         *out_p = blend(*in1_p, *in2_p);
                         ++in1_p; ++in2_p; ++out_p;
                     }
-                }
+                });
             }
         } else {
             // bpp2 == 1
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < h; ++i) {
+            ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                 guint32 *in1_p = in1_data + i * stride1/4;
                 guint8  *in2_p = reinterpret_cast<guint8*>(in2_data) + i * stride2;
                 guint32 *out_p = out_data + i * strideout/4;
@@ -117,15 +148,12 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                     *out_p = blend(*in1_p, in2_px);
                     ++in1_p; ++in2_p; ++out_p;
                 }
-            }
+            });
         }
     } else {
         if (bpp2 == 4) {
             // bpp1 == 1
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < h; ++i) {
+            ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                 guint8  *in1_p = reinterpret_cast<guint8*>(in1_data) + i * stride1;
                 guint32 *in2_p = in2_data + i * stride2/4;
                 guint32 *out_p = out_data + i * strideout/4;
@@ -135,14 +163,11 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                     *out_p = blend(in1_px, *in2_p);
                     ++in1_p; ++in2_p; ++out_p;
                 }
-            }
+            });
         } else {
             // bpp1 == 1 && bpp2 == 1
             if (fast_path) {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < limit; ++i) {
+                ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                     guint8 *in1_p = reinterpret_cast<guint8*>(in1_data) + i;
                     guint8 *in2_p = reinterpret_cast<guint8*>(in2_data) + i;
                     guint8 *out_p = reinterpret_cast<guint8*>(out_data) + i;
@@ -150,12 +175,9 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                     guint32 in2_px = *in2_p; in2_px <<= 24;
                     guint32 out_px = blend(in1_px, in2_px);
                     *out_p = out_px >> 24;
-                }
+                });
             } else {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < h; ++i) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                     guint8 *in1_p = reinterpret_cast<guint8*>(in1_data) + i * stride1;
                     guint8 *in2_p = reinterpret_cast<guint8*>(in2_data) + i * stride2;
                     guint8 *out_p = reinterpret_cast<guint8*>(out_data) + i * strideout;
@@ -166,7 +188,7 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                         *out_p = out_px >> 24;
                         ++in1_p; ++in2_p; ++out_p;
                     }
-                }
+                });
             }
         }
     }
@@ -200,29 +222,29 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
     guint32 *const in_data  = reinterpret_cast<guint32*>(cairo_image_surface_get_data(in));
     guint32 *const out_data = reinterpret_cast<guint32*>(cairo_image_surface_get_data(out));
 
-    #if HAVE_OPENMP
-    int numOfThreads = get_num_filter_threads();
-    #endif
-
     // this is provided just in case, to avoid problems with strict aliasing rules
     if (in == out) {
+        if constexpr (ink_cairo_has_filter_row<Filter>::value) {
+            if (bppin == 4) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
+                    guint32 *row = in_data + i * stridein/4;
+                    filter.filter_row(row, row, w);
+                });
+                cairo_surface_mark_dirty(out);
+                return;
+            }
+        }
         if (bppin == 4) {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < limit; ++i) {
+            ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                 *(in_data + i) = filter(*(in_data + i));
-            }
+            });
         } else {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < limit; ++i) {
+            ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                 guint8 *in_p = reinterpret_cast<guint8*>(in_data) + i;
                 guint32 in_px = *in_p; in_px <<= 24;
                 guint32 out_px = filter(in_px);
                 *in_p = out_px >> 24;
-            }
+            });
         }
         cairo_surface_mark_dirty(out);
         return;
@@ -231,33 +253,28 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
     if (bppin == 4) {
         if (bppout == 4) {
             // bppin == 4, bppout == 4
-            if (fast_path) {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < limit; ++i) {
+            if constexpr (ink_cairo_has_filter_row<Filter>::value) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
+                    filter.filter_row(in_data + i * stridein/4, out_data + i * strideout/4, w);
+                });
+            } else if (fast_path) {
+                ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                     *(out_data + i) = filter(*(in_data + i));
-                }
+                });
             } else {
-                #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-                #endif
-                for (int i = 0; i < h; ++i) {
+                ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                     guint32 *in_p = in_data + i * stridein/4;
                     guint32 *out_p = out_data + i * strideout/4;
                     for (int j = 0; j < w; ++j) {
                         *out_p = filter(*in_p);
                         ++in_p; ++out_p;
                     }
-                }
+                });
             }
         } else {
             // bppin == 4, bppout == 1
             // we use this path with COLORMATRIX_LUMINANCETOALPHA
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < h; ++i) {
+            ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                 guint32 *in_p = in_data + i * stridein/4;
                 guint8 *out_p = reinterpret_cast<guint8*>(out_data) + i * strideout;
                 for (int j = 0; j < w; ++j) {
@@ -265,26 +282,20 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
                     *out_p = out_px >> 24;
                     ++in_p; ++out_p;
                 }
-            }
+            });
         }
     } else if (bppout == 1) {
         // bppin == 1, bppout == 1
         if (fast_path) {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < limit; ++i) {
+            ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                 guint8 *in_p = reinterpret_cast<guint8*>(in_data) + i;
                 guint8 *out_p = reinterpret_cast<guint8*>(out_data) + i;
                 guint32 in_px = *in_p; in_px <<= 24;
                 guint32 out_px = filter(in_px);
                 *out_p = out_px >> 24;
-            }
+            });
         } else {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < h; ++i) {
+            ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                 guint8 *in_p = reinterpret_cast<guint8*>(in_data) + i * stridein;
                 guint8 *out_p = reinterpret_cast<guint8*>(out_data) + i * strideout;
                 for (int j = 0; j < w; ++j) {
@@ -293,30 +304,24 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
                     *out_p = out_px >> 24;
                     ++in_p; ++out_p;
                 }
-            }
+            });
         }
     } else {
         // bppin == 1, bppout == 4
         // used in COLORMATRIX_MATRIX when in is NR_FILTER_SOURCEALPHA
         if (fast_path) {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < limit; ++i) {
+            ink_cairo_parallel_for(0, limit, limit, [&] (int i) {
                 guint8 in_p = reinterpret_cast<guint8*>(in_data)[i];
                 out_data[i] = filter(guint32(in_p) << 24);
-            }
+            });
         } else {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < h; ++i) {
+            ink_cairo_parallel_for(0, h, limit, [&] (int i) {
                 guint8 *in_p = reinterpret_cast<guint8*>(in_data) + i * stridein;
                 guint32 *out_p = out_data + i * strideout/4;
                 for (int j = 0; j < w; ++j) {
                     out_p[j] = filter(guint32(in_p[j]) << 24);
                 }
-            }
+            });
         }
     }
     cairo_surface_mark_dirty(out);
@@ -346,35 +351,26 @@ void ink_cairo_surface_synthesize(cairo_surface_t *out, cairo_rectangle_t const
 
     unsigned char *out_data = cairo_image_surface_get_data(out);
 
-    #if HAVE_OPENMP
     int limit = w * h;
-    int numOfThreads = get_num_filter_threads();
-    #endif
 
     if (bppout == 4) {
-        #if HAVE_OPENMP
-        #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-        #endif
-        for (int i = out_area.y; i < h; ++i) {
+        ink_cairo_parallel_for(out_area.y, h, limit, [&] (int i) {
             guint32 *out_p = reinterpret_cast<guint32*>(out_data + i * strideout);
             for (int j = out_area.x; j < w; ++j) {
                 *out_p = synth(j, i);
                 ++out_p;
             }
-        }
+        });
     } else {
         // bppout == 1
-        #if HAVE_OPENMP
-        #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-        #endif
-        for (int i = out_area.y; i < h; ++i) {
+        ink_cairo_parallel_for(out_area.y, h, limit, [&] (int i) {
             guint8 *out_p = out_data + i * strideout;
             for (int j = out_area.x; j < w; ++j) {
                 guint32 out_px = synth(j, i);
                 *out_p = out_px >> 24;
                 ++out_p;
             }
-        }
+        });
     }
     cairo_surface_mark_dirty(out);
 }
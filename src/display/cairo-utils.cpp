@@ -19,15 +19,18 @@
 #include <2geom/point.h>
 #include <2geom/sbasis-to-bezier.h>
 #include <2geom/transforms.h>
-#include <atomic>
 #include <boost/algorithm/string.hpp>
 #include <boost/operators.hpp>
 #include <boost/optional/optional.hpp>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib/gstdio.h>
 #include <glibmm/fileutils.h>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
+#include "async/scheduler.h"
+#include "cairo-simd.h"
 #include "cairo-templates.h"
 #include "color.h"
 #include "document.h"
@@ -608,6 +611,97 @@ guchar *Pixbuf::pixels() {
 }
 void Pixbuf::markDirty() {
     cairo_surface_mark_dirty(_surface);
+    std::atomic_store(&_mipmaps, std::shared_ptr<Mipmaps>());
+}
+
+/// Mip levels of a pixbuf, shared with the task that builds them.
+struct Pixbuf::Mipmaps
+{
+    std::mutex mutex;
+    std::vector<cairo_surface_t *> levels; ///< Levels from 1 on, only ever appended to.
+    bool started = false;
+
+    ~Mipmaps()
+    {
+        for (auto surface : levels) {
+            cairo_surface_destroy(surface);
+        }
+    }
+};
+
+/**
+ * Downscale an ARGB32 surface by two in each direction, averaging blocks of 2x2 pixels.
+ * Averaging premultiplied pixels weighs the colours by their alpha, as is correct.
+ */
+static cairo_surface_t *ink_cairo_surface_halve(cairo_surface_t *src)
+{
+    int const w = cairo_image_surface_get_width(src);
+    int const h = cairo_image_surface_get_height(src);
+    int const sstride = cairo_image_surface_get_stride(src);
+    unsigned char const *sdata = cairo_image_surface_get_data(src);
+
+    int const dw = (w + 1) / 2;
+    int const dh = (h + 1) / 2;
+    cairo_surface_t *dst = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, dw, dh);
+    int const dstride = cairo_image_surface_get_stride(dst);
+    unsigned char *ddata = cairo_image_surface_get_data(dst);
+
+    for (int y = 0; y < dh; ++y) {
+        // Odd sizes repeat the last row and column.
+        unsigned char const *row0 = sdata + 2 * y * sstride;
+        unsigned char const *row1 = sdata + std::min(2 * y + 1, h - 1) * sstride;
+        unsigned char *out = ddata + y * dstride;
+        for (int x = 0; x < dw; ++x) {
+            int const x0 = 8 * x;
+            int const x1 = 4 * std::min(2 * x + 1, w - 1);
+            for (int c = 0; c < 4; ++c) {
+                out[4 * x + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2;
+            }
+        }
+    }
+
+    cairo_surface_mark_dirty(dst);
+    return dst;
+}
+
+cairo_surface_t *Pixbuf::getMipmap(int &level) const
+{
+    assert(_pixel_format == PF_CAIRO);
+    if (level <= 0) {
+        level = 0;
+        return _surface;
+    }
+
+    auto mipmaps = std::atomic_load(&_mipmaps);
+    if (!mipmaps) {
+        auto created = std::make_shared<Mipmaps>();
+        mipmaps = std::atomic_compare_exchange_strong(&_mipmaps, &mipmaps, created) ? created : mipmaps;
+    }
+
+    auto lock = std::lock_guard(mipmaps->mutex);
+
+    if (!mipmaps->started) {
+        mipmaps->started = true;
+        // The pixbuf may go away first, so keep the pixels alive, and stop once nobody needs the levels.
+        auto source = cairo_surface_reference(_surface);
+        auto owner = static_cast<GdkPixbuf *>(g_object_ref(_pixbuf));
+        Async::Scheduler::get().post([mipmaps, source, owner] {
+            auto prev = source;
+            while ((cairo_image_surface_get_width(prev) > 1 || cairo_image_surface_get_height(prev) > 1) &&
+                   mipmaps.use_count() > 1)
+            {
+                auto next = ink_cairo_surface_halve(prev);
+                auto lock = std::lock_guard(mipmaps->mutex);
+                mipmaps->levels.push_back(next);
+                prev = next;
+            }
+            cairo_surface_destroy(source);
+            g_object_unref(owner);
+        });
+    }
+
+    level = std::min<int>(level, mipmaps->levels.size());
+    return level == 0 ? _surface : mipmaps->levels[level - 1];
 }
 
 void Pixbuf::_forceAlpha()
@@ -645,6 +739,10 @@ void Pixbuf::_setMimeData(guchar *data, gsize len, Glib::ustring const &format)
  */
 void Pixbuf::ensurePixelFormat(PixelFormat fmt)
 {
+    if (fmt != _pixel_format) {
+        std::atomic_store(&_mipmaps, std::shared_ptr<Mipmaps>());
+    }
+
     if (fmt == PF_CAIRO && _pixel_format == PF_GDK) {
         ensure_argb32(_pixbuf);
         _pixel_format = fmt;
@@ -958,18 +1056,6 @@ std::optional<Geom::PathVector> extract_pathvector_from_cairo(cairo_t *ct)
     return res.peek();
 }
 
-static std::atomic<int> num_filter_threads = 4;
-
-int get_num_filter_threads()
-{
-    return num_filter_threads.load(std::memory_order_relaxed);
-}
-
-void set_num_filter_threads(int n)
-{
-    num_filter_threads.store(n, std::memory_order_relaxed);
-}
-
 SPColorInterpolation
 get_cairo_surface_ci(cairo_surface_t *surface) {
     void* data = cairo_surface_get_user_data( surface, &ink_color_interpolation_key );
@@ -1326,53 +1412,18 @@ void ink_cairo_surface_average_color_premul(cairo_surface_t *surface, double &r,
     a = CLAMP(a, 0.0, 1.0);
 }
 
-static guint32 srgb_to_linear( const guint32 c, const guint32 a ) {
-
-    const guint32 c1 = unpremul_alpha( c, a );
-
-    double cc = c1/255.0;
-
-    if( cc < 0.04045 ) {
-        cc /= 12.92;
-    } else {
-        cc = pow( (cc+0.055)/1.055, 2.4 );
-    }
-    cc *= 255.0;
-
-    const guint32 c2 = (int)cc;
-
-    return premul_alpha( c2, a );
-}
-
-static guint32 linear_to_srgb( const guint32 c, const guint32 a ) {
-
-    const guint32 c1 = unpremul_alpha( c, a );
-
-    double cc = c1/255.0;
-
-    if( cc < 0.0031308 ) {
-        cc *= 12.92;
-    } else {
-        cc = pow( cc, 1.0/2.4 )*1.055-0.055;
+struct SurfaceSrgbToLinear
+{
+    guint32 operator()(guint32 in)
+    {
+        return Inkscape::Display::srgb_to_linear_pixel(in);
     }
-    cc *= 255.0;
-
-    const guint32 c2 = (int)cc;
-
-    return premul_alpha( c2, a );
-}
 
-static uint32_t srgb_to_linear_argb32(uint32_t in)
-{
-    EXTRACT_ARGB32(in, a, r, g, b);
-    if (a != 0) {
-        r = srgb_to_linear(r, a);
-        g = srgb_to_linear(g, a);
-        b = srgb_to_linear(b, a);
+    void filter_row(guint32 const *in, guint32 *out, int n)
+    {
+        Inkscape::Display::srgb_to_linear_row(in, out, n);
     }
-    ASSEMBLE_ARGB32(out, a, r, g, b);
-    return out;
-}
+};
 
 int ink_cairo_surface_srgb_to_linear(cairo_surface_t *surface)
 {
@@ -1380,22 +1431,23 @@ int ink_cairo_surface_srgb_to_linear(cairo_surface_t *surface)
     int width = cairo_image_surface_get_width(surface);
     int height = cairo_image_surface_get_height(surface);
 
-    ink_cairo_surface_filter(surface, surface, srgb_to_linear_argb32);
+    ink_cairo_surface_filter(surface, surface, SurfaceSrgbToLinear());
 
     return width * height;
 }
 
-static uint32_t linear_to_srgb_argb32(uint32_t in)
+struct SurfaceLinearToSrgb
 {
-    EXTRACT_ARGB32(in, a, r, g, b);
-    if (a != 0) {
-        r = linear_to_srgb(r, a);
-        g = linear_to_srgb(g, a);
-        b = linear_to_srgb(b, a);
+    guint32 operator()(guint32 in)
+    {
+        return Inkscape::Display::linear_to_srgb_pixel(in);
     }
-    ASSEMBLE_ARGB32(out, a, r, g, b);
-    return out;
-}
+
+    void filter_row(guint32 const *in, guint32 *out, int n)
+    {
+        Inkscape::Display::linear_to_srgb_row(in, out, n);
+    }
+};
 
 SPBlendMode ink_cairo_operator_to_css_blend(cairo_operator_t cairo_operator)
 {
@@ -1492,7 +1544,7 @@ int ink_cairo_surface_linear_to_srgb(cairo_surface_t *surface)
     int width = cairo_image_surface_get_width(surface);
     int height = cairo_image_surface_get_height(surface);
 
-    ink_cairo_surface_filter(surface, surface, linear_to_srgb_argb32);
+    ink_cairo_surface_filter(surface, surface, SurfaceLinearToSrgb());
 
     return width * height;
 }
@@ -13,6 +13,7 @@
 #ifndef SEEN_INKSCAPE_DISPLAY_CAIRO_UTILS_H
 #define SEEN_INKSCAPE_DISPLAY_CAIRO_UTILS_H
 
+#include <memory>
 #include <2geom/forward.h>
 #include <cairomm/cairomm.h>
 #include "style.h"
@@ -48,6 +49,14 @@ public:
     cairo_surface_t *getSurfaceRaw() const;
     Cairo::RefPtr<Cairo::Surface> getSurface();
 
+    /**
+     * Get the image downscaled by 2^level in each direction, for drawing it at small sizes.
+     * The levels are built in the background on first use; until the requested one is ready,
+     * the finest one is returned instead and level is updated to match. Thread-safe.
+     * The pixbuf must be in the Cairo pixel format.
+     */
+    cairo_surface_t *getMipmap(int &level) const;
+
     int width() const;
     int height() const;
     int rowstride() const;
@@ -79,20 +88,19 @@ public:
     void _forceAlpha();
     void _setMimeData(guchar *data, gsize len, Glib::ustring const &format);
 
+    struct Mipmaps;
+
     GdkPixbuf *_pixbuf;
     cairo_surface_t *_surface;
     time_t _mod_time;
     std::string _path;
     PixelFormat _pixel_format;
     bool _cairo_store;
+    mutable std::shared_ptr<Mipmaps> _mipmaps; ///< Accessed atomically.
 };
 
 } // namespace Inkscape
 
-// Atomic accessors to global variable governing number of filter threads.
-int  get_num_filter_threads();
-void set_num_filter_threads(int);
-
 SPColorInterpolation get_cairo_surface_ci(cairo_surface_t *surface);
 void set_cairo_surface_ci(cairo_surface_t *surface, SPColorInterpolation cif);
 void copy_cairo_surface_ci(cairo_surface_t *in, cairo_surface_t *out);
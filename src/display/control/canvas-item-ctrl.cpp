@@ -23,6 +23,7 @@
 #include "display/cairo-utils.h" // argb32_from_rgba()
 
 #include "ui/widget/canvas.h"
+#include "util/cached_map.h"
 
 namespace Inkscape {
 
@@ -261,50 +262,144 @@ static inline uint32_t compose_xor(uint32_t bg, uint32_t fg, uint32_t a)
     return (c + 127) / 255;
 }
 
+namespace {
+
 /**
- * Render ctrl to screen via Cairo.
+ * Identifies the rasterised bitmap of a ctrl. Ctrls with equal keys, such as the thousands of
+ * nodes shown by the node tool, share a single bitmap.
  */
-void CanvasItemCtrl::_render(CanvasItemBuffer &buf) const
+struct SpriteKey
 {
-    _built.init([&, this] {
-        build_cache(buf.device_scale);
-    });
+    CanvasItemCtrlShape shape;
+    int width;
+    int height;
+    uint32_t fill;
+    uint32_t stroke;
+    int device_scale;
+    int angle; ///< Angle of rotated shapes, in multiples of a 1/ANGLE_BUCKETS turn.
+
+    bool operator==(SpriteKey const &other) const
+    {
+        return shape == other.shape && width == other.width && height == other.height && fill == other.fill &&
+               stroke == other.stroke && device_scale == other.device_scale && angle == other.angle;
+    }
+};
 
-    Geom::Point c = _bounds->min() - buf.rect.min();
-    int x = c.x(); // Must be pixel aligned.
-    int y = c.y();
+struct SpriteKeyHash
+{
+    std::size_t operator()(SpriteKey const &key) const
+    {
+        std::size_t hash = std::hash<int>()(key.shape);
+        for (std::size_t value : { (std::size_t)key.width, (std::size_t)key.height, (std::size_t)key.fill,
+                                   (std::size_t)key.stroke, (std::size_t)key.device_scale,
+                                   (std::size_t)key.angle }) {
+            hash = hash * 31 + value;
+        }
+        return hash;
+    }
+};
 
-    buf.cr->save();
+/// Rotated shapes are rendered at multiples of this fraction of a turn, so they can be shared.
+constexpr int ANGLE_BUCKETS = 1024;
 
-    // This code works regardless of source type.
+/// The bitmaps of all ctrls, shared by all canvases and render threads.
+auto &sprite_atlas()
+{
+    static Util::cached_map<SpriteKey, std::vector<uint32_t>, SpriteKeyHash> atlas(256);
+    return atlas;
+}
 
-    // 1. Copy the affected part of output to a temporary surface
+bool is_rotated(CanvasItemCtrlShape shape)
+{
+    switch (shape) {
+        case CANVAS_ITEM_CTRL_SHAPE_TRIANGLE:
+        case CANVAS_ITEM_CTRL_SHAPE_TRIANGLE_ANGLED:
+        case CANVAS_ITEM_CTRL_SHAPE_DARROW:
+        case CANVAS_ITEM_CTRL_SHAPE_SARROW:
+        case CANVAS_ITEM_CTRL_SHAPE_CARROW:
+        case CANVAS_ITEM_CTRL_SHAPE_PIVOT:
+        case CANVAS_ITEM_CTRL_SHAPE_SALIGN:
+        case CANVAS_ITEM_CTRL_SHAPE_CALIGN:
+        case CANVAS_ITEM_CTRL_SHAPE_MALIGN:
+            return true;
+        default:
+            return false;
+    }
+}
 
-    // Size in device pixels. Does not set device scale.
-    int width  = _width  * buf.device_scale;
-    int height = _height * buf.device_scale;
-    auto work = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
-    cairo_surface_set_device_scale(work->cobj(), buf.device_scale, buf.device_scale); // No C++ API!
+} // namespace
 
-    auto cr = Cairo::Context::create(work);
-    cr->translate(-_bounds->left(), -_bounds->top());
-    cr->set_source(buf.cr->get_target(), buf.rect.left(), buf.rect.top());
-    cr->paint();
-    // static int a = 0;
-    // std::string name0 = "ctrl0_" + _name + "_" + std::to_string(a++) + ".png";
-    // work->write_to_png(name0);
+/**
+ * Look up the bitmap of the ctrl in the atlas, rasterising it if not there yet.
+ */
+void CanvasItemCtrl::build_sprite(int device_scale) const
+{
+    if (_shape == CANVAS_ITEM_CTRL_SHAPE_BITMAP) {
+        // Not shared, as the pixbuf could be freed and another one allocated at the same address.
+        _sprite = build_cache(device_scale, _angle);
+        return;
+    }
+
+    int angle = 0;
+    if (is_rotated(_shape)) {
+        angle = (int)std::lround(_angle / (2 * M_PI) * ANGLE_BUCKETS) % ANGLE_BUCKETS;
+        if (angle < 0) {
+            angle += ANGLE_BUCKETS;
+        }
+    }
+
+    auto const key = SpriteKey{_shape, _width, _height, _fill, _stroke, device_scale, angle};
 
-    // 2. Composite the control on a temporary surface
-    work->flush();
-    int strideb = work->get_stride();
-    unsigned char *pxb = work->get_data();
+    auto &atlas = sprite_atlas();
+    _sprite = atlas.lookup(key);
+    if (!_sprite) {
+        _sprite = atlas.add(key, build_cache(device_scale, angle * 2 * M_PI / ANGLE_BUCKETS));
+    }
+}
+
+/**
+ * Render ctrl to screen.
+ */
+void CanvasItemCtrl::_render(CanvasItemBuffer &buf) const
+{
+    _built.init([&, this] {
+        build_sprite(buf.device_scale);
+    });
+
+    if (_sprite->empty()) {
+        return;
+    }
+
+    // The control is composited straight into the buffer, without a temporary surface per ctrl, as
+    // the buffer is always an image surface with no transform other than the device scale.
+    auto const target = cairo_get_target(buf.cr->cobj());
+    g_return_if_fail(cairo_surface_get_type(target) == CAIRO_SURFACE_TYPE_IMAGE);
+    cairo_surface_flush(target);
+
+    // Sizes and positions in device pixels.
+    int const width  = _width  * buf.device_scale;
+    int const height = _height * buf.device_scale;
+    int const left = (_bounds->left() - buf.rect.left()) * buf.device_scale;
+    int const top  = (_bounds->top()  - buf.rect.top())  * buf.device_scale;
+
+    // Clip to the buffer.
+    int const x0 = std::max(left, 0);
+    int const y0 = std::max(top,  0);
+    int const x1 = std::min(left + width,  cairo_image_surface_get_width(target));
+    int const y1 = std::min(top  + height, cairo_image_surface_get_height(target));
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    int strideb = cairo_image_surface_get_stride(target);
+    unsigned char *pxb = cairo_image_surface_get_data(target);
 
     // this code allow background become isolated from rendering so we can do things like outline overlay
     uint32_t backcolor = get_canvas()->get_effective_background();
-    uint32_t *p = _cache.get();
-    for (int i = 0; i < height; ++i) {
-        auto pb = reinterpret_cast<uint32_t*>(pxb + i * strideb);
-        for (int j = 0; j < width; ++j) {
+    for (int y = y0; y < y1; ++y) {
+        auto pb = reinterpret_cast<uint32_t*>(pxb + y * strideb) + x0;
+        uint32_t const *p = _sprite->data() + (y - top) * width + (x0 - left);
+        for (int x = x0; x < x1; ++x) {
             uint32_t base = *pb;
             uint32_t cc = *p++;
             uint32_t ac = cc & 0xff;
@@ -356,18 +451,8 @@ void CanvasItemCtrl::_render(CanvasItemBuffer &buf) const
             }
         }
     }
-    work->mark_dirty();
-    // std::string name1 = "ctrl1_" + _name + "_" + std::to_string(a) + ".png";
-    // work->write_to_png(name1);
-
-    // 3. Replace the affected part of output with contents of temporary surface
-    buf.cr->set_source(work, x, y);
-
-    buf.cr->rectangle(x, y, _width, _height);
-    buf.cr->clip();
-    buf.cr->set_operator(Cairo::OPERATOR_SOURCE);
-    buf.cr->paint();
-    buf.cr->restore();
+
+    cairo_surface_mark_dirty_rectangle(target, x0, y0, x1 - x0, y1 - y0);
 }
 
 void CanvasItemCtrl::set_fill(uint32_t fill)
@@ -893,10 +978,10 @@ static void draw_malign(Cairo::RefPtr<Cairo::Context> const &cr, double size)
     cr->close_path();
 }
 
-void CanvasItemCtrl::build_cache(int device_scale) const
+std::unique_ptr<std::vector<uint32_t>> CanvasItemCtrl::build_cache(int device_scale, double angle) const
 {
     if (_width < 2 || _height < 2) {
-        return; // Nothing to render
+        return std::make_unique<std::vector<uint32_t>>(); // Nothing to render
     }
 
     if (_shape != CANVAS_ITEM_CTRL_SHAPE_BITMAP) {
@@ -911,8 +996,8 @@ void CanvasItemCtrl::build_cache(int device_scale) const
     int height = _height * device_scale;
     int size = width * height;
 
-    _cache = std::make_unique<uint32_t[]>(size);
-    auto p = _cache.get();
+    auto cache = std::make_unique<std::vector<uint32_t>>(size);
+    auto p = cache->data();
 
     switch (_shape) {
         case CANVAS_ITEM_CTRL_SHAPE_SQUARE:
@@ -1026,7 +1111,7 @@ void CanvasItemCtrl::build_cache(int device_scale) const
 
             // Rotate around center
             cr->translate( size/2.0,  size/2.0);
-            cr->rotate(_angle);
+            cr->rotate(angle);
             cr->translate(-size/2.0, -size/2.0);
 
             // Construct path
@@ -1087,7 +1172,7 @@ void CanvasItemCtrl::build_cache(int device_scale) const
             work->flush();
             int strideb = work->get_stride();
             unsigned char* pxb = work->get_data();
-            auto p = _cache.get();
+            auto p = cache->data();
             for (int i = 0; i < device_scale * size; ++i) {
                 auto pb = reinterpret_cast<uint32_t*>(pxb + i * strideb);
                 for (int j = 0; j < width; ++j) {
@@ -1133,7 +1218,7 @@ void CanvasItemCtrl::build_cache(int device_scale) const
                         // Fill in device_scale x device_scale block
                         for (int i = 0; i < device_scale; ++i) {
                             for (int j = 0; j < device_scale; ++j) {
-                                auto p = _cache.get() +
+                                auto p = cache->data() +
                                     (x * device_scale + i) +            // Column
                                     (y * device_scale + j) * width;     // Row
                                 *p = color;
@@ -1143,7 +1228,7 @@ void CanvasItemCtrl::build_cache(int device_scale) const
                 }
             } else {
                 std::cerr << "CanvasItemCtrl::build_cache: No bitmap!" << std::endl;
-                auto p = _cache.get();
+                auto p = cache->data();
                 for (int y = 0; y < height/device_scale; y++){
                     for (int x = 0; x < width/device_scale; x++) {
                         if (x == y) {
@@ -1165,6 +1250,8 @@ void CanvasItemCtrl::build_cache(int device_scale) const
             std::cerr << "CanvasItemCtrl::build_cache: unhandled shape!" << std::endl;
             break;
     }
+
+    return cache;
 }
 
 } // namespace Inkscape
@@ -17,7 +17,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <2geom/point.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
@@ -68,14 +70,15 @@ protected:
     void _update(bool propagate) override;
     void _render(Inkscape::CanvasItemBuffer &buf) const override;
 
-    void build_cache(int device_scale) const;
+    void build_sprite(int device_scale) const;
+    std::unique_ptr<std::vector<uint32_t>> build_cache(int device_scale, double angle) const;
 
     // Geometry
     Geom::Point _position;
 
     // Display
     InitLock _built;
-    mutable std::unique_ptr<uint32_t[]> _cache;
+    mutable std::shared_ptr<std::vector<uint32_t> const> _sprite; ///< Shared with identical ctrls.
 
     // Properties
     CanvasItemCtrlType  _type  = CANVAS_ITEM_CTRL_TYPE_DEFAULT;
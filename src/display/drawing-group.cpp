@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+
 #include "drawing-group.h"
 #include "cairo-utils.h"
 #include "drawing-context.h"
@@ -18,6 +20,8 @@
 #include "drawing.h"
 #include "style.h"
 
+static constexpr auto CHILD_INDEX_THRESHOLD = 64; ///< Groups with fewer children are picked linearly.
+
 namespace Inkscape {
 
 DrawingGroup::DrawingGroup(Drawing &drawing)
@@ -71,9 +75,49 @@ unsigned DrawingGroup::_updateItem(Geom::IntRect const &area, UpdateContext cons
         _contains_unisolated_blend |= c.unisolatedBlend();
     }
 
+    _updateChildIndex();
+
     return STATE_ALL;
 }
 
+/**
+ * Bring the spatial index of children up to date with their bounding boxes.
+ * The index is only rebuilt if a child was added, removed, reordered or changed its boxes
+ * since the last update, so repeated updates of an unchanged group stay linear.
+ */
+void DrawingGroup::_updateChildIndex()
+{
+    // Glyphs are picked by their own pick box rather than their bbox, so text is never indexed.
+    if (_children.size() < CHILD_INDEX_THRESHOLD || is<DrawingText>(this)) {
+        _child_index.clear();
+        _indexed_children.clear();
+        return;
+    }
+
+    // Index the union of bbox and drawbox, since pick() tests either depending on flags.
+    std::vector<std::pair<DrawingItem*, Geom::OptIntRect>> current;
+    current.reserve(_children.size());
+    for (auto &c : _children) {
+        auto box = c.bbox();
+        box.unionWith(c.drawbox());
+        current.emplace_back(&c, box);
+    }
+
+    if (current == _indexed_children) {
+        return;
+    }
+
+    std::vector<Util::PackedRTree<unsigned>::Entry> entries;
+    entries.reserve(current.size());
+    for (unsigned i = 0; i < current.size(); i++) {
+        if (auto const &box = current[i].second) {
+            entries.emplace_back(*box, i);
+        }
+    }
+    _child_index.build(std::move(entries));
+    _indexed_children = std::move(current);
+}
+
 unsigned DrawingGroup::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const
 {
     if (!stop_at) {
@@ -108,6 +152,22 @@ void DrawingGroup::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRec
 
 DrawingItem *DrawingGroup::_pickItem(Geom::Point const &p, double delta, unsigned flags)
 {
+    if (!_indexed_children.empty()) {
+        // Only children whose boxes are near the point can be picked; test those in z-order.
+        // The extra pixel of slack guards against rounding differences with DrawingItem::pick().
+        auto area = Geom::Rect(p, p);
+        area.expandBy(delta + 1.0);
+        auto candidates = _child_index.collect(area);
+        std::sort(candidates.begin(), candidates.end());
+        for (auto i : candidates) {
+            DrawingItem *picked = _indexed_children[i].first->pick(p, delta, flags);
+            if (picked) {
+                return _pick_children ? picked : this;
+            }
+        }
+        return nullptr;
+    }
+
     for (auto &i : _children) {
         DrawingItem *picked = i.pick(p, delta, flags);
         if (picked) {
@@ -13,7 +13,10 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_GROUP_H
 #define INKSCAPE_DISPLAY_DRAWING_GROUP_H
 
+#include <vector>
+
 #include "display/drawing-item.h"
+#include "util/packed-rtree.h"
 
 namespace Inkscape {
 
@@ -38,7 +41,14 @@ protected:
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
     bool _canClip() const override { return true; }
 
+    void _updateChildIndex();
+
     std::unique_ptr<Geom::Affine> _child_transform;
+
+    /// Spatial index of the children's pick boxes, used by large groups to avoid linear picking.
+    /// Values are positions in _indexed_children, which holds the children in z-order.
+    Util::PackedRTree<unsigned> _child_index;
+    std::vector<std::pair<DrawingItem*, Geom::OptIntRect>> _indexed_children;
 };
 
 } // namespace Inkscape
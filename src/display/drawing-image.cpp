@@ -10,6 +10,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cmath>
 #include <2geom/bezier-curve.h>
 
 #include "drawing.h"
@@ -116,11 +117,6 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
 
         dc.translate(_origin);
         dc.scale(_scale);
-        // const_cast required since Cairo needs to modify the internal refcount variable, but we do not want to give up the
-        // benefits of const for the rest of our code. The underlying object is guaranteed to be non-const, so this is well-defined.
-        // It is also thread-safe to modify the refcount in this way, since Cairo uses atomics internally.
-        dc.setSource(const_cast<cairo_surface_t*>(_pixbuf->getSurfaceRaw()), 0, 0);
-        dc.patternSetExtend(CAIRO_EXTEND_PAD);
 
         // See: http://www.w3.org/TR/SVG/painting.html#ImageRenderingProperty
         //      https://drafts.csswg.org/css-images-3/#the-image-rendering
@@ -129,21 +125,38 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
         // CSS 3 defines:
         //   'optimizeSpeed' as alias for "pixelated"
         //   'optimizeQuality' as alias for "smooth"
+        bool smooth;
         switch (style_image_rendering) {
             case SP_CSS_IMAGE_RENDERING_OPTIMIZESPEED:
             case SP_CSS_IMAGE_RENDERING_PIXELATED:
             // we don't have an implementation for crisp-edges, but it should *not* smooth or blur
             case SP_CSS_IMAGE_RENDERING_CRISPEDGES:
-                dc.patternSetFilter( CAIRO_FILTER_NEAREST );
+                smooth = false;
                 break;
             case SP_CSS_IMAGE_RENDERING_AUTO:
             case SP_CSS_IMAGE_RENDERING_OPTIMIZEQUALITY:
             default:
-                // In recent Cairo, BEST used Lanczos3, which is prohibitively slow
-                dc.patternSetFilter( CAIRO_FILTER_GOOD );
+                smooth = true;
                 break;
         }
 
+        // When drawn smaller than half size, use the mip level closest to the displayed size
+        // from above, rather than resampling the whole image for every tile.
+        int level = smooth ? _mipLevel(dc) : 0;
+        // const_cast required since Cairo needs to modify the internal refcount variable, but we do not want to give up the
+        // benefits of const for the rest of our code. The underlying object is guaranteed to be non-const, so this is well-defined.
+        // It is also thread-safe to modify the refcount in this way, since Cairo uses atomics internally.
+        auto surface = const_cast<cairo_surface_t*>(_pixbuf->getMipmap(level));
+        if (level > 0) {
+            dc.scale(static_cast<double>(_pixbuf->width()) / cairo_image_surface_get_width(surface),
+                     static_cast<double>(_pixbuf->height()) / cairo_image_surface_get_height(surface));
+        }
+        dc.setSource(surface, 0, 0);
+        dc.patternSetExtend(CAIRO_EXTEND_PAD);
+
+        // In recent Cairo, BEST used Lanczos3, which is prohibitively slow
+        dc.patternSetFilter(smooth ? CAIRO_FILTER_GOOD : CAIRO_FILTER_NEAREST);
+
         // Handle an exceptional case where the greyscale color mode needs to be applied per-image.
         bool const greyscale_exception = (flags & RENDER_OUTLINE) && _drawing.colorMode() == ColorMode::GRAYSCALE;
         if (greyscale_exception) {
@@ -191,6 +204,28 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
     return RENDER_OK;
 }
 
+/**
+ * The mip level of the pixbuf to draw with the current transform of the context.
+ */
+int DrawingImage::_mipLevel(DrawingContext &dc) const
+{
+    double xx = 1, xy = 0, yx = 0, yy = 1;
+    dc.user_to_device_distance(xx, xy);
+    dc.user_to_device_distance(yx, yy);
+    double device_scale = 1;
+    cairo_surface_get_device_scale(dc.rawTarget(), &device_scale, nullptr);
+
+    return mipLevel(std::max(std::hypot(xx, xy), std::hypot(yx, yy)) * device_scale);
+}
+
+int DrawingImage::mipLevel(double pixel_size)
+{
+    if (!(pixel_size > 0) || pixel_size >= 0.5) {
+        return 0;
+    }
+    return static_cast<int>(std::floor(std::log2(1 / pixel_size)));
+}
+
 /** Calculates the closest distance from p to the segment a1-a2*/
 static double distance_to_segment(Geom::Point const &p, Geom::Point const &a1, Geom::Point const &a2)
 {
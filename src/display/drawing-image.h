@@ -38,6 +38,12 @@ public:
     void setClipbox(Geom::Rect const &box);
     Geom::Rect bounds() const;
 
+    /**
+     * The mip level to draw an image with when each of its pixels spans pixel_size device pixels:
+     * the coarsest one whose pixels are no larger than device pixels, if drawn below half size.
+     */
+    static int mipLevel(double pixel_size);
+
 protected:
     ~DrawingImage() override = default;
 
@@ -45,6 +51,8 @@ protected:
     unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
 
+    int _mipLevel(DrawingContext &dc) const;
+
     std::shared_ptr<Inkscape::Pixbuf const> _pixbuf;
 
     SPImageRendering style_image_rendering;
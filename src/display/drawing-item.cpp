@@ -10,7 +10,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <chrono>
 #include <climits>
+#include <ostream>
 
 #include "display/drawing-context.h"
 #include "display/drawing-group.h"
@@ -41,6 +43,53 @@ struct CacheData
     mutable std::optional<DrawingCache> surface;
 };
 
+namespace {
+
+/// Adds the time elapsed during its lifetime to a RenderStats counter, unless given null.
+class StatsTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StatsTimer(std::atomic<std::uint64_t> *counter)
+        : _counter(counter)
+    {
+        if (_counter) _start = Clock::now();
+    }
+
+    ~StatsTimer()
+    {
+        if (_counter) *_counter += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _start).count();
+    }
+
+    StatsTimer(StatsTimer const &) = delete;
+    StatsTimer &operator=(StatsTimer const &) = delete;
+
+private:
+    std::atomic<std::uint64_t> *_counter;
+    Clock::time_point _start;
+};
+
+/// Write a string as a JSON string literal.
+void write_json_string(std::ostream &os, char const *str)
+{
+    os << '"';
+    for (; *str; str++) {
+        auto const c = static_cast<unsigned char>(*str);
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (c < 0x20) {
+            static char const hex[] = "0123456789abcdef";
+            os << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+} // namespace
+
 /**
  * @class DrawingItem
  * SVG drawing item for display.
@@ -415,6 +464,8 @@ void DrawingItem::setZOrder(unsigned zorder)
         std::advance(it2, std::min<unsigned>(zorder, _parent->_children.size()));
         _parent->_children.insert(it2, *this);
         _markForRendering();
+        // The parent's child index stores z-order positions, so it must be refreshed.
+        _parent->_markForUpdate(STATE_PICK, false);
     });
 }
 
@@ -484,6 +535,10 @@ void DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, un
     // compute which elements need an update
     unsigned to_update = _state ^ flags;
 
+    if (to_update & STATE_BBOX) {
+        _drawing._bbox_generation++;
+    }
+
     // this needs to be called before we recurse into children
     if (to_update & STATE_BACKGROUND) {
         _background_accumulate = _background_new;
@@ -748,6 +803,11 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
         return RENDER_OK;
     }
 
+    bool const record_stats = _drawing.recordStats();
+    if (record_stats) {
+        _stats.renders++;
+    }
+
     // Device scale for HiDPI screens (typically 1 or 2)
     int const device_scale = dc.surface()->device_scale();
 
@@ -765,6 +825,9 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
             dc.setOperator(ink_css_blend_to_cairo_operator(_blend_mode));
             _cache->surface->paintFromCache(dc, carea, forcecache);
             if (!carea) {
+                if (record_stats) {
+                    _stats.cache_hits++;
+                }
                 dc.setSource(0, 0, 0, 0);
                 return RENDER_OK;
             }
@@ -778,6 +841,10 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
             _cache->surface.emplace(*cl, device_scale);
         }
 
+        if (record_stats) {
+            _stats.cache_misses++;
+        }
+
         if (!forcecache) {
             lock.unlock(); // Only hold the lock for the full duration of rendering for filters.
         }
@@ -820,6 +887,7 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     if ((flags & RENDER_FILTER_BACKGROUND) || !needs_intermediate_rendering) {
         dc.setOperator(ink_css_blend_to_cairo_operator(SP_CSS_BLEND_NORMAL));
         apply_antialias(dc, antialias);
+        auto timer = StatsTimer(record_stats ? &_stats.render_ns : nullptr);
         return _renderItem(dc, rc, *carea, flags & ~RENDER_FILTER_BACKGROUND, stop_at);
     }
 
@@ -872,10 +940,14 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     // 3. Render object itself
     ict.pushGroup();
     apply_antialias(ict, antialias);
-    render_result = _renderItem(ict, rc, *carea, flags, stop_at);
+    {
+        auto timer = StatsTimer(record_stats ? &_stats.render_ns : nullptr);
+        render_result = _renderItem(ict, rc, *carea, flags, stop_at);
+    }
 
     // 4. Apply filter.
     if (_filter && render_filters) {
+        auto timer = StatsTimer(record_stats ? &_stats.filter_ns : nullptr);
         bool rendered = false;
         if (_filter->uses_background() && _background_accumulate) {
             auto bg_root = this;
@@ -1098,6 +1170,63 @@ void DrawingItem::recursivePrintTree(unsigned level) const
     }
 }
 
+size_t DrawingItem::cachedBytes() const
+{
+    if (!_cache) {
+        return 0;
+    }
+    auto lock = std::lock_guard(_cache->mutables);
+    if (!_cache->surface) {
+        return 0;
+    }
+    auto const pixels = _cache->surface->pixels();
+    return size_t{4} * pixels.x() * pixels.y();
+}
+
+void DrawingItem::recursiveResetStats()
+{
+    _stats.renders = 0;
+    _stats.cache_hits = 0;
+    _stats.cache_misses = 0;
+    _stats.render_ns = 0;
+    _stats.filter_ns = 0;
+
+    for (auto &i : _children) {
+        i.recursiveResetStats();
+    }
+    for (auto i : {_clip, _mask, static_cast<DrawingItem *>(_fill_pattern), static_cast<DrawingItem *>(_stroke_pattern)}) {
+        if (i) i->recursiveResetStats();
+    }
+}
+
+// For debugging: Write the render counters of the subtree as a comma-separated sequence of JSON
+// objects in depth-first order, for the items array written by Drawing::writeStats().
+void DrawingItem::recursiveWriteStats(std::ostream &os, unsigned depth, char const *role) const
+{
+    if (depth > 0) {
+        os << ",";
+    }
+    os << "\n    {\"id\": ";
+    write_json_string(os, name().c_str());
+    os << ", \"role\": \"" << role << "\""
+       << ", \"depth\": " << depth
+       << ", \"renders\": " << _stats.renders
+       << ", \"cache_hits\": " << _stats.cache_hits
+       << ", \"cache_misses\": " << _stats.cache_misses
+       << ", \"render_ms\": " << _stats.render_ns / 1e6
+       << ", \"filter_ms\": " << _stats.filter_ns / 1e6
+       << ", \"cached_bytes\": " << cachedBytes()
+       << "}";
+
+    if (_clip) _clip->recursiveWriteStats(os, depth + 1, "clip");
+    if (_mask) _mask->recursiveWriteStats(os, depth + 1, "mask");
+    if (_fill_pattern) _fill_pattern->recursiveWriteStats(os, depth + 1, "fill");
+    if (_stroke_pattern) _stroke_pattern->recursiveWriteStats(os, depth + 1, "stroke");
+    for (auto &i : _children) {
+        i.recursiveWriteStats(os, depth + 1);
+    }
+}
+
 /**
  * Marks the current visual bounding box of the item for redrawing.
  * This is called whenever the object changes its visible appearance.
@@ -13,6 +13,9 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_ITEM_H
 #define INKSCAPE_DISPLAY_DRAWING_ITEM_H
 
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <list>
 #include <exception>
@@ -70,6 +73,16 @@ struct CacheRecord : boost::totally_ordered<CacheRecord>
 };
 using CacheList = std::list<CacheRecord>;
 
+/// Counters of rendering activity, recorded while Drawing::recordStats() is set. For profiling.
+struct RenderStats
+{
+    std::atomic<std::uint64_t> renders = 0;      ///< Calls to render() that had something to draw.
+    std::atomic<std::uint64_t> cache_hits = 0;   ///< Renders drawn entirely from the cache.
+    std::atomic<std::uint64_t> cache_misses = 0; ///< Renders of a cached item that had to draw.
+    std::atomic<std::uint64_t> render_ns = 0;    ///< Time spent in _renderItem(), including children.
+    std::atomic<std::uint64_t> filter_ns = 0;    ///< Time spent applying the filter.
+};
+
 struct InvalidItemException : std::exception
 {
     char const *what() const noexcept override { return "Invalid item in drawing"; }
@@ -162,6 +175,10 @@ public:
     Glib::ustring name() const; // For debugging
     void recursivePrintTree(unsigned level = 0) const;  // For debugging
 
+    size_t cachedBytes() const; ///< Size of the cache surface, or 0 if not cached.
+    void recursiveResetStats();
+    void recursiveWriteStats(std::ostream &os, unsigned depth = 0, char const *role = "child") const;
+
 protected:
     enum class ChildType : unsigned char
     {
@@ -226,6 +243,7 @@ protected:
     DrawingPattern *_stroke_pattern;
     std::unique_ptr<Inkscape::Filters::Filter> _filter;
     std::unique_ptr<CacheData> _cache;
+    mutable RenderStats _stats;
     int _update_complexity = 0;
     bool _contains_unisolated_blend : 1;
 
@@ -1,5 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #include "drawing-paintserver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "async/scheduler.h"
 #include "cairo-utils.h"
 
 namespace Inkscape {
@@ -109,12 +116,303 @@ cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRec
     return pat;
 }
 
-cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity) const
+namespace {
+
+/// Largest mesh rasterisation, in pixels, and along either side; a mesh that would need more
+/// at device resolution is rasterised at a lower one and scaled up.
+constexpr int MESH_RASTER_MAX_PIXELS = 2048 * 2048;
+constexpr int MESH_RASTER_MAX_SIDE = 8192;
+
+/// Bound on the number of grid cells the patches of a mesh are subdivided into.
+constexpr int MESH_MAX_CELLS = 1 << 20;
+
+/// Height in pixels of the bands rasterised in parallel.
+constexpr int MESH_BAND_HEIGHT = 32;
+
+/// A vertex of the subdivided mesh, in pixels, with its premultiplied colour.
+struct MeshVertex
+{
+    float x, y;
+    std::array<float, 4> color;
+};
+
+/**
+ * Write the pixels whose centres lie in the triangle abc, within the rows [y0, y1), interpolating
+ * the colours of its vertices. Pixels are replaced rather than composited, as Cairo does for the
+ * patches of a mesh.
+ */
+void rasterise_triangle(MeshVertex const &a, MeshVertex const &b, MeshVertex const &c,
+                        unsigned char *data, int stride, int width, int y0, int y1)
+{
+    float const area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+
+    int const xmin = std::max(0, (int)std::floor(std::min({a.x, b.x, c.x}) - 0.5f));
+    int const xmax = std::min(width - 1, (int)std::ceil(std::max({a.x, b.x, c.x}) - 0.5f));
+    int const ymin = std::max(y0, (int)std::floor(std::min({a.y, b.y, c.y}) - 0.5f));
+    int const ymax = std::min(y1 - 1, (int)std::ceil(std::max({a.y, b.y, c.y}) - 0.5f));
+
+    // Allow for rounding, so that no gaps open between the triangles of a grid.
+    constexpr float eps = -1e-4f;
+
+    for (int y = ymin; y <= ymax; y++) {
+        auto const row = reinterpret_cast<std::uint32_t *>(data + y * stride);
+        float const py = y + 0.5f;
+        for (int x = xmin; x <= xmax; x++) {
+            float const px = x + 0.5f;
+            float const wa = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+            float const wb = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+            float const wc = 1.0f - wa - wb;
+            if (wa < eps || wb < eps || wc < eps) {
+                continue;
+            }
+            std::uint32_t channels[4];
+            for (int k = 0; k < 4; k++) {
+                float const v = wa * a.color[k] + wb * b.color[k] + wc * c.color[k];
+                channels[k] = (std::uint32_t)std::clamp(v * 255.0f + 0.5f, 0.0f, 255.0f);
+            }
+            // Channels above alpha would be invalid premultiplied pixels.
+            for (int k = 0; k < 3; k++) {
+                channels[k] = std::min(channels[k], channels[3]);
+            }
+            row[x] = (channels[3] << 24) | (channels[0] << 16) | (channels[1] << 8) | channels[2];
+        }
+    }
+}
+
+} // namespace
+
+DrawingMeshGradient::DrawingMeshGradient(SPGradientSpread spread, SPGradientUnits units, Geom::Affine const &transform,
+                                         int rows, int cols, std::vector<std::vector<PatchData>> patchdata)
+    : DrawingGradient(spread, units, transform)
+    , rows(rows)
+    , cols(cols)
+    , patchdata(std::move(patchdata))
+{
+    // Convert the patches to tensor-product surfaces as Cairo does, which saves doing so whenever
+    // the mesh is rasterised again.
+    tensors.reserve(rows * cols);
+    for (auto const &row : this->patchdata) {
+        for (auto const &data : row) {
+            auto &t = tensors.emplace_back();
+            auto &p = t.points;
+
+            // The boundary, going round the corners at [0][0], [0][3], [3][3] and [3][0].
+            Geom::Point *side[4][4] = {
+                {&p[0][0], &p[0][1], &p[0][2], &p[0][3]},
+                {&p[0][3], &p[1][3], &p[2][3], &p[3][3]},
+                {&p[3][3], &p[3][2], &p[3][1], &p[3][0]},
+                {&p[3][0], &p[2][0], &p[1][0], &p[0][0]}
+            };
+            for (int k = 0; k < 4; k++) {
+                auto const &start = data.points[k][0];
+                auto const &end = data.points[k][3];
+                *side[k][0] = start;
+                *side[k][3] = end;
+                if (data.pathtype[k] == 'c' || data.pathtype[k] == 'C') {
+                    *side[k][1] = data.points[k][1];
+                    *side[k][2] = data.points[k][2];
+                } else {
+                    *side[k][1] = Geom::lerp(1.0 / 3.0, start, end);
+                    *side[k][2] = Geom::lerp(2.0 / 3.0, start, end);
+                }
+            }
+
+            // The interior control points next to each corner, given or as for a Coons patch.
+            int const corners[4][2] = {{0, 0}, {0, 3}, {3, 3}, {3, 0}};
+            for (int k = 0; k < 4; k++) {
+                auto const [ci, cj] = corners[k];
+                auto const i = [ci = ci] (int n) { return ci ? 3 - n : n; };
+                auto const j = [cj = cj] (int n) { return cj ? 3 - n : n; };
+                if (data.tensorIsSet[k]) {
+                    p[i(1)][j(1)] = data.tensorpoints[k];
+                } else {
+                    p[i(1)][j(1)] = (-4.0 * p[i(0)][j(0)]
+                                     + 6.0 * (p[i(0)][j(1)] + p[i(1)][j(0)])
+                                     - 2.0 * (p[i(0)][j(3)] + p[i(3)][j(0)])
+                                     + 3.0 * (p[i(3)][j(1)] + p[i(1)][j(3)])
+                                     - p[i(3)][j(3)]) / 9.0;
+                }
+            }
+
+            for (int k = 0; k < 4; k++) {
+                auto const alpha = (float)data.opacity[k];
+                t.color[k] = {data.color[k][0] * alpha, data.color[k][1] * alpha, data.color[k][2] * alpha, alpha};
+            }
+
+            for (auto const &point_row : p) {
+                for (auto const &point : point_row) {
+                    tensor_bounds.expandTo(point);
+                }
+            }
+        }
+    }
+}
+
+cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const
 {
 #ifdef MESH_DEBUG
     std::cout << "sp_meshgradient_create_pattern: " << bbox << " " << opacity << std::endl;
 #endif
 
+    Geom::Affine gs2user = transform;
+    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
+        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
+        gs2user *= bbox2user;
+    }
+
+    // Vector backends, such as PDF export, get the mesh itself rather than a bitmap of it.
+    if (!tensor_bounds || !ct || cairo_surface_get_type(cairo_get_target(ct)) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return create_mesh_pattern(gs2user, opacity);
+    }
+
+    // Rasterise in gradient space, with as many pixels per unit as the device has.
+    cairo_matrix_t ctm;
+    cairo_get_matrix(ct, &ctm);
+    Geom::Affine user2device;
+    ink_matrix_to_2geom(user2device, ctm);
+    double device_scale_x, device_scale_y;
+    cairo_surface_get_device_scale(cairo_get_target(ct), &device_scale_x, &device_scale_y);
+    user2device *= Geom::Scale(device_scale_x, device_scale_y);
+    auto const gs2device = gs2user * user2device;
+    double scale_x = gs2device.expansionX();
+    double scale_y = gs2device.expansionY();
+    if (!(scale_x > 0 && scale_y > 0 && std::isfinite(scale_x) && std::isfinite(scale_y))) {
+        return create_mesh_pattern(gs2user, opacity);
+    }
+
+    // Colours vary smoothly across a mesh, so little is lost by capping the resolution, as for a
+    // mesh much larger than the screen when zoomed in, and letting Cairo interpolate the pixels.
+    double const mesh_width = std::max(tensor_bounds->width(), 1e-6);
+    double const mesh_height = std::max(tensor_bounds->height(), 1e-6);
+    scale_x = std::min(scale_x, (MESH_RASTER_MAX_SIDE - 2) / mesh_width);
+    scale_y = std::min(scale_y, (MESH_RASTER_MAX_SIDE - 2) / mesh_height);
+    auto const raster_pixels = [&] {
+        return (std::ceil(mesh_width * scale_x) + 2) * (std::ceil(mesh_height * scale_y) + 2);
+    };
+    while (raster_pixels() > MESH_RASTER_MAX_PIXELS) {
+        double const shrink = std::min(std::sqrt(MESH_RASTER_MAX_PIXELS / raster_pixels()), 0.99);
+        scale_x *= shrink;
+        scale_y *= shrink;
+    }
+    auto const scale = Geom::Scale(scale_x, scale_y);
+
+    // The pattern owns the raster, which is freed with the items' cached patterns.
+    auto surface = rasterise(scale, opacity);
+    auto pat = cairo_pattern_create_for_surface(surface);
+    cairo_surface_destroy(surface);
+
+    // Pixels of the raster have a margin of one around the bounds of the mesh.
+    auto const gs2raster = Geom::Translate(-tensor_bounds->min()) * scale * Geom::Translate(1, 1);
+    ink_cairo_pattern_set_matrix(pat, gs2user.inverse() * gs2raster);
+
+    return pat;
+}
+
+cairo_surface_t *DrawingMeshGradient::rasterise(Geom::Scale const &scale, double opacity) const
+{
+    int const width = std::ceil(tensor_bounds->width() * scale[Geom::X]) + 2;
+    int const height = std::ceil(tensor_bounds->height() * scale[Geom::Y]) + 2;
+    auto const gs2raster = Geom::Translate(-tensor_bounds->min()) * scale * Geom::Translate(1, 1);
+
+    // Subdivide all patches equally, so that neighbouring patches meet at the same vertices, into
+    // cells of a few pixels across that are then shaded linearly.
+    double extent = 0;
+    for (auto const &t : tensors) {
+        Geom::Rect r(t.points[0][0] * gs2raster, t.points[0][0] * gs2raster);
+        for (auto const &row : t.points) {
+            for (auto const &point : row) {
+                r.expandTo(point * gs2raster);
+            }
+        }
+        extent = std::max(extent, r.maxExtent());
+    }
+    int n = std::clamp((int)std::ceil(extent / 4), 1, 64);
+    while (n > 1 && (std::size_t)n * n * tensors.size() > MESH_MAX_CELLS) {
+        n /= 2;
+    }
+
+    std::vector<std::array<float, 4>> basis(n + 1);
+    for (int i = 0; i <= n; i++) {
+        float const s = (float)i / n;
+        float const r = 1 - s;
+        basis[i] = {r * r * r, 3 * s * r * r, 3 * s * s * r, s * s * s};
+    }
+
+    int const stride_v = n + 1;
+    std::vector<MeshVertex> vertices(tensors.size() * stride_v * stride_v);
+    Async::Scheduler::get().parallel_for(0, (int)tensors.size(), [&] (int k) {
+        auto const &t = tensors[k];
+        auto vertex = vertices.begin() + k * stride_v * stride_v;
+        for (int i = 0; i <= n; i++) {
+            float const v = (float)i / n;
+            for (int j = 0; j <= n; j++, ++vertex) {
+                float const u = (float)j / n;
+                Geom::Point point;
+                for (int r = 0; r < 4; r++) {
+                    for (int c = 0; c < 4; c++) {
+                        point += basis[i][r] * basis[j][c] * t.points[r][c];
+                    }
+                }
+                point *= gs2raster;
+                vertex->x = point.x();
+                vertex->y = point.y();
+                for (int ch = 0; ch < 4; ch++) {
+                    vertex->color[ch] = opacity * ((1 - u) * (1 - v) * t.color[0][ch] + u * (1 - v) * t.color[1][ch]
+                                                   + u * v * t.color[2][ch] + (1 - u) * v * t.color[3][ch]);
+                }
+            }
+        }
+    });
+
+    // Sort the cells, in painting order, into the bands of rows they touch.
+    int const bands = (height + MESH_BAND_HEIGHT - 1) / MESH_BAND_HEIGHT;
+    std::vector<std::vector<int>> band_cells(bands);
+    for (int k = 0; k < (int)tensors.size(); k++) {
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                int const first = (k * stride_v + i) * stride_v + j;
+                float ymin = vertices[first].y;
+                float ymax = ymin;
+                for (int corner : {first + 1, first + stride_v, first + stride_v + 1}) {
+                    ymin = std::min(ymin, vertices[corner].y);
+                    ymax = std::max(ymax, vertices[corner].y);
+                }
+                int const band_min = std::clamp((int)std::floor(ymin - 0.5f) / MESH_BAND_HEIGHT, 0, bands - 1);
+                int const band_max = std::clamp((int)std::ceil(ymax - 0.5f) / MESH_BAND_HEIGHT, 0, bands - 1);
+                for (int b = band_min; b <= band_max; b++) {
+                    band_cells[b].push_back(first);
+                }
+            }
+        }
+    }
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_surface_flush(surface);
+    auto const data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+
+    Async::Scheduler::get().parallel_for(0, bands, [&] (int b) {
+        int const y0 = b * MESH_BAND_HEIGHT;
+        int const y1 = std::min(y0 + MESH_BAND_HEIGHT, height);
+        for (int first : band_cells[b]) {
+            auto const &v00 = vertices[first];
+            auto const &v01 = vertices[first + 1];
+            auto const &v10 = vertices[first + stride_v];
+            auto const &v11 = vertices[first + stride_v + 1];
+            rasterise_triangle(v00, v01, v11, data, stride, width, y0, y1);
+            rasterise_triangle(v00, v11, v10, data, stride, width, y0, y1);
+        }
+    });
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+cairo_pattern_t *DrawingMeshGradient::create_mesh_pattern(Geom::Affine const &gs2user, double opacity) const
+{
     auto pat = cairo_pattern_create_mesh();
 
     for (int i = 0; i < rows; i++) {
@@ -160,11 +458,6 @@ cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect co
     }
 
     // set pattern transform matrix
-    Geom::Affine gs2user = transform;
-    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
-        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
-        gs2user *= bbox2user;
-    }
     ink_cairo_pattern_set_matrix(pat, gs2user.inverse());
 
     return pat;
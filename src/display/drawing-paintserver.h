@@ -16,6 +16,7 @@
 #include <cairo.h>
 #include <2geom/rect.h>
 #include <2geom/affine.h>
+#include <2geom/transforms.h>
 #include "object/sp-gradient-spread.h"
 #include "object/sp-gradient-units.h"
 #include "object/sp-gradient-vector.h"
@@ -43,7 +44,8 @@ public:
     /// Return whether this paint server could benefit from dithering.
     virtual bool ditherable() const { return false; }
 
-    /// Return whether create_pattern() uses its cairo_t argument. Such pattern cannot be cached, but recreated each time.
+    /// Return whether create_pattern() uses its cairo_t argument. NRStyle still caches such a pattern until the item is
+    /// next updated, so it must remain valid for any area drawn with the same transform.
     /// Fixme: The only reson this exists is to work around https://gitlab.freedesktop.org/cairo/cairo/-/issues/146.
     virtual bool uses_cairo_ctx() const { return false; }
 };
@@ -157,18 +159,34 @@ public:
     };
 
     DrawingMeshGradient(SPGradientSpread spread, SPGradientUnits units, Geom::Affine const &transform,
-                        int rows, int cols, std::vector<std::vector<PatchData>> patchdata)
-        : DrawingGradient(spread, units, transform)
-        , rows(rows)
-        , cols(cols)
-        , patchdata(std::move(patchdata)) {}
+                        int rows, int cols, std::vector<std::vector<PatchData>> patchdata);
 
-    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity) const override;
+    /**
+     * Produce a surface pattern holding the mesh rasterised at the resolution of the device
+     * transform of ct, or a lower one if that would take too much memory. A Cairo mesh pattern is
+     * produced instead if ct doesn't draw to an image surface, so that vector output keeps the mesh.
+     */
+    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const override;
+
+    bool uses_cairo_ctx() const override { return true; }
 
 private:
+    /// A patch as the control points of a bicubic tensor-product Bezier surface.
+    struct Tensor
+    {
+        Geom::Point points[4][4]; ///< Indexed by v, then u, with the first corner at [0][0].
+        std::array<float, 4> color[4]; ///< Premultiplied RGBA of the corners at [0][0], [0][3], [3][3], [3][0].
+    };
+
+    cairo_pattern_t *create_mesh_pattern(Geom::Affine const &gs2user, double opacity) const;
+    cairo_surface_t *rasterise(Geom::Scale const &scale, double opacity) const;
+
     int rows;
     int cols;
     std::vector<std::vector<PatchData>> patchdata;
+
+    std::vector<Tensor> tensors; ///< The patches, computed once as the gradient is built.
+    Geom::OptRect tensor_bounds; ///< Bounds of the control points of all patches.
 };
 
 } // namespace Inkscape
@@ -12,6 +12,7 @@
 
 #include <cairomm/region.h>
 #include <cairo.h>
+#include "async/scheduler.h"
 #include "cairo-utils.h"
 #include "display/drawing-item.h"
 #include "drawing-context.h"
@@ -36,6 +37,11 @@ DrawingPattern::DrawingPattern(Drawing &drawing)
 {
 }
 
+DrawingPattern::~DrawingPattern()
+{
+    _dropPatternCache();
+}
+
 void DrawingPattern::setPatternToUserTransform(Geom::Affine const &transform)
 {
     defer([=] {
@@ -79,7 +85,6 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
 
     // Calculate various transforms.
     auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions()); // AKA user_to_tile.
-    auto const idt = dt.inverse();
     auto const pattern_to_tile = _pattern_to_user ? _pattern_to_user->inverse() * dt : dt;
     auto const screen_to_tile = _ctm.inverse() * pattern_to_tile;
 
@@ -95,28 +100,6 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
         return rect;
     };
 
-    // Return whether the periodic tiling of a contains the periodic tiling of b.
-    auto wrapped_contains = [&] (Geom::IntRect const &a, Geom::IntRect const &b) {
-        auto check = [&] (int i) {
-            int const period = _pattern_resolution[i];
-            if (a[i].extent() >= period) return true;
-            if (b[i].extent() > a[i].extent()) return false;
-            return Util::rounddown(b[i].min() - a[i].min(), period) >= b[i].max() - a[i].max();
-        };
-        return check(0) && check(1);
-    };
-
-    // Return whether the periodic tiling of a intersects with or touches the periodic tiling of b.
-    auto wrapped_touches = [&] (Geom::IntRect const &a, Geom::IntRect const &b) {
-        auto check = [&] (int i) {
-            int const period = _pattern_resolution[i];
-            if (a[i].extent() >= period) return true;
-            if (b[i].extent() >= period) return true;
-            return Util::rounddown(b[i].max() - a[i].min(), period) >= b[i].min() - a[i].max();
-        };
-        return check(0) && check(1);
-    };
-
     // Calculate the minimum and maximum translates of a that overlap with b.
     auto overlapping_translates = [&, this] (Geom::IntRect const &a, Geom::IntRect const &b) {
         Geom::IntPoint min, max;
@@ -127,137 +110,79 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
         return std::make_pair(min, max);
     };
 
-    // Paint the periodic tiling of a into b, and remove the painted region from dirty.
-    auto wrapped_paint = [&, this] (Surface const &a, Geom::IntRect &b, Cairo::RefPtr<Cairo::Context> const &cr, Cairo::RefPtr<Cairo::Region> const &dirty) {
-        auto const [min, max] = overlapping_translates(a.rect, b);
-        for (int x = min.x(); x <= max.x(); x += _pattern_resolution.x()) {
-            for (int y = min.y(); y <= max.y(); y += _pattern_resolution.y()) {
-                auto const rect = a.rect + Geom::IntPoint(x, y);
-                dirty->subtract(geom_to_cairo(rect));
-                cr->set_source(a.surface, rect.left(), rect.top());
-                cr->paint();
-            }
-        }
-    };
-
     // Calculate the requested area to draw within tile rasterisation space.
     auto const area_orig = (Geom::Rect(area) * screen_to_tile).roundOutwards();
     auto const area_tile = canonicalised(area_orig);
 
-    // Simplest solution for now to protecting pattern cache is a mutex. This makes all
-    // pattern rendering single-threaded, however patterns are typically not the bottleneck.
-    auto lock = std::lock_guard(mutables);
-
-    auto get_surface = [&, this] () -> std::pair<Surface*, Cairo::RefPtr<Cairo::Region>> {
-        // If there is a rectangle containing the requested area, just use that.
-        for (auto &s : surfaces) {
-            if (wrapped_contains(s.rect, area_tile)) {
-                return { &s, {} };
-            }
-        }
-
-        // Otherwise, recursively merge the requested area with all overlapping or touching rectangles, and paint the missing part.
-        std::vector<Surface> merged;
-        auto expanded = area_tile;
-
-        while (true) {
-            bool modified = false;
-
-            for (auto it = surfaces.begin(); it != surfaces.end(); ) {
-                if (wrapped_touches(expanded, it->rect)) {
-                    expanded.unionWith(it->rect + rounddown(expanded.max() - it->rect.min(), _pattern_resolution));
-                    merged.emplace_back(std::move(*it));
-                    *it = std::move(surfaces.back());
-                    surfaces.pop_back();
-                    modified = true;
-                } else {
-                    ++it;
-                }
-            }
-
-            if (!modified) break;
-        }
-
-        // Canonicalise the expanded rectangle. (Stops Cairo's coordinates overflowing and the pattern disappearing.)
-        expanded = canonicalised(expanded);
-
-        // Create a new surface covering the expanded rectangle.
-        auto surface = Surface(expanded, device_scale);
-        auto cr = Cairo::Context::create(surface.surface);
-        cr->translate(-surface.rect.left(), -surface.rect.top());
-
-        // Paste all the old surfaces into the new surface, tracking the remaining dirty region.
-        auto dirty = Cairo::Region::create(geom_to_cairo(expanded));
-
-        for (auto &m : merged) {
-            wrapped_paint(m, expanded, cr, dirty);
-        }
-
-        // Emplace the surface, and return it along with the remaining dirty region.
-        surfaces.emplace_back(std::move(surface));
-        return std::make_pair(&surfaces.back(), std::move(dirty));
+    auto cell_rect = [this] (int index) {
+        auto const min = Geom::IntPoint(index % _cell_count.x() * CELL_SIZE, index / _cell_count.x() * CELL_SIZE);
+        return *(Geom::IntRect(min, min + Geom::IntPoint(CELL_SIZE, CELL_SIZE)) & Geom::IntRect({0, 0}, _pattern_resolution));
     };
 
-    // Find an already-drawn surface containing the requested area, or create if it none exists.
-    auto [surface, dirty] = get_surface();
-
-    // Draw the pattern contents to the dirty areas of the surface, taking care of possible wrapping.
-    Inkscape::DrawingContext dc(surface->surface->cobj(), surface->rect.min());
-    if (rc.antialiasing_override) {
-        apply_antialias(dc, rc.antialiasing_override.value());
+    // Find the cells whose periodic tiling overlaps the requested area, and those not yet rendered.
+    std::vector<std::pair<int, std::shared_ptr<Cell const>>> cells;
+    std::vector<std::shared_ptr<Cell const>> stale;
+    for (int i = 0; i < _cell_count.x() * _cell_count.y(); i++) {
+        auto const [min, max] = overlapping_translates(cell_rect(i), area_tile);
+        if (min.x() > max.x() || min.y() > max.y()) continue;
+        auto cell = std::atomic_load(&_cells[i]);
+        if (cell && (cell->device_scale != device_scale || cell->opacity != opacity)) {
+            stale.emplace_back(std::move(cell));
+        } else {
+            stale.emplace_back();
+        }
+        cells.emplace_back(i, std::move(cell));
     }
 
-    auto paint = [&, this] (Geom::IntRect const &rect) {
-        if (_overflow_steps == 1) {
-            render(dc, rc, rect);
-        } else {
-            // Overflow transforms need to be transformed to the old coordinate system
-            // before stretching to the pattern resolution.
-            auto const initial_transform = idt * _overflow_initial_transform * dt;
-            auto const step_transform    = idt * _overflow_step_transform    * dt;
-            dc.transform(initial_transform);
-            for (int i = 0; i < _overflow_steps; i++) {
-                // render() fails to handle transforms applied here when using cache.
-                render(dc, rc, rect, RENDER_BYPASS_CACHE);
-                dc.transform(step_transform);
-                // auto raw = pattern_surface.raw();
-                // auto filename = "drawing-pattern" + std::to_string(i) + ".png";
-                // cairo_surface_write_to_png(pattern_surface.raw(), filename.c_str());
+    // Render the missing cells in parallel, publishing them for other renderers if the cache
+    // budget allows. If several renderers miss the same cell, the first one to finish wins.
+    Async::Scheduler::get().parallel_for(0, cells.size(), [&, this] (int j) {
+        auto &[index, cell] = cells[j];
+        if (cell) return;
+
+        auto rc_copy = rc;
+        cell = _renderCell(rc_copy, cell_rect(index), opacity, device_scale);
+
+        if (!_drawing.reservePatternCache(cell->size)) return;
+        auto expected = stale[j];
+        if (std::atomic_compare_exchange_strong(&_cells[index], &expected, cell)) {
+            _cells_size += cell->size;
+            if (expected) {
+                _cells_size -= expected->size;
+                _drawing.releasePatternCache(expected->size);
             }
+        } else {
+            _drawing.releasePatternCache(cell->size);
         }
-    };
+    });
 
-    if (dirty) {
-        for (int i = 0; i < dirty->get_num_rectangles(); i++) {
-            auto const rect = cairo_to_geom(dirty->get_rectangle(i));
-            for (int x = 0; x <= 1; x++) {
-                for (int y = 0; y <= 1; y++) {
-                    auto const wrap = _pattern_resolution * Geom::IntPoint(x, y);
-                    auto const rect2 = rect & Geom::IntRect(wrap, wrap + _pattern_resolution);
-                    if (!rect2) continue;
-                    auto save = DrawingContext::Save(dc);
-                    // Clip to rectangle to be drawn.
-                    dc.rectangle(*rect2);
-                    dc.clip();
-                    // Draw the pattern.
-                    dc.translate(wrap);
-                    paint(*rect2 - wrap);
-                    // Apply opacity, if necessary.
-                    if (opacity < 1.0 - 1e-3) {
-                        dc.setOperator(CAIRO_OPERATOR_DEST_IN);
-                        dc.setSource(0.0, 0.0, 0.0, opacity);
-                        dc.paint();
-                    }
+    // If the whole tile is a single cell, use it directly. Otherwise, assemble the requested area.
+    std::shared_ptr<Surface const> surface;
+    if (cells.size() == 1 && cells[0].second->rect == Geom::IntRect({0, 0}, _pattern_resolution)) {
+        surface = cells[0].second;
+    } else {
+        auto assembled = std::make_shared<Surface>(area_tile, device_scale);
+        auto cr = Cairo::Context::create(assembled->surface);
+        cr->translate(-area_tile.left(), -area_tile.top());
+        cr->set_operator(Cairo::OPERATOR_SOURCE);
+        for (auto const &[index, cell] : cells) {
+            auto const [min, max] = overlapping_translates(cell->rect, area_tile);
+            for (int x = min.x(); x <= max.x(); x += _pattern_resolution.x()) {
+                for (int y = min.y(); y <= max.y(); y += _pattern_resolution.y()) {
+                    auto const rect = cell->rect + Geom::IntPoint(x, y);
+                    cr->set_source(cell->surface, rect.left(), rect.top());
+                    cr->rectangle(rect.left(), rect.top(), rect.width(), rect.height());
+                    cr->fill();
                 }
             }
         }
-        dirty.clear();
+        surface = std::move(assembled);
     }
 
     // Debug: Show pattern tile.
     // surface->surface->write_to_png("/tmp/patternsurface.png");
 
-    // Create and return pattern.
+    // Create and return pattern. It holds a reference to the surface, so outlives the cell.
     auto cp = cairo_pattern_create_for_surface(surface->surface->cobj());
     auto const shift = surface->rect.min() + rounddown(area_orig.min() - surface->rect.min(), _pattern_resolution);
     ink_cairo_pattern_set_matrix(cp, pattern_to_tile * Geom::Translate(-shift));
@@ -268,6 +193,49 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
     return cp;
 }
 
+/**
+ * Render a part of the pattern tile.
+ */
+std::shared_ptr<DrawingPattern::Cell const> DrawingPattern::_renderCell(RenderContext &rc, Geom::IntRect const &rect, float opacity, int device_scale) const
+{
+    auto cell = std::make_shared<Cell>(rect, device_scale);
+    cell->device_scale = device_scale;
+    cell->opacity = opacity;
+    cell->size = cell->surface->get_stride() * cell->surface->get_height();
+
+    Inkscape::DrawingContext dc(cell->surface->cobj(), rect.min());
+    if (rc.antialiasing_override) {
+        apply_antialias(dc, rc.antialiasing_override.value());
+    }
+
+    if (_overflow_steps == 1) {
+        render(dc, rc, rect);
+    } else {
+        // Overflow transforms need to be transformed to the old coordinate system
+        // before stretching to the pattern resolution.
+        auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions());
+        auto const idt = dt.inverse();
+        auto const initial_transform = idt * _overflow_initial_transform * dt;
+        auto const step_transform    = idt * _overflow_step_transform    * dt;
+        dc.transform(initial_transform);
+        for (int i = 0; i < _overflow_steps; i++) {
+            // render() fails to handle transforms applied here when using cache.
+            render(dc, rc, rect, RENDER_BYPASS_CACHE);
+            dc.transform(step_transform);
+        }
+    }
+
+    // Apply opacity, if necessary.
+    if (opacity < 1.0 - 1e-3) {
+        dc.setOperator(CAIRO_OPERATOR_DEST_IN);
+        dc.setSource(0.0, 0.0, 0.0, opacity);
+        dc.paint();
+    }
+
+    cell->surface->flush();
+    return cell;
+}
+
 unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset)
 {
     _dropPatternCache();
@@ -285,6 +253,9 @@ unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext co
     // Correct solution should make use of visible area and change pattern tile rect accordingly.
     auto const c = _tile_rect->dimensions() * scale;
     _pattern_resolution = c.ceil();
+    _cell_count = Geom::IntPoint(Util::roundup(_pattern_resolution.x(), CELL_SIZE) / CELL_SIZE,
+                                 Util::roundup(_pattern_resolution.y(), CELL_SIZE) / CELL_SIZE);
+    _cells.assign(_cell_count.x() * _cell_count.y(), nullptr);
 
     // Map tile rect to the origin and stretch it to the desired resolution.
     auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions());
@@ -295,7 +266,10 @@ unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext co
 
 void DrawingPattern::_dropPatternCache()
 {
-    surfaces.clear();
+    for (auto &cell : _cells) {
+        std::atomic_store(&cell, std::shared_ptr<Cell const>());
+    }
+    _drawing.releasePatternCache(_cells_size.exchange(0));
 }
 
 } // namespace Inkscape
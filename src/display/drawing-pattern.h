@@ -13,7 +13,9 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 #define INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 
-#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <cairomm/surface.h>
 #include "drawing-group.h"
 
@@ -63,7 +65,7 @@ public:
     cairo_pattern_t *renderPattern(RenderContext &rc, Geom::IntRect const &area, float opacity, int device_scale) const;
 
 protected:
-    ~DrawingPattern() override = default;
+    ~DrawingPattern() override;
 
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
 
@@ -80,6 +82,7 @@ protected:
 
     // Set on update.
     Geom::IntPoint _pattern_resolution;
+    Geom::IntPoint _cell_count;
 
     struct Surface
     {
@@ -88,10 +91,24 @@ protected:
         Cairo::RefPtr<Cairo::ImageSurface> surface;
     };
 
-    mutable std::mutex mutables;
+    /// A rendered part of the pattern tile, immutable once published.
+    struct Cell : Surface
+    {
+        using Surface::Surface;
+        int device_scale;
+        float opacity;
+        size_t size;
+    };
+
+    /// Size of the cells the pattern tile is divided into, in tile rasterisation pixels.
+    static constexpr int CELL_SIZE = 256;
+
+    std::shared_ptr<Cell const> _renderCell(RenderContext &rc, Geom::IntRect const &rect, float opacity, int device_scale) const;
 
-    // Parts of the pattern tile that have been rendered. Read/written on render, cleared on update.
-    mutable std::vector<Surface> surfaces;
+    // Cells of the pattern tile in row-major order, or null if not rendered yet. Each is accessed
+    // atomically, so that renderers can share them without locking. Published on render, cleared on update.
+    mutable std::vector<std::shared_ptr<Cell const>> _cells;
+    mutable std::atomic<size_t> _cells_size = 0; ///< Reserved in the drawing's cache budget.
 };
 
 } // namespace Inkscape
@@ -10,6 +10,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <optional>
 #include "2geom/pathvector.h"
 
 #include "dither-lock.h"
@@ -20,6 +21,7 @@
 #include "drawing-surface.h"
 #include "drawing-text.h"
 #include "drawing.h"
+#include "glyph-cache.h"
 
 #include "helper/geom.h"
 
@@ -190,6 +192,41 @@ unsigned DrawingGlyphs::_updateItem(Geom::IntRect const &/*area*/, UpdateContext
     return STATE_ALL;
 }
 
+/**
+ * Composite the cached coverage mask of the glyph with the current source, the glyph's transform
+ * being in effect. Returns false if the glyph has no cacheable mask and must be drawn as a path.
+ */
+bool DrawingGlyphs::_drawCachedMask(DrawingContext &dc, cairo_fill_rule_t fill_rule) const
+{
+    auto const ct = dc.raw();
+    auto const target = dc.rawTarget();
+
+    // Transform from glyph space to the pixels of the target.
+    cairo_matrix_t matrix;
+    cairo_get_matrix(ct, &matrix);
+    Geom::Affine transform;
+    ink_matrix_to_2geom(transform, matrix);
+    double device_scale = 1;
+    cairo_surface_get_device_scale(target, &device_scale, nullptr);
+    Geom::Point offset;
+    cairo_surface_get_device_offset(target, &offset[Geom::X], &offset[Geom::Y]);
+    transform *= Geom::Scale(device_scale) * Geom::Translate(offset);
+
+    Geom::IntPoint position;
+    auto mask = GlyphCache::get().lookup(_font_data, _glyph, *pathvec, transform, device_scale, fill_rule,
+                                         cairo_get_antialias(ct), position);
+    if (!mask) {
+        return false;
+    }
+
+    // The mask has the device scale of the target, so lines up with its pixels.
+    auto const origin = (Geom::Point(position) - offset) / device_scale;
+    cairo_identity_matrix(ct);
+    cairo_mask_surface(ct, mask, origin.x(), origin.y());
+    cairo_surface_destroy(mask);
+    return true;
+}
+
 DrawingItem *DrawingGlyphs::_pickItem(Geom::Point const &p, double /*delta*/, unsigned flags)
 {
     auto ggroup = cast<DrawingText>(_parent);
@@ -606,6 +643,24 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
             dc.newPath(); // Clear text-decoration path
         }
 
+        // Opaque plain fills of glyphs are composited from cached coverage masks, one glyph at a
+        // time, which only matches filling their union if overlaps cannot show. Glyphs that also
+        // have a stroke, or are painted with a paint server, are drawn as paths.
+        bool const cached_masks = has_fill && !has_stroke && _nrstyle.data.fill.type == NRStyleData::PaintType::COLOR &&
+                                  _nrstyle.data.fill.opacity >= 1.0 &&
+                                  cairo_surface_get_type(dc.rawTarget()) == CAIRO_SURFACE_TYPE_IMAGE &&
+                                  GlyphCache::get().enabled();
+        std::optional<Inkscape::DrawingContext::Save> save_source;
+        if (cached_masks) {
+            // Set the fill as the source for the whole loop, in the coordinates it was prepared in.
+            save_source.emplace(dc);
+            cairo_matrix_t matrix;
+            cairo_get_matrix(dc.raw(), &matrix);
+            dc.transform(_ctm);
+            _nrstyle.applyFill(dc, has_fill);
+            cairo_set_matrix(dc.raw(), &matrix);
+        }
+
         // Accumulate the path that represents the glyphs and/or draw SVG glyphs.
         for (auto &i : _children) {
             auto g = cast<DrawingGlyphs>(&i);
@@ -635,12 +690,14 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
                         dc.setSource(g->pixbuf->getSurfaceRaw(), 0, 0);
                         dc.paint(1);
                     }
-                } else {
+                } else if (!cached_masks || !g->_drawCachedMask(dc, _nrstyle.data.fill_rule)) {
                     dc.path(*g->pathvec);
                 }
             }
         }
 
+        save_source.reset();
+
         // Draw the glyphs (non-SVG glyphs).
         {
             Inkscape::DrawingContext::Save save(dc);
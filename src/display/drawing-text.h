@@ -41,6 +41,8 @@ protected:
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
 
+    bool _drawCachedMask(DrawingContext &dc, cairo_fill_rule_t fill_rule) const;
+
     std::shared_ptr<void const> _font_data; // keeps alive pathvec, pathvec_ref, and pixbuf
     int            _glyph;
     float          _width;          // These three are used to set up bounding box
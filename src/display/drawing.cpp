@@ -12,9 +12,13 @@
  */
 
 #include <array>
+#include <ostream>
 #include <thread>
+#include "async/scheduler.h"
 #include "display/drawing.h"
 #include "display/control/canvas-item-drawing.h"
+#include "glyph-cache.h"
+#include "nr-filter-cache.h"
 #include "nr-filter-gaussian.h"
 #include "nr-filter-types.h"
 
@@ -196,6 +200,61 @@ void Drawing::setCacheBudget(size_t bytes)
     });
 }
 
+void Drawing::setFilterCacheBudget(size_t bytes)
+{
+    defer([=] {
+        if (bytes == 0) {
+            _filter_cache.reset();
+        } else if (_filter_cache) {
+            _filter_cache->setBudget(bytes);
+        } else {
+            _filter_cache = std::make_unique<Filters::FilterCache>(bytes);
+        }
+    });
+}
+
+bool Drawing::reservePatternCache(size_t bytes) const
+{
+    if (!_canvas_item_drawing) {
+        _pattern_cache_size.fetch_add(bytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    // The budget is shared with the caches of the items picked by _pickItemsForCaching().
+    auto const items = _item_cache_size.load(std::memory_order_relaxed);
+    auto size = _pattern_cache_size.load(std::memory_order_relaxed);
+    do {
+        if (items + size + bytes > _cache_budget) {
+            return false;
+        }
+    } while (!_pattern_cache_size.compare_exchange_weak(size, size + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+void Drawing::releasePatternCache(size_t bytes) const
+{
+    _pattern_cache_size.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void Drawing::resetStats()
+{
+    if (_root) {
+        _root->recursiveResetStats();
+    }
+}
+
+void Drawing::writeStats(std::ostream &os) const
+{
+    os << "{\n  \"cache_budget\": " << _cache_budget
+       << ",\n  \"cached_items\": " << _cached_items.size()
+       << ",\n  \"pattern_cache_bytes\": " << _pattern_cache_size.load(std::memory_order_relaxed)
+       << ",\n  \"items\": [";
+    if (_root) {
+        _root->recursiveWriteStats(os, 0, "root");
+    }
+    os << "\n  ]\n}\n";
+}
+
 void Drawing::setCacheLimit(Geom::OptIntRect const &rect)
 {
     defer([=] {
@@ -275,13 +334,15 @@ void Drawing::_pickItemsForCaching()
 {
     // Build sorted list of items that should be cached.
     std::vector<DrawingItem*> to_cache;
+    size_t const patterns = _pattern_cache_size.load(std::memory_order_relaxed); // Patterns share the budget.
     size_t used = 0;
     for (auto &rec : _candidate_items) {
-        if (used + rec.cache_size > _cache_budget) break;
+        if (patterns + used + rec.cache_size > _cache_budget) break;
         to_cache.emplace_back(rec.item);
         used += rec.cache_size;
     }
     std::sort(to_cache.begin(), to_cache.end());
+    _item_cache_size.store(used, std::memory_order_relaxed);
 
     // Uncache the items that are cached but should not be cached.
     // Note: setCached() modifies _cached_items, so the temporary container is necessary.
@@ -307,6 +368,7 @@ void Drawing::_clearCache()
     for (auto item : to_uncache) {
         item->_setCached(false, true);
     }
+    _item_cache_size.store(0, std::memory_order_relaxed);
 }
 
 void Drawing::_loadPrefs()
@@ -328,12 +390,17 @@ void Drawing::_loadPrefs()
     if (_canvas_item_drawing) {
         // Preference is stored in MiB; convert to bytes, taking care not to overflow.
         _cache_budget = (size_t{1} << 20) * prefs->getIntLimited("/options/renderingcache/size", 64, 0, 4096);
+        if (auto const budget = (size_t{1} << 20) * prefs->getIntLimited("/options/filtercache/size", 64, 0, 4096)) {
+            _filter_cache = std::make_unique<Filters::FilterCache>(budget);
+        }
+        // The glyph cache is shared by all drawings, but only pays off for repeated redraws.
+        GlyphCache::get().setBudget((size_t{1} << 20) * prefs->getIntLimited("/options/glyphcache/size", 16, 0, 1024));
     } else {
         _cache_budget = 0;
     }
 
-    // Set the global variable governing the number of filter threads, and track it too. (This is ugly, but hopefully transitional.)
-    set_num_filter_threads(prefs->getIntLimited("/options/threading/numthreads", default_numthreads(), 1, 256));
+    // Set the number of threads of the process-wide render scheduler, and track it too.
+    Async::Scheduler::get().setConcurrency(prefs->getIntLimited("/options/threading/numthreads", default_numthreads(), 1, 256));
 
     // Similarly, enable preference tracking only for the Canvas's drawing.
     if (_canvas_item_drawing) {
@@ -350,7 +417,9 @@ void Drawing::_loadPrefs()
         actions.emplace("/options/cursortolerance/value",        [this] (auto &entry) { setCursorTolerance(entry.getDouble(1.0)); });
         actions.emplace("/options/selection/zeroopacity",        [this] (auto &entry) { setSelectZeroOpacity(entry.getBool(false)); });
         actions.emplace("/options/renderingcache/size",          [this] (auto &entry) { setCacheBudget((1 << 20) * entry.getIntLimited(64, 0, 4096)); });
-        actions.emplace("/options/threading/numthreads",         [this] (auto &entry) { set_num_filter_threads(entry.getIntLimited(default_numthreads(), 1, 256)); });
+        actions.emplace("/options/filtercache/size",             [this] (auto &entry) { setFilterCacheBudget((size_t{1} << 20) * entry.getIntLimited(64, 0, 4096)); });
+        actions.emplace("/options/glyphcache/size",              [] (auto &entry) { GlyphCache::get().setBudget((size_t{1} << 20) * entry.getIntLimited(16, 0, 1024)); });
+        actions.emplace("/options/threading/numthreads",         [] (auto &entry) { Async::Scheduler::get().setConcurrency(entry.getIntLimited(default_numthreads(), 1, 256)); });
 
         _pref_tracker = Inkscape::Preferences::PreferencesObserver::create("/options", [actions = std::move(actions)] (auto &entry) {
             auto it = actions.find(entry.getPath());
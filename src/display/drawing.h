@@ -13,6 +13,7 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_H
 #define INKSCAPE_DISPLAY_DRAWING_H
 
+#include <atomic>
 #include <optional>
 #include <set>
 #include <cstdint>
@@ -34,6 +35,10 @@ class DrawingItem;
 class CanvasItemDrawing;
 class DrawingContext;
 
+namespace Filters {
+class FilterCache;
+} // namespace Filters
+
 class Drawing
 {
 public:
@@ -60,6 +65,7 @@ public:
     void setCursorTolerance(double tol) { _cursor_tolerance = tol; }
     void setSelectZeroOpacity(bool select_zero_opacity) { _select_zero_opacity = select_zero_opacity; }
     void setCacheBudget(size_t bytes);
+    void setFilterCacheBudget(size_t bytes);
     void setCacheLimit(Geom::OptIntRect const &rect);
     void setClip(std::optional<Geom::PathVector> &&clip);
     void setAntialiasingOverride(std::optional<Antialiasing> antialiasing_override);
@@ -78,6 +84,22 @@ public:
     double cursorTolerance() const { return _cursor_tolerance; }
     bool selectZeroOpacity() const { return _select_zero_opacity; }
     Geom::OptIntRect const &cacheLimit() const { return _cache_limit; }
+    Filters::FilterCache *filterCache() const { return _filter_cache.get(); } ///< Null if disabled.
+
+    /// Account for rendered pattern tiles in the cache budget, returning false if they don't fit.
+    /// Thread-safe. Offscreen drawings, which are rendered only once or a few times, have no limit.
+    bool reservePatternCache(size_t bytes) const;
+    void releasePatternCache(size_t bytes) const;
+
+    /// Record per-item render counters and timings, for finding slow objects and tuning the cache.
+    void setRecordStats(bool record) { _record_stats.store(record, std::memory_order_relaxed); }
+    bool recordStats() const { return _record_stats.load(std::memory_order_relaxed); }
+    void resetStats();
+    void writeStats(std::ostream &os) const; ///< Write the counters of all items as JSON.
+
+    /// Incremented whenever the bounding box of any item is recomputed.
+    /// Data derived from item bounding boxes, such as spatial indices, is valid while this is unchanged.
+    std::uint64_t bboxGeneration() const { return _bbox_generation; }
 
     void update(Geom::IntRect const &area = Geom::IntRect::infinite(), Geom::Affine const &affine = Geom::identity(),
                 unsigned flags = DrawingItem::STATE_ALL, unsigned reset = 0);
@@ -119,6 +141,11 @@ private:
     std::optional<Geom::PathVector> _clip;
     bool _select_zero_opacity;
     std::optional<Antialiasing> _antialiasing_override;
+    std::uint64_t _bbox_generation = 0; // modified by DrawingItem::update()
+    std::unique_ptr<Filters::FilterCache> _filter_cache; ///< Results of filter primitives, kept across redraws.
+    mutable std::atomic<size_t> _pattern_cache_size = 0; ///< Size of the tiles cached by patterns.
+    std::atomic<size_t> _item_cache_size = 0;            ///< Size of the caches of the items picked for caching.
+    std::atomic<bool> _record_stats = false;
 
     std::set<DrawingItem*> _cached_items; // modified by DrawingItem::_setCached()
     CacheList _candidate_items;           // keep this list always sorted with std::greater
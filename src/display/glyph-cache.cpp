@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of rasterised glyphs, shared between drawings.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "display/glyph-cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <2geom/pathvector.h>
+#include <2geom/transforms.h>
+
+#include "display/cairo-utils.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Larger glyphs are drawn as paths, which is fast enough at that size and avoids filling the
+// cache with masks seldom reused.
+constexpr double MAX_LINEAR = 256.0;   ///< Maximum size of the em box in device pixels.
+constexpr int MAX_MASK_AREA = 256 * 256;
+
+constexpr int SUBPIXEL_STEPS = 4;
+
+} // namespace
+
+GlyphCache &GlyphCache::get()
+{
+    // Holds only Cairo surfaces, so may be destroyed after main() exits.
+    static GlyphCache instance;
+    return instance;
+}
+
+GlyphCache::~GlyphCache()
+{
+    _evict(0);
+}
+
+void GlyphCache::setBudget(std::size_t budget)
+{
+    auto lock = std::lock_guard(_mutex);
+    _budget = budget;
+    _evict(_budget);
+}
+
+bool GlyphCache::enabled() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _budget > 0;
+}
+
+std::size_t GlyphCache::size() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _size;
+}
+
+void GlyphCache::_evict(std::size_t budget)
+{
+    while (_size > budget && !_entries.empty()) {
+        auto &entry = _entries.back();
+        _size -= entry.size;
+        cairo_surface_destroy(entry.mask);
+        _index.erase(entry.key);
+        _entries.pop_back();
+    }
+}
+
+bool GlyphCache::Key::operator==(Key const &other) const
+{
+    return font == other.font && glyph == other.glyph && std::equal(linear, linear + 4, other.linear) &&
+           subpixel == other.subpixel && device_scale == other.device_scale && fill_rule == other.fill_rule &&
+           antialias == other.antialias;
+}
+
+std::size_t GlyphCache::KeyHash::operator()(Key const &key) const
+{
+    auto seed = std::hash<void const *>()(key.font);
+    auto combine = [&] (std::size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    };
+    combine(key.glyph);
+    for (auto l : key.linear) {
+        combine(l);
+    }
+    combine(key.subpixel | key.device_scale << 8 | key.fill_rule << 16 | key.antialias << 24);
+    return seed;
+}
+
+cairo_surface_t *GlyphCache::lookup(std::shared_ptr<void const> const &font, int glyph, Geom::PathVector const &outline,
+                                    Geom::Affine const &transform, double device_scale,
+                                    cairo_fill_rule_t fill_rule, cairo_antialias_t antialias, Geom::IntPoint &position)
+{
+    Key key;
+    key.font = font.get();
+    key.glyph = glyph;
+    for (int i = 0; i < 4; i++) {
+        if (!(std::abs(transform[i]) <= MAX_LINEAR)) {
+            return nullptr;
+        }
+        key.linear[i] = std::lround(transform[i] * 64);
+    }
+
+    // Split the translation into whole pixels and a quantised position within the pixel.
+    Geom::IntPoint whole;
+    int subpixel[2];
+    for (auto d : {Geom::X, Geom::Y}) {
+        double const t = transform.translation()[d];
+        whole[d] = std::floor(t);
+        subpixel[d] = std::lround((t - whole[d]) * SUBPIXEL_STEPS);
+        if (subpixel[d] == SUBPIXEL_STEPS) {
+            whole[d] += 1;
+            subpixel[d] = 0;
+        }
+    }
+    key.subpixel = subpixel[Geom::X] | subpixel[Geom::Y] << 4;
+    key.device_scale = std::clamp<long>(std::lround(device_scale), 1, 255);
+    key.fill_rule = fill_rule;
+    key.antialias = antialias;
+
+    {
+        auto lock = std::lock_guard(_mutex);
+        auto it = _index.find(key);
+        if (it != _index.end()) {
+            auto &entry = *it->second;
+            if (!entry.font.expired()) {
+                // Mark as most recently used.
+                _entries.splice(_entries.begin(), _entries, it->second);
+                position = whole + entry.offset;
+                return cairo_surface_reference(entry.mask);
+            }
+            // The font was freed and its address reused.
+            _size -= entry.size;
+            cairo_surface_destroy(entry.mask);
+            _entries.erase(it->second);
+            _index.erase(it);
+        }
+    }
+
+    // Rasterise with the quantised transform, so that the mask is the same for all its users.
+    auto const quantised = Geom::Affine(key.linear[0] / 64.0, key.linear[1] / 64.0,
+                                        key.linear[2] / 64.0, key.linear[3] / 64.0,
+                                        static_cast<double>(subpixel[Geom::X]) / SUBPIXEL_STEPS,
+                                        static_cast<double>(subpixel[Geom::Y]) / SUBPIXEL_STEPS);
+    auto const path = outline * quantised;
+    auto const bounds = path.boundsExact();
+    if (!bounds) {
+        return nullptr;
+    }
+    auto const area = bounds->roundOutwards();
+    if (area.hasZeroArea() || area.area() > MAX_MASK_AREA) {
+        return nullptr;
+    }
+
+    auto mask = cairo_image_surface_create(CAIRO_FORMAT_A8, area.width(), area.height());
+    auto ct = cairo_create(mask);
+    cairo_set_antialias(ct, antialias);
+    cairo_set_fill_rule(ct, fill_rule);
+    feed_pathvector_to_cairo(ct, path * Geom::Translate(-area.min()));
+    cairo_fill(ct);
+    cairo_destroy(ct);
+    cairo_surface_flush(mask);
+    cairo_surface_set_device_scale(mask, key.device_scale, key.device_scale);
+
+    position = whole + area.min();
+
+    Entry entry;
+    entry.key = key;
+    entry.font = font;
+    entry.mask = mask;
+    entry.offset = area.min();
+    entry.size = cairo_image_surface_get_stride(mask) * area.height() + sizeof(Entry);
+
+    auto lock = std::lock_guard(_mutex);
+    if (entry.size > _budget || _index.count(key)) {
+        // Too large, or rasterised by another thread in the meantime.
+        return mask;
+    }
+    _entries.push_front(entry);
+    _index.emplace(key, _entries.begin());
+    _size += entry.size;
+    cairo_surface_reference(mask); // Before it can be evicted.
+    _evict(_budget);
+    return mask;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of rasterised glyphs, shared between drawings.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+#define SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <2geom/affine.h>
+#include <2geom/forward.h>
+#include <2geom/int-point.h>
+#include <cairo.h>
+
+namespace Inkscape {
+
+/**
+ * Coverage masks of glyphs, rasterised once and composited on every redraw.
+ *
+ * A mask is keyed by the font, the glyph, the linear part of its transform to device pixels,
+ * its position within a device pixel quantised to a quarter pixel, and the fill rule and
+ * antialiasing it was rasterised with. Text is drawn with the same few masks wherever it is
+ * repeated, across all drawings and rendering threads.
+ *
+ * The least recently used masks are evicted to stay within a memory budget.
+ */
+class GlyphCache
+{
+public:
+    /// The cache shared by all drawings.
+    static GlyphCache &get();
+
+    GlyphCache() = default;
+    ~GlyphCache();
+    GlyphCache(GlyphCache const &) = delete;
+    GlyphCache &operator=(GlyphCache const &) = delete;
+
+    /// Change the memory budget in bytes, evicting masks if necessary. Zero disables the cache.
+    void setBudget(std::size_t budget);
+    bool enabled() const;
+
+    /**
+     * Get the coverage mask of a glyph with the given outline, drawn with the given transform to
+     * the pixels of a surface with the given device scale. Rasterise it if it isn't cached.
+     *
+     * Returns a new reference to an A8 surface with the device scale set, to be drawn with its
+     * top left corner at the returned pixel position; or null if the glyph is empty or too large
+     * to cache, in which case it should be drawn as a path.
+     */
+    cairo_surface_t *lookup(std::shared_ptr<void const> const &font, int glyph, Geom::PathVector const &outline,
+                            Geom::Affine const &transform, double device_scale,
+                            cairo_fill_rule_t fill_rule, cairo_antialias_t antialias, Geom::IntPoint &position);
+
+    /// Size of the cached masks in bytes.
+    std::size_t size() const;
+
+private:
+    struct Key
+    {
+        void const *font;
+        int glyph;
+        std::int32_t linear[4]; ///< Linear part of the transform, in 1/64 pixels.
+        std::uint8_t subpixel;  ///< Position within a pixel, in quarter pixels along x and y.
+        std::uint8_t device_scale;
+        std::uint8_t fill_rule;
+        std::uint8_t antialias;
+
+        bool operator==(Key const &other) const;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::weak_ptr<void const> font; ///< Invalidates the entry if the font goes away.
+        cairo_surface_t *mask;
+        Geom::IntPoint offset;          ///< Position of the mask relative to the glyph origin.
+        std::size_t size;
+    };
+
+    void _evict(std::size_t budget);
+
+    std::size_t _budget = 0;
+    std::size_t _size = 0;
+    mutable std::mutex _mutex;
+    std::list<Entry> _entries; ///< Most recently used first.
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> _index;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -150,6 +150,12 @@ void FilterBlend::set_input(int input, int slot)
     if (input == 1) _input2 = slot;
 }
 
+void FilterBlend::get_inputs(std::vector<int> &inputs) const
+{
+    inputs.push_back(_input);
+    inputs.push_back(_input2);
+}
+
 void FilterBlend::set_mode(SPBlendMode mode)
 {
     if (_valid_modes.count(mode)) {
@@ -37,6 +37,7 @@ public:
 
     void set_input(int slot) override;
     void set_input(int input, int slot) override;
+    void get_inputs(std::vector<int> &inputs) const override;
     void set_mode(SPBlendMode mode);
 
     Glib::ustring name() const override { return Glib::ustring("Blend"); }
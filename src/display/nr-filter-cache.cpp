@@ -0,0 +1,406 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of filter primitive results, shared between redraws.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "display/nr-filter-cache.h"
+
+#include <cstring>
+#include <cairo.h>
+
+#include "display/cairo-utils.h"
+#include "display/nr-filter-slot.h"
+
+namespace Inkscape {
+namespace Filters {
+
+namespace {
+
+// Constants and round function of xxHash64, for hashing keys.
+constexpr std::uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+
+inline std::uint64_t rotl(std::uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t xxh_round(std::uint64_t acc, std::uint64_t input)
+{
+    return rotl(acc + input * PRIME2, 31) * PRIME1;
+}
+
+inline std::uint64_t avalanche(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void hash_combine(std::uint64_t &seed, std::uint64_t value)
+{
+    seed = avalanche(xxh_round(seed, value) + PRIME3);
+}
+
+void hash_combine(std::uint64_t &seed, double value)
+{
+    if (value == 0.0) {
+        value = 0.0; // Treat -0.0 like 0.0, as operator== does.
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    hash_combine(seed, bits);
+}
+
+void hash_combine(std::uint64_t &seed, Geom::OptRect const &rect)
+{
+    hash_combine(seed, static_cast<std::uint64_t>(bool(rect)));
+    if (rect) {
+        hash_combine(seed, rect->left());
+        hash_combine(seed, rect->top());
+        hash_combine(seed, rect->right());
+        hash_combine(seed, rect->bottom());
+    }
+}
+
+int bytes_per_pixel(cairo_surface_t *surface)
+{
+    return cairo_image_surface_get_format(surface) == CAIRO_FORMAT_A8 ? 1 : 4;
+}
+
+/// Size of an area in pixels.
+Geom::IntPoint pixel_size(Geom::Rect const &area, int device_scale)
+{
+    return (area.dimensions() * device_scale).round();
+}
+
+/**
+ * Where an area lies in the image of an entry, in pixels from its corner, if the entry covers it
+ * and the offset is a whole number of pixels.
+ */
+std::optional<Geom::IntPoint> pixel_offset(Geom::Rect const &entry_area, Geom::Rect const &area, int device_scale)
+{
+    auto constexpr EPS = 1e-6;
+    if (!entry_area.contains(area)) {
+        return {};
+    }
+    auto const offset = (area.min() - entry_area.min()) * device_scale;
+    auto const pixels = offset.round();
+    if (!Geom::are_near(Geom::Point(pixels), offset, EPS)) {
+        return {};
+    }
+    auto const size = pixel_size(area, device_scale);
+    auto const entry_size = pixel_size(entry_area, device_scale);
+    if (pixels.x() + size.x() > entry_size.x() || pixels.y() + size.y() > entry_size.y()) {
+        return {};
+    }
+    return pixels;
+}
+
+/// Whether surface equals the part of a larger one at the given offset in pixels.
+bool equal_part(cairo_surface_t *larger, Geom::IntPoint const &offset, cairo_surface_t *surface)
+{
+    if (cairo_image_surface_get_format(larger) != cairo_image_surface_get_format(surface)) {
+        return false;
+    }
+    cairo_surface_flush(surface);
+    int const bpp = bytes_per_pixel(surface);
+    int const row_bytes = cairo_image_surface_get_width(surface) * bpp;
+    int const height = cairo_image_surface_get_height(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    int const larger_stride = cairo_image_surface_get_stride(larger);
+    auto const data = cairo_image_surface_get_data(surface);
+    auto const larger_data = cairo_image_surface_get_data(larger) + offset.y() * larger_stride + offset.x() * bpp;
+    for (int y = 0; y < height; y++) {
+        if (std::memcmp(data + y * stride, larger_data + y * larger_stride, row_bytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Copy the part of an image surface at the given offset in pixels.
+cairo_surface_t *copy_part(cairo_surface_t *surface, Geom::IntPoint const &offset, Geom::IntPoint const &size)
+{
+    auto const format = cairo_image_surface_get_format(surface);
+    cairo_surface_t *part = cairo_image_surface_create(format, size.x(), size.y());
+    double x_scale = 1.0, y_scale = 1.0;
+    cairo_surface_get_device_scale(surface, &x_scale, &y_scale);
+    cairo_surface_set_device_scale(part, x_scale, y_scale);
+    copy_cairo_surface_ci(surface, part);
+
+    int const bpp = bytes_per_pixel(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    int const part_stride = cairo_image_surface_get_stride(part);
+    auto const data = cairo_image_surface_get_data(surface) + offset.y() * stride + offset.x() * bpp;
+    auto const part_data = cairo_image_surface_get_data(part);
+    for (int y = 0; y < size.y(); y++) {
+        std::memcpy(part_data + y * part_stride, data + y * stride, size.x() * bpp);
+    }
+    cairo_surface_mark_dirty(part);
+    return part;
+}
+
+} // namespace
+
+bool FilterCache::Key::operator==(Key const &other) const
+{
+    return filter == other.filter && primitive == other.primitive && ctm == other.ctm &&
+           display2pb == other.display2pb && item_bbox == other.item_bbox && filter_area == other.filter_area &&
+           resolution_x == other.resolution_x && resolution_y == other.resolution_y &&
+           blurquality == other.blurquality && device_scale == other.device_scale && inputs == other.inputs;
+}
+
+std::uint64_t FilterCache::Key::hash() const
+{
+    std::uint64_t h = filter;
+    hash_combine(h, static_cast<std::uint64_t>(primitive));
+    for (int i = 0; i < 6; i++) {
+        hash_combine(h, ctm[i]);
+        hash_combine(h, display2pb[i]);
+    }
+    hash_combine(h, item_bbox);
+    hash_combine(h, filter_area);
+    hash_combine(h, resolution_x);
+    hash_combine(h, resolution_y);
+    hash_combine(h, static_cast<std::uint64_t>(blurquality));
+    hash_combine(h, static_cast<std::uint64_t>(device_scale));
+    for (auto input : inputs) {
+        hash_combine(h, input);
+    }
+    return h;
+}
+
+FilterCache::FilterCache(std::size_t budget)
+    : _budget(budget)
+{
+}
+
+FilterCache::~FilterCache()
+{
+    clear();
+}
+
+void FilterCache::setBudget(std::size_t budget)
+{
+    auto lock = std::lock_guard(_mutex);
+    _budget = budget;
+    _evict(_budget);
+}
+
+void FilterCache::clear()
+{
+    auto lock = std::lock_guard(_mutex);
+    _evict(0);
+}
+
+std::size_t FilterCache::size() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _size;
+}
+
+std::size_t FilterCache::count() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _entries.size();
+}
+
+void FilterCache::_evict(std::size_t budget)
+{
+    while (_size > budget && !_entries.empty()) {
+        auto const last = std::prev(_entries.end());
+        _size -= last->size;
+        cairo_surface_destroy(last->surface);
+        auto range = _index.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                _index.erase(it);
+                break;
+            }
+        }
+        _entries.erase(last);
+    }
+}
+
+/**
+ * Find the entry with the key that covers the area and is accepted, and mark it as most recently
+ * used. Hashes only narrow the search; the keys themselves must be equal. Call with the mutex held.
+ */
+template <typename F>
+FilterCache::Entries::iterator FilterCache::_find(Key const &key, std::uint64_t hash, Geom::Rect const &area, F &&accept)
+{
+    auto range = _index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto const entry = it->second;
+        if (entry->key != key) {
+            continue;
+        }
+        if (auto offset = pixel_offset(entry->area, area, key.device_scale); offset && accept(*entry, *offset)) {
+            _entries.splice(_entries.begin(), _entries, entry);
+            return entry;
+        }
+    }
+    return _entries.end();
+}
+
+/// Add an entry as most recently used and return its id. Call with the mutex held.
+std::uint64_t FilterCache::_insert(Entry entry)
+{
+    auto const id = entry.id;
+    _size += entry.size;
+    _entries.push_front(std::move(entry));
+    _index.emplace(_entries.front().hash, _entries.begin());
+    _evict(_budget);
+    return id;
+}
+
+std::optional<FilterCache::Result> FilterCache::lookup(Key const &key, Geom::Rect const &area)
+{
+    auto const hash = key.hash();
+    auto const size = pixel_size(area, key.device_scale);
+
+    cairo_surface_t *cached;
+    Geom::IntPoint offset;
+    Result result;
+    {
+        auto lock = std::lock_guard(_mutex);
+        auto entry = _find(key, hash, area, [&] (Entry const &, Geom::IntPoint const &o) {
+            offset = o;
+            return true;
+        });
+        if (entry == _entries.end()) {
+            return {};
+        }
+        cached = cairo_surface_reference(entry->surface);
+        result.id = entry->id;
+        result.primitive_area = entry->primitive_area;
+        result.input_interpolation = entry->input_interpolation;
+    }
+
+    // The caller gets its own copy, as later primitives may modify it in place.
+    result.surface = copy_part(cached, offset, size);
+    cairo_surface_destroy(cached);
+    return result;
+}
+
+std::uint64_t FilterCache::store(Key const &key, Geom::Rect const &area, cairo_surface_t *surface,
+                                 std::optional<Geom::Rect> primitive_area,
+                                 std::vector<SPColorInterpolation> input_interpolation)
+{
+    Entry entry{key, key.hash(), 0, area, nullptr, 0, primitive_area, std::move(input_interpolation)};
+    return _store(std::move(entry), surface, true);
+}
+
+std::uint64_t FilterCache::identify(Key const &key, Geom::Rect const &area, cairo_surface_t *surface)
+{
+    Entry entry{key, key.hash(), 0, area, nullptr, 0, {}, {}};
+    if (_storable(entry, surface)) {
+        auto lock = std::lock_guard(_mutex);
+        auto const found = _find(key, entry.hash, area, [=] (Entry const &e, Geom::IntPoint const &offset) {
+            return equal_part(e.surface, offset, surface);
+        });
+        if (found != _entries.end()) {
+            return found->id;
+        }
+    }
+    return _store(std::move(entry), surface, false);
+}
+
+/// Whether a surface can be cached for the area of an entry.
+bool FilterCache::_storable(Entry const &entry, cairo_surface_t *surface)
+{
+    auto const size = pixel_size(entry.area, entry.key.device_scale);
+    return cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+           cairo_image_surface_get_width(surface) == size.x() &&
+           cairo_image_surface_get_height(surface) == size.y();
+}
+
+/**
+ * Cache a copy of the surface for an entry if it fits, and return the id of its contents. If
+ * shared, the contents are known from the key, so those of an entry with the same key covering
+ * the area can be returned instead, for example if another thread stored them in the meantime.
+ */
+std::uint64_t FilterCache::_store(Entry entry, cairo_surface_t *surface, bool shared)
+{
+    bool const storable = _storable(entry, surface);
+    if (storable) {
+        entry.size = static_cast<std::size_t>(cairo_image_surface_get_stride(surface)) * cairo_image_surface_get_height(surface);
+    }
+
+    auto lock = std::lock_guard(_mutex);
+    if (shared) {
+        auto const existing = _find(entry.key, entry.hash, entry.area, [] (Entry const &, Geom::IntPoint const &) { return true; });
+        if (existing != _entries.end()) {
+            return existing->id;
+        }
+    }
+
+    entry.id = ++_last_id;
+    if (!storable || entry.size > _budget) {
+        return entry.id;
+    }
+    entry.surface = ink_cairo_surface_copy(surface);
+    return _insert(std::move(entry));
+}
+
+bool FilterCache::restore(Key const &key, FilterSlot &slot, int output, std::vector<int> const &inputs)
+{
+    auto result = lookup(key, slot.get_slot_area());
+    if (!result) {
+        return false;
+    }
+
+    // Primitives convert their inputs to their color space in place; do the same, as later
+    // primitives reading these slots depend on it.
+    for (std::size_t i = 0; i < inputs.size() && i < result->input_interpolation.size(); i++) {
+        set_cairo_surface_ci(slot.getcairo(inputs[i]), result->input_interpolation[i]);
+    }
+
+    if (result->primitive_area) {
+        slot.set_primitive_area(output, *result->primitive_area);
+    }
+    slot.set(output, result->surface);
+    slot.set_key(slot.get_last_out(), result->id);
+    cairo_surface_destroy(result->surface);
+
+    return true;
+}
+
+void FilterCache::store(Key const &key, FilterSlot &slot, std::vector<int> const &inputs)
+{
+    int const output = slot.get_last_out();
+
+    std::optional<Geom::Rect> primitive_area;
+    if (slot.has_primitive_area(output)) {
+        primitive_area = slot.get_primitive_area(output);
+    }
+    std::vector<SPColorInterpolation> input_interpolation;
+    for (int input : inputs) {
+        input_interpolation.push_back(get_cairo_surface_ci(slot.getcairo(input)));
+    }
+
+    auto const id = store(key, slot.get_slot_area(), slot.getcairo(output), primitive_area, std::move(input_interpolation));
+    slot.set_key(output, id);
+}
+
+} // namespace Filters
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of filter primitive results, shared between redraws.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_NR_FILTER_CACHE_H
+#define SEEN_INKSCAPE_DISPLAY_NR_FILTER_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <2geom/affine.h>
+#include <2geom/rect.h>
+
+#include "style-enums.h"
+
+extern "C" {
+typedef struct _cairo_surface cairo_surface_t;
+}
+
+namespace Inkscape {
+namespace Filters {
+
+class FilterSlot;
+
+/**
+ * Cache of the outputs of filter primitives.
+ *
+ * An output is filed under a Key: the filter primitive, the rendering parameters of the filter
+ * (transform, filter region, resolution, quality) and the ids of the images the primitive read.
+ * None of these change when the canvas is panned; what does change is the area being rendered,
+ * which is kept alongside. A result covering a larger area is reused for any part of it, by copying
+ * that part at its offset, so redrawing a tile or an area uncovered by an unrelated change costs a
+ * lookup and a copy.
+ *
+ * Every cached image has an id that identifies its contents over the whole of its area. The source
+ * graphic and background image get theirs from identify(), which compares their pixels with those
+ * of earlier ones; the output of a primitive gets the id of the result it was restored from, or a
+ * new one when it is stored.
+ *
+ * The least recently used results are evicted to stay within a memory budget. The cache may be
+ * used by several rendering threads at once.
+ */
+class FilterCache
+{
+public:
+    /// Everything a cached image depends on, apart from the area it covers.
+    struct Key
+    {
+        std::uint64_t filter = 0; ///< Uid of the filter, renewed whenever it is rebuilt.
+        int primitive = 0;        ///< Index of the primitive, or the slot of a source image.
+        Geom::Affine ctm;
+        Geom::Affine display2pb;
+        Geom::OptRect item_bbox;
+        Geom::OptRect filter_area;
+        double resolution_x = 0.0;
+        double resolution_y = 0.0;
+        int blurquality = 0;
+        int device_scale = 1;
+        std::vector<std::uint64_t> inputs; ///< Ids and color interpolation of the images read.
+
+        bool operator==(Key const &other) const;
+        bool operator!=(Key const &other) const { return !(*this == other); }
+        std::uint64_t hash() const;
+    };
+
+    /// A cached image, as returned by lookup().
+    struct Result
+    {
+        cairo_surface_t *surface = nullptr; ///< A new surface covering the requested area, owned by the caller.
+        std::uint64_t id = 0;
+        std::optional<Geom::Rect> primitive_area;
+        std::vector<SPColorInterpolation> input_interpolation;
+    };
+
+    explicit FilterCache(std::size_t budget);
+    ~FilterCache();
+    FilterCache(FilterCache const &) = delete;
+    FilterCache &operator=(FilterCache const &) = delete;
+
+    /// Change the memory budget in bytes, evicting results if necessary.
+    void setBudget(std::size_t budget);
+    std::size_t budget() const { return _budget; }
+
+    /// Drop all cached results.
+    void clear();
+
+    /**
+     * Find an image cached under the key whose area contains the given area, at a whole number of
+     * pixels from its corner, and return a copy of that part of it.
+     * Area and offsets are in filter (pb) units, scaled by the device scale of the key for pixels.
+     */
+    std::optional<Result> lookup(Key const &key, Geom::Rect const &area);
+
+    /**
+     * Cache a copy of an image covering the given area, and return its id. Nothing is stored
+     * if the image is larger than the budget or not an image surface of the size of the area, but
+     * an id is returned all the same.
+     */
+    std::uint64_t store(Key const &key, Geom::Rect const &area, cairo_surface_t *surface,
+                        std::optional<Geom::Rect> primitive_area = {},
+                        std::vector<SPColorInterpolation> input_interpolation = {});
+
+    /**
+     * Return the id of the contents of a source image: that of an image cached under the same key
+     * if its pixels are the same where they overlap, else that of a new copy.
+     */
+    std::uint64_t identify(Key const &key, Geom::Rect const &area, cairo_surface_t *surface);
+
+    /**
+     * If a result is cached under the given key, put it in the output slot of the primitive, as
+     * rendering the primitive would have done, and return true.
+     */
+    bool restore(Key const &key, FilterSlot &slot, int output, std::vector<int> const &inputs);
+
+    /// Store the result just rendered by a primitive, found in the last output slot.
+    void store(Key const &key, FilterSlot &slot, std::vector<int> const &inputs);
+
+    /// Size of the cached results in bytes.
+    std::size_t size() const;
+
+    /// Number of cached images.
+    std::size_t count() const;
+
+private:
+    struct Entry
+    {
+        Key key;
+        std::uint64_t hash;
+        std::uint64_t id;
+        Geom::Rect area;
+        cairo_surface_t *surface;
+        std::size_t size;
+        std::optional<Geom::Rect> primitive_area;             ///< Primitive area of the output slot.
+        std::vector<SPColorInterpolation> input_interpolation; ///< Input color spaces after rendering.
+    };
+    using Entries = std::list<Entry>;
+
+    template <typename F>
+    Entries::iterator _find(Key const &key, std::uint64_t hash, Geom::Rect const &area, F &&accept);
+    static bool _storable(Entry const &entry, cairo_surface_t *surface);
+    std::uint64_t _store(Entry entry, cairo_surface_t *surface, bool shared);
+    std::uint64_t _insert(Entry entry);
+    void _evict(std::size_t budget);
+
+    std::size_t _budget;
+    std::size_t _size = 0;
+    std::uint64_t _last_id = 0;
+    mutable std::mutex _mutex;
+    Entries _entries; ///< Most recently used first.
+    std::unordered_multimap<std::uint64_t, Entries::iterator> _index;
+};
+
+} // namespace Filters
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DISPLAY_NR_FILTER_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -13,6 +13,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-colormatrix.h"
@@ -43,30 +44,12 @@ FilterColorMatrix::ColorMatrixMatrix::ColorMatrixMatrix(std::vector<double> cons
 
 guint32 FilterColorMatrix::ColorMatrixMatrix::operator()(guint32 in)
 {
-    EXTRACT_ARGB32(in, a, r, g, b)
-    // we need to un-premultiply alpha values for this type of matrix
-    // TODO: unpremul can be ignored if there is an identity mapping on the alpha channel
-    if (a != 0) {
-        r = unpremul_alpha(r, a);
-        g = unpremul_alpha(g, a);
-        b = unpremul_alpha(b, a);
-    }
+    return Display::color_matrix_pixel(_v, in);
+}
 
-    gint32 ro = r*_v[0]  + g*_v[1]  + b*_v[2]  + a*_v[3]  + _v[4];
-    gint32 go = r*_v[5]  + g*_v[6]  + b*_v[7]  + a*_v[8]  + _v[9];
-    gint32 bo = r*_v[10] + g*_v[11] + b*_v[12] + a*_v[13] + _v[14];
-    gint32 ao = r*_v[15] + g*_v[16] + b*_v[17] + a*_v[18] + _v[19];
-    ro = (pxclamp(ro, 0, 255*255) + 127) / 255;
-    go = (pxclamp(go, 0, 255*255) + 127) / 255;
-    bo = (pxclamp(bo, 0, 255*255) + 127) / 255;
-    ao = (pxclamp(ao, 0, 255*255) + 127) / 255;
-
-    ro = premul_alpha(ro, ao);
-    go = premul_alpha(go, ao);
-    bo = premul_alpha(bo, ao);
-
-    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
-    return pxout;
+void FilterColorMatrix::ColorMatrixMatrix::filter_row(guint32 const *in, guint32 *out, int n)
+{
+    Display::color_matrix_row(_v, in, out, n);
 }
 
 struct ColorMatrixSaturate
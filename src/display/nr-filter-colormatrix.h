@@ -55,6 +55,7 @@ public:
     {
         ColorMatrixMatrix(std::vector<double> const &values);
         guint32 operator()(guint32 in);
+        void filter_row(guint32 const *in, guint32 *out, int n);
     private:
         gint32 _v[20];
     };
@@ -12,6 +12,7 @@
  */
 
 #include <cmath>
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-component-transfer.h"
@@ -37,6 +38,11 @@ struct UnmultiplyAlpha
         ASSEMBLE_ARGB32(out, a, r, g, b);
         return out;
     }
+
+    void filter_row(guint32 const *in, guint32 *out, int n)
+    {
+        Display::unpremultiply_row(in, out, n);
+    }
 };
 
 struct MultiplyAlpha
@@ -50,6 +56,11 @@ struct MultiplyAlpha
         ASSEMBLE_ARGB32(out, a, r, g, b);
         return out;
     }
+
+    void filter_row(guint32 const *in, guint32 *out, int n)
+    {
+        Display::premultiply_row(in, out, n);
+    }
 };
 
 struct ComponentTransfer
@@ -33,6 +33,7 @@ public:
 
     void set_input(int input) override;
     void set_input(int input, int slot) override;
+    void get_inputs(std::vector<int> &inputs) const override;
 
     void set_operator(FeCompositeOperator op);
     void set_arithmetic(double k1, double k2, double k3, double k4);
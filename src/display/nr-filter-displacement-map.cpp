@@ -106,6 +106,12 @@ void FilterDisplacementMap::set_input(int input, int slot)
     if (input == 1) _input2 = slot;
 }
 
+void FilterDisplacementMap::get_inputs(std::vector<int> &inputs) const
+{
+    inputs.push_back(_input);
+    inputs.push_back(_input2);
+}
+
 void FilterDisplacementMap::set_channel_selector(int s, FilterDisplacementMapChannelSelector channel)
 {
     if (channel > DISPLACEMENTMAP_CHANNEL_ALPHA || channel < DISPLACEMENTMAP_CHANNEL_RED) {
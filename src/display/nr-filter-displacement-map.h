@@ -30,6 +30,7 @@ public:
 
     void set_input(int slot) override;
     void set_input(int input, int slot) override;
+    void get_inputs(std::vector<int> &inputs) const override;
     void set_scale(double s);
     void set_channel_selector(int s, FilterDisplacementMapChannelSelector channel);
 
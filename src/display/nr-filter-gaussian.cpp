@@ -22,10 +22,9 @@
 #include <cstdlib>
 #include <glib.h>
 #include <limits>
-#if HAVE_OPENMP
-#include <omp.h>
-#endif //HAVE_OPENMP
+#include <vector>
 
+#include "async/scheduler.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-primitive.h"
 #include "display/nr-filter-gaussian.h"
@@ -35,9 +34,6 @@
 #include <2geom/affine.h>
 #include "util/fixed_point.h"
 
-#ifndef INK_UNUSED
-#define INK_UNUSED(x) ((void)(x))
-#endif
 
 // IIR filtering method based on:
 // L.J. van Vliet, I.T. Young, and P.W. Verbeek, Recursive Gaussian Derivative Filters,
@@ -289,8 +285,7 @@ template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA>
 static void
 filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
              PT const *const src, int const sstr1, int const sstr2,
-             int const n1, int const n2, IIRValue const b[N+1], double const M[N*N],
-             IIRValue *const tmpdata[], int const num_threads)
+             int const n1, int const n2, IIRValue const b[N+1], double const M[N*N])
 {
     assert(src && dest);
 
@@ -302,53 +297,33 @@ filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
     #define PREMUL_ALPHA_LOOP for(unsigned int c=1; c<PC; ++c)
 #endif
 
-INK_UNUSED(num_threads); // to suppress unused argument compiler warning
-#if HAVE_OPENMP
-#pragma omp parallel for num_threads(num_threads)
-#endif // HAVE_OPENMP
-    for ( int c2 = 0 ; c2 < n2 ; c2++ ) {
-#if HAVE_OPENMP
-        unsigned int tid = omp_get_thread_num();
-#else
-        unsigned int tid = 0;
-#endif // HAVE_OPENMP
-        // corresponding line in the source and output buffer
-        PT const * srcimg = src  + c2*sstr2;
-        PT       * dstimg = dest + c2*dstr2 + n1*dstr1;
-        // Border constants
-        IIRValue imin[PC];  copy_n(srcimg + (0)*sstr1, PC, imin);
-        IIRValue iplus[PC]; copy_n(srcimg + (n1-1)*sstr1, PC, iplus);
-        // Forward pass
-        IIRValue u[N+1][PC];
-        for(unsigned int i=0; i<N; i++) copy_n(imin, PC, u[i]);
-        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
-            for(unsigned int i=N; i>0; i--) copy_n(u[i-1], PC, u[i]);
-            copy_n(srcimg, PC, u[0]);
-            srcimg += sstr1;
-            for(unsigned int c=0; c<PC; c++) u[0][c] *= b[0];
-            for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) u[0][c] += u[i][c]*b[i];
-            }
-            copy_n(u[0], PC, tmpdata[tid]+c1*PC);
-        }
-        // Backward pass
-        IIRValue v[N+1][PC];
-        calcTriggsSdikaInitialization<PC>(M, u, iplus, iplus, b[0], v);
-        dstimg -= dstr1;
-        if ( PREMULTIPLIED_ALPHA ) {
-            dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
-            PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
-        } else {
-            for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
-        }
-        int c1=n1-1;
-        while(c1-->0) {
-            for(unsigned int i=N; i>0; i--) copy_n(v[i-1], PC, v[i]);
-            copy_n(tmpdata[tid]+c1*PC, PC, v[0]);
-            for(unsigned int c=0; c<PC; c++) v[0][c] *= b[0];
-            for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) v[0][c] += v[i][c]*b[i];
+    Async::Scheduler::get().parallel_for_ranges(0, n2, [&] (int first, int last) {
+        // Temporary storage for the forward pass over a line
+        // NOTE: This can be eliminated, but it reduces the precision a bit
+        std::vector<IIRValue> tmp(n1 * PC);
+        for ( int c2 = first ; c2 < last ; c2++ ) {
+            // corresponding line in the source and output buffer
+            PT const * srcimg = src  + c2*sstr2;
+            PT       * dstimg = dest + c2*dstr2 + n1*dstr1;
+            // Border constants
+            IIRValue imin[PC];  copy_n(srcimg + (0)*sstr1, PC, imin);
+            IIRValue iplus[PC]; copy_n(srcimg + (n1-1)*sstr1, PC, iplus);
+            // Forward pass
+            IIRValue u[N+1][PC];
+            for(unsigned int i=0; i<N; i++) copy_n(imin, PC, u[i]);
+            for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+                for(unsigned int i=N; i>0; i--) copy_n(u[i-1], PC, u[i]);
+                copy_n(srcimg, PC, u[0]);
+                srcimg += sstr1;
+                for(unsigned int c=0; c<PC; c++) u[0][c] *= b[0];
+                for(unsigned int i=1; i<N+1; i++) {
+                    for(unsigned int c=0; c<PC; c++) u[0][c] += u[i][c]*b[i];
+                }
+                copy_n(u[0], PC, tmp.data()+c1*PC);
             }
+            // Backward pass
+            IIRValue v[N+1][PC];
+            calcTriggsSdikaInitialization<PC>(M, u, iplus, iplus, b[0], v);
             dstimg -= dstr1;
             if ( PREMULTIPLIED_ALPHA ) {
                 dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
@@ -356,8 +331,24 @@ INK_UNUSED(num_threads); // to suppress unused argument compiler warning
             } else {
                 for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
             }
+            int c1=n1-1;
+            while(c1-->0) {
+                for(unsigned int i=N; i>0; i--) copy_n(v[i-1], PC, v[i]);
+                copy_n(tmp.data()+c1*PC, PC, v[0]);
+                for(unsigned int c=0; c<PC; c++) v[0][c] *= b[0];
+                for(unsigned int i=1; i<N+1; i++) {
+                    for(unsigned int c=0; c<PC; c++) v[0][c] += v[i][c]*b[i];
+                }
+                dstimg -= dstr1;
+                if ( PREMULTIPLIED_ALPHA ) {
+                    dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
+                    PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
+                } else {
+                    for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
+                }
+            }
         }
-    }
+    });
 }
 
 // Filters over 1st dimension
@@ -367,110 +358,107 @@ template<typename PT, unsigned int PC>
 static void
 filter2D_FIR(PT *const dst, int const dstr1, int const dstr2,
              PT const *const src, int const sstr1, int const sstr2,
-             int const n1, int const n2, FIRValue const *const kernel, int const scr_len, int const num_threads)
+             int const n1, int const n2, FIRValue const *const kernel, int const scr_len)
 {
     assert(src && dst);
 
-    // Past pixels seen (to enable in-place operation)
-    PT history[scr_len+1][PC];
+    Async::Scheduler::get().parallel_for_ranges(0, n2, [&] (int first, int last) {
+        // Past pixels seen (to enable in-place operation)
+        PT history[scr_len+1][PC];
 
-INK_UNUSED(num_threads); // suppresses unused argument compiler warning
-#if HAVE_OPENMP
-#pragma omp parallel for num_threads(num_threads) private(history)
-#endif // HAVE_OPENMP
-    for ( int c2 = 0 ; c2 < n2 ; c2++ ) {
+        for ( int c2 = first ; c2 < last ; c2++ ) {
 
-        // corresponding line in the source buffer
-        int const src_line = c2 * sstr2;
+            // corresponding line in the source buffer
+            int const src_line = c2 * sstr2;
 
-        // current line in the output buffer
-        int const dst_line = c2 * dstr2;
+            // current line in the output buffer
+            int const dst_line = c2 * dstr2;
 
-        int skipbuf[4] = {INT_MIN, INT_MIN, INT_MIN, INT_MIN};
+            int skipbuf[4] = {INT_MIN, INT_MIN, INT_MIN, INT_MIN};
 
-        // history initialization
-        PT imin[PC]; copy_n(src + src_line, PC, imin);
-        for(int i=0; i<scr_len; i++) copy_n(imin, PC, history[i]);
+            // history initialization
+            PT imin[PC]; copy_n(src + src_line, PC, imin);
+            for(int i=0; i<scr_len; i++) copy_n(imin, PC, history[i]);
 
-        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+            for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
 
-            int const src_disp = src_line + c1 * sstr1;
-            int const dst_disp = dst_line + c1 * dstr1;
+                int const src_disp = src_line + c1 * sstr1;
+                int const dst_disp = dst_line + c1 * dstr1;
 
-            // update history
-            for(int i=scr_len; i>0; i--) copy_n(history[i-1], PC, history[i]);
-            copy_n(src + src_disp, PC, history[0]);
+                // update history
+                for(int i=scr_len; i>0; i--) copy_n(history[i-1], PC, history[i]);
+                copy_n(src + src_disp, PC, history[0]);
 
-            // for all bytes of the pixel
-            for ( unsigned int byte = 0 ; byte < PC ; byte++) {
+                // for all bytes of the pixel
+                for ( unsigned int byte = 0 ; byte < PC ; byte++) {
 
-                if(skipbuf[byte] > c1) continue;
+                    if(skipbuf[byte] > c1) continue;
 
-                FIRValue sum = 0;
-                int last_in = -1;
-                int different_count = 0;
+                    FIRValue sum = 0;
+                    int last_in = -1;
+                    int different_count = 0;
 
-                // go over our point's neighbours in the history
-                for ( int i = 0 ; i <= scr_len ; i++ ) {
-                    // value at the pixel
-                    PT in_byte = history[i][byte];
+                    // go over our point's neighbours in the history
+                    for ( int i = 0 ; i <= scr_len ; i++ ) {
+                        // value at the pixel
+                        PT in_byte = history[i][byte];
 
-                    // is it the same as last one we saw?
-                    if(in_byte != last_in) different_count++;
-                    last_in = in_byte;
+                        // is it the same as last one we saw?
+                        if(in_byte != last_in) different_count++;
+                        last_in = in_byte;
 
-                    // sum pixels weighted by the kernel
-                    sum += in_byte * kernel[i];
-                }
-
-                // go over our point's neighborhood on x axis in the in buffer
-                int nb_src_disp = src_disp + byte;
-                for ( int i = 1 ; i <= scr_len ; i++ ) {
-                    // the pixel we're looking at
-                    int c1_in = c1 + i;
-                    if (c1_in >= n1) {
-                        c1_in = n1 - 1;
-                    } else {
-                        nb_src_disp += sstr1;
+                        // sum pixels weighted by the kernel
+                        sum += in_byte * kernel[i];
                     }
 
-                    // value at the pixel
-                    PT in_byte = src[nb_src_disp];
-
-                    // is it the same as last one we saw?
-                    if(in_byte != last_in) different_count++;
-                    last_in = in_byte;
-
-                    // sum pixels weighted by the kernel
-                    sum += in_byte * kernel[i];
-                }
+                    // go over our point's neighborhood on x axis in the in buffer
+                    int nb_src_disp = src_disp + byte;
+                    for ( int i = 1 ; i <= scr_len ; i++ ) {
+                        // the pixel we're looking at
+                        int c1_in = c1 + i;
+                        if (c1_in >= n1) {
+                            c1_in = n1 - 1;
+                        } else {
+                            nb_src_disp += sstr1;
+                        }
+
+                        // value at the pixel
+                        PT in_byte = src[nb_src_disp];
+
+                        // is it the same as last one we saw?
+                        if(in_byte != last_in) different_count++;
+                        last_in = in_byte;
+
+                        // sum pixels weighted by the kernel
+                        sum += in_byte * kernel[i];
+                    }
 
-                // store the result in bufx
-                dst[dst_disp + byte] = round_cast<PT>(sum);
-
-                // optimization: if there was no variation within this point's neighborhood,
-                // skip ahead while we keep seeing the same last_in byte:
-                // blurring flat color would not change it anyway
-                if (different_count <= 1) { // note that different_count is at least 1, because last_in is initialized to -1
-                    int pos = c1 + 1;
-                    int nb_src_disp = src_disp + (1+scr_len)*sstr1 + byte; // src_line + (pos+scr_len) * sstr1 + byte
-                    int nb_dst_disp = dst_disp + (1)        *dstr1 + byte; // dst_line + (pos) * sstr1 + byte
-                    while(pos + scr_len < n1 && src[nb_src_disp] == last_in) {
-                        dst[nb_dst_disp] = last_in;
-                        pos++;
-                        nb_src_disp += sstr1;
-                        nb_dst_disp += dstr1;
+                    // store the result in bufx
+                    dst[dst_disp + byte] = round_cast<PT>(sum);
+
+                    // optimization: if there was no variation within this point's neighborhood,
+                    // skip ahead while we keep seeing the same last_in byte:
+                    // blurring flat color would not change it anyway
+                    if (different_count <= 1) { // note that different_count is at least 1, because last_in is initialized to -1
+                        int pos = c1 + 1;
+                        int nb_src_disp = src_disp + (1+scr_len)*sstr1 + byte; // src_line + (pos+scr_len) * sstr1 + byte
+                        int nb_dst_disp = dst_disp + (1)        *dstr1 + byte; // dst_line + (pos) * sstr1 + byte
+                        while(pos + scr_len < n1 && src[nb_src_disp] == last_in) {
+                            dst[nb_dst_disp] = last_in;
+                            pos++;
+                            nb_src_disp += sstr1;
+                            nb_dst_disp += dstr1;
+                        }
+                        skipbuf[byte] = pos;
                     }
-                    skipbuf[byte] = pos;
                 }
             }
         }
-    }
+    });
 }
 
 static void
-gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest,
-    IIRValue **tmpdata, int num_threads)
+gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest)
 {
     // Filter variables
     IIRValue b[N+1];  // scaling coefficient + filter coefficients (can be 10.21 fixed point)
@@ -500,13 +488,13 @@ gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
         filter2D_IIR<unsigned char,1,false>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
             cairo_image_surface_get_data(src),  d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            w, h, b, M, tmpdata, num_threads);
+            w, h, b, M);
         break;
     case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
         filter2D_IIR<unsigned char,4,true>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
             cairo_image_surface_get_data(src),  d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            w, h, b, M, tmpdata, num_threads);
+            w, h, b, M);
         break;
     default:
         g_warning("gaussian_pass_IIR: unsupported image format");
@@ -514,8 +502,7 @@ gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
 }
 
 static void
-gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest,
-    int num_threads)
+gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest)
 {
     int scr_len = _effect_area_scr(deviation);
     // Filter kernel for x direction
@@ -533,13 +520,13 @@ gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
         filter2D_FIR<unsigned char,1>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
             cairo_image_surface_get_data(src),  d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            w, h, &kernel[0], scr_len, num_threads);
+            w, h, &kernel[0], scr_len);
         break;
     case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
         filter2D_FIR<unsigned char,4>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
             cairo_image_surface_get_data(src),  d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            w, h, &kernel[0], scr_len, num_threads);
+            w, h, &kernel[0], scr_len);
         break;
     default:
         g_warning("gaussian_pass_FIR: unsupported image format");
@@ -587,18 +574,7 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
     deviation_x_orig *= device_scale;
     deviation_y_orig *= device_scale;
 
-    cairo_format_t fmt = cairo_image_surface_get_format(in);
-    int bytes_per_pixel = 0;
-    switch (fmt) {
-        case CAIRO_FORMAT_A8:
-            bytes_per_pixel = 1; break;
-        case CAIRO_FORMAT_ARGB32:
-        default:
-            bytes_per_pixel = 4; break;
-    }
-
     int quality = slot.get_blurquality();
-    int threads = get_num_filter_threads();
     int x_step = 1 << _effect_subsample_step_log2(deviation_x_orig, quality);
     int y_step = 1 << _effect_subsample_step_log2(deviation_y_orig, quality);
     bool resampling = x_step > 1 || y_step > 1;
@@ -619,16 +595,6 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
     bool use_IIR_x = deviation_x > 3;
     bool use_IIR_y = deviation_y > 3;
 
-    // Temporary storage for IIR filter
-    // NOTE: This can be eliminated, but it reduces the precision a bit
-    IIRValue * tmpdata[threads];
-    std::fill_n(tmpdata, threads, (IIRValue*)0);
-    if ( use_IIR_x || use_IIR_y ) {
-        for(int i = 0; i < threads; ++i) {
-            tmpdata[i] = new IIRValue[std::max(w_downsampled,h_downsampled)*bytes_per_pixel];
-        }
-    }
-
     cairo_surface_t *downsampled = nullptr;
     if (resampling) {
         // Divide by device scale as w_downsampled is in pixels while
@@ -647,24 +613,17 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
 
     if (scr_len_x > 0) {
         if (use_IIR_x) {
-            gaussian_pass_IIR(Geom::X, deviation_x, downsampled, downsampled, tmpdata, threads);
+            gaussian_pass_IIR(Geom::X, deviation_x, downsampled, downsampled);
         } else {
-            gaussian_pass_FIR(Geom::X, deviation_x, downsampled, downsampled, threads);
+            gaussian_pass_FIR(Geom::X, deviation_x, downsampled, downsampled);
         }
     }
 
     if (scr_len_y > 0) {
         if (use_IIR_y) {
-            gaussian_pass_IIR(Geom::Y, deviation_y, downsampled, downsampled, tmpdata, threads);
+            gaussian_pass_IIR(Geom::Y, deviation_y, downsampled, downsampled);
         } else {
-            gaussian_pass_FIR(Geom::Y, deviation_y, downsampled, downsampled, threads);
-        }
-    }
-
-    // free the temporary data
-    if ( use_IIR_x || use_IIR_y ) {
-        for(int i = 0; i < threads; ++i) {
-            delete[] tmpdata[i];
+            gaussian_pass_FIR(Geom::Y, deviation_y, downsampled, downsampled);
         }
     }
 
@@ -31,6 +31,7 @@ public:
 
     void set_input(int input) override;
     void set_input(int input, int slot) override;
+    void get_inputs(std::vector<int> &inputs) const override;
 
     Glib::ustring name() const override { return Glib::ustring("Merge"); }
 
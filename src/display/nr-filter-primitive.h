@@ -13,6 +13,7 @@
 #define SEEN_NR_FILTER_PRIMITIVE_H
 
 #include <memory>
+#include <vector>
 #include <2geom/forward.h>
 #include <2geom/rect.h>
 
@@ -72,6 +73,20 @@ public:
      */
     virtual void set_output(int slot);
 
+    int get_output() const { return _output; }
+
+    /**
+     * Appends the slots read by this primitive. Its result is cached by the contents of these
+     * slots, so this must include every input that can affect the result.
+     */
+    virtual void get_inputs(std::vector<int> &inputs) const { inputs.push_back(_input); }
+
+    /**
+     * Indicate whether the result only depends on the inputs and parameters of the primitive,
+     * so can be reused by the filter cache for the same inputs.
+     */
+    virtual bool can_cache() const { return true; }
+
     // returns cache score factor, reflecting the cost of rendering this filter
     // this should return how many times slower this primitive is that normal rendering
     virtual double complexity(Geom::Affine const &/*ctm*/) const { return 1.0; }
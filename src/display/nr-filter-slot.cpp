@@ -236,7 +236,9 @@ void FilterSlot::set(int slot_nr, cairo_surface_t *surface)
         slot_nr = NR_FILTER_UNNAMED_SLOT;
 
     _set_internal(slot_nr, surface);
+    _keys.erase(slot_nr);
     _last_out = slot_nr;
+    _set_count++;
 }
 
 void FilterSlot::set_primitive_area(int slot_nr, Geom::Rect &area)
@@ -260,6 +262,50 @@ Geom::Rect FilterSlot::get_primitive_area(int slot_nr) const
     return s->second;
 }
 
+bool FilterSlot::has_primitive_area(int slot_nr) const
+{
+    if (slot_nr == NR_FILTER_SLOT_NOT_SET)
+        slot_nr = _last_out;
+
+    return _primitiveAreas.find(slot_nr) != _primitiveAreas.end();
+}
+
+std::optional<std::uint64_t> FilterSlot::get_key(int slot_nr) const
+{
+    if (slot_nr == NR_FILTER_SLOT_NOT_SET)
+        slot_nr = _last_out;
+
+    auto k = _keys.find(slot_nr);
+    if (k != _keys.end()) {
+        return k->second;
+    }
+
+    switch (slot_nr) {
+        case NR_FILTER_SOURCEGRAPHIC:
+        case NR_FILTER_SOURCEALPHA:
+        case NR_FILTER_BACKGROUNDIMAGE:
+        case NR_FILTER_BACKGROUNDALPHA:
+            // Not identified yet.
+            return {};
+        default:
+            break;
+    }
+    if (_slots.find(slot_nr) != _slots.end()) {
+        // Set by a primitive which was not cached.
+        return {};
+    }
+    // Read as an empty surface.
+    return 0;
+}
+
+void FilterSlot::set_key(int slot_nr, std::uint64_t key)
+{
+    if (slot_nr == NR_FILTER_SLOT_NOT_SET)
+        slot_nr = _last_out;
+
+    _keys[slot_nr] = key;
+}
+
 Geom::Rect FilterSlot::get_slot_area() const
 {
     return Geom::Rect::from_xywh(_slot_x, _slot_y, _slot_w, _slot_h);
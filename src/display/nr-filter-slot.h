@@ -15,7 +15,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstdint>
 #include <map>
+#include <optional>
 #include "nr-filter-types.h"
 #include "nr-filter-units.h"
 
@@ -59,6 +61,21 @@ public:
 
     void set_primitive_area(int slot, Geom::Rect &area);
     Geom::Rect get_primitive_area(int slot) const;
+    bool has_primitive_area(int slot) const;
+
+    /** Returns the id of the contents of the specified slot in the filter cache, or nothing if
+     * they are unknown: set by an uncached primitive, or a source image not yet identified.
+     */
+    std::optional<std::uint64_t> get_key(int slot) const;
+
+    /** Sets the id of the contents of the specified slot in the filter cache. */
+    void set_key(int slot, std::uint64_t key);
+
+    /** Returns the slot most recently set, read by primitives whose input is not set. */
+    int get_last_out() const { return _last_out; }
+
+    /** Returns the number of times set() has been called, to tell whether a primitive set its output. */
+    int get_set_count() const { return _set_count; }
     
     /** Returns the number of slots in use. */
     int get_slot_count() const { return _slots.size(); }
@@ -82,6 +99,10 @@ private:
     using PrimitiveAreaMap = std::map<int, Geom::Rect>;
     PrimitiveAreaMap _primitiveAreas;
 
+    // Ids of the slot contents in the filter cache, when known
+    std::map<int, std::uint64_t> _keys;
+    int _set_count = 0;
+
     int _slot_w, _slot_h;
     double _slot_x, _slot_y;
     cairo_surface_t *_source_graphic;
@@ -11,12 +11,16 @@
  */
 
 #include <glib.h>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <optional>
 #include <string>
+#include <vector>
 #include <cairo.h>
 
 #include "display/nr-filter.h"
+#include "display/nr-filter-cache.h"
 #include "display/nr-filter-primitive.h"
 #include "display/nr-filter-slot.h"
 #include "display/nr-filter-types.h"
@@ -68,6 +72,9 @@ Filter::Filter(int n)
 
 void Filter::_common_init()
 {
+    static std::atomic<std::uint64_t> last_uid = 0;
+    _uid = ++last_uid;
+
     _slot_count = 1;
     // Having "not set" here as value means the output of last filter
     // primitive will be used as output of this filter
@@ -151,8 +158,82 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
 
     auto slot = FilterSlot(bgdc, graphic, units, rc, blurquality);
 
-    for (auto &i : primitives) {
+    // Key everything the primitives depend on apart from their inputs. The area being rendered is
+    // left out, so that results are reused for any part of the area they cover, e.g. after panning.
+    auto const cache = item->drawing().filterCache();
+    FilterCache::Key base;
+    if (cache) {
+        base.filter = _uid;
+        base.ctm = trans;
+        base.display2pb = units.get_matrix_display2pb();
+        base.item_bbox = units.get_item_bbox();
+        base.filter_area = filter_area;
+        base.resolution_x = resolution.first;
+        base.resolution_y = resolution.second;
+        base.blurquality = blurquality;
+        base.device_scale = slot.get_device_scale();
+    }
+
+    // The id of an image read by a primitive. The source graphic and background image are
+    // identified by their pixels when first read, and their alpha channels share their ids.
+    auto input_id = [&] (int input) -> std::optional<std::uint64_t> {
+        int source = input;
+        if (input == NR_FILTER_SOURCEALPHA) {
+            source = NR_FILTER_SOURCEGRAPHIC;
+        } else if (input == NR_FILTER_BACKGROUNDALPHA) {
+            source = NR_FILTER_BACKGROUNDIMAGE;
+        }
+        if (source != NR_FILTER_SOURCEGRAPHIC && source != NR_FILTER_BACKGROUNDIMAGE) {
+            return slot.get_key(input);
+        }
+        if (auto id = slot.get_key(source)) {
+            return id;
+        }
+        auto key = base;
+        key.primitive = source;
+        cairo_surface_t *surface = slot.getcairo(source);
+        key.inputs.push_back(get_cairo_surface_ci(surface));
+        auto const id = cache->identify(key, slot.get_slot_area(), surface);
+        slot.set_key(source, id);
+        return id;
+    };
+
+    std::vector<int> inputs;
+    for (std::size_t n = 0; n < primitives.size(); n++) {
+        auto &i = primitives[n];
+
+        // Only run primitives whose inputs changed since their result was cached.
+        std::optional<FilterCache::Key> key;
+        if (cache && i->can_cache()) {
+            key = base;
+            key->primitive = n;
+            inputs.clear();
+            i->get_inputs(inputs);
+            for (auto &input : inputs) {
+                if (input == NR_FILTER_SLOT_NOT_SET) {
+                    input = slot.get_last_out();
+                }
+                auto const id = input_id(input);
+                if (!id) {
+                    key.reset();
+                    break;
+                }
+                key->inputs.push_back(*id);
+                // Primitives convert their inputs to linearRGB or sRGB in place.
+                bool const alpha = input == NR_FILTER_SOURCEALPHA || input == NR_FILTER_BACKGROUNDALPHA;
+                key->inputs.push_back(get_cairo_surface_ci(slot.getcairo(input)) | std::uint64_t{alpha} << 8);
+            }
+        }
+
+        if (key && cache->restore(*key, slot, i->get_output(), inputs)) {
+            continue;
+        }
+
+        int const set_count = slot.get_set_count();
         i->render_cairo(slot);
+        if (key && slot.get_set_count() != set_count) {
+            cache->store(*key, slot, inputs);
+        }
     }
 
     Geom::Point origin = graphic.targetLogicalBounds().min();
@@ -13,6 +13,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstdint>
 #include <memory>
 #include <cairo.h>
 #include "display/nr-filter-primitive.h"
@@ -185,6 +186,10 @@ private:
     SPFilterUnits _filter_units;
     SPFilterUnits _primitive_units;
 
+    /** Distinguishes the results of this filter in the filter cache from those of other filters,
+     * including earlier versions of the same filter element, as the renderer is rebuilt on change. */
+    std::uint64_t _uid;
+
     void _common_init();
     static int _resolution_limit(FilterQuality quality);
     std::pair<double, double> _filter_resolution(Geom::Rect const &area,
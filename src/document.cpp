@@ -40,6 +40,7 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <utility>
 
 #include <boost/range/adaptor/reversed.hpp>
 
@@ -54,6 +55,7 @@
 #include "inkscape-window.h"
 #include "profile-manager.h"
 #include "rdf.h"
+#include "style-selector-index.h"
 
 #include "live_effects/effect.h"
 
@@ -61,10 +63,15 @@
 #include "actions/actions-undo-document.h"
 #include "actions/actions-pages.h"
 
+#include "async/scheduler.h"
+
 #include "display/drawing.h"
 #include "display/control/canvas-item-drawing.h"
 #include "ui/widget/canvas.h"
 
+#include "debug/logger.h"
+#include "debug/simple-event.h"
+
 #include "3rdparty/adaptagrams/libavoid/router.h"
 
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
@@ -72,6 +79,7 @@
 
 #include "io/dir-util.h"
 #include "layer-manager.h"
+#include "libnrtype/Layout-TNG.h"
 #include "page-manager.h"
 #include "live_effects/lpeobject.h"
 #include "object/persp3d.h"
@@ -82,6 +90,8 @@
 #include "object/sp-symbol.h"
 #include "object/sp-page.h"
 
+#include "util/packed-rtree.h"
+
 #include "widgets/desktop-widget.h"
 
 #include "xml/croco-node-iface.h"
@@ -107,6 +117,20 @@ static gint doc_mem_count = 0;
 
 static unsigned long next_serial = 0;
 
+/**
+ * Spatial index over the pick boxes of the items in _node_cache. The boxes are taken from the
+ * display items of one desktop, so the index is only valid for the drawing generation it was
+ * built from.
+ */
+struct SPDocument::NodeIndex
+{
+    Inkscape::Util::PackedRTree<unsigned> tree;
+    bool built = false;
+    unsigned dkey = 0;
+    std::uint64_t generation = 0;
+    Inkscape::Drawing const *drawing = nullptr;
+};
+
 SPDocument::SPDocument() :
     keepalive(false),
     virgin(true),
@@ -161,6 +185,7 @@ SPDocument::SPDocument() :
     // XXX only for testing!
     undoStackObservers.add(console_output_undo_observer);
     _node_cache = std::deque<SPItem*>();
+    _node_index = std::make_unique<NodeIndex>();
 
     // Actions
     action_group = Gio::SimpleActionGroup::create();
@@ -513,21 +538,8 @@ SPDocument *SPDocument::createDoc(Inkscape::XML::Document *rdoc,
  */
 std::unique_ptr<SPDocument> SPDocument::copy() const
 {
-    // New SimpleDocument object where we will put all the same data
-    Inkscape::XML::Document *new_rdoc = new Inkscape::XML::SimpleDocument();
-
-    // Duplicate the svg root node AND any PI and COMMENT nodes, this should be put
-    // into xml/simple-document.h at some point to fix it's duplicate implementation.
-    for (Inkscape::XML::Node *child = rdoc->firstChild(); child; child = child->next()) {
-        if (child) {
-            // Get a new xml repr for the svg root node
-            Inkscape::XML::Node *new_child = child->duplicate(new_rdoc);
-
-            // Add the duplicated svg node as the document's rdoc
-            new_rdoc->appendChild(new_child);
-            Inkscape::GC::release(new_child);
-        }
-    }
+    // Copy of the XML document, sharing the attribute values and text of this one
+    Inkscape::XML::Document *new_rdoc = sp_repr_document_copy(rdoc);
 
     auto doc = createDoc(new_rdoc, document_filename, document_base, document_name, keepalive, nullptr);
     doc->_original_document = this;
@@ -1308,6 +1320,30 @@ std::vector<SPObject*> SPDocument::getObjectsBySelector(Glib::ustring const &sel
     return objects;
 }
 
+/**
+ * Return the style cascade compiled for matching, or null if it uses features the index does not
+ * support. The index is rebuilt on first use after styleSheetsChanged().
+ */
+Inkscape::StyleSelectorIndex const *SPDocument::getStyleSelectorIndex()
+{
+    if (!_style_selector_index_valid) {
+        if (!_style_selector_index) {
+            _style_selector_index = std::make_unique<Inkscape::StyleSelectorIndex>();
+        }
+        _style_selector_index_usable = _style_selector_index->build(style_cascade);
+        _style_selector_index_valid = true;
+    }
+    return _style_selector_index_usable ? _style_selector_index.get() : nullptr;
+}
+
+/**
+ * Must be called whenever a style sheet is added to or removed from the style cascade.
+ */
+void SPDocument::styleSheetsChanged()
+{
+    _style_selector_index_valid = false;
+}
+
 // Note: Despite appearances, this implementation is allocation-free thanks to SSO.
 std::string SPDocument::generate_unique_id(char const *prefix)
 {
@@ -1434,18 +1470,110 @@ SPDocument::_updateDocument(int update_flags)
 {
     /* Process updates */
     if (this->root->uflags || this->root->mflags) {
+        auto const start = g_get_monotonic_time();
         if (this->root->uflags) {
             SPItemCtx ctx;
             setupViewport(&ctx);
 
             DocumentUndo::ScopedInsensitive _no_undo(this);
 
+            // Text layout dominates the first update of documents with a lot of text, so compute
+            // the layouts of independent text objects in parallel.
+            bool const batch_text_layouts = !_text_layouts_batched;
+            if (batch_text_layouts) {
+                _text_layouts.emplace();
+                _text_layouts_batched = true;
+            }
+
             this->root->updateDisplay((SPCtx *)&ctx, update_flags);
+
+            if (batch_text_layouts) {
+                _runTextLayouts();
+            }
         }
         this->_emitModified();
+        update_stats.passes++;
+        update_stats.duration += (g_get_monotonic_time() - start) / 1e6;
     }
 
-    return !(this->root->uflags || this->root->mflags);
+    bool const done = !(this->root->uflags || this->root->mflags);
+    if (done && update_stats.passes) {
+        _finishUpdateStats();
+    }
+    return done;
+}
+
+namespace {
+
+class UpdateEvent : public Inkscape::Debug::SimpleEvent<Inkscape::Debug::Event::DOCUMENT>
+{
+public:
+    UpdateEvent(SPDocument::UpdateStats const &stats)
+        : SimpleEvent("update")
+    {
+        _addProperty("passes", stats.passes);
+        _addProperty("updated", stats.updated);
+        _addProperty("restyled", stats.restyled);
+        _addProperty("modified", stats.modified);
+        _addProperty("dependents", stats.dependents);
+        _addProperty("microseconds", static_cast<long>(stats.duration * 1e6));
+    }
+};
+
+} // namespace
+
+/**
+ * During an update, defer the flow of a text layout so that all layouts of the update are
+ * calculated in parallel once the objects are updated. Calls done on the main thread afterwards,
+ * unless the object was released meanwhile. Queuing the same layout again replaces its callback.
+ *
+ * @return false if no update is running, in which case the caller must lay out the text itself.
+ */
+bool SPDocument::queueTextLayout(SPObject *object, Inkscape::Text::Layout *layout, std::function<void ()> done)
+{
+    if (!_text_layouts) {
+        return false;
+    }
+
+    if (auto it = _text_layout_index.find(layout); it != _text_layout_index.end()) {
+        // Input rebuilt since queued.
+        (*_text_layouts)[it->second].done = std::move(done);
+        return true;
+    }
+
+    sp_object_ref(object);
+    _text_layout_index.emplace(layout, _text_layouts->size());
+    _text_layouts->push_back({object, layout, std::move(done)});
+    return true;
+}
+
+void SPDocument::_runTextLayouts()
+{
+    auto layouts = std::move(*_text_layouts);
+    _text_layouts.reset();
+    _text_layout_index.clear();
+
+    // Layouts share nothing but the FontFactory and the ShapingCache, which are thread-safe.
+    Async::Scheduler::get().parallel_for(0, layouts.size(), [&] (int i) {
+        layouts[i].layout->calculateFlow();
+    });
+
+    for (auto &queued : layouts) {
+        if (queued.object->document) { // Not released meanwhile.
+            queued.done();
+        }
+        sp_object_unref(queued.object);
+    }
+}
+
+/**
+ * Keep the counters of the update that has just completed, and log them in the DOCUMENT
+ * category of the debug log.
+ */
+void SPDocument::_finishUpdateStats()
+{
+    _last_update_stats = std::exchange(update_stats, {});
+    Inkscape::Debug::Logger::write<UpdateEvent>(_last_update_stats);
 }
 
 
@@ -1645,6 +1773,49 @@ void SPDocument::build_flat_item_list(unsigned int dkey, SPGroup *group, gboolea
     }
 }
 
+/**
+ * Return a spatial index of the current flat item list for the given display key, or null if
+ * picking should just scan the list. Building the index costs more than a single scan, so it is
+ * only built once the drawing has been queried twice without changing in between.
+ */
+Inkscape::Util::PackedRTree<unsigned> const *SPDocument::_getNodeIndex(unsigned dkey) const
+{
+    auto root_item = root->get_arenaitem(dkey);
+    if (!root_item) {
+        return nullptr;
+    }
+    auto const &drawing = root_item->drawing();
+
+    auto &index = *_node_index;
+    if (index.dkey != dkey || index.drawing != &drawing || index.generation != drawing.bboxGeneration()) {
+        index.tree.clear();
+        index.built = false;
+        index.dkey = dkey;
+        index.drawing = &drawing;
+        index.generation = drawing.bboxGeneration();
+        return nullptr;
+    }
+
+    if (!index.built) {
+        std::vector<Inkscape::Util::PackedRTree<unsigned>::Entry> entries;
+        entries.reserve(_node_cache.size());
+        for (unsigned i = 0; i < _node_cache.size(); i++) {
+            if (auto di = _node_cache[i]->get_arenaitem(dkey)) {
+                // DrawingItem::pick() tests either of these boxes depending on flags.
+                auto box = di->bbox();
+                box.unionWith(di->drawbox());
+                if (box) {
+                    entries.emplace_back(*box, i);
+                }
+            }
+        }
+        index.tree.build(std::move(entries));
+        index.built = true;
+    }
+
+    return &index.tree;
+}
+
 /**
 Returns the items from the descendants of group (recursively) which are at the
 point p, or NULL if none. Honors into_groups on whether to recurse into non-layer
@@ -1653,23 +1824,42 @@ If upto != NULL, then if item upto is encountered (at any level), stops searchin
 upwards in z-order and returns what it has found so far (i.e. the found items are
 guaranteed to be lower than upto). Requires a list of nodes built by build_flat_item_list.
 If items_count > 0, it'll return the topmost (in z-order) items_count items.
+If an index of the nodes is given, only the nodes near the point are tested.
  */
 static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes, unsigned dkey,
-                                                Geom::Point const &p, int items_count = 0, SPItem *upto = nullptr)
+                                                Geom::Point const &p, int items_count = 0, SPItem *upto = nullptr,
+                                                Inkscape::Util::PackedRTree<unsigned> const *index = nullptr)
 {
     double const delta = Inkscape::Preferences::get()->getDouble("/options/cursortolerance/value", 1.0);
     std::optional<bool> outline;
 
     std::vector<SPItem*> result;
 
-    bool seen_upto = !upto;
-    for (auto node : nodes) {
-        if (!seen_upto) {
-            if (node == upto) {
-                seen_upto = true;
-            }
+    std::vector<unsigned> candidates;
+    if (index) {
+        // Allow a pixel of slack for rounding differences with DrawingItem::pick().
+        auto area = Geom::Rect(p, p);
+        area.expandBy(delta + 1.0);
+        candidates = index->collect(area);
+        std::sort(candidates.begin(), candidates.end());
+    }
+
+    unsigned first = 0;
+    if (upto) {
+        auto it = std::find(nodes.begin(), nodes.end(), upto);
+        if (it == nodes.end()) {
+            return result;
+        }
+        first = it - nodes.begin() + 1;
+    }
+
+    auto const count = index ? candidates.size() : nodes.size();
+    for (std::size_t i = 0; i < count; i++) {
+        auto const pos = index ? candidates[i] : i;
+        if (pos < first) {
             continue;
         }
+        auto node = nodes[pos];
         if (auto di = node->get_arenaitem(dkey)) {
             if (!outline) {
                 if (auto cid = di->drawing().getCanvasItemDrawing()) {
@@ -1689,9 +1879,10 @@ static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes
     return result;
 }
 
-static SPItem *find_item_at_point(std::deque<SPItem*> const &nodes, unsigned dkey, Geom::Point const &p, SPItem *upto = nullptr)
+static SPItem *find_item_at_point(std::deque<SPItem*> const &nodes, unsigned dkey, Geom::Point const &p, SPItem *upto = nullptr,
+                                  Inkscape::Util::PackedRTree<unsigned> const *index = nullptr)
 {
-    auto items = find_items_at_point(nodes, dkey, p, 1, upto);
+    auto items = find_items_at_point(nodes, dkey, p, 1, upto, index);
     if (items.empty()) {
         return nullptr;
     }
@@ -1775,6 +1966,7 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
         _node_cache.clear();
         build_flat_item_list(key, this->root, true);
         _node_cache_valid=true;
+        *_node_index = {};
     }
     SPObject *current_layer = nullptr;
     SPDesktop *desktop = SP_ACTIVE_DESKTOP;
@@ -1783,7 +1975,7 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     }
     size_t item_counter = 0;
     for(int i = points.size()-1;i>=0; i--) {
-        std::vector<SPItem*> items = find_items_at_point(_node_cache, key, points[i], topmost_only);
+        std::vector<SPItem*> items = find_items_at_point(_node_cache, key, points[i], topmost_only, nullptr, _getNodeIndex(key));
         for (SPItem *item : items) {
             if (item && result.end()==find(result.begin(), result.end(), item))
                 if(all_layers || (desktop && desktop->layerManager().layerForObject(item) == current_layer)){
@@ -1817,9 +2009,12 @@ SPItem *SPDocument::getItemAtPoint( unsigned const key, Geom::Point const &p,
         _node_cache.clear();
         build_flat_item_list(key, this->root, true);
         _node_cache_valid=true;
+        *_node_index = {};
     }
 
-    SPItem *res = find_item_at_point(_node_cache, key, p, upto);
+    // The index only covers the full flat list, not the temporary one without groups.
+    auto index = into_groups ? _getNodeIndex(key) : nullptr;
+    SPItem *res = find_item_at_point(_node_cache, key, p, upto, index);
     if(!into_groups)
         _node_cache = bak;
     return res;
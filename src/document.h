@@ -21,8 +21,11 @@
 
 #include <cstddef>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 
@@ -82,6 +85,7 @@ namespace Inkscape {
     class EventLog;
     class ProfileManager;
     class PageManager;
+    class StyleSelectorIndex;
     namespace XML {
         struct Document;
         class Node;
@@ -89,6 +93,10 @@ namespace Inkscape {
     namespace Util {
         class Unit;
         class Quantity;
+        template <typename T> class PackedRTree;
+    }
+    namespace Text {
+        class Layout;
     }
 }
 
@@ -111,6 +119,20 @@ public:
     /// For sanity check in SPObject::requestDisplayUpdate
     unsigned update_in_progress = 0;
 
+    /// Work done by an update of the document, to tell which changes make updates expensive.
+    struct UpdateStats
+    {
+        unsigned passes = 0;     ///< Update passes until the document was up to date.
+        unsigned updated = 0;    ///< Objects whose update() was called.
+        unsigned restyled = 0;   ///< Objects whose style was read again from the style sheets.
+        unsigned modified = 0;   ///< Objects whose modified signal was emitted.
+        unsigned dependents = 0; ///< Objects notified of a change to an object they depend on.
+        double duration = 0.0;   ///< Seconds spent in update passes.
+    };
+
+    /// Counters of the update in progress, incremented by the objects.
+    UpdateStats update_stats;
+
     /************ Functions *****************/
 
     // Fundamental ------------------------
@@ -155,6 +177,7 @@ public:
     bool isModifiedSinceAutoSave() const { return modified_since_autosave; }
     void setModifiedSinceSave(bool const modified = true);
     void setModifiedSinceAutoSaveFalse() { modified_since_autosave = false; };
+    void setModifiedSinceAutoSaveTrue() { modified_since_autosave = true; };
 
     bool idle_handler();
     bool rerouting_handler();
@@ -162,6 +185,16 @@ public:
     void requestModified();
     bool _updateDocument(int flags); // Used by stand-alone sp_document_idle_handler
     int ensureUpToDate();
+    /// The counters of the last update that brought the document up to date.
+    UpdateStats const &getLastUpdateStats() const { return _last_update_stats; }
+
+    /**
+     * While the document is first brought up to date, queue the computation of a text layout whose
+     * input has been built. The queued layouts are computed in parallel at the end of the update
+     * pass, each followed by its done function on the main thread. Returns false if layouts are not
+     * being batched, in which case the caller must compute the layout itself.
+     */
+    bool queueTextLayout(SPObject *object, Inkscape::Text::Layout *layout, std::function<void ()> done);
 
     bool addResource(char const *key, SPObject *object);
     bool removeResource(char const *key, SPObject *object);
@@ -180,6 +213,20 @@ public:
 
 
 private:
+    void _finishUpdateStats();
+    UpdateStats _last_update_stats;
+
+    struct QueuedTextLayout
+    {
+        SPObject *object; ///< Referenced while queued.
+        Inkscape::Text::Layout *layout;
+        std::function<void ()> done;
+    };
+    void _runTextLayouts();
+    std::optional<std::vector<QueuedTextLayout>> _text_layouts; ///< Set while batching layouts.
+    std::unordered_map<Inkscape::Text::Layout const *, std::size_t> _text_layout_index;
+    bool _text_layouts_batched = false; ///< Whether the first update has been done.
+
     void _importDefsNode(SPDocument *source, Inkscape::XML::Node *defs, Inkscape::XML::Node *target_defs);
     SPObject *_activexmltree;
 
@@ -224,6 +271,8 @@ public:
 
     // Styling
     CRCascade    *getStyleCascade() { return style_cascade; }
+    Inkscape::StyleSelectorIndex const *getStyleSelectorIndex();
+    void styleSheetsChanged();
 
     // File information --------------------
 
@@ -403,6 +452,9 @@ private:
 
     // Styling
     CRCascade *style_cascade;
+    std::unique_ptr<Inkscape::StyleSelectorIndex> _style_selector_index; // Compiled style_cascade.
+    bool _style_selector_index_valid = false;
+    bool _style_selector_index_usable = false;
 
     // Desktop geometry
     mutable Geom::Affine _doc2dt;
@@ -419,6 +471,9 @@ private:
     // Find items by geometry --------------------
     mutable std::deque<SPItem*> _node_cache; // Used to speed up search.
     mutable bool _node_cache_valid;
+    struct NodeIndex;
+    mutable std::unique_ptr<NodeIndex> _node_index; // Spatial index of _node_cache.
+    Inkscape::Util::PackedRTree<unsigned> const *_getNodeIndex(unsigned dkey) const;
 
     // Box tool ----------------------------
     Persp3D *current_persp3d; /**< Currently 'active' perspective (to which, e.g., newly created boxes are attached) */
@@ -811,6 +811,11 @@ CairoRenderer::setupDocument(CairoRenderContext *ctx, SPDocument *doc, SPItem *b
         base = doc->getRoot();
     }
 
+    // Linked bitmaps may still be decoding for the canvas.
+    doc->ensureUpToDate();
+    sp_image_wait_for_decoding(doc);
+    doc->ensureUpToDate();
+
     // Most pages will ignore this setup, but we still want to initialise something useful.
     Geom::Rect d = Geom::Rect::from_xywh(Geom::Point(0,0), doc->getDimensions());
     double px_to_ctx_units = 1.0;
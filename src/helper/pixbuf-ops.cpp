@@ -21,6 +21,7 @@
 #include "display/drawing.h"
 #include "display/drawing-context.h"
 #include "document.h"
+#include "object/sp-image.h"
 #include "object/sp-root.h"
 #include "object/sp-defs.h"
 #include "object/sp-use.h"
@@ -59,6 +60,8 @@ Inkscape::Pixbuf *sp_generate_internal_bitmap(SPDocument *document,
 
     // Document
     document->ensureUpToDate();
+    sp_image_wait_for_decoding(document);
+    document->ensureUpToDate();
     unsigned dkey = SPItem::display_key_new(1);
 
     // Drawing
@@ -15,6 +15,14 @@
  */
 
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
 
@@ -26,6 +34,8 @@
 #include "preferences.h"
 #include "rdf.h"
 
+#include "async/scheduler.h"
+
 #include "display/cairo-utils.h"
 #include "display/drawing-context.h"
 #include "display/drawing.h"
@@ -33,6 +43,7 @@
 #include "io/sys.h"
 
 #include "object/sp-defs.h"
+#include "object/sp-image.h"
 #include "object/sp-item.h"
 #include "object/sp-root.h"
 
@@ -51,11 +62,193 @@
  * working PNG reader/writer, see pngtest.c, included in this distribution.
  */
 
+namespace {
+
+/**
+ * Renders horizontal bands of the export area ahead of the PNG writer.
+ *
+ * Each band is split into tiles which are rendered in parallel on the render scheduler, in the
+ * same way as the canvas renders its tiles from a snapshotted drawing. Only a bounded window of
+ * bands is kept in flight, so memory use depends on the export width but not on its height.
+ */
+class BandRenderer
+{
+public:
+    static constexpr int TILE_WIDTH = 256;
+
+    BandRenderer(Inkscape::Drawing &drawing, int width, int height, int band_height, guint32 background);
+    ~BandRenderer();
+
+    /**
+     * Return the rendered band starting at the given row, waiting for it if necessary.
+     * The pixels are in pixbuf format and must be freed with g_free().
+     * Bands are expected in increasing order; requesting any other row restarts from there.
+     * Returns null if memory could not be allocated.
+     */
+    guchar *take(int row, int &rows, int &stride);
+
+private:
+    struct Band
+    {
+        int row;
+        int rows;
+        int stride;
+        guchar *px;
+        int remaining; ///< Number of tiles not yet rendered, protected by mutex.
+    };
+
+    void _fill();
+    void _drain();
+    void _renderTile(Band &band, Geom::IntRect const &tile);
+
+    Inkscape::Drawing &_drawing;
+    int const _width;
+    int const _height;
+    int const _band_height;
+    guint32 const _background;
+    int _window;
+    int _next_row = 0; ///< First row not yet submitted for rendering.
+
+    Inkscape::Async::TaskGroup _tasks;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<std::unique_ptr<Band>> _bands; ///< Submitted bands, in order.
+    std::atomic<bool> _cancelled = false;
+};
+
+BandRenderer::BandRenderer(Inkscape::Drawing &drawing, int width, int height, int band_height, guint32 background)
+    : _drawing(drawing)
+    , _width(width)
+    , _height(height)
+    , _band_height(band_height)
+    , _background(background)
+{
+    // Keep enough tiles in flight to occupy all threads, but at least one band ahead of the writer.
+    int const numthreads = Inkscape::Async::Scheduler::get().concurrency();
+    int const tiles_per_band = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    _window = std::clamp((2 * numthreads + tiles_per_band - 1) / tiles_per_band, 2, 64);
+
+    // Bring the whole area to a renderable state once, then freeze the drawing while threads use it.
+    _drawing.update(Geom::IntRect::from_xywh(0, 0, width, height));
+    _drawing.snapshot();
+}
+
+BandRenderer::~BandRenderer()
+{
+    _cancelled = true;
+    _drain();
+    _tasks.wait();
+    _drawing.unsnapshot();
+}
+
+/// Submit bands for rendering until the window is full or the end of the area is reached.
+void BandRenderer::_fill()
+{
+    while (static_cast<int>(_bands.size()) < _window && _next_row < _height) {
+        auto band = std::make_unique<Band>();
+        band->row = _next_row;
+        band->rows = std::min(_band_height, _height - _next_row);
+        band->stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, _width);
+        band->px = g_try_new(guchar, band->rows * band->stride);
+        if (!band->px) {
+            return;
+        }
+        // One count per tile, plus one for the conversion done after the last tile.
+        band->remaining = (_width + TILE_WIDTH - 1) / TILE_WIDTH + 1;
+        _next_row += band->rows;
+
+        for (int x = 0; x < _width; x += TILE_WIDTH) {
+            auto tile = Geom::IntRect::from_xywh(x, band->row, std::min(TILE_WIDTH, _width - x), band->rows);
+            _tasks.run([this, b = band.get(), tile] { _renderTile(*b, tile); });
+        }
+        _bands.push_back(std::move(band));
+    }
+}
+
+/// Wait for all submitted bands to finish and discard them.
+void BandRenderer::_drain()
+{
+    auto lock = std::unique_lock(_mutex);
+    for (auto &band : _bands) {
+        _cond.wait(lock, [&] { return band->remaining == 0; });
+        g_free(band->px);
+    }
+    _bands.clear();
+}
+
+void BandRenderer::_renderTile(Band &band, Geom::IntRect const &tile)
+{
+    if (!_cancelled) {
+        cairo_surface_t *s = cairo_image_surface_create_for_data(
+            band.px + tile.left() * 4, CAIRO_FORMAT_ARGB32, tile.width(), tile.height(), band.stride);
+        Inkscape::DrawingContext dc(s, tile.min());
+        dc.setSource(_background);
+        dc.setOperator(CAIRO_OPERATOR_SOURCE);
+        dc.paint();
+        dc.setOperator(CAIRO_OPERATOR_OVER);
+
+        /* Render */
+        _drawing.render(dc, tile, 0);
+        cairo_surface_destroy(s);
+    }
+
+    bool last;
+    {
+        auto lock = std::lock_guard(_mutex);
+        last = --band.remaining == 1;
+    }
+
+    if (last) {
+        // The final tile of the band converts it for the writer, off the writer's thread.
+        if (!_cancelled) {
+            // PNG stores data as unpremultiplied big-endian RGBA, which means
+            // it's identical to the GdkPixbuf format.
+            convert_pixels_argb32_to_pixbuf(band.px, _width, band.rows, band.stride,
+                                            /* RGBA to ARGB with A=0 */ _background >> 8);
+        }
+        {
+            auto lock = std::lock_guard(_mutex);
+            band.remaining = 0;
+        }
+        _cond.notify_all();
+    }
+}
+
+guchar *BandRenderer::take(int row, int &rows, int &stride)
+{
+    if (_bands.empty() || _bands.front()->row != row) {
+        // Out of order request, e.g. the next pass of an interlaced image.
+        _cancelled = true;
+        _drain();
+        _cancelled = false;
+        _next_row = row;
+    }
+    _fill();
+    if (_bands.empty()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Band> band;
+    {
+        auto lock = std::unique_lock(_mutex);
+        _cond.wait(lock, [&] { return _bands.front()->remaining == 0; });
+        band = std::move(_bands.front());
+        _bands.pop_front();
+    }
+    _fill();
+
+    rows = band->rows;
+    stride = band->stride;
+    return band->px;
+}
+
+} // namespace
+
 struct SPEBP {
     unsigned long int width, height, sheight;
     guint32 background;
     Inkscape::Drawing *drawing; // it is assumed that all unneeded items are hidden
-    guchar *px;
+    BandRenderer *renderer;
     unsigned (*status)(float, void *);
     void *data;
 };
@@ -331,42 +524,17 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
         if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
     }
 
-    num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
-    num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
-
-    /* Set area of interest */
-    // bbox is now set to the entire image to prevent discontinuities
-    // in the image when blur is used (the borders may still be a bit
-    // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
-
-    /* Update to renderable state */
-    ebp->drawing->update(bbox);
-
-    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
-    unsigned char *px = g_new(guchar, num_rows * stride);
-
-    cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
-    Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
-    dc.setOperator(CAIRO_OPERATOR_SOURCE);
-    dc.paint();
-    dc.setOperator(CAIRO_OPERATOR_OVER);
-
-    /* Render */
-    ebp->drawing->render(dc, bbox, 0);
-    cairo_surface_destroy(s);
-
-    // PNG stores data as unpremultiplied big-endian RGBA, which means
-    // it's identical to the GdkPixbuf format.
-    convert_pixels_argb32_to_pixbuf(px, ebp->width, num_rows, stride,
-                                    /* RGBA to ARGB with A=0 */ ebp->background >> 8);
-    
+    int band_rows, stride;
+    guchar *px = ebp->renderer->take(row, band_rows, stride);
+    if (!px) {
+        return 0;
+    }
+    num_rows = std::min(num_rows, band_rows);
+
     // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
     const guchar* new_data = pixbuf_to_png(rows, px, num_rows, ebp->width, stride, color_type, bit_depth);
     *to_free = (void*) new_data;
-    free(px);
+    g_free(px);
 
     return num_rows;
 }
@@ -407,6 +575,8 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 	return EXPORT_ABORTED;
     }
 
+    doc->ensureUpToDate();
+    sp_image_wait_for_decoding(doc);
     doc->ensureUpToDate();
 
     /* Calculate translation by transforming to document coordinates (flipping Y)*/
@@ -456,14 +626,13 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     ebp.status = status;
     ebp.data   = data;
 
-    bool write_status = false;;
-
     ebp.sheight = 64;
-    ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
 
-    if (ebp.px) {
+    bool write_status;
+    {
+        BandRenderer renderer(drawing, width, height, ebp.sheight, ebp.background);
+        ebp.renderer = &renderer;
         write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib);
-        g_free(ebp.px);
     }
 
     // Hide items, this releases arenaitem
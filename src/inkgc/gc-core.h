@@ -57,6 +57,8 @@ struct Ops {
     void (*enable)();
     void (*disable)();
     void (*free)(void *ptr);
+    bool (*register_thread)();
+    void (*unregister_thread)();
 };
 
 struct Core {
@@ -112,6 +114,12 @@ public:
     static inline void free(void *ptr) {
         return _ops.free(ptr);
     }
+    static inline bool register_thread() {
+        return _ops.register_thread();
+    }
+    static inline void unregister_thread() {
+        _ops.unregister_thread();
+    }
 private:
     static Ops _ops;
 };
@@ -122,6 +130,26 @@ inline void init() {
 
 void request_early_collection();
 
+/**
+ * While alive, lets the current thread allocate and hold collected memory, such as XML nodes.
+ * Needed on threads not created by the collector, for example by std::async. Does nothing on
+ * threads already known to the collector, such as the main thread.
+ */
+class ThreadRegistration {
+public:
+    ThreadRegistration() : _registered(Core::register_thread()) {}
+    ~ThreadRegistration() {
+        if (_registered) {
+            Core::unregister_thread();
+        }
+    }
+    ThreadRegistration(ThreadRegistration const &) = delete;
+    ThreadRegistration &operator=(ThreadRegistration const &) = delete;
+
+private:
+    bool _registered;
+};
+
 }
 }
 
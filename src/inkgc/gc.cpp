@@ -34,10 +34,24 @@ void do_init() {
     GC_set_finalize_on_demand(0);
 
     GC_INIT();
+    GC_allow_register_threads();
 
     GC_set_warn_proc(&display_warning);
 }
 
+bool register_thread() {
+    GC_stack_base stack_base;
+    if (GC_get_stack_base(&stack_base) != GC_SUCCESS) {
+        g_warning("Could not find the stack of a thread to register with the garbage collector");
+        return false;
+    }
+    return GC_register_my_thread(&stack_base) == GC_SUCCESS;
+}
+
+void unregister_thread() {
+    GC_unregister_my_thread();
+}
+
 void *debug_malloc(std::size_t size) {
     return GC_debug_malloc(size, GC_EXTRAS);
 }
@@ -109,6 +123,10 @@ void dummy_enable() {}
 
 void dummy_disable() {}
 
+bool dummy_register_thread() { return false; }
+
+void dummy_unregister_thread() {}
+
 Ops enabled_ops = {
     &do_init,
     &GC_malloc,
@@ -128,7 +146,9 @@ Ops enabled_ops = {
     &GC_gcollect,
     &GC_enable,
     &GC_disable,
-    &GC_free
+    &GC_free,
+    &register_thread,
+    &unregister_thread
 };
 
 Ops debug_ops = {
@@ -146,7 +166,9 @@ Ops debug_ops = {
     &GC_gcollect,
     &GC_enable,
     &GC_disable,
-    &GC_debug_free
+    &GC_debug_free,
+    &register_thread,
+    &unregister_thread
 };
 
 Ops disabled_ops = {
@@ -164,7 +186,9 @@ Ops disabled_ops = {
     &dummy_gcollect,
     &dummy_enable,
     &dummy_disable,
-    &std::free
+    &std::free,
+    &dummy_register_thread,
+    &dummy_unregister_thread
 };
 
 class InvalidGCModeError : public std::runtime_error {
@@ -247,6 +271,15 @@ void stub_free(void *) {
     die_because_not_initialized();
 }
 
+bool stub_register_thread() {
+    die_because_not_initialized();
+    return false;
+}
+
+void stub_unregister_thread() {
+    die_because_not_initialized();
+}
+
 }
 
 Ops Core::_ops = {
@@ -264,7 +297,9 @@ Ops Core::_ops = {
     &stub_gcollect,
     &stub_enable,
     &stub_disable,
-    &stub_free
+    &stub_free,
+    &stub_register_thread,
+    &stub_unregister_thread
 };
 
 void Core::init() {
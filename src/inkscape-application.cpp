@@ -44,6 +44,7 @@
 #include <unistd.h>
 #include <chrono>
 #include <thread>
+#include <set>
 
 // checking if dithering is supported
 #ifdef  WITH_PATCHED_CAIRO
@@ -77,6 +78,7 @@
 #include "extension/db.h"
 #include "extension/effect.h"
 
+#include "io/batch-server.h"        // Persistent render server.
 #include "io/file.h"                // File open (command line).
 #include "io/resource.h"            // TEMPLATE
 #include "io/fix-broken-links.h"    // Fix up references.
@@ -804,6 +806,7 @@ InkscapeApplication::InkscapeApplication()
     _start_main_option_section();
     gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "shell",                 '\0', N_("Start Inkscape in interactive shell mode"),                                 "");
     gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "active-window",          'q', N_("Use active window from commandline"),                                       "");
+    gapp->add_main_option_entry(T::OPTION_TYPE_INT,      "batch-server",          '\0', N_("Serve render requests from standard input using JOBS worker processes (0 = one per CPU)"), N_("JOBS"));
     // clang-format on
 
     gapp->signal_handle_local_options().connect(sigc::mem_fun(*this, &InkscapeApplication::on_handle_local_options));
@@ -1075,6 +1078,11 @@ InkscapeApplication::on_activate()
 {
     std::string output;
 
+    if (_batch_server_jobs >= 0) {
+        batch_server(_batch_server_jobs);
+        return;
+    }
+
     // Create new document, either from pipe or from template.
     SPDocument *document = nullptr;
     auto prefs = Inkscape::Preferences::get();
@@ -1404,6 +1412,80 @@ InkscapeApplication::shell(bool active_window)
     }
 }
 
+/**
+ * Process render requests read from standard input until end of input, see Inkscape::IO::BatchServer.
+ * Each request gets a fresh copy of the export settings given on the command line.
+ */
+void
+InkscapeApplication::batch_server(int jobs)
+{
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [] (Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    auto const command_line_export = _file_export;
+
+    auto handler = [&] (std::string const &actions, std::string const &data, Inkscape::IO::BatchServer::Timing &timing) {
+        _file_export = command_line_export;
+
+        std::set<SPDocument *> kept_documents;
+        for (auto const &[doc, windows] : _documents) {
+            kept_documents.insert(doc);
+        }
+
+        auto start = Clock::now();
+        SPDocument *document = nullptr;
+        if (!data.empty()) {
+            document = document_open(data);
+            if (!document) {
+                return false;
+            }
+            INKSCAPE.add_document(document);
+            _active_document = document;
+            _active_selection = document->getSelection();
+            _active_desktop = nullptr;
+            _active_window = nullptr;
+            document->ensureUpToDate();
+        }
+        timing.load_ms = ms_since(start);
+
+        start = Clock::now();
+        bool ok = true;
+        action_vector_t action_vector;
+        parse_actions(actions, action_vector);
+        for (auto const &action : action_vector) {
+            if (!_gio_application->has_action(action.first)) {
+                std::cerr << "InkscapeApplication::batch_server: Unknown action name: " << action.first << std::endl;
+                ok = false;
+                continue;
+            }
+            _gio_application->activate_action(action.first, action.second);
+        }
+        timing.process_ms = ms_since(start);
+
+        // Close the documents the request opened, unless the actions did so already.
+        std::vector<SPDocument *> opened;
+        for (auto const &[doc, windows] : _documents) {
+            if (!kept_documents.count(doc)) {
+                opened.push_back(doc);
+            }
+        }
+        for (auto doc : opened) {
+            INKSCAPE.remove_document(doc);
+            document_close(doc);
+        }
+        _active_document = nullptr;
+        _active_selection = nullptr;
+        _active_desktop = nullptr;
+        _active_window = nullptr;
+
+        return ok;
+    };
+
+    Inkscape::IO::BatchServer(handler).run(jobs);
+}
+
 // Todo: Code can be improved by using proper IPC rather than temporary file polling.
 void InkscapeApplication::redirect_output()
 {
@@ -1572,7 +1654,8 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("action-list")           ||
         options->contains("actions")               ||
         options->contains("actions-file")          ||
-        options->contains("shell")
+        options->contains("shell")                 ||
+        options->contains("batch-server")
         ) {
         _with_gui = false;
     }
@@ -1588,6 +1671,11 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
     if (options->contains("batch-process"))  _batch_process = true;
     if (options->contains("shell"))          _use_shell = true;
     if (options->contains("pipe"))           _use_pipe  = true;
+    if (options->contains("batch-server")) {
+        _batch_server_jobs = 0;
+        options->lookup_value("batch-server", _batch_server_jobs);
+        _batch_server_jobs = std::max(_batch_server_jobs, 0);
+    }
 
     // Enable auto-export
     if (options->contains("export-filename")  ||
@@ -10,6 +10,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cstdlib>
+
 #ifdef _WIN32
 #include <windows.h> // SetDllDirectoryW, SetConsoleOutputCP
 #include <fcntl.h> // _O_BINARY
@@ -19,6 +22,7 @@
 #include "inkscape-application.h"
 #include "path-prefix.h"
 
+#include "io/batch-server.h"
 #include "io/resource.h"
 
 static void set_extensions_env()
@@ -159,6 +163,26 @@ static void convert_legacy_options(int &argc, char **&argv)
     argv = argv_new.data();
 }
 
+/**
+ * The number of jobs given with --batch-server, or -1 if the option is not given.
+ * The option is looked for before the application parses it, see main().
+ */
+static int batch_server_jobs(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (g_str_equal(argv[i], "--")) {
+            break;
+        }
+        if (g_str_has_prefix(argv[i], "--batch-server=")) {
+            return std::max(std::atoi(argv[i] + 15), 0);
+        }
+        if (g_str_equal(argv[i], "--batch-server") && i + 1 < argc) {
+            return std::max(std::atoi(argv[i + 1]), 0);
+        }
+    }
+    return -1;
+}
+
 int main(int argc, char *argv[])
 {
     convert_legacy_options(argc, argv);
@@ -204,6 +228,13 @@ int main(int argc, char *argv[])
     set_themes_env();
     set_extensions_env();
 
+    // Batch server workers must be forked before the application starts any threads.
+    if (auto const jobs = batch_server_jobs(argc, argv); jobs >= 0) {
+        if (auto const status = Inkscape::IO::BatchServer::start_workers(jobs)) {
+            return *status;
+        }
+    }
+
     auto ret = InkscapeApplication().gio_app()->run(argc, argv);
 
 #ifdef _WIN32
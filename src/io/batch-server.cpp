@@ -0,0 +1,537 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Persistent render server for batch processing from the command line.
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "batch-server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "util/scope_exit.h"
+
+namespace Inkscape {
+namespace IO {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int resolve_jobs(int jobs)
+{
+    return jobs > 0 ? jobs : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// In a worker process, the descriptor results are written to instead of standard output.
+int worker_result_fd = -1;
+
+/// Result of parsing a header line.
+struct Header
+{
+    bool quit = false;
+    std::string id;
+    std::string actions;
+    std::size_t length = 0;
+};
+
+std::optional<Header> parse_header(std::string line)
+{
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+
+    Header header;
+    std::istringstream iss(line);
+    std::string command;
+    iss >> command;
+    if (command == "quit" || command == "q") {
+        header.quit = true;
+        return header;
+    }
+    if (command != "render" || !(iss >> header.id >> header.length)) {
+        return {};
+    }
+    std::getline(iss >> std::ws, header.actions);
+    return header;
+}
+
+std::string format_result(std::string const &id, bool ok, BatchServer::Timing const &timing, double total_ms)
+{
+    std::ostringstream out;
+    out << "result " << id << (ok ? " ok" : " error") << std::fixed << std::setprecision(2)
+        << " load=" << timing.load_ms
+        << " process=" << timing.process_ms
+        << " total=" << total_ms << '\n';
+    return out.str();
+}
+
+#ifndef _WIN32
+
+bool write_all(int fd, char const *data, std::size_t size)
+{
+    while (size > 0) {
+        auto n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+#endif
+
+void print_result(std::string const &result)
+{
+#ifndef _WIN32
+    if (worker_result_fd >= 0) {
+        write_all(worker_result_fd, result.data(), result.size());
+        return;
+    }
+#endif
+    std::cout << result << std::flush;
+}
+
+} // namespace
+
+BatchServer::BatchServer(Handler handler)
+    : _handler(std::move(handler))
+{
+}
+
+void BatchServer::run(int jobs)
+{
+    if (worker_result_fd >= 0) {
+        // The dispatcher has announced the server already.
+        _runSerial();
+        return;
+    }
+
+    std::cerr << "Inkscape batch server ready (1 job). "
+              << "Send 'render ID LENGTH ACTIONS' followed by the document, or 'quit'." << std::endl;
+    if (resolve_jobs(jobs) > 1) {
+        std::cerr << "BatchServer: worker processes could not be started, processing requests serially." << std::endl;
+    }
+    _runSerial();
+}
+
+/// Run the handler, keeping whatever the actions print off the result stream.
+bool BatchServer::_process(std::string const &actions, std::string const &document, Timing &timing)
+{
+    auto const saved = std::cout.rdbuf(std::cerr.rdbuf());
+    auto restore = scope_exit([&] { std::cout.rdbuf(saved); });
+
+    try {
+        return _handler(actions, document, timing);
+    } catch (std::exception const &e) {
+        std::cerr << "BatchServer: request failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void BatchServer::_runSerial()
+{
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        auto header = parse_header(line);
+        if (!header) {
+            std::cerr << "BatchServer: malformed request: " << line << std::endl;
+            continue;
+        }
+        if (header->quit) {
+            break;
+        }
+
+        std::string document(header->length, '\0');
+        std::cin.read(document.data(), header->length);
+        if (static_cast<std::size_t>(std::cin.gcount()) != header->length) {
+            std::cerr << "BatchServer: incomplete document for request " << header->id << std::endl;
+            break;
+        }
+
+        auto const start = Clock::now();
+        Timing timing;
+        bool const ok = _process(header->actions, document, timing);
+        print_result(format_result(header->id, ok, timing, elapsed_ms(start)));
+    }
+}
+
+#ifndef _WIN32
+
+namespace {
+
+/// The number of threads of this process, or nothing where it can't be told.
+std::optional<int> thread_count()
+{
+#ifdef __linux__
+    if (auto dir = opendir("/proc/self/task")) {
+        int count = 0;
+        while (auto entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                count++;
+            }
+        }
+        closedir(dir);
+        return count;
+    }
+#endif
+    return {};
+}
+
+struct Request
+{
+    std::string id;
+    std::string data; ///< The request as sent to a worker: header line and document.
+    Clock::time_point received;
+};
+
+struct Worker
+{
+    pid_t pid;
+    int to_fd;   ///< Requests from dispatcher to worker, non-blocking.
+    int from_fd; ///< Results from worker to dispatcher.
+    bool busy = false;
+    std::string id;
+    Clock::time_point received;
+    std::string outgoing; ///< The part of the request not yet taken by the worker.
+    std::string incoming;
+};
+
+/**
+ * Distribute the requests read from standard input among the workers, and print their results.
+ * Returns the exit status of the server.
+ */
+int dispatch(std::vector<Worker> &workers)
+{
+    for (auto &w : workers) {
+        fcntl(w.to_fd, F_SETFL, fcntl(w.to_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    auto finish = [&] (Worker &w, bool ok, BatchServer::Timing const &timing) {
+        print_result(format_result(w.id, ok, timing, elapsed_ms(w.received)));
+        w.busy = false;
+    };
+
+    // Stop using a worker that died or whose pipes broke, failing its request.
+    auto retire = [&] (Worker &w) {
+        if (w.busy) {
+            finish(w, false, {});
+        }
+        close(w.to_fd);
+        close(w.from_fd);
+        waitpid(w.pid, nullptr, 0);
+        w.pid = -1;
+    };
+
+    // Pass on as much of the request as the worker's pipe takes.
+    auto send = [&] (Worker &w) {
+        while (!w.outgoing.empty()) {
+            auto const n = write(w.to_fd, w.outgoing.data(), w.outgoing.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    retire(w);
+                }
+                return;
+            }
+            w.outgoing.erase(0, n);
+        }
+    };
+
+    std::deque<Request> pending;
+    std::string input;
+    bool eof = false;
+
+    // Extract complete requests from the input buffer.
+    auto parse_input = [&] {
+        while (!eof) {
+            auto const newline = input.find('\n');
+            if (newline == std::string::npos) {
+                return;
+            }
+            auto const line = input.substr(0, newline);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                input.erase(0, newline + 1);
+                continue;
+            }
+            auto header = parse_header(line);
+            if (!header) {
+                std::cerr << "BatchServer: malformed request: " << line << std::endl;
+                input.erase(0, newline + 1);
+                continue;
+            }
+            if (header->quit) {
+                eof = true;
+                return;
+            }
+            if (input.size() < newline + 1 + header->length) {
+                return; // Wait for the rest of the document.
+            }
+            auto const size = newline + 1 + header->length;
+            pending.push_back({std::move(header->id), input.substr(0, size), Clock::now()});
+            input.erase(0, size);
+        }
+    };
+
+    int status = EXIT_SUCCESS;
+
+    while (true) {
+        for (auto &w : workers) {
+            if (!w.busy && w.pid > 0 && !pending.empty()) {
+                auto &request = pending.front();
+                w.busy = true;
+                w.id = std::move(request.id);
+                w.received = request.received;
+                w.outgoing = std::move(request.data);
+                pending.pop_front();
+                send(w);
+            }
+        }
+
+        bool const any_busy = std::any_of(workers.begin(), workers.end(), [] (auto const &w) { return w.busy; });
+        bool const any_alive = std::any_of(workers.begin(), workers.end(), [] (auto const &w) { return w.pid > 0; });
+        if (!any_alive) {
+            for (auto const &request : pending) {
+                print_result(format_result(request.id, false, {}, elapsed_ms(request.received)));
+            }
+            std::cerr << "BatchServer: all workers exited." << std::endl;
+            status = EXIT_FAILURE;
+            break;
+        }
+        if (eof && pending.empty() && !any_busy) {
+            break;
+        }
+
+        // Only read ahead while there is no backlog, to bound memory use.
+        std::vector<pollfd> fds;
+        bool const want_input = !eof && pending.size() < workers.size();
+        if (want_input) {
+            fds.push_back({STDIN_FILENO, POLLIN, 0});
+        }
+        for (auto const &w : workers) {
+            if (w.pid > 0) {
+                // Also watch idle workers, to notice those that exit before taking a request.
+                fds.push_back({w.from_fd, POLLIN, 0});
+                fds.push_back({w.outgoing.empty() ? -1 : w.to_fd, POLLOUT, 0});
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "BatchServer: poll failed: " << std::strerror(errno) << std::endl;
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        char buf[65536];
+        std::size_t i = 0;
+        if (want_input) {
+            if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+                auto const n = read(STDIN_FILENO, buf, sizeof(buf));
+                if (n > 0) {
+                    input.append(buf, n);
+                    parse_input();
+                } else if (n == 0 || errno != EINTR) {
+                    eof = true;
+                }
+            }
+            i++;
+        }
+
+        for (auto &w : workers) {
+            if (w.pid < 0) {
+                continue;
+            }
+            auto const in = fds[i++].revents;
+            auto const out = fds[i++].revents;
+
+            if (out & (POLLOUT | POLLERR)) {
+                send(w);
+                if (w.pid < 0) {
+                    continue;
+                }
+            }
+
+            if (!(in & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            auto const n = read(w.from_fd, buf, sizeof(buf));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                // The worker exited, failing the request it was processing.
+                retire(w);
+                continue;
+            }
+            w.incoming.append(buf, n);
+            auto const newline = w.incoming.find('\n');
+            if (newline != std::string::npos && w.busy) {
+                // The worker's own result line: "result ID ok|error load=MS process=MS total=MS".
+                std::istringstream iss(w.incoming.substr(0, newline));
+                w.incoming.erase(0, newline + 1);
+                std::string word, id, outcome;
+                BatchServer::Timing timing;
+                iss >> word >> id >> outcome;
+                while (iss >> word) {
+                    if (word.rfind("load=", 0) == 0) {
+                        timing.load_ms = std::atof(word.c_str() + 5);
+                    } else if (word.rfind("process=", 0) == 0) {
+                        timing.process_ms = std::atof(word.c_str() + 8);
+                    }
+                }
+                finish(w, outcome == "ok", timing);
+            }
+        }
+    }
+
+    // Closing the request pipes ends the workers' input, so that they shut down.
+    for (auto &w : workers) {
+        if (w.pid > 0) {
+            close(w.to_fd);
+        }
+    }
+    for (auto &w : workers) {
+        if (w.pid > 0) {
+            char buf[4096];
+            while (read(w.from_fd, buf, sizeof(buf)) > 0) {}
+            close(w.from_fd);
+            waitpid(w.pid, nullptr, 0);
+        }
+    }
+
+    return status;
+}
+
+} // namespace
+
+/**
+ * Between dispatcher and worker, requests and results use the same protocol as the server
+ * itself. The worker reads requests from its standard input, which is connected to the
+ * dispatcher, and writes results to a pipe of its own, as its standard output is redirected to
+ * standard error.
+ */
+std::optional<int> BatchServer::start_workers(int jobs)
+{
+    jobs = resolve_jobs(jobs);
+    if (jobs == 1) {
+        return {};
+    }
+
+    // A forked process only has the thread that called fork(). Locks held by any other thread at
+    // that moment, such as those of GLib's or the scheduler's worker threads, would never be
+    // released in the workers. Where the number of threads is unknown, it is not safe either.
+    if (thread_count() != 1) {
+        return {};
+    }
+
+    std::vector<Worker> workers;
+    std::cout.flush();
+    std::cerr.flush();
+
+    for (int i = 0; i < jobs; i++) {
+        int req[2], res[2];
+        if (pipe(req) != 0) {
+            break;
+        }
+        if (pipe(res) != 0) {
+            close(req[0]);
+            close(req[1]);
+            break;
+        }
+
+        auto const pid = fork();
+        if (pid < 0) {
+            close(req[0]); close(req[1]);
+            close(res[0]); close(res[1]);
+            break;
+        }
+
+        if (pid == 0) {
+            // Worker: read requests from the dispatcher, and keep anything printed off the results.
+            for (auto const &w : workers) {
+                close(w.to_fd);
+                close(w.from_fd);
+            }
+            close(req[1]);
+            close(res[0]);
+            dup2(req[0], STDIN_FILENO);
+            close(req[0]);
+            dup2(STDERR_FILENO, STDOUT_FILENO);
+            fcntl(res[1], F_SETFD, FD_CLOEXEC); // Not for extensions.
+            worker_result_fd = res[1];
+            return {};
+        }
+
+        close(req[0]);
+        close(res[1]);
+        auto &worker = workers.emplace_back();
+        worker.pid = pid;
+        worker.to_fd = req[1];
+        worker.from_fd = res[0];
+    }
+
+    if (workers.empty()) {
+        return {};
+    }
+
+    // A worker dying must not kill the dispatcher through a write to its pipe.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cerr << "Inkscape batch server ready (" << workers.size() << " jobs). "
+              << "Send 'render ID LENGTH ACTIONS' followed by the document, or 'quit'." << std::endl;
+
+    return dispatch(workers);
+}
+
+#else
+
+std::optional<int> BatchServer::start_workers(int)
+{
+    return {};
+}
+
+#endif // _WIN32
+
+} // namespace IO
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Persistent render server for batch processing from the command line.
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_IO_BATCH_SERVER_H
+#define INKSCAPE_IO_BATCH_SERVER_H
+
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+namespace Inkscape {
+namespace IO {
+
+/**
+ * A long-lived server that processes a stream of render requests, so that the cost of
+ * application startup (fonts, preferences, extensions) is only paid once.
+ *
+ * Requests are read from standard input. Each request is a header line
+ *
+ *     render ID LENGTH [ACTION(:ARG)[;ACTION(:ARG)]*]
+ *
+ * immediately followed by LENGTH bytes of document data (LENGTH may be 0 if the actions
+ * open a document themselves). The actions are the same as for --actions, e.g.
+ * "export-type:png;export-filename:out.png;export-do". A line reading "quit" ends the session.
+ *
+ * For each request, one line is written to standard output once it has been processed:
+ *
+ *     result ID ok|error load=MS process=MS total=MS
+ *
+ * where total also includes the time the request waited for a free worker. Results may arrive
+ * out of order when several workers are used. Anything the actions print is sent to standard
+ * error, so that standard output only carries results.
+ *
+ * With more than one job, start_workers() forks worker processes before the application starts
+ * up, while the process is known to have a single thread: a forked process only inherits the
+ * thread that called fork(), and with it none of the locks other threads might hold. Each worker
+ * then starts up as a single-job server, while the original process only distributes requests
+ * among them. This is only available on POSIX systems; otherwise, or if the number of threads
+ * can't be told, requests are processed one after another.
+ */
+class BatchServer
+{
+public:
+    struct Timing
+    {
+        double load_ms = 0.0;    ///< Time spent parsing the document.
+        double process_ms = 0.0; ///< Time spent running the actions.
+    };
+
+    /// Process one request. Returns false if the request failed.
+    using Handler = std::function<bool (std::string const &actions, std::string const &document, Timing &timing)>;
+
+    explicit BatchServer(Handler handler);
+
+    /**
+     * Fork the worker processes for the given number of jobs (0 = one per CPU). This must be
+     * called before startup. Returns the exit status once this process has served all requests
+     * through the workers, or nothing if it should go on to start up and call run(), either as
+     * a worker or because no workers are used.
+     */
+    static std::optional<int> start_workers(int jobs);
+
+    /// Serve requests until end of input or "quit", in this process.
+    void run(int jobs);
+
+private:
+    void _runSerial();
+    bool _process(std::string const &actions, std::string const &document, Timing &timing);
+
+    Handler _handler;
+};
+
+} // namespace IO
+} // namespace Inkscape
+
+#endif // INKSCAPE_IO_BATCH_SERVER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -20,6 +20,7 @@
 #include "object/sp-object.h"
 #include "object/sp-flowdiv.h"
 #include "Layout-TNG-Scanline-Maker.h"
+#include "shaping-cache.h"
 #include <limits>
 #include "livarot/Shape.h"
 
@@ -177,6 +178,7 @@ class Layout::Calculator
         std::vector<PangoItemInfo> pango_items;
         std::vector<PangoLogAttr> char_attributes;    ///< For every character in the paragraph.
         std::vector<UnbrokenSpan> unbroken_spans;
+        std::shared_ptr<ShapingCache::Paragraph> shaped; ///< Shared results of Pango for the same input.
 
         template<typename T> static void free_sequence(T &seq)
         {
@@ -189,6 +191,7 @@ class Layout::Calculator
         void free()
         {
             text = "";
+            shaped.reset();
             free_sequence(input_items);
             free_sequence(pango_items);
             free_sequence(unbroken_spans);
@@ -932,10 +935,13 @@ void Layout::Calculator::_outputLine(ParagraphInfo const &para,
                                     // calculated by shaper. We must undo this!
                                     PangoRectangle ink_rect;
                                     PangoRectangle logical_rect;
-                                    pango_font_get_glyph_extents (font->get_font(),
-                                                                  new_glyph.glyph,
-                                                                  &ink_rect,
-                                                                  &logical_rect);
+                                    {
+                                        auto lock = std::lock_guard(FontFactory::get().get_mutex());
+                                        pango_font_get_glyph_extents (font->get_font(),
+                                                                      new_glyph.glyph,
+                                                                      &ink_rect,
+                                                                      &logical_rect);
+                                    }
 
                                     // Shift required to move centered glyph back to proper position
                                     // relative to baseline.
@@ -1321,8 +1327,11 @@ void Layout::Calculator::BrokenSpan::setZero()
  * the whole thing.
  *
  * Input: para.first_input_index.
- * Output: para.direction, para.pango_items, para.char_attributes.
+ * Output: para.direction, para.pango_items, para.char_attributes, para.shaped.
  * Returns: the number of spans created by pango_itemize
+ *
+ * The results are shared through the ShapingCache with all paragraphs having the same text
+ * and attributes, so that only the first of them is itemised.
  */
 void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) const
 {
@@ -1332,6 +1341,7 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
     TRACE(("itemizing para, first input %d\n", para->first_input_index));
 
     PangoAttrList *attributes_list = pango_attr_list_new();
+    std::string shaping_key; // Everything passed to Pango, for looking up its results in the ShapingCache.
     for (unsigned input_index = para->first_input_index ; input_index < _flow._input_stream.size() ; input_index++) {
         if (_flow._input_stream[input_index]->Type() == CONTROL_CODE) {
             Layout::InputStreamControlCode const *control_code = static_cast<Layout::InputStreamControlCode const *>(_flow._input_stream[input_index]);
@@ -1352,9 +1362,20 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
             PangoAttribute *attribute_font_description = pango_attr_font_desc_new(font->get_descr());
             attribute_font_description->start_index = para->text.bytes();
 
+            auto const font_features = text_source->style->getFontFeatureString();
             PangoAttribute *attribute_font_features =
-                pango_attr_font_features_new( text_source->style->getFontFeatureString().c_str());
+                pango_attr_font_features_new(font_features.c_str());
             attribute_font_features->start_index = para->text.bytes();
+
+            char *font_description_string = pango_font_description_to_string(font->get_descr());
+            shaping_key += font_description_string;
+            shaping_key += '\x1f';
+            shaping_key += font_features;
+            shaping_key += '\x1f';
+            shaping_key += std::to_string(para->text.bytes());
+            shaping_key += '\x1f';
+            g_free(font_description_string);
+
             para->text.append(&*text_source->text_begin.base(), text_source->text_length);     // build the combined text
 
             attribute_font_description->end_index = para->text.bytes();
@@ -1366,6 +1387,8 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
             // Set language
             SPObject * object = text_source->source;
             if (!object->lang.empty()) {
+                shaping_key += object->lang;
+                shaping_key += '\x1f';
                 PangoLanguage* language = pango_language_from_string(object->lang.c_str());
                 PangoAttribute *attribute_language = pango_attr_language_new( language );
                 pango_attr_list_insert(attributes_list, attribute_language);
@@ -1376,44 +1399,75 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
     TRACE(("whole para: \"%s\"\n", para->text.data()));
 //    TRACE(("%d input sources used\n", input_index - para->first_input_index));
 
-    // Pango Itemize
-    GList *pango_items_glist = nullptr;
+    std::optional<PangoDirection> pango_direction;
     para->direction = LEFT_TO_RIGHT; // CSS default
     if (_flow._input_stream[para->first_input_index]->Type() == TEXT_SOURCE) {
         Layout::InputStreamTextSource const *text_source = static_cast<Layout::InputStreamTextSource *>(_flow._input_stream[para->first_input_index]);
 
-        para->direction =                (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? LEFT_TO_RIGHT : RIGHT_TO_LEFT;
-        PangoDirection pango_direction = (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? PANGO_DIRECTION_LTR : PANGO_DIRECTION_RTL;
-        pango_items_glist = pango_itemize_with_base_dir(_pango_context, pango_direction, para->text.data(), 0, para->text.bytes(), attributes_list, nullptr);
+        para->direction = (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? LEFT_TO_RIGHT : RIGHT_TO_LEFT;
+        pango_direction = (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? PANGO_DIRECTION_LTR : PANGO_DIRECTION_RTL;
     }
 
-    if( pango_items_glist == nullptr ) {
-        // Type wasn't TEXT_SOURCE or direction was not set.
-        pango_items_glist = pango_itemize(_pango_context, para->text.data(), 0, para->text.bytes(), attributes_list, nullptr);
+    shaping_key += std::to_string(pango_direction ? (int)*pango_direction : -1);
+    shaping_key += '\x1f';
+    shaping_key += std::to_string((int)pango_context_get_base_gravity(_pango_context));
+    shaping_key += '\x1f';
+    shaping_key += std::to_string((int)pango_context_get_gravity_hint(_pango_context));
+    shaping_key += '\x1f';
+    shaping_key += para->text.raw();
+
+    para->shaped = ShapingCache::get().lookup(shaping_key);
+    if (!para->shaped) {
+        // Itemisation loads fonts from the shared font map, so must not run concurrently.
+        auto lock = std::lock_guard(FontFactory::get().get_mutex());
+
+        // Pango Itemize
+        GList *pango_items_glist = nullptr;
+        if (pango_direction) {
+            pango_items_glist = pango_itemize_with_base_dir(_pango_context, *pango_direction, para->text.data(), 0, para->text.bytes(), attributes_list, nullptr);
+        }
+
+        if( pango_items_glist == nullptr ) {
+            // Type wasn't TEXT_SOURCE or direction was not set.
+            pango_items_glist = pango_itemize(_pango_context, para->text.data(), 0, para->text.bytes(), attributes_list, nullptr);
+        }
+
+        std::vector<PangoItem *> items;
+        items.reserve(g_list_length(pango_items_glist));
+        for (GList *current_pango_item = pango_items_glist ; current_pango_item != nullptr ; current_pango_item = current_pango_item->next) {
+            auto item = (PangoItem*)current_pango_item->data;
+            // Create the HarfBuzz font now, as Pango does so lazily and without locking.
+            pango_font_get_hb_font(item->analysis.font);
+            items.push_back(item);
+        }
+        g_list_free(pango_items_glist);
+
+        // and get the character attributes on everything
+        std::vector<PangoLogAttr> char_attributes(para->text.length() + 1);
+        pango_get_log_attrs(para->text.data(), para->text.bytes(), -1, nullptr, char_attributes.data(), char_attributes.size());
+
+        // Fix for Pango 1.49 which changes the end of a paragraph to a mandatory break.
+        // This breaks Inkscape's multiline text (i.e. sodipodi:role line).
+        char_attributes[para->text.length()].is_mandatory_break = 0;
+
+        para->shaped = ShapingCache::get().insert(shaping_key, std::move(items), std::move(char_attributes));
     }
 
     pango_attr_list_unref(attributes_list);
 
-    // convert the GList to our vector<> and make the FontInstance for each PangoItem at the same time
-    para->pango_items.reserve(g_list_length(pango_items_glist));
-    TRACE(("para itemizes to %d sections\n", g_list_length(pango_items_glist)));
-    for (GList *current_pango_item = pango_items_glist ; current_pango_item != nullptr ; current_pango_item = current_pango_item->next) {
+    // copy the items to our vector<> and make the FontInstance for each PangoItem at the same time
+    para->pango_items.reserve(para->shaped->items().size());
+    TRACE(("para itemizes to %lu sections\n", para->shaped->items().size()));
+    for (auto item : para->shaped->items()) {
         PangoItemInfo new_item;
-        new_item.item = (PangoItem*)current_pango_item->data;
+        new_item.item = pango_item_copy(item);
         PangoFontDescription *font_description = pango_font_describe(new_item.item->analysis.font);
         new_item.font = FontFactory::get().Face(font_description);
         pango_font_description_free(font_description);   // Face() makes a copy
         para->pango_items.push_back(new_item);
     }
-    g_list_free(pango_items_glist);
-
-    // and get the character attributes on everything
-    para->char_attributes.resize(para->text.length() + 1);
-    pango_get_log_attrs(para->text.data(), para->text.bytes(), -1, nullptr, &*para->char_attributes.begin(), para->char_attributes.size());
 
-    // Fix for Pango 1.49 which changes the end of a paragraph to a mandatory break.
-    // This breaks Inkscape's multiline text (i.e. sodipodi:role line).
-    para->char_attributes[para->text.length()].is_mandatory_break = 0;
+    para->char_attributes = para->shaped->charAttributes();
 
     TRACE(("end para itemize, direction = %d\n", para->direction));
 }
@@ -1588,7 +1642,6 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                 // now we know the length, do some final calculations and add the UnbrokenSpan to the list
                 new_span.font_size = text_source->style->font_size.computed * _flow.getTextLengthMultiplierDue();
                 if (new_span.text_bytes) {
-                    new_span.glyph_string = pango_glyph_string_new();
                     /* Some assertions intended to help diagnose bug #1277746. */
                     g_assert( 0 < new_span.text_bytes );
                     g_assert( span_start_byte_in_source < text_source->text->bytes() );
@@ -1609,13 +1662,8 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                     auto gnew = std::string_view(para->text.data()         + para_text_index,           new_span.text_bytes);
                     assert (gold == gnew);
 
-                    // Convert characters to glyphs
-                    pango_shape_full(para->text.data() + para_text_index,
-                                     new_span.text_bytes,
-                                     para->text.data(),
-                                     -1,
-                                     &para->pango_items[pango_item_index].item->analysis,
-                                     new_span.glyph_string);
+                    // Convert characters to glyphs, or copy them if another paragraph with the same input did.
+                    new_span.glyph_string = para->shaped->shape(para->text.data(), para_text_index, new_span.text_bytes, pango_item_index);
 
                     if (para->pango_items[pango_item_index].item->analysis.level & 1) {
                         // Right to left text (Arabic, Hebrew, etc.)
@@ -2118,7 +2166,7 @@ bool Layout::Calculator::calculate()
 
     _flow._clearOutputObjects();
 
-    _pango_context = FontFactory::get().get_font_context();
+    _pango_context = FontFactory::get().get_thread_font_context();
 
     _font_factory_size_multiplier = FontFactory::get().fontSize;
 
@@ -34,6 +34,7 @@
 #include "libnrtype/font-factory.h"
 #include "libnrtype/font-instance.h"
 #include "libnrtype/OpenTypeUtil.h"
+#include "libnrtype/shaping-cache.h"
 
 #include "util/statics.h"
 
@@ -207,6 +208,7 @@ FontFactory &FontFactory::get()
 FontFactory::FontFactory()
     : fontServer(pango_ft2_font_map_new())
     , fontContext(pango_font_map_create_context(fontServer))
+    , _main_thread(std::this_thread::get_id())
 {
     pango_ft2_font_map_set_resolution(PANGO_FT2_FONT_MAP(fontServer), 72, 72);
 #if PANGO_VERSION_CHECK(1,48,0)
@@ -214,18 +216,43 @@ FontFactory::FontFactory()
 #else
     pango_ft2_font_map_set_default_substitute(PANGO_FT2_FONT_MAP(fontServer), FactorySubstituteFunc, this, nullptr);
 #endif
+
+    // The last use of a font may end on a worker thread laying out text. Its destruction releases
+    // FreeType, HarfBuzz and Pango objects, so must not race with Face() on other threads.
+    loaded.set_disposer([this] (std::unique_ptr<FontInstance> font) {
+        auto lock = std::lock_guard(_mutex);
+        font.reset();
+    });
 }
 
 FontFactory::~FontFactory()
 {
+    // Cached itemisations keep fonts alive, which must go before main() exits with us.
+    Inkscape::Text::ShapingCache::get().clear();
     loaded.clear();
     g_object_unref(fontContext);
     g_object_unref(fontServer);
 }
 
+PangoContext *FontFactory::get_thread_font_context()
+{
+    if (std::this_thread::get_id() == _main_thread) {
+        return fontContext;
+    }
+
+    // Contexts hold a reference to their font map, so may outlive us.
+    thread_local auto context = std::unique_ptr<PangoContext, void (*)(gpointer)>(nullptr, g_object_unref);
+    if (!context) {
+        auto lock = std::lock_guard(_mutex);
+        context.reset(pango_font_map_create_context(fontServer));
+    }
+    return context.get();
+}
+
 void FontFactory::refreshConfig()
 {
     pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+    Inkscape::Text::ShapingCache::get().clear();
 }
 
 Glib::ustring FontFactory::ConstructFontSpecification(PangoFontDescription *font)
@@ -598,6 +625,8 @@ std::shared_ptr<FontInstance> FontFactory::Face(PangoFontDescription *descr, boo
     // Mandatory huge size (hinting workaround).
     pango_font_description_set_size(descr, fontSize * PANGO_SCALE);
 
+    auto lock = std::lock_guard(_mutex);
+
     // Check if already loaded.
     if (auto res = loaded.lookup(descr)) {
         return res;
@@ -691,6 +720,7 @@ void FontFactory::AddFontsDir(char const *utf8dir)
     if (res == FcTrue) {
         g_info("Fonts dir '%s' added successfully.", utf8dir);
         pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+        Inkscape::Text::ShapingCache::get().clear();
     } else {
         g_warning("Could not add fonts dir '%s'.", utf8dir);
     }
@@ -718,6 +748,7 @@ void FontFactory::AddFontFile(char const *utf8file)
     if (res == FcTrue) {
         g_info("Font file '%s' added successfully.", utf8file);
         pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+        Inkscape::Text::ShapingCache::get().clear();
     } else {
         g_warning("Could not add font file '%s'.", utf8file);
     }
@@ -14,6 +14,8 @@
 #include <algorithm>
 #include <utility>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include <pango/pango.h>
 #include "style.h"
@@ -99,10 +101,21 @@ public:
 
     PangoContext *get_font_context() const { return fontContext; }
 
+    /**
+     * A context for laying out text on the calling thread, which may be a worker thread.
+     * On the main thread this is get_font_context().
+     */
+    PangoContext *get_thread_font_context();
+
+    /// Serialises the use of the font map, which Pango does not make thread-safe. Held by Face().
+    std::recursive_mutex &get_mutex() { return _mutex; }
+
 private:
     // Pango data. Backend-specific structures are cast to these opaque types.
     PangoFontMap *fontServer;
     PangoContext *fontContext;
+    std::thread::id _main_thread;
+    std::recursive_mutex _mutex; // Recursive because Face() calls itself to fall back.
 
     // A hashmap of all the loaded font instances, indexed by their PangoFontDescription.
     // Note: Since pango already does that, using the PangoFont could work too.
@@ -11,6 +11,7 @@
 #define LIBNRTYPE_FONT_INSTANCE_H
 
 #include <map>
+#include <mutex>
 #include <vector>
 #include <optional>
 #include <unordered_map>
@@ -56,7 +57,7 @@ public:
     int MapUnicodeChar(gunichar c) const; // calls the relevant unicode->glyph index function
 
     // Loads the given glyph's info. Glyphs are lazy-loaded, but never unloaded or modified
-    // as long as the FontInstance still exists. Pointers to FontGlyphs also remain valid.
+    // as long as the FontInstance still exists. Pointers to FontGlyphs also remain valid. Thread-safe.
     FontGlyph const *LoadGlyph(int glyph_id);
 
     // nota: all coordinates returned by these functions are on a [0..1] scale; you need to multiply
@@ -165,6 +166,9 @@ private:
 
         // Lookup table mapping pango glyph ids to glyphs.
         std::unordered_map<int, std::unique_ptr<FontGlyph const>> glyphs;
+
+        // Guards glyphs and the glyph slot of the FreeType face, so text can be laid out in parallel.
+        std::mutex glyphs_mutex;
     };
 
     std::shared_ptr<Data> data;
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of Pango itemisation and shaping results, shared between text layouts.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "libnrtype/shaping-cache.h"
+
+#include <iterator>
+
+namespace Inkscape {
+namespace Text {
+
+ShapingCache::Paragraph::Paragraph(std::vector<PangoItem *> items, std::vector<PangoLogAttr> char_attributes)
+    : _items(std::move(items))
+    , _char_attributes(std::move(char_attributes))
+{
+}
+
+ShapingCache::Paragraph::~Paragraph()
+{
+    for (auto item : _items) {
+        pango_item_free(item);
+    }
+    for (auto &[range, glyphs] : _glyphs) {
+        pango_glyph_string_free(glyphs);
+    }
+}
+
+PangoGlyphString *ShapingCache::Paragraph::shape(char const *text, unsigned offset, unsigned length, unsigned item_index)
+{
+    auto const range = std::make_pair(offset, length);
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (auto it = _glyphs.find(range); it != _glyphs.end()) {
+            return pango_glyph_string_copy(it->second);
+        }
+    }
+
+    // Shape without holding the lock, as other threads may be shaping other runs.
+    auto glyphs = pango_glyph_string_new();
+    pango_shape_full(text + offset, length, text, -1, &_items[item_index]->analysis, glyphs);
+
+    auto lock = std::lock_guard(_mutex);
+    auto [it, inserted] = _glyphs.emplace(range, glyphs);
+    if (!inserted) {
+        // Shaped by another thread in the meantime.
+        pango_glyph_string_free(glyphs);
+    }
+    return pango_glyph_string_copy(it->second);
+}
+
+ShapingCache &ShapingCache::get()
+{
+    // Not a Util::Static, as it is first used on worker threads. Emptied by ~FontFactory instead,
+    // as the fonts referenced by its items must be released before main() exits.
+    static ShapingCache instance;
+    return instance;
+}
+
+ShapingCache::~ShapingCache() = default;
+
+std::shared_ptr<ShapingCache::Paragraph> ShapingCache::lookup(std::string const &key)
+{
+    auto lock = std::lock_guard(_mutex);
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return {};
+    }
+    // Mark as most recently used.
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->second;
+}
+
+std::shared_ptr<ShapingCache::Paragraph> ShapingCache::insert(std::string const &key, std::vector<PangoItem *> items,
+                                                              std::vector<PangoLogAttr> char_attributes)
+{
+    auto paragraph = std::make_shared<Paragraph>(std::move(items), std::move(char_attributes));
+
+    // Destroy evicted paragraphs after releasing the lock.
+    std::list<Entry> evicted;
+
+    auto lock = std::lock_guard(_mutex);
+    if (auto it = _index.find(key); it != _index.end()) {
+        // Itemised by another thread in the meantime.
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->second;
+    }
+    _entries.emplace_front(key, paragraph);
+    _index.emplace(key, _entries.begin());
+    while (_entries.size() > CAPACITY) {
+        _index.erase(_entries.back().first);
+        evicted.splice(evicted.end(), _entries, std::prev(_entries.end()));
+    }
+    return paragraph;
+}
+
+void ShapingCache::clear()
+{
+    std::list<Entry> evicted;
+    auto lock = std::lock_guard(_mutex);
+    _index.clear();
+    evicted.swap(_entries);
+}
+
+std::size_t ShapingCache::size() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _entries.size();
+}
+
+} // namespace Text
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Cache of Pango itemisation and shaping results, shared between text layouts.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef LIBNRTYPE_SHAPING_CACHE_H
+#define LIBNRTYPE_SHAPING_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <pango/pango.h>
+
+namespace Inkscape {
+namespace Text {
+
+/**
+ * Results of pango_itemize() and pango_shape() for paragraphs, reused by all text layouts.
+ *
+ * Layout::Calculator describes a paragraph by a key holding its text and everything it passes to
+ * Pango: the font description, font features and language of each text source, the base
+ * direction and the gravity. Paragraphs with the same key, such as those of a text object laid
+ * out again after a transform, or those of the many identical labels of a map, are then itemised
+ * only once and each of their runs shaped only once.
+ *
+ * The least recently used paragraphs are evicted beyond a fixed number. The cache must be cleared
+ * when the available fonts change, and is cleared by ~FontFactory before main() exits.
+ */
+class ShapingCache
+{
+public:
+    /// The cache shared by all layouts.
+    static ShapingCache &get();
+
+    /// The itemisation of a paragraph, and the runs of it shaped so far. Thread-safe.
+    class Paragraph
+    {
+    public:
+        Paragraph(std::vector<PangoItem *> items, std::vector<PangoLogAttr> char_attributes);
+        ~Paragraph();
+        Paragraph(Paragraph const &) = delete;
+        Paragraph &operator=(Paragraph const &) = delete;
+
+        std::vector<PangoItem *> const &items() const { return _items; }
+        std::vector<PangoLogAttr> const &charAttributes() const { return _char_attributes; }
+
+        /**
+         * Return a new copy of the glyphs of length bytes of text at offset in the paragraph,
+         * which lie within the item with the given index, shaping them if not done yet.
+         */
+        PangoGlyphString *shape(char const *text, unsigned offset, unsigned length, unsigned item_index);
+
+    private:
+        std::vector<PangoItem *> _items;
+        std::vector<PangoLogAttr> _char_attributes;
+
+        std::mutex _mutex;
+        std::map<std::pair<unsigned, unsigned>, PangoGlyphString *> _glyphs;
+    };
+
+    ShapingCache() = default;
+    ~ShapingCache();
+    ShapingCache(ShapingCache const &) = delete;
+    ShapingCache &operator=(ShapingCache const &) = delete;
+
+    /// The paragraph cached under key, or null.
+    std::shared_ptr<Paragraph> lookup(std::string const &key);
+
+    /// Cache the itemisation of a paragraph under key, taking ownership of the items.
+    std::shared_ptr<Paragraph> insert(std::string const &key, std::vector<PangoItem *> items,
+                                      std::vector<PangoLogAttr> char_attributes);
+
+    /// Drop all paragraphs, for when fonts are added or removed, or the FontFactory goes.
+    void clear();
+
+    std::size_t size() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<Paragraph>>;
+
+    static constexpr std::size_t CAPACITY = 16384; ///< Number of paragraphs kept.
+
+    mutable std::mutex _mutex;
+    std::list<Entry> _entries; ///< Most recently used first.
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+};
+
+} // namespace Text
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_SHAPING_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -10,6 +10,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <glib.h>
@@ -236,6 +237,8 @@ Shape::Reset (int pointCount, int edgeCount)
 {
   _pts.clear();
   _aretes.clear();
+  _pts.reserve(pointCount);
+  _aretes.reserve(edgeCount);
   
   type = shape_polygon;
   if (pointCount > maxPt)
@@ -262,6 +265,18 @@ Shape::Reset (int pointCount, int edgeCount)
   _bbox_up_to_date = false;
 }
 
+std::size_t
+Shape::ArenaSizeHint (int n)
+{
+  // an operation usually makes a few shapes with about as many points and edges as the polyline,
+  // each carrying the data of a sweep; reserving for two of them is enough to start with, as more
+  // than that ends up unused by stroke to path (see testfiles/benchmarks/livarot-benchmark.cpp)
+  constexpr std::size_t per_point = sizeof(dg_point) + sizeof(point_data)
+                                  + sizeof(dg_arete) + sizeof(edge_data) + sizeof(back_data)
+                                  + sizeof(sweep_src_data) + sizeof(sweep_dest_data);
+  return 2 * per_point * std::max(n, 0);
+}
+
 int
 Shape::AddPoint (const Geom::Point x)
 {
@@ -19,6 +19,7 @@
 #include <2geom/point.h>
 
 #include "livarot/LivarotDefs.h"
+#include "livarot/arena.h"
 #include "object/object-set.h"   // For BooleanOp
 
 class Path;
@@ -132,6 +133,14 @@ public:
      * @param m Number of edges to make space for.
      */
     void Reset(int n = 0, int m = 0);
+
+    /**
+     * Estimate the memory taken by the shapes of a typical operation on a polyline.
+     *
+     * @param n Number of points of the polyline.
+     * @return A size hint in bytes for an ArenaScope.
+     */
+    static std::size_t ArenaSizeHint(int n);
     //  -points:
     int AddPoint(const Geom::Point x);        // as the function name says
     // returns the index at which the point has been added in the array
@@ -420,9 +429,9 @@ public:
     void Transform(Geom::Affine const &tr)
         {for(auto & _pt : _pts) _pt.x*=tr;}
 
-    std::vector<back_data> ebData;        /*!< Stores the back data for each edge. */
+    ArenaVector<back_data> ebData;        /*!< Stores the back data for each edge. */
 
-    std::vector<sTreeChange> chgts;    /*!< An array to store all the changes that happen to a sweepline within a y value */
+    ArenaVector<sTreeChange> chgts;    /*!< An array to store all the changes that happen to a sweepline within a y value */
     int nbInc;
     int maxInc;
 
@@ -1081,16 +1090,17 @@ private:
     bool _has_back_data;        //< the ebData array is allocated
     bool _bbox_up_to_date;      ///< the leftX/rightX/topY/bottomY are up to date
 
-    std::vector<dg_point> _pts;    /*!< The array of points */
-    std::vector<dg_arete> _aretes; /*!< The array of edges */
+    // all the arrays come from the current ArenaScope, if any
+    ArenaVector<dg_point> _pts;    /*!< The array of points */
+    ArenaVector<dg_arete> _aretes; /*!< The array of edges */
   
     // the arrays of temporary data
     // these ones are dynamically kept at a length of maxPt or maxAr
-    std::vector<edge_data> eData;           /*!< Extra edge data */
-    std::vector<sweep_src_data> swsData;
-    std::vector<sweep_dest_data> swdData;
-    std::vector<raster_data> swrData;
-    std::vector<point_data> pData;          /*!< Extra point data */
+    ArenaVector<edge_data> eData;           /*!< Extra edge data */
+    ArenaVector<sweep_src_data> swsData;
+    ArenaVector<sweep_dest_data> swdData;
+    ArenaVector<raster_data> swrData;
+    ArenaVector<point_data> pData;          /*!< Extra point data */
 
     // edge direction comparison function    
 
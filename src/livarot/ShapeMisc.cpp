@@ -723,7 +723,9 @@ Shape::MakeTweak (int mode, Shape *a, double power, JoinType join, double miter,
     for (int i = 0; i < a->numberOfEdges(); i++)
     {
       int nEd=AddEdge (a->swsData[i].stPt, a->swsData[i].enPt);
-      ebData[nEd]=a->ebData[i];
+      if (nEd >= 0) { // Degenerate joins give edges without length, which are not added.
+        ebData[nEd]=a->ebData[i];
+      }
     }
   } else {
     for (int i = 0; i < a->numberOfEdges(); i++)
@@ -879,7 +881,9 @@ Shape::MakeOffset (Shape * a, double dec, JoinType join, double miter, bool do_p
     for (int i = 0; i < a->numberOfEdges(); i++)
     {
       int nEd=AddEdge (a->swsData[i].stPt, a->swsData[i].enPt);
-      ebData[nEd]=a->ebData[i];
+      if (nEd >= 0) { // Degenerate joins give edges without length, which are not added.
+        ebData[nEd]=a->ebData[i];
+      }
     }
   } else {
     for (int i = 0; i < a->numberOfEdges(); i++)
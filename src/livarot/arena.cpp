@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Scratch memory for the temporary arrays of livarot shapes.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "livarot/arena.h"
+
+#include "util/pool.h"
+
+namespace {
+
+struct ThreadArena
+{
+    Inkscape::Util::Pool pool;
+    Inkscape::Util::Pool *current = nullptr;
+    int depth = 0; ///< Number of active ArenaScopes.
+};
+
+thread_local ThreadArena arena;
+
+/// Largest buffer kept between operations; enough for polylines of a few thousand points.
+constexpr std::size_t MAX_RETAINED_SIZE = 4 << 20;
+
+} // namespace
+
+ArenaScope::ArenaScope(std::size_t size_hint)
+    : _saved(arena.current)
+{
+    if (arena.depth++ == 0) {
+        arena.pool.reserve(size_hint);
+    }
+    arena.current = &arena.pool;
+}
+
+ArenaScope::~ArenaScope()
+{
+    arena.current = _saved;
+    if (--arena.depth == 0) {
+        // Don't pin the memory of an unusually large operation for the rest of the thread's life.
+        if (arena.pool.buffer_size() > MAX_RETAINED_SIZE) {
+            arena.pool.release();
+        } else {
+            arena.pool.free_all();
+        }
+    }
+}
+
+Inkscape::Util::Pool *ArenaScope::current()
+{
+    return arena.current;
+}
+
+ArenaSuspension::ArenaSuspension()
+    : _saved(arena.current)
+{
+    arena.current = nullptr;
+}
+
+ArenaSuspension::~ArenaSuspension()
+{
+    arena.current = _saved;
+}
+
+std::byte *arena_allocate(Inkscape::Util::Pool *pool, std::size_t size, std::size_t alignment)
+{
+    return pool->allocate(size, alignment);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
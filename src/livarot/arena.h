@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Scratch memory for the temporary arrays of livarot shapes.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef SEEN_LIVAROT_ARENA_H
+#define SEEN_LIVAROT_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Inkscape {
+namespace Util {
+class Pool;
+} // namespace Util
+} // namespace Inkscape
+
+/**
+ * While an ArenaScope is alive, the arrays of Shapes constructed on the same thread are allocated
+ * from a per-thread Inkscape::Util::Pool instead of the heap. Growing an array then costs a bump of
+ * a pointer, freeing it costs nothing, and when the outermost scope ends the pool is reset in one
+ * go, keeping its largest buffer for the next operation unless that buffer is larger than a few
+ * megabytes.
+ *
+ * Shapes constructed within a scope must therefore be destroyed before it ends, and must not be
+ * modified by other threads. Use ArenaSuspension around code that shares shapes between threads.
+ */
+class ArenaScope
+{
+public:
+    /// Open a scope, expecting roughly size_hint bytes to be allocated within it.
+    explicit ArenaScope(std::size_t size_hint = 0);
+    ~ArenaScope();
+    ArenaScope(ArenaScope const &) = delete;
+    ArenaScope &operator=(ArenaScope const &) = delete;
+
+    /// The pool of the innermost active scope on this thread, or null.
+    static Inkscape::Util::Pool *current();
+
+private:
+    Inkscape::Util::Pool *_saved;
+};
+
+/**
+ * Allocate from the heap on this thread while alive, even within an ArenaScope.
+ */
+class ArenaSuspension
+{
+public:
+    ArenaSuspension();
+    ~ArenaSuspension();
+    ArenaSuspension(ArenaSuspension const &) = delete;
+    ArenaSuspension &operator=(ArenaSuspension const &) = delete;
+
+private:
+    Inkscape::Util::Pool *_saved;
+};
+
+/**
+ * Allocator drawing from the pool that was current when it was constructed, or else the heap.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept : _pool(ArenaScope::current()) {}
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U> const &other) noexcept : _pool(other._pool) {}
+
+    /// Copies of containers belong to the scope they are made in.
+    ArenaAllocator select_on_container_copy_construction() const noexcept { return {}; }
+
+    T *allocate(std::size_t n);
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        if (!_pool) {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    template <typename U>
+    bool operator==(ArenaAllocator<U> const &other) const noexcept { return _pool == other._pool; }
+    template <typename U>
+    bool operator!=(ArenaAllocator<U> const &other) const noexcept { return _pool != other._pool; }
+
+private:
+    Inkscape::Util::Pool *_pool;
+
+    template <typename U>
+    friend class ArenaAllocator;
+};
+
+/// A vector whose storage comes from the current ArenaScope, if any.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+std::byte *arena_allocate(Inkscape::Util::Pool *pool, std::size_t size, std::size_t alignment);
+
+template <typename T>
+T *ArenaAllocator<T>::allocate(std::size_t n)
+{
+    if (!_pool) {
+        return std::allocator<T>().allocate(n);
+    }
+    return reinterpret_cast<T *>(arena_allocate(_pool, n * sizeof(T), alignof(T)));
+}
+
+#endif // SEEN_LIVAROT_ARENA_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -560,6 +560,7 @@ PathParam::linked_modified_callback(SPObject *linked_obj, guint flags)
         must_recalculate_pwd2 = true;
         emit_changed();
         if (!param_effect->is_load || ownerlocator || (!SP_ACTIVE_DESKTOP && param_effect->isReady())) {
+            linked_obj->document->update_stats.dependents++;
             param_effect->getLPEObj()->requestModified(SP_OBJECT_MODIFIED_FLAG);
         }
     }
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Background decoding of the bitmaps of <image> elements.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "object/image-decoder.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <vector>
+#include <glib.h>
+
+#include "async/scheduler.h"
+#include "display/cairo-utils.h"
+#include "util/statics.h"
+
+namespace Inkscape {
+
+class ImageDecoder::Job
+{
+public:
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool finished = false;
+    Result result;
+    std::vector<std::pair<Async::Channel::Source, std::function<void (Result)>>> waiters;
+};
+
+ImageDecoder &ImageDecoder::get()
+{
+    // Using Static<ImageDecoder> so that pending decodes are finished before the scheduler goes.
+    static Util::Static<ImageDecoder> instance;
+    return instance.get();
+}
+
+ImageDecoder::ImageDecoder()
+{
+    // The scheduler runs our decodes, so must outlive us.
+    Async::Scheduler::get();
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    auto lock = std::unique_lock(_mutex);
+    _idle.wait(lock, [this] { return _running == 0; });
+}
+
+ImageDecoder::Result ImageDecoder::lookup(std::string const &key)
+{
+    auto lock = std::lock_guard(_mutex);
+    auto it = _entries.find(key);
+    return it == _entries.end() ? nullptr : it->second.pixbuf.lock();
+}
+
+ImageDecoder::Request ImageDecoder::decode(std::string const &key, std::function<Pixbuf *()> decode, std::function<void (Result)> done)
+{
+    auto [src, dst] = Async::Channel::create();
+
+    Request request;
+    request.channel = std::move(dst);
+
+    bool start = false;
+    {
+        auto lock = std::lock_guard(_mutex);
+        auto &entry = _entries[key];
+        if (!entry.job) {
+            entry.job = std::make_shared<Job>();
+            start = true;
+            _running++;
+        }
+        request.job = entry.job;
+        {
+            auto job_lock = std::lock_guard(request.job->mutex);
+            request.job->waiters.emplace_back(std::move(src), std::move(done));
+        }
+        _prune();
+    }
+
+    if (start) {
+        _post([this, key, job = request.job, decode = std::move(decode)] {
+            _run(key, job, decode);
+        });
+    }
+
+    return request;
+}
+
+/**
+ * Post a decode to the scheduler, or queue it if the maximum number of decodes are running.
+ */
+void ImageDecoder::_post(std::function<void ()> task)
+{
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (_active >= std::max(Async::Scheduler::get().concurrency() / 2, 1)) {
+            _queued.push_back(std::move(task));
+            return;
+        }
+        _active++;
+    }
+    Async::Scheduler::get().post(std::move(task));
+}
+
+void ImageDecoder::_run(std::string const &key, std::shared_ptr<Job> const &job, std::function<Pixbuf *()> const &decode)
+{
+    Result result;
+    try {
+        result.reset(decode());
+    } catch (std::exception const &e) {
+        g_warning("Failed to decode image: %s", e.what());
+    }
+
+    decltype(job->waiters) waiters;
+    {
+        auto lock = std::lock_guard(_mutex);
+        auto it = _entries.find(key);
+        if (it != _entries.end() && it->second.job == job) {
+            it->second.pixbuf = result;
+            it->second.job.reset();
+        }
+
+        auto job_lock = std::lock_guard(job->mutex);
+        job->finished = true;
+        job->result = result;
+        waiters = std::move(job->waiters);
+    }
+    job->cond.notify_all();
+
+    for (auto &[channel, done] : waiters) {
+        channel.run([done = std::move(done), result] { done(result); });
+    }
+
+    // Drop the waiters' functions before the decoder can be considered idle.
+    waiters.clear();
+
+    // Hand our slot to the next queued decode, if any.
+    std::function<void ()> next;
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (!_queued.empty()) {
+            next = std::move(_queued.front());
+            _queued.pop_front();
+        } else {
+            _active--;
+        }
+        if (--_running == 0) {
+            _idle.notify_all();
+        }
+    }
+    if (next) {
+        // Still running, so we can't be destroyed yet.
+        Async::Scheduler::get().post(std::move(next));
+    }
+}
+
+ImageDecoder::Result ImageDecoder::wait(Request &request)
+{
+    if (!request.job) {
+        return nullptr;
+    }
+
+    request.channel.close();
+
+    Result result;
+    {
+        auto lock = std::unique_lock(request.job->mutex);
+        request.job->cond.wait(lock, [&] { return request.job->finished; });
+        result = request.job->result;
+    }
+    request.job.reset();
+    return result;
+}
+
+void ImageDecoder::_prune()
+{
+    if (_entries.size() < _prune_size) {
+        return;
+    }
+
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        if (!it->second.job && it->second.pixbuf.expired()) {
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    _prune_size = std::max<std::size_t>(64, 2 * _entries.size());
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
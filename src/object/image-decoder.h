@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Background decoding of the bitmaps of <image> elements.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_OBJECT_IMAGE_DECODER_H
+#define INKSCAPE_OBJECT_IMAGE_DECODER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "async/channel.h"
+
+namespace Inkscape {
+
+class Pixbuf;
+
+/**
+ * Decodes images on the worker threads of the Async::Scheduler, and shares the results.
+ *
+ * An image requested under the key of an image being decoded waits for that decode, and one
+ * requested under the key of a decoded image still in use gets the same pixbuf. The key must
+ * therefore identify everything the result depends on: the source and its modification time, the
+ * resolution, the colour profile.
+ *
+ * At most half of the scheduler's threads decode at a time, so that a document with many images
+ * doesn't hold up the rendering of the canvas, which shares the scheduler.
+ */
+class ImageDecoder
+{
+public:
+    using Result = std::shared_ptr<Pixbuf const>;
+
+    class Job;
+
+    /// A requested decode. Dropping it cancels the notification of the result.
+    struct Request
+    {
+        std::shared_ptr<Job> job;
+        Async::Channel::Dest channel;
+
+        explicit operator bool() const { return (bool)job; }
+    };
+
+    /// The decoder shared by all documents.
+    static ImageDecoder &get();
+
+    ImageDecoder();
+    ~ImageDecoder();
+    ImageDecoder(ImageDecoder const &) = delete;
+    ImageDecoder &operator=(ImageDecoder const &) = delete;
+
+    /// The image decoded under key, if it is still in use.
+    Result lookup(std::string const &key);
+
+    /**
+     * Decode an image with decode on a worker thread, unless an image with the same key is being
+     * decoded already, and then call done with it (null if decoding failed) from the main loop.
+     * The decode function must be safe to run on any thread.
+     */
+    Request decode(std::string const &key, std::function<Pixbuf *()> decode, std::function<void (Result)> done);
+
+    /// Block until the image of a request is decoded and return it. The done function is not called.
+    static Result wait(Request &request);
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Pixbuf const> pixbuf; ///< Last image decoded under the key.
+        std::shared_ptr<Job> job;           ///< Decode in progress.
+    };
+
+    void _post(std::function<void ()> task);
+    void _run(std::string const &key, std::shared_ptr<Job> const &job, std::function<Pixbuf *()> const &decode);
+    void _prune();
+
+    std::mutex _mutex;
+    std::condition_variable _idle;                    ///< Signalled when the last decode finishes.
+    int _running = 0;                                 ///< Number of decodes requested and not finished.
+    int _active = 0;                                  ///< Number of decodes posted to the scheduler.
+    std::deque<std::function<void ()>> _queued;       ///< Decodes waiting for an active one to finish.
+    std::unordered_map<std::string, Entry> _entries;
+    std::size_t _prune_size = 64;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_OBJECT_IMAGE_DECODER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -112,8 +112,23 @@ void SPFlowtext::update(SPCtx* ctx, unsigned int flags) {
 
     SPItem::update(ctx, flags);
 
-    this->rebuildLayout();
+    auto shapes = _buildLayout();
+
+    // While the document is loading, flow the text together with other text objects.
+    // Only signal the change, as updating would lay the text out again.
+    bool const queued = document->queueTextLayout(this, &layout, [this, shapes] {
+        _showLayout();
+        requestModified(SP_OBJECT_MODIFIED_FLAG);
+    });
+
+    if (!queued) {
+        layout.calculateFlow();
+        _showLayout();
+    }
+}
 
+void SPFlowtext::_showLayout()
+{
     Geom::OptRect pbox = this->geometricBounds();
 
     for (auto &v : views) {
@@ -472,17 +487,23 @@ Shape* SPFlowtext::_buildExclusionShape() const
 
 void SPFlowtext::rebuildLayout()
 {
-    std::list<Shape> shapes;
+    auto shapes = _buildLayout();
+    layout.calculateFlow();
+#if DEBUG_TEXTLAYOUT_DUMPASTEXT
+    g_print("%s", layout.dumpAsText().c_str());
+#endif
+}
+
+std::shared_ptr<std::list<Shape>> SPFlowtext::_buildLayout()
+{
+    auto shapes = std::make_shared<std::list<Shape>>();
 
     layout.clear();
     Shape *exclusion_shape = _buildExclusionShape();
     SPObject *pending_line_break_object = nullptr;
-    _buildLayoutInput(this, exclusion_shape, &shapes, &pending_line_break_object);
+    _buildLayoutInput(this, exclusion_shape, shapes.get(), &pending_line_break_object);
     delete exclusion_shape;
-    layout.calculateFlow();
-#if DEBUG_TEXTLAYOUT_DUMPASTEXT
-    g_print("%s", layout.dumpAsText().c_str());
-#endif
+    return shapes;
 }
 
 void SPFlowtext::_clearFlow(Inkscape::DrawingGroup *in_arena)
@@ -70,6 +70,13 @@ public:
     void optimizeScaledText() { _optimizeScaledText = true; }
 
 private:
+    /** Clears the layout and gives it the input of the flowed text, returning the wrap shapes,
+    which must be kept alive until Layout::calculateFlow() has been called. */
+    std::shared_ptr<std::list<Shape>> _buildLayout();
+
+    /** Shows the layout in all views. */
+    void _showLayout();
+
     /** Recursively walks the xml tree adding tags and their contents. */
     void _buildLayoutInput(SPObject *root, Shape const *exclusion_shape, std::list<Shape> *shapes, SPObject **pending_line_break_object);
 
@@ -477,8 +477,7 @@ void SPGradient::gradientRefChanged(SPObject *old_ref, SPObject *ref, SPGradient
         gr->spread = gr->fetchSpread();
     }
 
-    /// \todo Fixme: what should the flags (second) argument be? */
-    gradientRefModified(ref, 0, gr);
+    gradientRefModified(ref, SP_OBJECT_FLAGS_ALL, gr);
 }
 
 /**
@@ -938,9 +937,14 @@ SPGradient::repr_write_vector()
 }
 
 
-void SPGradient::gradientRefModified(SPObject */*href*/, guint /*flags*/, SPGradient *gradient)
+void SPGradient::gradientRefModified(SPObject */*href*/, guint flags, SPGradient *gradient)
 {
+    // Only a change of the linked gradient itself can change the stops or attributes we inherit.
+    if (!(flags & SP_OBJECT_MODIFIED_STATE)) {
+        return;
+    }
     if ( gradient->invalidateVector() ) {
+        gradient->document->update_stats.dependents++;
         gradient->requestModified(SP_OBJECT_MODIFIED_FLAG);
         // Conditional to avoid causing infinite loop if there's a cycle in the href chain.
     }
@@ -20,7 +20,10 @@
 
 #include <cstring>
 #include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include <glibmm.h>
 #include <glib/gstdio.h>
@@ -34,6 +37,7 @@
 // Added for preserveAspectRatio support -- EAF
 #include "attributes.h"
 #include "document.h"
+#include "inkscape.h"
 #include "preferences.h"
 #include "print.h"
 #include "snap-candidate.h"
@@ -153,6 +157,7 @@ void SPImage::release() {
         this->href = nullptr;
     }
 
+    _decoding = {};
     pixbuf.reset();
 
     if (this->color_profile) {
@@ -246,6 +251,71 @@ void SPImage::set(SPAttr key, const gchar* value) {
 
 // BLIP
 void SPImage::apply_profile(Inkscape::Pixbuf *pixbuf) {
+    if (auto transform = create_profile_transform()) {
+        apply_profile(pixbuf, transform.get());
+    }
+}
+
+/**
+ * Create the transform from the colour profile of the image to sRGB, or null if there is none.
+ * Must be called from the main thread, as it looks up the profile in the document; the transform
+ * can then be applied from any thread.
+ */
+std::shared_ptr<void> SPImage::create_profile_transform() const
+{
+    DEBUG_MESSAGE( lcmsFive, "in <image>'s sp_image_update. About to call get_document_profile()");
+
+    guint profIntent = Inkscape::RENDERING_INTENT_UNKNOWN;
+    cmsHPROFILE prof = Inkscape::CMSSystem::get_document_profile(document,
+                                                                 &profIntent,
+                                                                 color_profile );
+    if ( !prof ) {
+        DEBUG_MESSAGE( lcmsEight, "in <image>'s sp_image_update. No profile found." );
+        return nullptr;
+    }
+
+    cmsProfileClassSignature profileClass = cmsGetDeviceClass( prof );
+    if ( profileClass == cmsSigNamedColorClass ) {
+        DEBUG_MESSAGE( lcmsSeven, "in <image>'s sp_image_update. Profile type is named color. Can't transform." );
+        return nullptr;
+    }
+
+    int intent = INTENT_PERCEPTUAL;
+
+    switch ( profIntent ) {
+        case Inkscape::RENDERING_INTENT_RELATIVE_COLORIMETRIC:
+            intent = INTENT_RELATIVE_COLORIMETRIC;
+            break;
+        case Inkscape::RENDERING_INTENT_SATURATION:
+            intent = INTENT_SATURATION;
+            break;
+        case Inkscape::RENDERING_INTENT_ABSOLUTE_COLORIMETRIC:
+            intent = INTENT_ABSOLUTE_COLORIMETRIC;
+            break;
+        case Inkscape::RENDERING_INTENT_PERCEPTUAL:
+        case Inkscape::RENDERING_INTENT_UNKNOWN:
+        case Inkscape::RENDERING_INTENT_AUTO:
+        default:
+            intent = INTENT_PERCEPTUAL;
+    }
+
+    cmsHPROFILE destProf = cmsCreate_sRGBProfile();
+    cmsHTRANSFORM transf = cmsCreateTransform( prof,
+                                               TYPE_RGBA_8,
+                                               destProf,
+                                               TYPE_RGBA_8,
+                                               intent, 0 );
+    cmsCloseProfile( destProf );
+
+    if ( !transf ) {
+        DEBUG_MESSAGE( lcmsSix, "in <image>'s sp_image_update. Unable to create LCMS transform." );
+        return nullptr;
+    }
+
+    return std::shared_ptr<void>(transf, cmsDeleteTransform);
+}
+
+void SPImage::apply_profile(Inkscape::Pixbuf *pixbuf, void *transform) {
 
     // TODO: this will prevent using MIME data when exporting.
     // Integrate color correction into loading.
@@ -256,59 +326,11 @@ void SPImage::apply_profile(Inkscape::Pixbuf *pixbuf) {
     guchar* px = pixbuf->pixels();
 
     if ( px ) {
-        DEBUG_MESSAGE( lcmsFive, "in <image>'s sp_image_update. About to call get_document_profile()");
-
-        guint profIntent = Inkscape::RENDERING_INTENT_UNKNOWN;
-        cmsHPROFILE prof = Inkscape::CMSSystem::get_document_profile(document,
-                                                                     &profIntent,
-                                                                     color_profile );
-        if ( prof ) {
-            cmsProfileClassSignature profileClass = cmsGetDeviceClass( prof );
-            if ( profileClass != cmsSigNamedColorClass ) {
-                int intent = INTENT_PERCEPTUAL;
-                                
-                switch ( profIntent ) {
-                    case Inkscape::RENDERING_INTENT_RELATIVE_COLORIMETRIC:
-                        intent = INTENT_RELATIVE_COLORIMETRIC;
-                        break;
-                    case Inkscape::RENDERING_INTENT_SATURATION:
-                        intent = INTENT_SATURATION;
-                        break;
-                    case Inkscape::RENDERING_INTENT_ABSOLUTE_COLORIMETRIC:
-                        intent = INTENT_ABSOLUTE_COLORIMETRIC;
-                        break;
-                    case Inkscape::RENDERING_INTENT_PERCEPTUAL:
-                    case Inkscape::RENDERING_INTENT_UNKNOWN:
-                    case Inkscape::RENDERING_INTENT_AUTO:
-                    default:
-                        intent = INTENT_PERCEPTUAL;
-                }
-                                
-                cmsHPROFILE destProf = cmsCreate_sRGBProfile();
-                cmsHTRANSFORM transf = cmsCreateTransform( prof,
-                                                           TYPE_RGBA_8,
-                                                           destProf,
-                                                           TYPE_RGBA_8,
-                                                           intent, 0 );
-                if ( transf ) {
-                    guchar* currLine = px;
-                    for ( int y = 0; y < imageheight; y++ ) {
-                        // Since the types are the same size, we can do the transformation in-place
-                        cmsDoTransform( transf, currLine, currLine, imagewidth );
-                        currLine += rowstride;
-                    }
-
-                    cmsDeleteTransform( transf );
-                } else {
-                    DEBUG_MESSAGE( lcmsSix, "in <image>'s sp_image_update. Unable to create LCMS transform." );
-                }
-
-                cmsCloseProfile( destProf );
-            } else {
-                DEBUG_MESSAGE( lcmsSeven, "in <image>'s sp_image_update. Profile type is named color. Can't transform." );
-            }
-        } else {
-            DEBUG_MESSAGE( lcmsEight, "in <image>'s sp_image_update. No profile found." );
+        guchar* currLine = px;
+        for ( int y = 0; y < imageheight; y++ ) {
+            // Since the types are the same size, we can do the transformation in-place
+            cmsDoTransform( transform, currLine, currLine, imagewidth );
+            currLine += rowstride;
         }
     }
 }
@@ -318,31 +340,18 @@ void SPImage::update(SPCtx *ctx, unsigned int flags) {
 
     if (flags & SP_IMAGE_HREF_MODIFIED_FLAG) {
         pixbuf.reset();
+        _decoding = {};
         if (href) {
-            Inkscape::Pixbuf *pb = nullptr;
             double svgdpi = 96;
             if (getRepr()->attribute("inkscape:svg-dpi")) {
                 svgdpi = g_ascii_strtod(getRepr()->attribute("inkscape:svg-dpi"), nullptr);
             }
             dpi = svgdpi;
-            pb = readImage(Inkscape::getHrefAttribute(*getRepr()).second,
-                           getRepr()->attribute("sodipodi:absref"),
-                           document->getDocumentBase(), svgdpi);
-            if (!pb) {
-                missing = true;
-                // Passing in our previous size allows us to preserve the image's expected size.
-                auto broken_width = width._set ? width.computed : 640;
-                auto broken_height = height._set ? height.computed : 640;
-                pb = getBrokenImage(broken_width, broken_height);
-            }
-            else {
-                missing = false;
-            }
-
-            if (pb) {
-                if (color_profile) apply_profile(pb);
-                pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
-                pixbuf = std::shared_ptr<Inkscape::Pixbuf>(pb);
+            auto const href_attr = Inkscape::getHrefAttribute(*getRepr()).second;
+            auto const absref = getRepr()->attribute("sodipodi:absref");
+            auto const base = document->getDocumentBase();
+            if (!_decodeAsync(href_attr, absref, base, svgdpi)) {
+                _setPixbuf(readImage(href_attr, absref, base, svgdpi));
             }
         }
     }
@@ -531,6 +540,12 @@ gchar* SPImage::description() const {
         href_desc = g_strdup("(null_pointer)"); // we call g_free() on href_desc
     }
 
+    if (_decoding) {
+        char *ret = g_strdup_printf(_("[loading]: %s"), href_desc);
+        g_free(href_desc);
+        return ret;
+    }
+
     char *ret = ( !pixbuf
                   ? g_strdup_printf(_("[bad reference]: %s"), href_desc)
                   : g_strdup_printf(_("%d &#215; %d: %s"),
@@ -623,6 +638,169 @@ Inkscape::Pixbuf *SPImage::readImage(gchar const *href, gchar const *absref, gch
     return inkpb;
 }
 
+namespace {
+
+std::optional<std::string> copy_string(gchar const *s)
+{
+    return s ? std::optional<std::string>(s) : std::nullopt;
+}
+
+gchar const *c_str(std::optional<std::string> const &s)
+{
+    return s ? s->c_str() : nullptr;
+}
+
+bool is_svg_filename(std::string const &fn)
+{
+    auto const idx = fn.find_last_of('.');
+    return idx != std::string::npos && g_ascii_strcasecmp(fn.c_str() + idx + 1, "svg") == 0;
+}
+
+/**
+ * Append what the bitmap read from a source depends on to the key, or return false if the source
+ * is an SVG document. Those are rendered through an SPDocument, so must be read on the main thread.
+ */
+bool append_source_key(std::string &key, gchar const *href, gchar const *base)
+{
+    if (!href) {
+        key += '\n';
+        return true;
+    }
+
+    if (g_ascii_strncasecmp(href, "data:", 5) == 0) {
+        auto const data = std::string_view(href + 5);
+        auto const header = data.substr(0, data.find(','));
+        if (header.find("image/svg+xml") != std::string_view::npos) {
+            return false;
+        }
+        // Embedded images are large; key them by a digest, which unlike a hash can't collide in
+        // practice and hand the image another one's pixels.
+        auto const digest = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+                                                        reinterpret_cast<guchar const *>(data.data()), data.size());
+        key += "data:";
+        key += digest;
+        key += '\n';
+        g_free(digest);
+        return true;
+    }
+
+    auto const url = Inkscape::URI::from_href_and_basedir(href, base);
+    if (url.hasScheme("file")) {
+        auto const native = url.toNativeFilename();
+        if (is_svg_filename(native)) {
+            return false;
+        }
+        GStatBuf st;
+        std::memset(&st, 0, sizeof(st));
+        g_stat(native.c_str(), &st);
+        key += native + ':' + std::to_string(st.st_mtime) + '\n';
+    } else {
+        key += url.str() + '\n';
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * Read the bitmap on a worker thread of the ImageDecoder, leaving the image without a pixbuf until
+ * it is decoded. Returns false, having done nothing, if it must be read synchronously.
+ */
+bool SPImage::_decodeAsync(gchar const *href, gchar const *absref, gchar const *base, double svgdpi)
+{
+    // Only worth it for the canvas; the image must also be sized without its bitmap, so that the
+    // layout doesn't change when it arrives.
+    auto prefs = Inkscape::Preferences::get();
+    if (!Inkscape::Application::exists() || !INKSCAPE.use_gui() || !prefs->getBool("/options/asyncimages/value", true) ||
+        !width._set || !height._set)
+    {
+        return false;
+    }
+
+    std::string key;
+    if (!append_source_key(key, href, base) || (absref && is_svg_filename(absref))) {
+        return false;
+    }
+    if (absref) {
+        key += absref;
+    }
+    key += '\n' + std::to_string(svgdpi);
+    if (color_profile) {
+        // The profile is looked up in the document.
+        key += '\n' + std::to_string(reinterpret_cast<std::uintptr_t>(document)) + ':' + color_profile;
+    }
+
+    auto &decoder = Inkscape::ImageDecoder::get();
+    if (auto decoded = decoder.lookup(key)) {
+        missing = false;
+        pixbuf = std::move(decoded);
+        return true;
+    }
+
+    auto transform = color_profile ? create_profile_transform() : nullptr;
+
+    _decoding = decoder.decode(key,
+        [href = copy_string(href), absref = copy_string(absref), base = copy_string(base), svgdpi, transform] {
+            auto pb = readImage(c_str(href), c_str(absref), c_str(base), svgdpi);
+            if (pb) {
+                if (transform) {
+                    apply_profile(pb, transform.get());
+                }
+                pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO);
+            }
+            return pb;
+        },
+        [this] (Inkscape::ImageDecoder::Result result) {
+            _decoded(std::move(result));
+        });
+
+    return true;
+}
+
+void SPImage::_decoded(Inkscape::ImageDecoder::Result result)
+{
+    _decoding = {};
+
+    if (result) {
+        missing = false;
+        pixbuf = std::move(result);
+    } else {
+        _setPixbuf(nullptr);
+    }
+
+    requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG);
+}
+
+void SPImage::wait_for_decoding()
+{
+    if (_decoding) {
+        _decoded(Inkscape::ImageDecoder::wait(_decoding));
+    }
+}
+
+/**
+ * Set the bitmap read from the source, or the broken image if it could not be read.
+ */
+void SPImage::_setPixbuf(Inkscape::Pixbuf *pb)
+{
+    if (!pb) {
+        missing = true;
+        // Passing in our previous size allows us to preserve the image's expected size.
+        auto broken_width = width._set ? width.computed : 640;
+        auto broken_height = height._set ? height.computed : 640;
+        pb = getBrokenImage(broken_width, broken_height);
+    }
+    else {
+        missing = false;
+    }
+
+    if (pb) {
+        if (color_profile) apply_profile(pb);
+        pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
+        pixbuf = std::shared_ptr<Inkscape::Pixbuf>(pb);
+    }
+}
+
 static std::string broken_image_svg = R"A(
 <svg xmlns:xlink="http://www.w3.org/1999/xlink" xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}">
   <defs>
@@ -866,6 +1044,15 @@ void sp_embed_svg(Inkscape::XML::Node *image_node, std::string const &fn)
     }
 }
 
+void sp_image_wait_for_decoding(SPDocument *document)
+{
+    for (auto obj : document->getResourceList("image")) {
+        if (auto image = cast<SPImage>(obj)) {
+            image->wait_for_decoding();
+        }
+    }
+}
+
 void SPImage::refresh_if_outdated()
 {
     if ( href && pixbuf && pixbuf->modificationTime()) {
@@ -25,6 +25,7 @@
 #include "viewbox.h"
 #include "sp-dimensions.h"
 #include "display/curve.h"
+#include "object/image-decoder.h"
 
 #include <memory>
 
@@ -68,6 +69,13 @@ public:
     Geom::Affine set_transform(Geom::Affine const &transform) override;
 
     void apply_profile(Inkscape::Pixbuf *pixbuf);
+    std::shared_ptr<void> create_profile_transform() const;
+    static void apply_profile(Inkscape::Pixbuf *pixbuf, void *transform);
+
+    /// Whether the bitmap is being decoded in the background.
+    bool is_decoding() const { return (bool)_decoding; }
+    /// Finish decoding the bitmap in this thread, if it is being decoded in the background.
+    void wait_for_decoding();
 
     SPCurve const *get_curve() const;
     void refresh_if_outdated();
@@ -76,10 +84,23 @@ public:
 private:
     static Inkscape::Pixbuf *readImage(gchar const *href, gchar const *absref, gchar const *base, double svgdpi = 0);
     static Inkscape::Pixbuf *getBrokenImage(double width, double height);
+
+    bool _decodeAsync(gchar const *href, gchar const *absref, gchar const *base, double svgdpi);
+    void _decoded(Inkscape::ImageDecoder::Result result);
+    void _setPixbuf(Inkscape::Pixbuf *pb);
+
+    Inkscape::ImageDecoder::Request _decoding;
 };
 
 /* Return duplicate of curve or NULL */
 void sp_embed_image(Inkscape::XML::Node *imgnode, Inkscape::Pixbuf *pb);
 void sp_embed_svg(Inkscape::XML::Node *image_node, std::string const &fn);
 
+/**
+ * Finish decoding the bitmaps of all images of a document, for consumers that render it at once.
+ * Decodes are started by updates, so the document must be brought up to date before, and again
+ * after, to apply the display updates of the decoded images.
+ */
+void sp_image_wait_for_decoding(SPDocument *document);
+
 #endif
@@ -415,6 +415,20 @@ std::vector<SPObject*> SPObject::childList(bool add_ref, Action) {
     return l;
 }
 
+std::vector<SPObject*> SPObject::cascadeChildList(unsigned flags, bool modified) {
+    if (flags) {
+        return childList(true);
+    }
+    std::vector<SPObject*> l;
+    for (auto& child: children) {
+        if ((modified ? child.mflags : child.uflags) & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG)) {
+            sp_object_ref(&child);
+            l.push_back(&child);
+        }
+    }
+    return l;
+}
+
 std::vector<SPObject*> SPObject::ancestorList(bool root_to_tip)
 {
     std::vector<SPObject *> ancestors;
@@ -1452,6 +1466,7 @@ void SPObject::updateDisplay(SPCtx *ctx, unsigned int flags)
 
     /* Get this flags */
     flags |= this->uflags;
+    document->update_stats.updated++;
     /* Copy flags to modified cascade for later processing */
     this->mflags |= this->uflags;
     /* We have to clear flags here to allow rescheduling update */
@@ -1467,6 +1482,7 @@ void SPObject::updateDisplay(SPCtx *ctx, unsigned int flags)
         style->block_filter_bbox_updates = true;
         if ((flags & SP_OBJECT_STYLESHEET_MODIFIED_FLAG)) {
             style->readFromObject(this);
+            document->update_stats.restyled++;
         } else if (parent && (flags & SP_OBJECT_STYLE_MODIFIED_FLAG) && (flags & SP_OBJECT_PARENT_MODIFIED_FLAG)) {
             style->cascade( this->parent->style );
         }
@@ -1541,6 +1557,9 @@ void SPObject::emitModified(unsigned int flags)
 #endif
 
     flags |= this->mflags;
+    if (document) {
+        document->update_stats.modified++;
+    }
     /* We have to clear mflags beforehand, as signal handlers may
      * make changes and therefore queue new modification notifications
      * themselves. */
@@ -298,6 +298,13 @@ public:
      */
     std::vector<SPObject*> childList(bool add_ref, Action action = ActionGeneral);
 
+    /**
+     * Retrieves the children an update (or modified signal) cascading flags has to visit, ref'ed:
+     * all of them if flags is non-zero, otherwise only those with a pending update (or
+     * modification), so that changing one object of a large group does not visit its siblings.
+     */
+    std::vector<SPObject*> cascadeChildList(unsigned flags, bool modified = false);
+
 
     /**
      * Retrieves a list of ancestors of the object, as an easy to use vector
@@ -15,6 +15,7 @@
 #include "document.h"
 #include "sp-root.h"
 #include "style.h"
+#include "style-selector-index.h"
 #include "xml/repr.h"
 
 // For external style sheets
@@ -457,9 +458,33 @@ static void clear_style_sheet(SPStyleElem &self)
     }
 
     self.style_sheet = nullptr;
+    self.document->styleSheetsChanged();
+}
+
+/**
+ * Request a style sheet update of the objects that may be matched by the selectors with the
+ * given keys. Their descendants follow, as the flag cascades.
+ */
+static void restyle_matching(SPObject &object, Inkscape::StyleSelectorIndex::Keys const &keys)
+{
+    for (auto &child : object.children) {
+        if (!child.document || !child.getRepr()) {
+            continue; // Not built yet, will read its style when it is.
+        }
+        if (child.getRepr()->type() == Inkscape::XML::NodeType::ELEMENT_NODE && keys.matches(child.getRepr())) {
+            child.requestDisplayUpdate(SP_OBJECT_STYLESHEET_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG |
+                                       SP_OBJECT_MODIFIED_FLAG);
+        } else {
+            restyle_matching(child, keys);
+        }
+    }
 }
 
 void SPStyleElem::read_content() {
+    // The objects whose style may change are those matched by the old or the new rules.
+    Inkscape::StyleSelectorIndex::Keys keys;
+    bool keyed = Inkscape::StyleSelectorIndex::collectKeys(style_sheet, keys);
+
     // TODO On modification (observer callbacks), clearing and re-appending to
     // the cascade can change the position of a stylesheet relative to other
     // sheets in the document. We need a better way to update a style sheet
@@ -471,13 +496,33 @@ void SPStyleElem::read_content() {
     // the document's style sheet later.
     style_sheet = cr_stylesheet_new (nullptr);
 
-    ParseTmp parse_tmp(style_sheet, document);
-
     //XML Tree being used directly here while it shouldn't be.
     Glib::ustring const text = concat_children(*getRepr());
-    if (!(text.find_first_not_of(" \t\r\n") != std::string::npos)) {
-        return;
+    if (text.find_first_not_of(" \t\r\n") != std::string::npos) {
+        parse_content(text);
     }
+
+    keyed = keyed && Inkscape::StyleSelectorIndex::collectKeys(style_sheet, keys);
+
+    if (keyed) {
+        if (!keys.empty()) {
+            restyle_matching(*document->getRoot(), keys);
+        }
+    } else {
+        // If a rule may match anything, we need to cascade the entire object tree, top down
+        // Get root, read style, loop through children
+        document->getRoot()->requestDisplayUpdate(SP_OBJECT_STYLESHEET_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG |
+                                                  SP_OBJECT_MODIFIED_FLAG);
+    }
+}
+
+/**
+ * Parse the style sheet text into style_sheet, and add it to the document's cascade.
+ */
+void SPStyleElem::parse_content(Glib::ustring const &text)
+{
+    ParseTmp parse_tmp(style_sheet, document);
+
     CRStatus const parse_status =
         cr_parser_parse_buf(parse_tmp.parser, reinterpret_cast<const guchar *>(text.c_str()), text.bytes(), CR_UTF_8);
 
@@ -494,6 +539,7 @@ void SPStyleElem::read_content() {
             // If not the first, then chain up this style_sheet
             cr_stylesheet_append_stylesheet(topsheet, style_sheet);
         }
+        document->styleSheetsChanged();
     } else {
         cr_stylesheet_destroy (style_sheet);
         style_sheet = nullptr;
@@ -501,10 +547,6 @@ void SPStyleElem::read_content() {
             g_printerr("parsing error code=%u\n", unsigned(parse_status));
         }
     }
-    // If style sheet has changed, we need to cascade the entire object tree, top down
-    // Get root, read style, loop through children
-    document->getRoot()->requestDisplayUpdate(SP_OBJECT_STYLESHEET_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG |
-                                              SP_OBJECT_MODIFIED_FLAG);
 }
 
 void SPStyleElem::build(SPDocument *document, Inkscape::XML::Node *repr) {
@@ -65,6 +65,8 @@ public:
     Inkscape::XML::Node *write(Inkscape::XML::Document *doc, Inkscape::XML::Node *repr, unsigned int flags) override;
 
 private:
+    void parse_content(Glib::ustring const &text);
+
     SPStyleElemNodeObserver &nodeObserver() { return *this; }
     SPStyleElemTextNodeObserver &textNodeObserver() { return *this; }
 
@@ -193,19 +193,35 @@ void SPText::update(SPCtx *ctx, guint flags) {
         /* fixme: It is not nice to have it here, but otherwise children content changes does not work */
         /* fixme: Even now it may not work, as we are delayed */
         /* fixme: So check modification flag everywhere immediate state is used */
-        this->rebuildLayout();
+        _buildLayout();
+
+        // While the document is loading, flow the text together with other text objects.
+        bool const queued = document->queueTextLayout(this, &layout, [this] {
+            _finishLayout();
+            _showLayout();
+            requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG);
+        });
+
+        if (!queued) {
+            layout.calculateFlow();
+            _finishLayout();
+            _showLayout();
+        }
+    }
+}
 
-        Geom::OptRect paintbox = this->geometricBounds();
+void SPText::_showLayout()
+{
+    Geom::OptRect paintbox = this->geometricBounds();
 
-        for (auto &v : views) {
-            auto &sa = view_style_attachments[v.key];
-            sa.unattachAll();
-            auto g = cast<Inkscape::DrawingGroup>(v.drawingitem.get());
-            _clearFlow(g);
-            g->setStyle(style, parent->style);
-            // pass the bbox of this as paintbox (used for paintserver fills)
-            layout.show(g, sa, paintbox);
-        }
+    for (auto &v : views) {
+        auto &sa = view_style_attachments[v.key];
+        sa.unattachAll();
+        auto g = cast<Inkscape::DrawingGroup>(v.drawingitem.get());
+        _clearFlow(g);
+        g->setStyle(style, parent->style);
+        // pass the bbox of this as paintbox (used for paintserver fills)
+        layout.show(g, sa, paintbox);
     }
 }
 
@@ -885,15 +901,23 @@ SPCurve SPText::getNormalizedBpath() const
 }
 
 void SPText::rebuildLayout()
+{
+    _buildLayout();
+    layout.calculateFlow();
+    _finishLayout();
+}
+
+void SPText::_buildLayout()
 {
     layout.clear();
     _buildLayoutInit();
 
     Inkscape::Text::Layout::OptionalTextTagAttrs optional_attrs;
     _buildLayoutInput(this, optional_attrs, 0, false);
+}
 
-    layout.calculateFlow();
-
+void SPText::_finishLayout()
+{
     for (auto& child: children) {
         if (is<SPTextPath>(&child)) {
             SPTextPath const *textpath = cast<SPTextPath>(&child);
@@ -88,6 +88,15 @@ public:
 
 private:
 
+    /** Clears the layout and gives it the input of the text, ready for Layout::calculateFlow(). */
+    void _buildLayout();
+
+    /** Adjusts the flowed layout to text paths and updates role:line positions. */
+    void _finishLayout();
+
+    /** Shows the layout in all views. */
+    void _showLayout();
+
     /** Initializes layout from <text> (i.e. this node). */
     void _buildLayoutInit();
 
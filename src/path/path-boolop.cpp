@@ -11,6 +11,10 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 
 #include <glibmm/i18n.h>
@@ -24,6 +28,8 @@
 #include "message-stack.h"
 #include "path-chemistry.h"     // copy_object_properties()
 
+#include "async/scheduler.h"
+
 #include "helper/geom.h"        // pathv_to_linear_and_cubic_beziers()
 
 #include "livarot/Path.h"
@@ -37,6 +43,8 @@
 
 #include "ui/icon-names.h"
 
+#include "util/packed-rtree.h"
+
 #include "xml/repr-sorting.h"
 
 using Inkscape::DocumentUndo;
@@ -147,6 +155,7 @@ static bool is_line(Path const &path)
 Geom::PathVector flattened(Geom::PathVector const &pathv, FillRule fill_rule)
 {
     auto path = make_path(pathv);
+    auto const arena = ArenaScope(Shape::ArenaSizeHint(path.pts.size()));
     auto shape = make_shape(path, 0, fill_rule);
 
     Path res;
@@ -168,6 +177,7 @@ std::vector<Geom::PathVector> pathvector_cut(Geom::PathVector const &pathv, Geom
 {
     auto patha = make_path(pathv);
     auto pathb = make_path(lines);
+    auto const arena = ArenaScope(Shape::ArenaSizeHint(patha.pts.size() + pathb.pts.size()));
     auto shapea = make_shape(patha, 0);
     auto shapeb = make_shape(pathb, 1, fill_justDont, is_line(pathb));
 
@@ -249,6 +259,7 @@ Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::Path
 
     auto patha = make_path(a);
     auto pathb = make_path(b);
+    auto const arena = ArenaScope(Shape::ArenaSizeHint(patha.pts.size() + pathb.pts.size()));
 
     Path result;
 
@@ -352,6 +363,230 @@ Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::Path
     return result.MakePathVector();
 }
 
+/*
+ * Boolean operations on many pathvectors
+ */
+
+/**
+ * Combine two shapes by a boolean operation, returning the other one if either is empty.
+ * See ObjectSet::pathBoolOp() for why.
+ */
+static std::unique_ptr<Shape> combine_shapes(std::unique_ptr<Shape> a, std::unique_ptr<Shape> b, BooleanOp bop)
+{
+    bool const zero_a = a->numberOfEdges() == 0;
+    bool const zero_b = b->numberOfEdges() == 0;
+    if (zero_a || zero_b) {
+        bool const result_is_b = (bop == bool_op_inters) == zero_b;
+        return result_is_b ? std::move(b) : std::move(a);
+    }
+
+    auto result = std::make_unique<Shape>();
+    result->Booleen(b.get(), a.get(), bop);
+    return result;
+}
+
+/**
+ * Combine shapes by a balanced tree of pairwise boolean operations, each level in parallel.
+ * Neighbouring shapes are combined first.
+ */
+static std::unique_ptr<Shape> reduce_shapes(std::vector<std::unique_ptr<Shape>> shapes, BooleanOp bop)
+{
+    while (shapes.size() > 1) {
+        std::vector<std::unique_ptr<Shape>> next((shapes.size() + 1) / 2);
+        Inkscape::Async::Scheduler::get().parallel_for(0, next.size(), [&] (int i) {
+            if (2 * i + 1 < (int)shapes.size()) {
+                next[i] = combine_shapes(std::move(shapes[2 * i]), std::move(shapes[2 * i + 1]), bop);
+            } else {
+                next[i] = std::move(shapes[2 * i]);
+            }
+        });
+        shapes = std::move(next);
+    }
+
+    return std::move(shapes.front());
+}
+
+Geom::PathVector sp_pathvector_boolop(std::vector<Geom::PathVector> const &pathvs, BooleanOp bop,
+                                      std::vector<FillRule> const &fill_rules)
+{
+    g_return_val_if_fail(bop == bool_op_union || bop == bool_op_inters || bop == bool_op_symdiff, {});
+    g_return_val_if_fail(pathvs.size() == fill_rules.size(), {});
+
+    int const n = pathvs.size();
+    auto &scheduler = Inkscape::Async::Scheduler::get();
+
+    // The shapes are passed between threads, so can't come from a per-thread arena.
+    auto const heap = ArenaSuspension();
+
+    // Convert each pathvector to a shape whose edges remember the index of the pathvector.
+    std::vector<std::unique_ptr<Path>> paths(n);
+    std::vector<std::unique_ptr<Shape>> shapes(n);
+    std::vector<Geom::OptRect> bounds(n);
+    scheduler.parallel_for(0, n, [&] (int i) {
+        // Livarot's outline of arcs is broken, see above.
+        auto const pathv = pathv_to_linear_and_cubic_beziers(pathvs[i]);
+        bounds[i] = pathv.boundsFast();
+
+        paths[i] = std::make_unique<Path>();
+        paths[i]->LoadPathVector(pathv);
+        paths[i]->ConvertWithBackData(get_threshold(pathv));
+
+        Shape tmp;
+        paths[i]->Fill(&tmp, i);
+        shapes[i] = std::make_unique<Shape>();
+        shapes[i]->ConvertToShape(&tmp, fill_rules[i]);
+    });
+
+    // Group the pathvectors whose bounding boxes overlap, directly or through others.
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&] (int i) {
+        while (parent[i] != i) {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+
+    std::vector<Inkscape::Util::PackedRTree<int>::Entry> entries;
+    for (int i = 0; i < n; i++) {
+        if (bounds[i]) {
+            entries.emplace_back(*bounds[i], i);
+        } else if (bop == bool_op_inters) {
+            return {};
+        }
+    }
+    auto const index = Inkscape::Util::PackedRTree<int>(std::move(entries));
+    for (int i = 0; i < n; i++) {
+        if (bounds[i]) {
+            index.query(*bounds[i], [&] (int j) {
+                parent[find(j)] = find(i);
+            });
+        }
+    }
+
+    std::vector<std::vector<int>> groups;
+    std::unordered_map<int, int> group_of_root;
+    for (int i = 0; i < n; i++) {
+        if (bounds[i]) {
+            auto [it, inserted] = group_of_root.emplace(find(i), groups.size());
+            if (inserted) {
+                groups.emplace_back();
+            }
+            groups[it->second].push_back(i);
+        }
+    }
+
+    if (groups.empty() || (bop == bool_op_inters && groups.size() > 1)) {
+        // Nothing to combine, or pathvectors apart from each other have no intersection.
+        return {};
+    }
+
+    // Combine each group, and convert the result back to a pathvector.
+    std::vector<Path *> orig;
+    orig.reserve(n);
+    for (auto const &path : paths) {
+        orig.push_back(path.get());
+    }
+
+    std::vector<Geom::PathVector> results(groups.size());
+    scheduler.parallel_for(0, groups.size(), [&] (int k) {
+        auto &group = groups[k];
+        std::sort(group.begin(), group.end(), [&] (int a, int b) {
+            return bounds[a]->midpoint().x() < bounds[b]->midpoint().x();
+        });
+
+        std::vector<std::unique_ptr<Shape>> group_shapes;
+        group_shapes.reserve(group.size());
+        for (auto i : group) {
+            group_shapes.push_back(std::move(shapes[i]));
+        }
+
+        auto shape = reduce_shapes(std::move(group_shapes), bop);
+
+        Path result;
+        shape->ConvertToForme(&result, n, orig.data());
+        results[k] = result.MakePathVector();
+    });
+
+    Geom::PathVector result;
+    for (auto const &pathv : results) {
+        result.insert(result.end(), pathv.begin(), pathv.end());
+    }
+    return result;
+}
+
+std::vector<Geom::PathVector> sp_pathvector_boolop_batch(std::vector<Geom::PathVector> pathvs,
+                                                         std::vector<FillRule> fill_rules,
+                                                         std::vector<BoolOpBatchStep> const &steps)
+{
+    g_return_val_if_fail(pathvs.size() == fill_rules.size(), {});
+
+    int const n = pathvs.size();
+
+    // Give every intermediate result a slot of its own, so a step only waits for the results it
+    // reads. Steps are sorted into waves: a step runs one wave after the latest of its inputs.
+    struct Task
+    {
+        BooleanOp bop;
+        std::vector<int> inputs; ///< Slots of the target and the operands.
+        int output;
+    };
+    std::vector<std::vector<Task>> waves;
+    std::vector<int> current(n); ///< Slot of the latest value of each pathvector.
+    std::iota(current.begin(), current.end(), 0);
+    std::vector<int> wave_of_slot(n, -1);
+
+    for (auto const &step : steps) {
+        auto const valid = [n] (int i) { return i >= 0 && i < n; };
+        if (!valid(step.target) || !std::all_of(step.operands.begin(), step.operands.end(), valid) ||
+            (step.op != bool_op_union && step.op != bool_op_diff && step.op != bool_op_inters &&
+             step.op != bool_op_symdiff))
+        {
+            g_warning("sp_pathvector_boolop_batch: skipping invalid step");
+            continue;
+        }
+
+        Task task{step.op, {current[step.target]}, (int)pathvs.size()};
+        int wave = wave_of_slot[task.inputs.front()];
+        for (auto i : step.operands) {
+            task.inputs.push_back(current[i]);
+            wave = std::max(wave, wave_of_slot[current[i]]);
+        }
+        wave++;
+
+        pathvs.emplace_back();
+        fill_rules.push_back(fill_nonZero);
+        wave_of_slot.push_back(wave);
+        current[step.target] = task.output;
+
+        if (wave == (int)waves.size()) {
+            waves.emplace_back();
+        }
+        waves[wave].push_back(std::move(task));
+    }
+
+    // The slots are all allocated now, so tasks of a wave may write theirs concurrently.
+    for (auto &wave : waves) {
+        Inkscape::Async::Scheduler::get().parallel_for(0, wave.size(), [&] (int k) {
+            auto const &task = wave[k];
+            auto result = pathvs[task.inputs.front()];
+            auto fill_rule = fill_rules[task.inputs.front()];
+            for (auto it = task.inputs.begin() + 1; it != task.inputs.end(); ++it) {
+                // The operand comes first, see sp_pathvector_boolop() for the order of difference.
+                result = sp_pathvector_boolop(pathvs[*it], result, task.bop, fill_rules[*it], fill_rule);
+                fill_rule = fill_nonZero;
+            }
+            pathvs[task.output] = std::move(result);
+        });
+    }
+
+    std::vector<Geom::PathVector> result(n);
+    for (int i = 0; i < n; i++) {
+        result[i] = std::move(pathvs[current[i]]);
+    }
+    return result;
+}
+
 /**
  * Workaround for buggy Path::Transform() which incorrectly transforms arc commands.
  *
@@ -501,6 +736,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
     std::vector<Path *> originaux(nbOriginaux);
     std::vector<FillRule> origWind(nbOriginaux);
     std::vector<double> origThresh(nbOriginaux);
+    std::vector<Geom::PathVector> origPathv(nbOriginaux);
     int curOrig;
     {
         curOrig = 0;
@@ -534,6 +770,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
                 auto pathv = curve->get_pathvector() * item->i2doc_affine();
                 originaux[curOrig] = Path_for_pathvector(pathv).release();
                 origThresh[curOrig] = get_threshold(pathv);
+                origPathv[curOrig] = std::move(pathv);
             } else {
                 originaux[curOrig] = nullptr;
             }
@@ -564,7 +801,11 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
     Path::cut_position  *toCut=nullptr;
     int                  nbToCut=0;
 
-    if ( bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff ) {
+    if ( bop == bool_op_union ) {
+        // unite all the paths at once, in parallel
+        res->LoadPathVector(sp_pathvector_boolop(origPathv, bop, origWind));
+
+    } else if ( bop == bool_op_inters || bop == bool_op_diff || bop == bool_op_symdiff ) {
         // true boolean op
         // get the polygons of each path, with the winding rule specified, and apply the operation iteratively
         originaux[0]->ConvertWithBackData(origThresh[0]);
@@ -752,7 +993,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
         // this function uses the point_data to get the winding number of each path (ie: is a hole or not)
         // for later reconstruction in objects, you also need to extract which path is parent of holes (nesting info)
         theShape->ConvertToFormeNested(res, nbOriginaux, &originaux[0], nbNest, nesting, conts, true);
-    } else {
+    } else if ( bop != bool_op_union ) {
         theShape->ConvertToForme(res, nbOriginaux, &originaux[0]);
     }
 
@@ -27,6 +27,34 @@ Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::Path
 Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pathvb, BooleanOp bop,
                                       FillRule fra, FillRule frb, bool livarotonly = false, bool flattenbefore = true);
 
+/**
+ * Perform a boolean union, intersection or exclusion of any number of pathvectors, using livarot.
+ *
+ * The pathvectors are combined by a balanced tree of pairwise operations, each level in parallel.
+ * For union and exclusion, groups of pathvectors whose bounding boxes don't overlap are combined
+ * independently, so large selections of mostly separate paths scale with the number of cores.
+ */
+Geom::PathVector sp_pathvector_boolop(std::vector<Geom::PathVector> const &pathvs, BooleanOp bop,
+                                      std::vector<FillRule> const &fill_rules);
+
+/// One step of a batch of boolean operations: replace pathvector target by target op operands.
+struct BoolOpBatchStep
+{
+    BooleanOp op; ///< Union, difference, intersection or exclusion.
+    int target;
+    std::vector<int> operands; ///< Combined with the target in order.
+};
+
+/**
+ * Run a batch of boolean operations on pathvectors in memory, returning the final pathvectors.
+ *
+ * Each step reads the pathvectors left by the steps before it, but steps that don't read each
+ * other's results run in parallel. Invalid steps are skipped with a warning.
+ */
+std::vector<Geom::PathVector> sp_pathvector_boolop_batch(std::vector<Geom::PathVector> pathvs,
+                                                         std::vector<FillRule> fill_rules,
+                                                         std::vector<BoolOpBatchStep> const &steps);
+
 #endif // PATH_BOOLOP_H
 
 /*
@@ -149,10 +149,12 @@ void sp_selected_path_create_offset_object(SPDesktop *desktop, int expand, bool
     res->SetBackData(false);
 
     {
+        orig->ConvertWithBackData(1.0);
+
+        auto const arena = ArenaScope(Shape::ArenaSizeHint(orig->pts.size()));
         Shape *theShape = new Shape;
         Shape *theRes = new Shape;
 
-        orig->ConvertWithBackData(1.0);
         orig->Fill(theShape, 0);
 
         SPCSSAttr *css = sp_repr_css_attr(item->getRepr(), "style");
@@ -329,10 +331,12 @@ sp_selected_path_do_offset(SPDesktop *desktop, bool expand, double prefOffset)
         res->SetBackData(false);
 
         {
+            orig->ConvertWithBackData(0.03);
+
+            auto const arena = ArenaScope(Shape::ArenaSizeHint(orig->pts.size()));
             Shape *theShape = new Shape;
             Shape *theRes = new Shape;
 
-            orig->ConvertWithBackData(0.03);
             orig->Fill(theShape, 0);
 
             SPCSSAttr *css = sp_repr_css_attr(item->getRepr(), "style");
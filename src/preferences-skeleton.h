@@ -263,6 +263,8 @@ static char const preferences_skeleton[] =
   <group id="options"
      rotationlock="1">
     <group id="renderingcache" size="512" />
+    <group id="filtercache" size="64" />
+    <group id="glyphcache" size="16" />
     <group id="useoldpdfexporter" value="0" />
     <group id="highlightoriginal" value="1" />
     <group id="relinkclonesonduplicate" value="0" />
@@ -362,7 +364,7 @@ static char const preferences_skeleton[] =
            allow_net_access="0"/>
     </group>
     <group id="forkgradientvectors" value="1"/>
-    <group id="autosave" enable="1" interval="10" path="" max="50"/>
+    <group id="autosave" enable="1" interval="10" path="" max="50" compress="1"/>
     <group id="grids"
       no_emphasize_when_zoomedout="0">
       <group id="xy"
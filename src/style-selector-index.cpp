@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Index of style sheet selectors for fast rule matching.
+ */
+
+#include "style-selector-index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xml/node.h"
+
+namespace Inkscape {
+
+namespace {
+
+bool is_css_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+}
+
+char const *cr_string_str(CRString const *s)
+{
+    return s && s->stryng ? s->stryng->str : nullptr;
+}
+
+struct SelectorKey
+{
+    enum Type { ID, CLASS, ELEMENT, NONE } type;
+    char const *name;
+};
+
+/**
+ * The key under which a selector is filed: the most selective key of its rightmost compound
+ * selector, that is the id, else the first class, else the element name.
+ */
+SelectorKey selector_key(CRSimpleSel *selector)
+{
+    auto last = selector;
+    while (last->next) {
+        last = last->next;
+    }
+
+    char const *klass = nullptr;
+    for (auto add = last->add_sel; add; add = add->next) {
+        if (add->type == ID_ADD_SELECTOR) {
+            if (auto id = cr_string_str(add->content.id_name)) {
+                return {SelectorKey::ID, id};
+            }
+        } else if (add->type == CLASS_ADD_SELECTOR && !klass) {
+            klass = cr_string_str(add->content.class_name);
+        }
+    }
+
+    if (klass) {
+        return {SelectorKey::CLASS, klass};
+    } else if ((last->type_mask & TYPE_SELECTOR) && !(last->type_mask & UNIVERSAL_SELECTOR) && cr_string_str(last->name)) {
+        return {SelectorKey::ELEMENT, cr_string_str(last->name)};
+    }
+    return {SelectorKey::NONE, nullptr};
+}
+
+/// Call f with each class of the class attribute of a node.
+template <typename F>
+void for_each_class(XML::Node const *node, F &&f)
+{
+    auto classes = node->attribute("class");
+    if (!classes) {
+        return;
+    }
+    for (auto p = classes; *p;) {
+        while (*p && is_css_space(*p)) {
+            p++;
+        }
+        auto start = p;
+        while (*p && !is_css_space(*p)) {
+            p++;
+        }
+        if (p != start) {
+            f(std::string(start, p));
+        }
+    }
+}
+
+/// The element name of a node, without namespace prefix.
+char const *element_name(XML::Node const *node)
+{
+    auto name = node->name();
+    if (auto colon = std::strrchr(name, ':')) {
+        name = colon + 1;
+    }
+    return name;
+}
+
+} // namespace
+
+bool StyleSelectorIndex::build(CRCascade *cascade)
+{
+    _rules.clear();
+    _by_id.clear();
+    _by_class.clear();
+    _by_element.clear();
+    _universal.clear();
+
+    for (int origin = ORIGIN_UA; origin < NB_ORIGINS; origin++) {
+        auto sheet = cr_cascade_get_sheet(cascade, static_cast<CRStyleOrigin>(origin));
+        for (; sheet; sheet = sheet->next) {
+            for (auto stmt = sheet->statements; stmt; stmt = stmt->next) {
+                switch (stmt->type) {
+                    case RULESET_STMT:
+                        break;
+                    case AT_FONT_FACE_RULE_STMT:
+                    case AT_CHARSET_RULE_STMT:
+                        continue; // Never matched against nodes.
+                    default:
+                        return false;
+                }
+                if (!stmt->kind.ruleset) {
+                    continue;
+                }
+                for (auto sel = stmt->kind.ruleset->sel_list; sel; sel = sel->next) {
+                    if (!sel->simple_sel) {
+                        continue;
+                    }
+                    cr_simple_sel_compute_specificity(sel->simple_sel);
+                    _add(_rules.size(), sel->simple_sel);
+                    _rules.push_back({stmt, sel->simple_sel, sel->simple_sel->specificity});
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * File a selector under its key. Selectors without one are tested for every node.
+ */
+void StyleSelectorIndex::_add(unsigned index, CRSimpleSel *selector)
+{
+    auto const key = selector_key(selector);
+    switch (key.type) {
+        case SelectorKey::ID:
+            _by_id[key.name].push_back(index);
+            break;
+        case SelectorKey::CLASS:
+            _by_class[key.name].push_back(index);
+            break;
+        case SelectorKey::ELEMENT:
+            _by_element[key.name].push_back(index);
+            break;
+        default:
+            _universal.push_back(index);
+            break;
+    }
+}
+
+void StyleSelectorIndex::_collect(Bucket const *bucket, std::vector<unsigned> &candidates)
+{
+    if (bucket) {
+        candidates.insert(candidates.end(), bucket->begin(), bucket->end());
+    }
+}
+
+std::vector<CRDeclaration *> StyleSelectorIndex::match(CRSelEng *sel_eng, XML::Node const *node) const
+{
+    auto lookup = [] (std::unordered_map<std::string, Bucket> const &map, std::string const &key) -> Bucket const * {
+        auto it = map.find(key);
+        return it != map.end() ? &it->second : nullptr;
+    };
+
+    std::vector<unsigned> candidates;
+    _collect(&_universal, candidates);
+
+    if (!_by_id.empty()) {
+        if (auto id = node->attribute("id")) {
+            _collect(lookup(_by_id, id), candidates);
+        }
+    }
+
+    if (!_by_class.empty()) {
+        for_each_class(node, [&] (std::string const &klass) {
+            _collect(lookup(_by_class, klass), candidates);
+        });
+    }
+
+    if (!_by_element.empty()) {
+        _collect(lookup(_by_element, element_name(node)), candidates);
+    }
+
+    if (candidates.empty()) {
+        return {};
+    }
+
+    // Restore cascade order; a node may reach the same selector through several classes.
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<Rule const *> matched;
+    for (auto i : candidates) {
+        auto &rule = _rules[i];
+        gboolean result = FALSE;
+        if (cr_sel_eng_matches_node(sel_eng, rule.selector, node, &result) == CR_OK && result) {
+            matched.push_back(&rule);
+        }
+    }
+
+    // Like libcroco, a statement matched by several of its selectors takes the specificity of the
+    // last one. Selectors of a statement are adjacent, so look ahead to find it.
+    std::vector<unsigned long> specificity(matched.size());
+    for (auto i = matched.size(); i-- > 0;) {
+        bool const same = i + 1 < matched.size() && matched[i + 1]->statement == matched[i]->statement;
+        specificity[i] = same ? specificity[i + 1] : matched[i]->specificity;
+    }
+
+    // Resolve conflicting declarations as cr_sel_eng_get_matched_properties_from_cascade does:
+    // a winning declaration replaces the previous one and moves to the end of the list.
+    struct Entry
+    {
+        CRDeclaration *decl;
+        CRStyleOrigin origin;
+        unsigned long specificity;
+    };
+    std::vector<Entry> entries;
+
+    for (std::size_t i = 0; i < matched.size(); i++) {
+        auto stmt = matched[i]->statement;
+        if (!stmt->parent_sheet) {
+            continue;
+        }
+        auto const origin = stmt->parent_sheet->origin;
+
+        for (auto decl = stmt->kind.ruleset->decl_list; decl; decl = decl->next) {
+            auto const name = cr_string_str(decl->property);
+            if (!name) {
+                continue;
+            }
+
+            Entry const entry{decl, origin, specificity[i]};
+            auto it = std::find_if(entries.begin(), entries.end(), [=] (Entry const &e) {
+                return std::strcmp(cr_string_str(e.decl->property), name) == 0;
+            });
+
+            if (it == entries.end()) {
+                entries.push_back(entry);
+                continue;
+            }
+            if (it->origin < origin) {
+                if (it->decl->important && it->origin != ORIGIN_UA) {
+                    continue;
+                }
+            } else if (it->origin > origin) {
+                continue;
+            } else if (specificity[i] < it->specificity || (it->decl->important && !decl->important)) {
+                continue;
+            }
+            entries.erase(it);
+            entries.push_back(entry);
+        }
+    }
+
+    std::vector<CRDeclaration *> result;
+    result.reserve(entries.size());
+    for (auto const &entry : entries) {
+        result.push_back(entry.decl);
+    }
+    return result;
+}
+
+bool StyleSelectorIndex::collectKeys(CRStyleSheet const *sheet, Keys &keys)
+{
+    if (!sheet) {
+        return true;
+    }
+    for (auto stmt = sheet->statements; stmt; stmt = stmt->next) {
+        switch (stmt->type) {
+            case RULESET_STMT:
+                break;
+            case AT_CHARSET_RULE_STMT:
+                continue;
+            default:
+                return false;
+        }
+        if (!stmt->kind.ruleset) {
+            continue;
+        }
+        for (auto sel = stmt->kind.ruleset->sel_list; sel; sel = sel->next) {
+            if (!sel->simple_sel) {
+                continue;
+            }
+            auto const key = selector_key(sel->simple_sel);
+            switch (key.type) {
+                case SelectorKey::ID:
+                    keys.ids.emplace(key.name);
+                    break;
+                case SelectorKey::CLASS:
+                    keys.classes.emplace(key.name);
+                    break;
+                case SelectorKey::ELEMENT:
+                    keys.elements.emplace(key.name);
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool StyleSelectorIndex::Keys::matches(XML::Node const *node) const
+{
+    if (!ids.empty()) {
+        if (auto id = node->attribute("id"); id && ids.count(id)) {
+            return true;
+        }
+    }
+
+    bool found = false;
+    if (!classes.empty()) {
+        for_each_class(node, [&] (std::string const &klass) {
+            found = found || classes.count(klass);
+        });
+    }
+
+    return found || (!elements.empty() && elements.count(element_name(node)));
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
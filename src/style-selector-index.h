@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Index of style sheet selectors for fast rule matching.
+ */
+#ifndef INKSCAPE_STYLE_SELECTOR_INDEX_H
+#define INKSCAPE_STYLE_SELECTOR_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "3rdparty/libcroco/src/cr-sel-eng.h"
+
+namespace Inkscape {
+namespace XML {
+class Node;
+} // namespace XML
+
+/**
+ * Precompiled form of a document's style cascade.
+ *
+ * Every selector of the cascade is filed under the id, class or element name required by its
+ * rightmost compound selector, so that only the few selectors that can possibly match a node
+ * have to be tested, instead of the whole cascade as cr_sel_eng_get_matched_properties_from_cascade
+ * does. The result is the same as libcroco's, including its resolution of conflicting declarations.
+ *
+ * The index refers to the statements of the cascade, so it must be rebuilt whenever a style sheet
+ * is added to or removed from the cascade.
+ */
+class StyleSelectorIndex
+{
+public:
+    /**
+     * Index the rulesets of the cascade. Returns false if the cascade contains statements the index
+     * does not handle (such as @import and @media), in which case it must not be used.
+     */
+    bool build(CRCascade *cascade);
+
+    /// Return the declarations applying to node, one per property, in the order libcroco would give them.
+    std::vector<CRDeclaration *> match(CRSelEng *sel_eng, XML::Node const *node) const;
+
+    /// Number of indexed selectors.
+    std::size_t size() const { return _rules.size(); }
+
+    /// Ids, classes and element names that the selectors of some style sheets require.
+    struct Keys
+    {
+        std::unordered_set<std::string> ids;
+        std::unordered_set<std::string> classes;
+        std::unordered_set<std::string> elements;
+
+        bool empty() const { return ids.empty() && classes.empty() && elements.empty(); }
+
+        /// Whether the node has one of the keys, which it needs to be matched by the selectors.
+        bool matches(XML::Node const *node) const;
+    };
+
+    /**
+     * Add the keys of the selectors of a style sheet. Returns false if the style sheet has
+     * selectors or statements that may affect a node with none of the keys, such as "*" or
+     * @font-face, which changes the fonts available to any text.
+     */
+    static bool collectKeys(CRStyleSheet const *sheet, Keys &keys);
+
+private:
+    struct Rule
+    {
+        CRStatement *statement;
+        CRSimpleSel *selector;
+        unsigned long specificity;
+    };
+
+    using Bucket = std::vector<unsigned>;
+
+    void _add(unsigned index, CRSimpleSel *selector);
+    static void _collect(Bucket const *bucket, std::vector<unsigned> &candidates);
+
+    // In cascade order: by origin, style sheet, statement and position in the selector list.
+    std::vector<Rule> _rules;
+    std::unordered_map<std::string, Bucket> _by_id;
+    std::unordered_map<std::string, Bucket> _by_class;
+    std::unordered_map<std::string, Bucket> _by_element;
+    Bucket _universal;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_STYLE_SELECTOR_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
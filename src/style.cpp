@@ -34,6 +34,7 @@
 #include "bad-uri-exception.h"
 #include "document.h"
 #include "preferences.h"
+#include "style-selector-index.h"
 
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
 
@@ -999,6 +1000,16 @@ SPStyle::_mergeObjectStylesheet( SPObject const *const object, SPDocument *const
         _mergeObjectStylesheet(object, parent);
     }
 
+    // Only test the rules that can match, instead of the whole cascade.
+    if (auto index = document->getStyleSelectorIndex()) {
+        auto const decls = index->match(sel_eng, object->getRepr());
+        // In reverse order, as later declarations to take precedence over earlier ones.
+        for (auto it = decls.rbegin(); it != decls.rend(); ++it) {
+            _mergeDecl(*it, SPStyleSrc::STYLE_SHEET);
+        }
+        return;
+    }
+
     CRPropList *props = nullptr;
 
     //XML Tree being directly used here while it shouldn't be.
@@ -1134,6 +1145,7 @@ static void sp_style_filter_ref_modified(SPObject *obj, unsigned flags, SPStyle
 
     if (flags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG)) {
         if (style->object) {
+            style->object->document->update_stats.dependents++;
             // FIXME: This line results in now-unnecessary filter recreation.
             style->object->requestModified(SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG);
             if (!style->block_filter_bbox_updates) {
@@ -1167,9 +1179,14 @@ void sp_style_filter_ref_changed(SPObject *old_ref, SPObject *ref, SPStyle *styl
  * Emit style modified signal on style's object if server is style's fill
  * or stroke paint server.
  */
-static void sp_style_paint_server_ref_modified(SPObject *obj, unsigned /*flags*/, SPStyle *style)
+static void sp_style_paint_server_ref_modified(SPObject *obj, unsigned flags, SPStyle *style)
 {
-    // todo: use flags
+    // A server that only received the modification of its parent (e.g. <defs>) is unchanged, and
+    // notifying its users would make every one of them emit modified again.
+    if (!(flags & SP_OBJECT_MODIFIED_STATE)) {
+        return;
+    }
+
     auto server = static_cast<SPPaintServer*>(obj);
 
     g_assert((style->fill  .isPaintserver() && style->getFillPaintServer()   == server) ||
@@ -1186,6 +1203,7 @@ static void sp_style_paint_server_ref_modified(SPObject *obj, unsigned /*flags*/
          * flag is only available downstreams.
          */
         // FIXME: For patterns and hatches, this line results in now-unnecessary pattern recreation.
+        style->object->document->update_stats.dependents++;
         style->object->requestModified(SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG);
     }
 }
@@ -1204,7 +1222,7 @@ void sp_style_fill_paint_server_ref_changed(SPObject *old_ref, SPObject *ref, SP
     }
 
     style->signal_fill_ps_changed.emit(old_ref, ref);
-    sp_style_paint_server_ref_modified(ref, 0, style);
+    sp_style_paint_server_ref_modified(ref, SP_OBJECT_FLAGS_ALL, style);
 }
 
 /**
@@ -1221,7 +1239,7 @@ void sp_style_stroke_paint_server_ref_changed(SPObject *old_ref, SPObject *ref,
     }
 
     style->signal_stroke_ps_changed.emit(old_ref, ref);
-    sp_style_paint_server_ref_modified(ref, 0, style);
+    sp_style_paint_server_ref_modified(ref, SP_OBJECT_FLAGS_ALL, style);
 }
 
 static CRSelEng *
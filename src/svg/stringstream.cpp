@@ -8,6 +8,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 #include "svg/stringstream.h"
+#include <glib.h>
 #include "svg/strip-trailing-zeros.h"
 #include "preferences.h"
 #include <2geom/point.h>
@@ -40,6 +41,17 @@ Inkscape::SVGOStringStream::operator<<(double d)
         }
     }
 
+    // Same as stripping the trailing zeros of "%#.*g", without the cost of another stream.
+    // Callers that set std::ios::fixed or scientific (the LaTeX exporters) take the slow path.
+    auto const precision = os.precision();
+    if ((ostr.flags() & std::ios::floatfield) == 0 && precision >= 0 && precision <= 32) {
+        char format[8];
+        char buffer[64];
+        g_snprintf(format, sizeof(format), "%%.%dg", (int)precision);
+        os << g_ascii_formatd(buffer, sizeof(buffer), format, d);
+        return os;
+    }
+
     std::ostringstream s;
     s.imbue(std::locale::classic());
     s.flags(os.setf(std::ios::showpoint));
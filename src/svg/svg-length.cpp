@@ -12,6 +12,7 @@
  */
 
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <glib.h>
@@ -63,13 +64,25 @@ unsigned int sp_svg_number_read_d(gchar const *str, double *val)
     return 1;
 }
 
-static std::string sp_svg_number_write_d( double val, unsigned int tprec, unsigned int fprec)
+/// Append the decimal digits of n to str.
+static void sp_svg_append_unsigned(std::string &str, unsigned int n)
 {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    while (count > 0) {
+        str += digits[--count];
+    }
+}
 
-    std::string buf;
+static void sp_svg_number_append_d(std::string &str, double val, unsigned int tprec, unsigned int fprec)
+{
     /* Process sign */
     if (val < 0.0) {
-        buf.append("-");
+        str += '-';
         val = fabs(val);
     }
 
@@ -88,39 +101,38 @@ static std::string sp_svg_number_write_d( double val, unsigned int tprec, unsign
     double fval = val - dival;
     /* Write integra */
     if (idigits > (int)tprec) {
-        buf.append(std::to_string((unsigned int)floor(dival/pow(10.0, idigits-tprec) + .5)));
-        for(unsigned int j=0; j<(unsigned int)idigits-tprec; j++) {
-            buf.append("0");
-        }
+        sp_svg_append_unsigned(str, (unsigned int)floor(dival/pow(10.0, idigits-tprec) + .5));
+        str.append(idigits - tprec, '0');
     } else {
-       buf.append(std::to_string((unsigned int)dival));
+        sp_svg_append_unsigned(str, (unsigned int)dival);
     }
 
     if (fprec > 0 && fval > 0.0) {
-        std::string s(".");
+        /* Trailing zeros are dropped again */
+        auto const point = str.size();
+        auto end = point;
+        str += '.';
         do {
             fval *= 10.0;
             dival = floor(fval);
             fval -= dival;
             int const int_dival = (int) dival;
-            s.append(std::to_string(int_dival));
+            sp_svg_append_unsigned(str, int_dival);
             if(int_dival != 0){
-                buf.append(s);
-                s="";
+                end = str.size();
             }
             fprec -= 1;
         } while(fprec > 0 && fval > 0.0);
+        str.resize(end);
     }
-    return buf;
 }
 
-std::string sp_svg_number_write_de(double val, unsigned int tprec, int min_exp)
+void sp_svg_number_append_de(std::string &str, double val, unsigned int tprec, int min_exp)
 {
-    std::string buf;
     int eval = (int)floor(log10(fabs(val)));
     if (val == 0.0 || eval < min_exp) {
-        buf.append("0");
-        return buf;
+        str += '0';
+        return;
     }
     unsigned int maxnumdigitsWithoutExp = // This doesn't include the sign because it is included in either representation
         eval<0?tprec+(unsigned int)-eval+1:
@@ -128,15 +140,23 @@ std::string sp_svg_number_write_de(double val, unsigned int tprec, int min_exp)
         (unsigned int)eval+1;
     unsigned int maxnumdigitsWithExp = tprec + ( eval<0 ? 4 : 3 ); // It's not necessary to take larger exponents into account, because then maxnumdigitsWithoutExp is DEFINITELY larger
     if (maxnumdigitsWithoutExp <= maxnumdigitsWithExp) {
-        buf.append(sp_svg_number_write_d(val, tprec, 0));
+        sp_svg_number_append_d(str, val, tprec, 0);
     } else {
         val = eval < 0 ? val * pow(10.0, -eval) : val / pow(10.0, eval);
-        buf.append(sp_svg_number_write_d(val, tprec, 0));
-        buf.append("e");
-        buf.append(std::to_string(eval));
+        sp_svg_number_append_d(str, val, tprec, 0);
+        str += 'e';
+        if (eval < 0) {
+            str += '-';
+        }
+        sp_svg_append_unsigned(str, std::abs(eval));
     }
-    return buf;
+}
 
+std::string sp_svg_number_write_de(double val, unsigned int tprec, int min_exp)
+{
+    std::string buf;
+    sp_svg_number_append_de(buf, val, tprec, min_exp);
+    return buf;
 }
 
 SVGLength::SVGLength()
@@ -18,6 +18,7 @@
 
 #include <cstring>
 #include <string>
+#include <typeinfo>
 #include <glib.h> // g_assert()
 
 #include <2geom/pathvector.h>
@@ -58,18 +59,40 @@ Geom::PathVector sp_svg_read_pathv(char const * str)
     return pathv;
 }
 
+static void sp_svg_write_line(Inkscape::SVG::PathString & str, Geom::LineSegment const &line_segment) {
+    if (line_segment.initialPoint()[Geom::X] == line_segment.finalPoint()[Geom::X]) {
+        str.verticalLineTo( line_segment.finalPoint()[Geom::Y] );
+    } else if (line_segment.initialPoint()[Geom::Y] == line_segment.finalPoint()[Geom::Y]) {
+        str.horizontalLineTo( line_segment.finalPoint()[Geom::X] );
+    } else {
+        str.lineTo( line_segment[1][0], line_segment[1][1] );
+    }
+}
+
+static void sp_svg_write_cubic(Inkscape::SVG::PathString & str, Geom::CubicBezier const &cubic_bezier) {
+    str.curveTo( cubic_bezier[1][0], cubic_bezier[1][1],
+                 cubic_bezier[2][0], cubic_bezier[2][1],
+                 cubic_bezier[3][0], cubic_bezier[3][1] );
+}
+
 static void sp_svg_write_curve(Inkscape::SVG::PathString & str, Geom::Curve const * c) {
+    // Lines and cubic Beziers make up nearly all paths, so look at their exact type first rather
+    // than trying a chain of dynamic_casts on every segment.
+    auto const &type = typeid(*c);
+    if (type == typeid(Geom::LineSegment)) {
+        sp_svg_write_line(str, static_cast<Geom::LineSegment const &>(*c));
+        return;
+    }
+    if (type == typeid(Geom::CubicBezier)) {
+        sp_svg_write_cubic(str, static_cast<Geom::CubicBezier const &>(*c));
+        return;
+    }
+
     // TODO: this code needs to removed and replaced by appropriate path sink
     if(Geom::LineSegment const *line_segment = dynamic_cast<Geom::LineSegment const  *>(c)) {
         // don't serialize stitch segments
         if (!dynamic_cast<Geom::Path::StitchSegment const *>(c)) {
-            if (line_segment->initialPoint()[Geom::X] == line_segment->finalPoint()[Geom::X]) {
-                str.verticalLineTo( line_segment->finalPoint()[Geom::Y] );
-            } else if (line_segment->initialPoint()[Geom::Y] == line_segment->finalPoint()[Geom::Y]) {
-                str.horizontalLineTo( line_segment->finalPoint()[Geom::X] );
-            } else {
-                str.lineTo( (*line_segment)[1][0], (*line_segment)[1][1] );
-            }
+            sp_svg_write_line(str, *line_segment);
         }
     }
     else if(Geom::QuadraticBezier const *quadratic_bezier = dynamic_cast<Geom::QuadraticBezier const  *>(c)) {
@@ -77,9 +100,7 @@ static void sp_svg_write_curve(Inkscape::SVG::PathString & str, Geom::Curve cons
                     (*quadratic_bezier)[2][0], (*quadratic_bezier)[2][1] );
     }
     else if(Geom::CubicBezier const *cubic_bezier = dynamic_cast<Geom::CubicBezier const  *>(c)) {
-        str.curveTo( (*cubic_bezier)[1][0], (*cubic_bezier)[1][1],
-                     (*cubic_bezier)[2][0], (*cubic_bezier)[2][1],
-                     (*cubic_bezier)[3][0], (*cubic_bezier)[3][1] );
+        sp_svg_write_cubic(str, *cubic_bezier);
     }
     else if(Geom::EllipticalArc const *elliptical_arc = dynamic_cast<Geom::EllipticalArc const *>(c)) {
         str.arcTo( elliptical_arc->ray(Geom::X), elliptical_arc->ray(Geom::Y),
@@ -37,6 +37,11 @@ unsigned int sp_svg_number_read_d( const char *str, double *val );
  */
 std::string sp_svg_number_write_de( double val, unsigned int tprec, int min_exp );
 
+/*
+ * Same as sp_svg_number_write_de, appending to str instead of allocating a new string
+ */
+void sp_svg_number_append_de( std::string &str, double val, unsigned int tprec, int min_exp );
+
 /* Length */
 
 /*
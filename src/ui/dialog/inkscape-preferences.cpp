@@ -2484,6 +2484,8 @@ void InkscapePreferences::initPageIO()
     _page_autosave.add_line(false, _("_Interval (in minutes):"), _save_autosave_interval, "", _("Interval (in minutes) at which document will be autosaved"), false);
     _save_autosave_max.init("/options/autosave/max", 1.0, 10000.0, 1.0, 10.0, 10.0, true, false);
     _page_autosave.add_line(false, _("_Maximum number of autosaves:"), _save_autosave_max, "", _("Maximum number of autosaved files; use this to limit the storage space used"), false);
+    _save_autosave_compress.init(_("Compress autosaves"), "/options/autosave/compress", true);
+    _page_autosave.add_line(false, "", _save_autosave_compress, "", _("Write autosaves as compressed Inkscape SVG (.svgz) to save storage space"), false);
 
     // When changing the interval or enabling/disabling the autosave function,
     // update our running configuration
@@ -2814,6 +2816,14 @@ void InkscapePreferences::initPageRendering()
     _rendering_cache_size.init("/options/renderingcache/size", 0.0, 4096.0, 1.0, 32.0, 64.0, true, false);
     _page_rendering.add_line( false, _("Rendering _cache size:"), _rendering_cache_size, C_("mebibyte (2^20 bytes) abbreviation","MiB"), _("Set the amount of memory per document which can be used to store rendered parts of the drawing for later reuse; set to zero to disable caching"), false);
 
+    // filter cache
+    _filter_cache_size.init("/options/filtercache/size", 0.0, 4096.0, 1.0, 32.0, 64.0, true, false);
+    _page_rendering.add_line( false, _("_Filter cache size:"), _filter_cache_size, C_("mebibyte (2^20 bytes) abbreviation","MiB"), _("Set the amount of memory per document which can be used to store the results of filter effects, so that they are not recomputed when only other objects change; set to zero to disable caching"), false);
+
+    // glyph cache
+    _glyph_cache_size.init("/options/glyphcache/size", 0.0, 1024.0, 1.0, 8.0, 16.0, true, false);
+    _page_rendering.add_line( false, _("_Glyph cache size:"), _glyph_cache_size, C_("mebibyte (2^20 bytes) abbreviation","MiB"), _("Set the amount of memory shared by all documents which can be used to store rendered glyphs of text filled with a flat color; set to zero to draw all text as paths"), false);
+
     // rendering x-ray radius
     _rendering_xray_radius.init("/options/rendering/xray-radius", 1.0, 1500.0, 1.0, 100.0, 100.0, true, false);
     _page_rendering.add_line( false, _("X-ray radius:"), _rendering_xray_radius, "", _("Radius of the circular area around the mouse cursor in X-ray mode"), false);
@@ -337,6 +337,8 @@ protected:
 
     UI::Widget::PrefSpinButton  _filter_multi_threaded;
     UI::Widget::PrefSpinButton  _rendering_cache_size;
+    UI::Widget::PrefSpinButton  _filter_cache_size;
+    UI::Widget::PrefSpinButton  _glyph_cache_size;
     UI::Widget::PrefSpinButton  _rendering_xray_radius;
     UI::Widget::PrefSpinButton  _rendering_outline_overlay_opacity;
     UI::Widget::PrefCombo       _canvas_update_strategy;
@@ -501,6 +503,7 @@ protected:
     UI::Widget::PrefSpinButton  _save_autosave_interval;
     UI::Widget::PrefEntry       _save_autosave_path;
     UI::Widget::PrefSpinButton  _save_autosave_max;
+    UI::Widget::PrefCheckButton _save_autosave_compress;
 
     Gtk::ComboBoxText   _cms_display_profile;
     UI::Widget::PrefCheckButton     _cms_from_user;
@@ -10,6 +10,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include <boost/none.hpp>
 #include <gdk/gdkkeysyms.h>
 #include <2geom/transforms.h>
@@ -26,6 +29,13 @@
 namespace Inkscape {
 namespace UI {
 
+namespace {
+
+/// How far out of view, in pixels, culled points get their canvas item: more than half a node.
+constexpr double view_margin = 16;
+
+} // namespace
+
 /**
  * @class ControlPointSelection
  * Group of selected control points.
@@ -67,6 +77,9 @@ ControlPointSelection::ControlPointSelection(SPDesktop *d, Inkscape::CanvasItemG
         sigc::mem_fun(*this, &ControlPointSelection::transform));
     _handles->signal_commit.connect(
         sigc::mem_fun(*this, &ControlPointSelection::_commitHandlesTransform));
+    _desktop->signal_display_area_changed.connect(
+        sigc::mem_fun(*this, &ControlPointSelection::_updateView));
+    _updateView();
 }
 
 ControlPointSelection::~ControlPointSelection()
@@ -163,15 +176,22 @@ void ControlPointSelection::selectAll()
 /** Select all points inside the given rectangle (in desktop coordinates). */
 void ControlPointSelection::selectArea(Geom::Path const &path, bool invert)
 {
+    // Only compute winding numbers for the points in the bounding box of the area.
+    auto const bounds = path.boundsFast();
+    if (!bounds) {
+        return;
+    }
     std::vector<SelectableControlPoint *> out;
-    for (auto _all_point : _all_points) {
-        if (path.winding(_all_point->position()) % 2 != 0) {
-            if (invert) {
-                erase(_all_point);
-            } else {
-                insert(_all_point, false, false);
-            }
-            out.push_back(_all_point);
+    _pointIndex().query(*bounds, [&] (SelectableControlPoint *point) {
+        if (path.winding(point->position()) % 2 != 0) {
+            out.push_back(point);
+        }
+    });
+    for (auto point : out) {
+        if (invert) {
+            erase(point);
+        } else {
+            insert(point, false, false);
         }
     }
     if (!out.empty()) {
@@ -205,21 +225,39 @@ void ControlPointSelection::spatialGrow(SelectableControlPoint *origin, int dir)
     Geom::Point p = origin->position();
     double best_dist = grow ? HUGE_VAL : 0;
     SelectableControlPoint *match = nullptr;
-    for (auto _all_point : _all_points) {
-        bool selected = _all_point->selected();
-        if (grow && !selected) {
-            double dist = Geom::distance(_all_point->position(), p);
-            if (dist < best_dist) {
-                best_dist = dist;
-                match = _all_point;
+    if (grow) {
+        // Search squares of doubling size around the origin, starting from about the spacing of
+        // the points. The nearest unselected point is known once one is found within the square's
+        // inscribed circle, or once the square covers all points.
+        auto const &index = _pointIndex();
+        auto const all = index.bounds();
+        if (all) {
+            double radius = std::max(all->maxExtent() / std::sqrt(index.size()), Geom::EPSILON);
+            while (true) {
+                Geom::Rect square(p, p);
+                square.expandBy(radius);
+                index.query(square, [&] (SelectableControlPoint *point) {
+                    if (!point->selected()) {
+                        double dist = Geom::distance(point->position(), p);
+                        if (dist < best_dist) {
+                            best_dist = dist;
+                            match = point;
+                        }
+                    }
+                });
+                if (best_dist <= radius || square.contains(*all)) {
+                    break;
+                }
+                radius *= 2;
             }
         }
-        if (!grow && selected) {
-            double dist = Geom::distance(_all_point->position(), p);
+    } else {
+        for (auto point : _points) {
+            double dist = Geom::distance(point->position(), p);
             // use >= to also deselect the origin node when it's the last one selected
             if (dist >= best_dist) {
                 best_dist = dist;
-                match = _all_point;
+                match = point;
             }
         }
     }
@@ -472,6 +510,74 @@ void ControlPointSelection::_mouseoverChanged()
     _mouseover_rot_radius = std::nullopt;
 }
 
+/** Keep track of a point created for this selection. */
+void ControlPointSelection::_pointAdded(SelectableControlPoint *point)
+{
+    _all_points.insert(point);
+    _pointMoved(point);
+}
+
+/** Keep the index up to date with a point's position, and show culled points that came into view. */
+void ControlPointSelection::_pointMoved(SelectableControlPoint *point)
+{
+    _index_dirty = true;
+    // Points that leave the view keep their canvas item until the view changes.
+    if (point->culled() && _view_area && _view_area->contains(point->position())) {
+        point->setCulled(false);
+        _in_view.insert(point);
+    }
+}
+
+void ControlPointSelection::_pointRemoved(SelectableControlPoint *point)
+{
+    _all_points.erase(point);
+    _in_view.erase(point);
+    _index_dirty = true;
+}
+
+/**
+ * Give their canvas item back to the culled points that came into view, and take it from those
+ * that left, so that only the points in view have canvas items to draw and pick.
+ */
+void ControlPointSelection::_updateView()
+{
+    auto area = _desktop->get_display_area().bounds();
+    area.expandBy(view_margin * _desktop->w2d().descrim());
+    _view_area = area;
+
+    for (auto it = _in_view.begin(); it != _in_view.end(); ) {
+        auto point = *it;
+        // The point under the pointer may be handling the event that changed the view.
+        if (area.contains(point->position()) || point->mouseovered()) {
+            ++it;
+        } else {
+            point->setCulled(true);
+            it = _in_view.erase(it);
+        }
+    }
+    _pointIndex().query(area, [this] (SelectableControlPoint *point) {
+        if (point->culled()) {
+            point->setCulled(false);
+            _in_view.insert(point);
+        }
+    });
+}
+
+/** The index of the positions of all points, for rubberband selection and searches. */
+Util::PackedRTree<SelectableControlPoint *> const &ControlPointSelection::_pointIndex()
+{
+    if (_index_dirty) {
+        std::vector<Util::PackedRTree<SelectableControlPoint *>::Entry> entries;
+        entries.reserve(_all_points.size());
+        for (auto point : _all_points) {
+            entries.emplace_back(Geom::Rect(point->position(), point->position()), point);
+        }
+        _index.build(std::move(entries));
+        _index_dirty = false;
+    }
+    return _index;
+}
+
 void ControlPointSelection::_update()
 {
     _updateBounds();
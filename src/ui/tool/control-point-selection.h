@@ -27,6 +27,7 @@
 #include "ui/tool/manipulator.h"
 #include "ui/tool/node-types.h"
 #include "snap-candidate.h"
+#include "util/packed-rtree.h"
 
 class SPDesktop;
 
@@ -134,6 +135,11 @@ private:
     void _pointUngrabbed();
     bool _pointClicked(SelectableControlPoint *, ButtonReleaseEvent const &);
     void _mouseoverChanged();
+    void _pointAdded(SelectableControlPoint *);
+    void _pointMoved(SelectableControlPoint *);
+    void _pointRemoved(SelectableControlPoint *);
+    void _updateView();
+    Util::PackedRTree<SelectableControlPoint *> const &_pointIndex();
 
     void _update();
     void _updateTransformHandles(bool preserve_center);
@@ -149,6 +155,10 @@ private:
     set_type _points;
 
     set_type _all_points;
+    Util::PackedRTree<SelectableControlPoint *> _index; ///< Positions of _all_points, rebuilt when used after a change
+    bool _index_dirty = false;
+    Geom::OptRect _view_area; ///< Where culled points get their canvas item back, in desktop coordinates
+    set_type _in_view; ///< Points given their canvas item back for being in _view_area
     std::unordered_map<SelectableControlPoint *, Geom::Point> _original_positions;
     std::unordered_map<SelectableControlPoint *, Geom::Affine> _last_trans;
     std::optional<double> _rot_radius;
@@ -77,10 +77,12 @@ ControlPoint::ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAncho
                            Inkscape::CanvasItemGroup *group)
     : _desktop(d)
     , _cset(cset)
+    , _group(group ? group : d->getCanvasControls())
+    , _anchor(anchor)
+    , _type(Inkscape::CANVAS_ITEM_CTRL_TYPE_DEFAULT)
     , _position(initial_pos)
 {
-    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(group ? group : _desktop->getCanvasControls(),
-                                                Inkscape::CANVAS_ITEM_CTRL_SHAPE_BITMAP);
+    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(_group, Inkscape::CANVAS_ITEM_CTRL_SHAPE_BITMAP);
     _canvas_item_ctrl->set_name("CanvasItemCtrl:ControlPoint");
     _canvas_item_ctrl->set_pixbuf(std::move(pixbuf));
     _canvas_item_ctrl->set_fill(  _cset.normal.fill);
@@ -93,18 +95,20 @@ ControlPoint::ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAncho
 ControlPoint::ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                            Inkscape::CanvasItemCtrlType type,
                            ColorSet const &cset,
-                           Inkscape::CanvasItemGroup *group)
+                           Inkscape::CanvasItemGroup *group,
+                           bool deferred)
     : _desktop(d)
     , _cset(cset)
+    , _group(group ? group : d->getCanvasControls())
+    , _anchor(anchor)
+    , _type(type)
     , _position(initial_pos)
 {
-    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(group ? group : _desktop->getCanvasControls(), type);
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:ControlPoint");
-    _canvas_item_ctrl->set_fill(  _cset.normal.fill);
-    _canvas_item_ctrl->set_stroke(_cset.normal.stroke);
-    _canvas_item_ctrl->set_anchor(anchor);
-
-    _commonInit();
+    if (deferred) {
+        _visible = false;
+    } else {
+        _createCanvasItem();
+    }
 }
 
 ControlPoint::~ControlPoint()
@@ -115,7 +119,20 @@ ControlPoint::~ControlPoint()
     }
 
     _event_handler_connection.disconnect();
-    _canvas_item_ctrl->hide();
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->hide();
+    }
+}
+
+void ControlPoint::_createCanvasItem()
+{
+    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(_group, _type);
+    _canvas_item_ctrl->set_name("CanvasItemCtrl:ControlPoint");
+    _canvas_item_ctrl->set_fill(  _cset.normal.fill);
+    _canvas_item_ctrl->set_stroke(_cset.normal.stroke);
+    _canvas_item_ctrl->set_anchor(_anchor);
+
+    _commonInit();
 }
 
 void ControlPoint::_commonInit()
@@ -133,7 +150,9 @@ void ControlPoint::_commonInit()
 void ControlPoint::setPosition(Geom::Point const &pos)
 {
     _position = pos;
-    _canvas_item_ctrl->set_position(_position);
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_position(_position);
+    }
 }
 
 void ControlPoint::move(Geom::Point const &pos)
@@ -147,14 +166,39 @@ void ControlPoint::transform(Geom::Affine const &m) {
 
 bool ControlPoint::visible() const
 {
-    return _canvas_item_ctrl->is_visible();
+    return _visible;
 }
 
 void ControlPoint::setVisible(bool v)
 {
-    if (v) {
-        _canvas_item_ctrl->show();
+    _visible = v;
+    _showCanvasItem();
+}
+
+void ControlPoint::setCulled(bool culled)
+{
+    if (culled == _culled) {
+        return;
+    }
+    _culled = culled;
+    if (culled) {
+        // Free the canvas item rather than hide it, so that canvas groups only hold points in view.
+        _event_handler_connection.disconnect();
+        _canvas_item_ctrl.reset();
     } else {
+        _showCanvasItem();
+    }
+}
+
+void ControlPoint::_showCanvasItem()
+{
+    if (_visible && !_culled) {
+        if (!_canvas_item_ctrl) {
+            _createCanvasItem();
+            _setState(_state);
+        }
+        _canvas_item_ctrl->show();
+    } else if (_canvas_item_ctrl) {
         _canvas_item_ctrl->hide();
     }
 }
@@ -175,12 +219,19 @@ Glib::ustring ControlPoint::format_tip(char const *format, ...)
 
 void ControlPoint::_setSize(unsigned int size)
 {
+    if (!_canvas_item_ctrl) {
+        _createCanvasItem();
+        _canvas_item_ctrl->hide();
+    }
     _canvas_item_ctrl->set_size(size);
 }
 
 void ControlPoint::_setControlType(Inkscape::CanvasItemCtrlType type)
 {
-    _canvas_item_ctrl->set_type(type);
+    _type = type;
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_type(type);
+    }
 }
 
 void ControlPoint::_setAnchor(SPAnchorType anchor)
@@ -497,13 +548,19 @@ void ControlPoint::_setState(State state)
 // TODO: RENAME
 void ControlPoint::_handleControlStyling()
 {
-    _canvas_item_ctrl->set_size_default();
+    // A canvas item created later picks up the default size itself.
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_size_default();
+    }
 }
 
 void ControlPoint::_setColors(ColorEntry colors)
 {
-    _canvas_item_ctrl->set_fill(colors.fill);
-    _canvas_item_ctrl->set_stroke(colors.stroke);
+    // Reapplied from _state when the canvas item is created.
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_fill(colors.fill);
+        _canvas_item_ctrl->set_stroke(colors.stroke);
+    }
 }
 
 bool ControlPoint::_isLurking()
@@ -140,6 +140,15 @@ public:
      * to events, use <tt>invisible_cset</tt> as its color set.
      */
     virtual void setVisible(bool v);
+
+    /**
+     * Keep a point without a canvas item while it is out of view. A culled point is neither
+     * drawn nor receives events, even if visible; its canvas item is made again when it is
+     * no longer culled. This is for points too many to all have a canvas item, like the nodes
+     * of long paths.
+     */
+    void setCulled(bool culled);
+    bool culled() const { return _culled; }
     /// @}
     
     /// @name Transfer grab from another event handler
@@ -219,11 +228,14 @@ protected:
      * @param type Logical type of the control point.
      * @param cset Colors of the point
      * @param group The canvas group the point's canvas item should be created in
+     * @param deferred Create the canvas item only when the point is first shown. For points of
+     *                 which only a few are visible at a time, such as the handles of path nodes.
      */
     ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                  Inkscape::CanvasItemCtrlType type,
                  ColorSet const &cset = _default_color_set,
-                 Inkscape::CanvasItemGroup *group = nullptr);
+                 Inkscape::CanvasItemGroup *group = nullptr,
+                 bool deferred = false);
 
     /**
      * Create a control point with a pixbuf-based visual representation.
@@ -329,7 +341,7 @@ protected:
     virtual bool _hasDragTips() const { return false; }
 
 
-    CanvasItemPtr<Inkscape::CanvasItemCtrl> _canvas_item_ctrl; ///< Visual representation of the control point.
+    CanvasItemPtr<Inkscape::CanvasItemCtrl> _canvas_item_ctrl; ///< Visual representation of the control point, or null until shown if deferred, and while culled.
 
     ColorSet const &_cset; ///< Colors used to represent the point
 
@@ -360,12 +372,24 @@ private:
 
     void _commonInit();
 
+    void _createCanvasItem();
+
+    void _showCanvasItem();
+
+    Inkscape::CanvasItemGroup *_group; ///< Where the canvas item goes, when created on demand
+    SPAnchorType _anchor;
+    Inkscape::CanvasItemCtrlType _type;
+
     Geom::Point _position; ///< Current position in desktop coordinates
 
     sigc::connection _event_handler_connection;
 
     bool _lurking = false;
 
+    bool _visible = true;
+
+    bool _culled = false;
+
     static ColorSet _default_color_set;
 
     /** Stores the window point over which the cursor was during the last mouse button press. */
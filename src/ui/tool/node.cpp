@@ -182,12 +182,13 @@ bool Handle::_drag_out = false;
 Handle::Handle(NodeSharedData const &data, Geom::Point const &initial_pos, Node *parent)
     : ControlPoint(data.desktop, initial_pos, SP_ANCHOR_CENTER,
                    Inkscape::CANVAS_ITEM_CTRL_TYPE_ROTATE,
-                   _handle_colors, data.handle_group)
-    , _handle_line(make_canvasitem<CanvasItemCurve>(data.handle_line_group))
+                   _handle_colors, data.handle_group, true)
     , _parent(parent)
+    , _handle_line_group(data.handle_line_group)
     , _degenerate(true)
 {
-    setVisible(false);
+    // Only the handles of selected nodes are shown, so the canvas items of both the handle and
+    // its line are created when first needed, which saves most of them on paths with many nodes.
 }
 
 Handle::~Handle() = default;
@@ -195,7 +196,12 @@ Handle::~Handle() = default;
 void Handle::setVisible(bool v)
 {
     ControlPoint::setVisible(v);
-    _handle_line->set_visible(v);
+    if (v && !_handle_line) {
+        _handle_line = make_canvasitem<CanvasItemCurve>(_handle_line_group, _parent->position(), position());
+    }
+    if (_handle_line) {
+        _handle_line->set_visible(v);
+    }
 }
 
 void Handle::_update_bspline_handles() {
@@ -296,7 +302,9 @@ void Handle::move(Geom::Point const &new_pos)
 void Handle::setPosition(Geom::Point const &p)
 {
     ControlPoint::setPosition(p);
-    _handle_line->set_coords(_parent->position(), position());
+    if (_handle_line) {
+        _handle_line->set_coords(_parent->position(), position());
+    }
 
     // update degeneration info and visibility
     if (Geom::are_near(position(), _parent->position()))
@@ -757,13 +765,17 @@ Node::Node(NodeSharedData const &data, Geom::Point const &initial_pos) :
     SelectableControlPoint(data.desktop, initial_pos, SP_ANCHOR_CENTER,
                            Inkscape::CANVAS_ITEM_CTRL_TYPE_NODE_CUSP,
                            *data.selection,
-                           node_colors, data.node_group),
+                           node_colors, data.node_group, true),
     _front(data, initial_pos, this),
     _back(data, initial_pos, this),
     _type(NODE_CUSP),
     _handles_shown(false)
 {
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:Node");
+    // Nodes only have a canvas item while in view (see ControlPointSelection::_updateView), so
+    // that editing paths with very many nodes does not make a canvas item for each of them.
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_name("CanvasItemCtrl:Node");
+    }
     // NOTE we do not set type here, because the handles are still degenerate
 }
 
@@ -1137,7 +1149,9 @@ bool Node::isEndNode() const
 
 void Node::sink()
 {
-    _canvas_item_ctrl->lower_to_bottom();
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->lower_to_bottom();
+    }
 }
 
 NodeType Node::parse_nodetype(char x)
@@ -1311,7 +1325,9 @@ void Node::_linearGrow(int dir)
 void Node::_setState(State state)
 {
     // change node size to match type and selection state
-    _canvas_item_ctrl->set_size_extra(selected() ? 2 : 0);
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_size_extra(selected() ? 2 : 0);
+    }
     switch (state) {
         // These were used to set "active" and "prelight" flags but the flags weren't being used.
         case STATE_NORMAL:
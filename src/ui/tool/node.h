@@ -100,7 +100,8 @@ private:
     void _update_bspline_handles();
     Node *_parent; // the handle's lifetime does not extend beyond that of the parent node,
     // so a naked pointer is OK and allows setting it during Node's construction
-    CanvasItemPtr<CanvasItemCurve> _handle_line;
+    CanvasItemPtr<CanvasItemCurve> _handle_line; ///< Null until the handle is first shown.
+    Inkscape::CanvasItemGroup *_handle_line_group;
     bool _degenerate; // True if the handle is retracted, i.e. has zero length. This is used often internally so it makes sense to cache this
 
     /**
@@ -28,12 +28,18 @@ SelectableControlPoint::SelectableControlPoint(SPDesktop *d, Geom::Point const &
                                                Inkscape::CanvasItemCtrlType type,
                                                ControlPointSelection &sel,
                                                ColorSet const &cset,
-                                               Inkscape::CanvasItemGroup *group)
-    : ControlPoint(d, initial_pos, anchor, type, cset, group)
+                                               Inkscape::CanvasItemGroup *group,
+                                               bool deferred)
+    : ControlPoint(d, initial_pos, anchor, type, cset, group, deferred)
     , _selection(sel)
 {
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:SelectableControlPoint");
-    _selection.allPoints().insert(this);
+    if (deferred) {
+        setCulled(true);
+        setVisible(true);
+    } else {
+        _canvas_item_ctrl->set_name("CanvasItemCtrl:SelectableControlPoint");
+    }
+    _selection._pointAdded(this);
 }
 
 SelectableControlPoint::SelectableControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
@@ -44,13 +50,19 @@ SelectableControlPoint::SelectableControlPoint(SPDesktop *d, Geom::Point const &
     : ControlPoint(d, initial_pos, anchor, pixbuf, cset, group)
     , _selection (sel)
 {
-    _selection.allPoints().insert(this);
+    _selection._pointAdded(this);
 }
 
 SelectableControlPoint::~SelectableControlPoint()
 {
     _selection.erase(this);
-    _selection.allPoints().erase(this);
+    _selection._pointRemoved(this);
+}
+
+void SelectableControlPoint::setPosition(Geom::Point const &pos)
+{
+    ControlPoint::setPosition(pos);
+    _selection._pointMoved(this);
 }
 
 bool SelectableControlPoint::grabbed(MotionEvent const &)
@@ -26,6 +26,7 @@ public:
 
     bool selected() const;
     void updateState() { _setState(_state); }
+    void setPosition(Geom::Point const &pos) override;
     virtual Geom::Rect bounds() const {
         return Geom::Rect(position(), position());
     }
@@ -33,11 +34,16 @@ public:
     friend class NodeList;
 
 protected:
+    /**
+     * @param deferred Give the point a canvas item only while it is in view, as tracked by the
+     *                 selection, so that points far out of view cost no canvas item.
+     */
     SelectableControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                            Inkscape::CanvasItemCtrlType type,
                            ControlPointSelection &sel,
                            ColorSet const &cset = _default_scp_color_set,
-                           Inkscape::CanvasItemGroup *group = nullptr);
+                           Inkscape::CanvasItemGroup *group = nullptr,
+                           bool deferred = false);
 
     SelectableControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                            Glib::RefPtr<Gdk::Pixbuf> pixbuf,
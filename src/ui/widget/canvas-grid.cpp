@@ -373,6 +373,9 @@ CanvasGrid::on_size_allocate(Gtk::Allocation& allocation)
     if (!(_allocation == allocation)) { // No != function defined!
         _allocation = allocation;
         UpdateRulers();
+        if (auto desktop = _dtw->desktop) {
+            desktop->signal_display_area_changed.emit();
+        }
     }
 }
 
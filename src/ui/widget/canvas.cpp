@@ -16,12 +16,11 @@
 #include <mutex>
 #include <array>
 #include <cassert>
-#include <boost/asio/thread_pool.hpp>
-#include <boost/asio/post.hpp>
 #include <2geom/convex-hull.h>
 
 #include "canvas.h"
 
+#include "async/scheduler.h"
 #include "color.h"          // Background color
 #include "desktop-events.h"
 #include "desktop.h"
@@ -268,9 +267,7 @@ public:
     bool background_in_stores_enabled = false; // Whether the page and desk should be drawn into the stores/tiles; if not then transparency is used instead.
     bool background_in_stores_required() const { return !q->get_opengl_enabled() && SP_RGBA32_A_U(page) == 255 && SP_RGBA32_A_U(desk) == 255; } // Enable solid colour optimisation if both page and desk are solid (as opposed to checkerboard).
 
-    // Async redraw process.
-    std::optional<boost::asio::thread_pool> pool;
-    int numthreads;
+    // Async redraw process, run on the render scheduler shared with filters and export.
     int get_numthreads() const;
 
     Synchronizer sync;
@@ -373,17 +370,6 @@ Canvas::Canvas()
             d->activate();
         }
     };
-    d->prefs.numthreads.action = [=] {
-        if (!d->active) return;
-        int const new_numthreads = d->get_numthreads();
-        if (d->numthreads == new_numthreads) return;
-        d->numthreads = new_numthreads;
-        d->deactivate();
-        d->deactivate_graphics();
-        d->pool.emplace(d->numthreads);
-        d->activate_graphics();
-        d->activate();
-    };
 
     // Canvas item tree
     d->canvasitem_ctx.emplace(this);
@@ -403,9 +389,6 @@ Canvas::Canvas()
     set_opengl_enabled(d->prefs.request_opengl);
 
     // Async redraw process.
-    d->numthreads = d->get_numthreads();
-    d->pool.emplace(d->numthreads);
-
     d->sync.connectExit([this] { d->after_redraw(); });
 }
 
@@ -680,7 +663,7 @@ void CanvasPrivate::launch_redraw()
 
     abort_flags.store((int)AbortFlags::None, std::memory_order_relaxed);
 
-    boost::asio::post(*pool, [this] { init_tiler(); });
+    Inkscape::Async::Scheduler::get().post([this] { init_tiler(); });
 }
 
 void CanvasPrivate::after_redraw()
@@ -2062,7 +2045,7 @@ void CanvasPrivate::init_tiler()
     rd.numactive = rd.numthreads;
 
     for (int i = 0; i < rd.numthreads - 1; i++) {
-        boost::asio::post(*pool, [=] { render_tile(i); });
+        Inkscape::Async::Scheduler::get().post([=] { render_tile(i); });
     }
 
     render_tile(rd.numthreads - 1);
@@ -15,7 +15,9 @@
 
 #include <unordered_map>
 #include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <algorithm>
 
 namespace Inkscape {
@@ -44,6 +46,8 @@ namespace Util {
  * still active. This is in accord with its expected usage; if the factory loads objects from an
  * external library, then it should be safe to destroy the cache just before the library is
  * unloaded, as the objects should no longer be in use at that point anyway.
+ *
+ * All operations are thread-safe, and the returned shared pointers may be released from any thread.
  */
 template <typename Tk, typename Tv, typename Hash = std::hash<Tk>, typename Compare = std::equal_to<Tk>>
 class cached_map
@@ -57,6 +61,16 @@ public:
      */
     cached_map(std::size_t max_cache_size = 32) : max_cache_size(max_cache_size) {}
 
+    /**
+     * Set a function to destroy evicted values, in place of destroying them directly. It is called
+     * without the map's lock held, on whichever thread released the last view of the value.
+     */
+    void set_disposer(std::function<void (std::unique_ptr<Tv>)> disposer)
+    {
+        auto lock = std::lock_guard(mutex);
+        dispose = std::move(disposer);
+    }
+
     /**
      * Given a key and a unique_ptr to a value, inserts them into the map, or discards them if the
      * key is already present.
@@ -65,6 +79,7 @@ public:
      */
     auto add(Tk key, std::unique_ptr<Tv> value)
     {
+        auto lock = std::lock_guard(mutex);
         auto ret = map.emplace(std::move(key), std::move(value));
         return get_view(ret.first->second);
     }
@@ -76,6 +91,7 @@ public:
      */
     auto lookup(Tk const &key) -> std::shared_ptr<Tv>
     {
+        auto lock = std::lock_guard(mutex);
         if (auto it = map.find(key); it != map.end()) {
             return get_view(it->second);
         } else {
@@ -85,6 +101,7 @@ public:
 
     void clear()
     {
+        auto lock = std::lock_guard(mutex);
         unused.clear();
         map.clear();
     }
@@ -100,6 +117,8 @@ private:
     std::size_t const max_cache_size;
     std::unordered_map<Tk, Item, Hash, Compare> map;
     std::deque<Tv*> unused;
+    std::mutex mutex;
+    std::function<void (std::unique_ptr<Tv>)> dispose;
 
     auto get_view(Item &item)
     {
@@ -108,7 +127,25 @@ private:
         } else {
             remove_unused(item.value.get());
             auto new_view = std::shared_ptr<Tv>(item.value.get(), [this] (Tv *value) {
-                push_unused(value);
+                std::unique_ptr<Tv> evicted;
+                decltype(dispose) disposer;
+                {
+                    auto lock = std::lock_guard(mutex);
+                    // Look the item up again, as it may have been evicted while waiting for the lock.
+                    // Skip if it was, or if a new view was handed out in the meantime.
+                    auto it = find_item(value);
+                    if (it != map.end() && it->second.view.expired()) {
+                        remove_unused(value);
+                        evicted = push_unused(value);
+                        if (evicted) {
+                            disposer = dispose;
+                        }
+                    }
+                }
+                // Destroy outside the lock, as destructors may take locks of their own.
+                if (disposer) {
+                    disposer(std::move(evicted));
+                }
             });
             item.view = new_view;
             return new_view;
@@ -123,21 +160,30 @@ private:
         }
     }
 
-    void push_unused(Tv *value)
+    /// Mark a value as unused, returning the value evicted to make room, if any.
+    std::unique_ptr<Tv> push_unused(Tv *value)
     {
         unused.emplace_back(value);
         if (unused.size() > max_cache_size) {
-            pop_unused();
+            return pop_unused();
         }
+        return {};
     }
 
-    void pop_unused()
+    auto find_item(Tv *value)
     {
-        auto value = unused.front();
-        map.erase(std::find_if(map.begin(), map.end(), [value] (auto const &it) {
+        return std::find_if(map.begin(), map.end(), [value] (auto const &it) {
             return it.second.value.get() == value;
-        }));
+        });
+    }
+
+    std::unique_ptr<Tv> pop_unused()
+    {
+        auto it = find_item(unused.front());
+        auto evicted = std::move(it->second.value);
+        map.erase(it);
         unused.pop_front();
+        return evicted;
     }
 };
 
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** \file
+ * Bulk-loaded R-tree over axis-aligned rectangles.
+ */
+#ifndef INKSCAPE_UTIL_PACKED_RTREE_H
+#define INKSCAPE_UTIL_PACKED_RTREE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <2geom/rect.h>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * A PackedRTree is a static spatial index mapping rectangles to values, answering
+ * "which entries intersect this area" in O(log n + k) time.
+ *
+ *   - The tree is built in one go using Sort-Tile-Recursive packing, in O(n log n) time.
+ *   - It cannot be modified after building; instead it is cheaply rebuilt when its contents change.
+ *   - Nodes are stored as a flat array per level, so there is no per-node allocation.
+ *
+ * Queries visit entries in no particular order; callers that care about ordering (e.g. z-order)
+ * should store a sort key as the value.
+ */
+template <typename T>
+class PackedRTree final
+{
+public:
+    using Entry = std::pair<Geom::Rect, T>;
+
+    /// Number of children per node.
+    static constexpr std::size_t FANOUT = 16;
+
+    PackedRTree() = default;
+    explicit PackedRTree(std::vector<Entry> entries) { build(std::move(entries)); }
+
+    /// Replace the contents of the tree with the given entries.
+    void build(std::vector<Entry> entries);
+
+    /// Remove all entries.
+    void clear() noexcept { _levels.clear(); _values.clear(); }
+
+    bool empty() const noexcept { return _values.empty(); }
+    std::size_t size() const noexcept { return _values.size(); }
+
+    /// The bounding box of all entries, or nothing if the tree is empty.
+    Geom::OptRect bounds() const
+    {
+        if (_values.empty()) {
+            return {};
+        }
+        return _levels.back().front();
+    }
+
+    /// Call f(value) for every entry whose rectangle intersects area (boundaries included).
+    template <typename F>
+    void query(Geom::Rect const &area, F &&f) const
+    {
+        if (!_values.empty()) {
+            _query(_levels.size() - 1, 0, area, f);
+        }
+    }
+
+    /// Call f(value) for every entry whose rectangle contains the point.
+    template <typename F>
+    void query(Geom::Point const &p, F &&f) const { query(Geom::Rect(p, p), std::forward<F>(f)); }
+
+    /// Convenience function: return the values of all entries intersecting area.
+    std::vector<T> collect(Geom::Rect const &area) const
+    {
+        std::vector<T> result;
+        query(area, [&] (T const &value) { result.push_back(value); });
+        return result;
+    }
+
+private:
+    // _levels[0] holds the entry rectangles; _levels[i][j] is the bounding box
+    // of _levels[i - 1][j * FANOUT] to _levels[i - 1][(j + 1) * FANOUT - 1].
+    std::vector<std::vector<Geom::Rect>> _levels;
+    std::vector<T> _values;
+
+    template <typename F>
+    void _query(std::size_t level, std::size_t index, Geom::Rect const &area, F &f) const;
+};
+
+template <typename T>
+void PackedRTree<T>::build(std::vector<Entry> entries)
+{
+    clear();
+    if (entries.empty()) {
+        return;
+    }
+
+    // Sort-Tile-Recursive: sort by x into vertical slices, then each slice by y.
+    auto const n = entries.size();
+    auto const leaves = (n + FANOUT - 1) / FANOUT;
+    auto const slices = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(leaves))));
+    auto const slice_size = slices * FANOUT;
+
+    auto by_x = [] (Entry const &a, Entry const &b) { return a.first.midpoint().x() < b.first.midpoint().x(); };
+    auto by_y = [] (Entry const &a, Entry const &b) { return a.first.midpoint().y() < b.first.midpoint().y(); };
+    std::sort(entries.begin(), entries.end(), by_x);
+    for (std::size_t i = 0; i < n; i += slice_size) {
+        std::sort(entries.begin() + i, entries.begin() + std::min(n, i + slice_size), by_y);
+    }
+
+    std::vector<Geom::Rect> rects;
+    rects.reserve(n);
+    _values.reserve(n);
+    for (auto &entry : entries) {
+        rects.push_back(entry.first);
+        _values.push_back(std::move(entry.second));
+    }
+    _levels.push_back(std::move(rects));
+
+    // Group consecutive nodes into parents until a single root remains.
+    while (_levels.back().size() > 1) {
+        auto const &below = _levels.back();
+        std::vector<Geom::Rect> above;
+        above.reserve((below.size() + FANOUT - 1) / FANOUT);
+        for (std::size_t i = 0; i < below.size(); i += FANOUT) {
+            Geom::Rect box = below[i];
+            for (std::size_t j = i + 1; j < std::min(below.size(), i + FANOUT); j++) {
+                box.unionWith(below[j]);
+            }
+            above.push_back(box);
+        }
+        _levels.push_back(std::move(above));
+    }
+}
+
+template <typename T>
+template <typename F>
+void PackedRTree<T>::_query(std::size_t level, std::size_t index, Geom::Rect const &area, F &f) const
+{
+    auto const &nodes = _levels[level];
+    if (!nodes[index].intersects(area)) {
+        return;
+    }
+    if (level == 0) {
+        f(_values[index]);
+        return;
+    }
+    auto const &below = _levels[level - 1];
+    auto const last = std::min(below.size(), (index + 1) * FANOUT);
+    for (std::size_t i = index * FANOUT; i < last; i++) {
+        _query(level - 1, i, area, f);
+    }
+}
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // INKSCAPE_UTIL_PACKED_RTREE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -25,8 +25,8 @@ std::byte *Pool::allocate(std::size_t size, std::size_t alignment)
     }
 
     cursize = std::max(nextsize, size + alignment - 1);
-    buffers.emplace_back(std::make_unique<std::byte[]>(cursize));
-    // buffers.emplace_back(std::make_unique_for_overwrite<std::byte[]>(cursize)); // Todo: C++20.
+    // Not value-initialized, as zeroing large buffers costs more than what they are used for.
+    buffers.emplace_back(new std::byte[cursize]); // Todo: (C++20) Use std::make_unique_for_overwrite.
     resetblock();
     nextsize = cursize * 3 / 2;
 
@@ -48,6 +48,15 @@ void Pool::free_all() noexcept
     resetblock();
 }
 
+void Pool::release() noexcept
+{
+    buffers.clear();
+    cur = nullptr;
+    end = nullptr;
+    cursize = 0;
+    nextsize = 2;
+}
+
 void Pool::movefrom(Pool &other) noexcept
 {
     buffers = std::move(other.buffers);
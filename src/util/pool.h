@@ -44,6 +44,12 @@ public:
     /// Free all previous allocations, retaining the largest existing buffer for re-use.
     void free_all() noexcept;
 
+    /// Free all previous allocations and all buffers, returning the pool to its initial state.
+    void release() noexcept;
+
+    /// The size of the current buffer, which is the one retained by free_all().
+    std::size_t buffer_size() const { return cursize; }
+
 private:
     std::vector<std::unique_ptr<std::byte[]>> buffers;
     std::byte *cur = nullptr, *end = nullptr;
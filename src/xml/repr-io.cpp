@@ -13,10 +13,12 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 #include <stdexcept>
 
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
+#include <libxml/xmlreader.h>
 
 #include "xml/repr.h"
 #include "xml/attribute-record.h"
@@ -48,7 +50,10 @@ using Inkscape::XML::AttributeVector;
 using Inkscape::XML::rebase_href_attrs;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
+static Document *sp_repr_do_read (xmlTextReaderPtr reader, const gchar *default_ns);
+static void sp_repr_fix_root (Node *root, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
+static Node *sp_repr_svg_read_element (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
                                               bool add_whitespace, gchar const *default_ns,
@@ -93,6 +98,7 @@ public:
     int setFile( char const * filename );
 
     xmlDocPtr readXml();
+    xmlTextReaderPtr readXmlStream();
 
     static int readCb( void * context, char * buffer, int len );
     static int closeCb( void * context );
@@ -170,7 +176,7 @@ int XmlSource::setFile(char const *filename)
     return retVal;
 }
 
-xmlDocPtr XmlSource::readXml()
+static int xml_source_parse_options()
 {
     int parse_options = XML_PARSE_HUGE | XML_PARSE_RECOVER;
 
@@ -178,7 +184,21 @@ xmlDocPtr XmlSource::readXml()
     bool allowNetAccess = prefs->getBool("/options/externalresources/xml/allow_net_access", false);
     if (!allowNetAccess) parse_options |= XML_PARSE_NONET;
 
-    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), parse_options);
+    return parse_options;
+}
+
+xmlDocPtr XmlSource::readXml()
+{
+    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), xml_source_parse_options());
+}
+
+/**
+ * Like readXml(), but returns a reader which parses the file as it is being read.
+ * The reader must be freed before this XmlSource.
+ */
+xmlTextReaderPtr XmlSource::readXmlStream()
+{
+    return xmlReaderForIO(readCb, closeCb, this, filename, getEncoding(), xml_source_parse_options());
 }
 
 int XmlSource::readCb( void * context, char * buffer, int len )
@@ -297,9 +317,20 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns, bo
 
     Inkscape::IO::dump_fopen_call(filename, "N");
 
+    if (!xinclude) {
+        // Build the document while parsing, without an intermediate libxml2 tree.
+        XmlSource src;
+        if (src.setFile(filename) == 0) {
+            xmlTextReaderPtr reader = src.readXmlStream();
+            rdoc = sp_repr_do_read(reader, default_ns);
+            xmlFreeTextReader(reader);
+        }
+    }
+
+    // XInclude needs the whole tree, and the tree parser recovers from more errors.
     XmlSource src;
 
-    if (src.setFile(filename) == 0) {
+    if (!rdoc && src.setFile(filename) == 0) {
         doc = src.readXml();
         if (xinclude && doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
             g_warning("XInclude processing failed for %s", filename);
@@ -335,6 +366,14 @@ Document *sp_repr_read_mem (const gchar * buffer, gint length, const gchar *defa
                                        // proper solution would be to check the preference "/options/externalresources/xml/allow_net_access"
                                        // as done in XmlSource::readXml which gets called by the analogous sp_repr_read_file()
                                        // but sp_repr_read_mem() seems to be called in locations where Inkscape::Preferences::get() fails badly
+    xmlTextReaderPtr reader = xmlReaderForMemory(buffer, length, nullptr, nullptr, parser_options);
+    rdoc = sp_repr_do_read(reader, default_ns);
+    xmlFreeTextReader(reader);
+    if (rdoc) {
+        return rdoc;
+    }
+
+    // Fall back to the tree parser, which recovers from more errors.
     doc = xmlReadMemory (const_cast<gchar *>(buffer), length, nullptr, nullptr, parser_options);
 
     rdoc = sp_repr_do_read (doc, default_ns);
@@ -468,36 +507,127 @@ Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns)
     }
 
     if (root != nullptr) {
-        /* promote elements of some XML documents that don't use namespaces
-         * into their default namespace */
-        if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
-            g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
-            repair_namespace(root, "svg");
-        } else if ( default_ns && !strchr(root->name(), ':') ) {
-            if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
-                promote_to_namespace(root, "svg");
-            }
-            if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
-                promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
-            }
+        sp_repr_fix_root(root, default_ns);
+    }
+
+    return rdoc;
+}
+
+/**
+ * Reads in a XML file to create a Document, one node at a time as the reader parses it.
+ * Returns nullptr if the reader fails, in which case the document may be recoverable with the
+ * tree parser.
+ */
+static Document *sp_repr_do_read (xmlTextReaderPtr reader, const gchar *default_ns)
+{
+    if (reader == nullptr) {
+        return nullptr;
+    }
+
+    std::map<std::string, std::string> prefix_map;
+
+    Document *rdoc = new Inkscape::XML::SimpleDocument();
+
+    // The open elements; the reader frees its own nodes once they have been read.
+    std::vector<Node *> open;
+    Node *root = nullptr;
+    bool multiple_roots = false;
+    int status;
+    while ((status = xmlTextReaderRead(reader)) == 1) {
+        xmlNodePtr node = xmlTextReaderCurrentNode(reader);
+        int const type = xmlTextReaderNodeType(reader);
+        Node *repr = nullptr;
+
+        switch (type) {
+            case XML_READER_TYPE_ELEMENT:
+                repr = sp_repr_svg_read_element(rdoc, node, default_ns, prefix_map);
+                break;
+            case XML_READER_TYPE_END_ELEMENT:
+                if (!open.empty()) {
+                    open.pop_back();
+                }
+                continue;
+            case XML_READER_TYPE_TEXT:
+            case XML_READER_TYPE_CDATA:
+            case XML_READER_TYPE_WHITESPACE:
+            case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+            case XML_READER_TYPE_ENTITY_REFERENCE: // Unexpanded; read like the tree parser does.
+                if (!open.empty()) {
+                    repr = sp_repr_svg_read_node(rdoc, node, default_ns, prefix_map);
+                }
+                break;
+            case XML_READER_TYPE_COMMENT:
+            case XML_READER_TYPE_PROCESSING_INSTRUCTION:
+                repr = sp_repr_svg_read_node(rdoc, node, default_ns, prefix_map);
+                break;
+            default:
+                continue;
+        }
+
+        if (!repr) {
+            continue;
         }
 
+        Node *parent = open.empty() ? rdoc : open.back();
+        parent->appendChild(repr);
+        Inkscape::GC::release(repr);
 
-        // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
-        // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
-        // icons.svg). How can one tell if a file is internal?
-        if ( !strcmp(root->name(), "svg:svg" ) ) {
-            Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-            bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
-            if( clean ) {
-                sp_attribute_clean_tree( root );
+        if (type == XML_READER_TYPE_ELEMENT) {
+            if (open.empty()) {
+                if (root) {
+                    multiple_roots = true;
+                }
+                root = repr;
+            }
+            if (!xmlTextReaderIsEmptyElement(reader)) {
+                open.push_back(repr);
             }
         }
     }
 
+    // Leave documents without exactly one root element to the tree parser.
+    if (status != 0 || !root || multiple_roots) {
+        Inkscape::GC::release(rdoc);
+        return nullptr;
+    }
+
+    sp_repr_fix_root(root, default_ns);
+
     return rdoc;
 }
 
+/**
+ * Repair namespaces and clean up the root element of a document that has just been read.
+ */
+static void sp_repr_fix_root (Node *root, const gchar *default_ns)
+{
+    /* promote elements of some XML documents that don't use namespaces
+     * into their default namespace */
+    if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
+        g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
+        repair_namespace(root, "svg");
+    } else if ( default_ns && !strchr(root->name(), ':') ) {
+        if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
+            promote_to_namespace(root, "svg");
+        }
+        if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
+            promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
+        }
+    }
+
+
+    // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
+    // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
+    // icons.svg). How can one tell if a file is internal?
+    if ( !strcmp(root->name(), "svg:svg" ) ) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
+        if( clean ) {
+            sp_attribute_clean_tree( root );
+        }
+    }
+}
+
 gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
 {
     const xmlChar *prefix;
@@ -522,11 +652,35 @@ gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *nam
     }
 }
 
+/**
+ * Create an element with the name and attributes of node, but without its children.
+ */
+static Node *sp_repr_svg_read_element (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map)
+{
+    gchar c[256];
+
+    sp_repr_qualified_name (c, 256, node->ns, node->name, default_ns, prefix_map);
+    Node *repr = xml_doc->createElement(c);
+    /* TODO remember node->ns->prefix if node->ns != NULL */
+
+    for (xmlAttrPtr prop = node->properties; prop != nullptr; prop = prop->next) {
+        if (prop->children) {
+            sp_repr_qualified_name (c, 256, prop->ns, prop->name, default_ns, prefix_map);
+            repr->setAttribute(c, reinterpret_cast<gchar*>(prop->children->content));
+            /* TODO remember prop->ns->prefix if prop->ns != NULL */
+        }
+    }
+
+    if (node->content) {
+        repr->setContent(reinterpret_cast<gchar*>(node->content));
+    }
+
+    return repr;
+}
+
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map)
 {
-    xmlAttrPtr prop;
     xmlNodePtr child;
-    gchar c[256];
 
     if (node->type == XML_TEXT_NODE || node->type == XML_CDATA_SECTION_NODE) {
 
@@ -565,21 +719,7 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
         return nullptr;
     }
 
-    sp_repr_qualified_name (c, 256, node->ns, node->name, default_ns, prefix_map);
-    Node *repr = xml_doc->createElement(c);
-    /* TODO remember node->ns->prefix if node->ns != NULL */
-
-    for (prop = node->properties; prop != nullptr; prop = prop->next) {
-        if (prop->children) {
-            sp_repr_qualified_name (c, 256, prop->ns, prop->name, default_ns, prefix_map);
-            repr->setAttribute(c, reinterpret_cast<gchar*>(prop->children->content));
-            /* TODO remember prop->ns->prefix if prop->ns != NULL */
-        }
-    }
-
-    if (node->content) {
-        repr->setContent(reinterpret_cast<gchar*>(node->content));
-    }
+    Node *repr = sp_repr_svg_read_element(xml_doc, node, default_ns, prefix_map);
 
     for (child = node->xmlChildrenNode; child != nullptr; child = child->next) {
         Node *crepr = sp_repr_svg_read_node (xml_doc, child, default_ns, prefix_map);
@@ -593,15 +733,13 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
 }
 
 
+/// Write a document as it is, with the given formatting.
 static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
+                    SPReprSaveOptions const &options,
                     gchar const *default_ns,
                     gchar const *old_href_abs_base,
                     gchar const *new_href_abs_base)
 {
-    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-    bool inlineattrs = prefs->getBool("/options/svgoutput/inlineattrs");
-    int indent = prefs->getInt("/options/svgoutput/indent", 2);
-
     /* fixme: do this The Right Way */
     out->writeString( "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n" );
 
@@ -615,10 +753,10 @@ static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
     {
         Inkscape::XML::NodeType const node_type = repr->type();
         if ( node_type == Inkscape::XML::NodeType::ELEMENT_NODE ) {
-            sp_repr_write_stream_root_element(repr, *out, TRUE, default_ns, inlineattrs, indent,
+            sp_repr_write_stream_root_element(repr, *out, TRUE, default_ns, options.inlineattrs, options.indent,
                                               old_href_abs_base, new_href_abs_base);
         } else {
-            sp_repr_write_stream(repr, *out, 0, TRUE, GQuark(0), inlineattrs, indent,
+            sp_repr_write_stream(repr, *out, 0, TRUE, GQuark(0), options.inlineattrs, options.indent,
                                  old_href_abs_base, new_href_abs_base);
             if ( node_type == Inkscape::XML::NodeType::COMMENT_NODE ) {
                 out->writeChar('\n');
@@ -627,13 +765,41 @@ static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
     }
 }
 
+/// Clean and sort the attributes of a document before saving it, as set in the preferences.
+static void sp_repr_tidy_for_saving(Document *doc)
+{
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+
+    // Clean unnecessary attributes and stype properties. (Controlled by preferences.)
+    bool clean = prefs->getBool("/options/svgoutput/check_on_writing");
+
+    // Sort attributes in a canonical order (helps with "diffing" SVG files).only if not set disable optimizations
+    bool sort = !prefs->getBool("/options/svgoutput/disable_optimizations") && prefs->getBool("/options/svgoutput/sort_attributes");
+
+    for (Node *repr = sp_repr_document_first_child(doc); repr; repr = repr->next()) {
+        if (repr->type() == Inkscape::XML::NodeType::ELEMENT_NODE) {
+            if (clean) sp_attribute_clean_tree( repr );
+            if (sort) sp_attribute_sort_tree( *repr );
+        }
+    }
+}
+
+SPReprSaveOptions sp_repr_save_options()
+{
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    SPReprSaveOptions options;
+    options.inlineattrs = prefs->getBool("/options/svgoutput/inlineattrs");
+    options.indent = prefs->getInt("/options/svgoutput/indent", 2);
+    return options;
+}
 
 Glib::ustring sp_repr_save_buf(Document *doc)
 {   
     Inkscape::IO::StringOutputStream souts;
     Inkscape::IO::OutputStreamWriter outs(souts);
 
-    sp_repr_save_writer(doc, &outs, SP_INKSCAPE_NS_URI, nullptr, nullptr);
+    sp_repr_tidy_for_saving(doc);
+    sp_repr_save_writer(doc, &outs, sp_repr_save_options(), SP_INKSCAPE_NS_URI, nullptr, nullptr);
 
     outs.close();
     Glib::ustring buf = souts.getString();
@@ -645,12 +811,19 @@ Glib::ustring sp_repr_save_buf(Document *doc)
 void sp_repr_save_stream(Document *doc, FILE *fp, gchar const *default_ns, bool compress,
                     gchar const *const old_href_abs_base,
                     gchar const *const new_href_abs_base)
+{
+    sp_repr_tidy_for_saving(doc);
+    sp_repr_save_stream(doc, fp, sp_repr_save_options(), default_ns, compress, old_href_abs_base, new_href_abs_base);
+}
+
+void sp_repr_save_stream(Document *doc, FILE *fp, SPReprSaveOptions const &options, gchar const *default_ns,
+                         bool compress, gchar const *const old_href_abs_base, gchar const *const new_href_abs_base)
 {
     Inkscape::IO::FileOutputStream bout(fp);
     Inkscape::IO::GzipOutputStream *gout = compress ? new Inkscape::IO::GzipOutputStream(bout) : nullptr;
     Inkscape::IO::OutputStreamWriter *out  = compress ? new Inkscape::IO::OutputStreamWriter( *gout ) : new Inkscape::IO::OutputStreamWriter( bout );
 
-    sp_repr_save_writer(doc, out, default_ns, old_href_abs_base, new_href_abs_base);
+    sp_repr_save_writer(doc, out, options, default_ns, old_href_abs_base, new_href_abs_base);
 
     delete out;
     delete gout;
@@ -836,15 +1009,6 @@ static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
 
     g_assert(repr != nullptr);
 
-    // Clean unnecessary attributes and stype properties. (Controlled by preferences.)
-    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-    bool clean = prefs->getBool("/options/svgoutput/check_on_writing");
-    if (clean) sp_attribute_clean_tree( repr );
-
-    // Sort attributes in a canonical order (helps with "diffing" SVG files).only if not set disable optimizations
-    bool sort = !prefs->getBool("/options/svgoutput/disable_optimizations") && prefs->getBool("/options/svgoutput/sort_attributes");
-    if (sort) sp_attribute_sort_tree( *repr );
-
     Glib::QueryQuark xml_prefix=g_quark_from_static_string("xml");
 
     NSMap ns_map;
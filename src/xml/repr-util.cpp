@@ -17,6 +17,7 @@
  */
 
 #include <cstring>
+#include <mutex>
 
 #include <glib.h>
 #include <glibmm.h>
@@ -65,6 +66,16 @@ static char *sp_xml_ns_auto_prefix(char const *uri);
 
 static SPXMLNs *namespaces=nullptr;
 
+/*
+ * Protects namespaces, as documents may be saved on other threads, such as the autosave writer.
+ * Recursive because sp_xml_ns_uri_prefix() looks up candidate prefixes while holding it.
+ */
+static std::recursive_mutex &namespaces_mutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
 /*
  * There are the prefixes to use for the XML namespaces defined
  * in repr.h
@@ -163,6 +174,7 @@ gchar const *sp_xml_ns_uri_prefix(gchar const *uri, gchar const *suggested)
 
     if (!uri) return nullptr;
 
+    auto lock = std::lock_guard(namespaces_mutex());
     if (!namespaces) {
         sp_xml_ns_register_defaults();
     }
@@ -224,6 +236,7 @@ gchar const *sp_xml_ns_prefix_uri(gchar const *prefix)
 
     if (!prefix) return nullptr;
 
+    auto lock = std::lock_guard(namespaces_mutex());
     if (!namespaces) {
         sp_xml_ns_register_defaults();
     }
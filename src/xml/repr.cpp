@@ -47,6 +47,25 @@ sp_repr_document_new(char const *rootname)
     return doc;
 }
 
+Inkscape::XML::Document *
+sp_repr_document_copy(Inkscape::XML::Document const *doc)
+{
+    Inkscape::XML::Document *copy = new Inkscape::XML::SimpleDocument();
+
+    for (auto const &attribute : doc->attributeList()) {
+        copy->setAttribute(g_quark_to_string(attribute.key), attribute.value);
+    }
+
+    // Duplicate the svg root node AND any PI and COMMENT nodes.
+    for (auto child = doc->firstChild(); child; child = child->next()) {
+        Inkscape::XML::Node *new_child = child->duplicate(copy);
+        copy->appendChild(new_child);
+        Inkscape::GC::release(new_child);
+    }
+
+    return copy;
+}
+
 /*
   Local Variables:
   mode:c++
@@ -44,12 +44,18 @@ namespace Geom {
 class Point;
 }
 
-/* SPXMLNs */
+/* SPXMLNs; these may be called from any thread. */
 char const *sp_xml_ns_uri_prefix(char const *uri, char const *suggested);
 char const *sp_xml_ns_prefix_uri(char const *prefix);
 
 Inkscape::XML::Document *sp_repr_document_new(char const *rootname);
 
+/**
+ * Copy a document and all its nodes. Attribute values and text are immutable shared strings, so
+ * only the tree itself is copied.
+ */
+Inkscape::XML::Document *sp_repr_document_copy(Inkscape::XML::Document const *doc);
+
 /* IO */
 
 Inkscape::XML::Document *sp_repr_read_file(char const *filename, char const *default_ns, bool xinclude = false);
@@ -68,6 +74,26 @@ void sp_repr_save_stream(Inkscape::XML::Document *doc, FILE *to_file,
                          char const *old_href_base = nullptr,
                          char const *new_href_base = nullptr);
 
+/// Formatting of saved documents.
+struct SPReprSaveOptions
+{
+    bool inlineattrs = false; ///< Write the attributes of an element on the same line.
+    int indent = 2;
+};
+
+/// The formatting of saved documents set in the preferences.
+SPReprSaveOptions sp_repr_save_options();
+
+/**
+ * Save a document as it is, with the given formatting. Unlike the above, this reads no
+ * preferences and doesn't clean the document first, so it may be used on another thread, provided
+ * the thread is registered with the garbage collector and nothing else accesses the document.
+ */
+void sp_repr_save_stream(Inkscape::XML::Document *doc, FILE *to_file, SPReprSaveOptions const &options,
+                         char const *default_ns = nullptr, bool compress = false,
+                         char const *old_href_base = nullptr,
+                         char const *new_href_base = nullptr);
+
 bool sp_repr_save_file(Inkscape::XML::Document *doc, char const *filename, char const *default_ns=nullptr);
 bool sp_repr_save_rebased_file(Inkscape::XML::Document *doc, char const *filename_utf8,
                                char const *default_ns,
@@ -19,6 +19,8 @@
 // clang-format on
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -164,6 +166,33 @@ public:
     }
 };
 
+/**
+ * Return the quark of an attribute name, or 0 if no attribute can have that name. Unlike
+ * g_quark_from_string(), this neither interns unknown names nor takes GLib's global quark lock
+ * for names looked up recently by the same thread, which are mostly string literals.
+ */
+GQuark lookup_attribute_key(char const *name)
+{
+    struct Entry
+    {
+        char const *name;
+        GQuark key;
+    };
+    static thread_local std::array<Entry, 64> cache{};
+
+    // The same address may hold a different name by now, so check the string too.
+    auto &entry = cache[(reinterpret_cast<std::uintptr_t>(name) >> 3) % cache.size()];
+    if (entry.name == name && entry.key && std::strcmp(g_quark_to_string(entry.key), name) == 0) {
+        return entry.key;
+    }
+
+    GQuark const key = g_quark_try_string(name);
+    if (key) {
+        entry = {name, key};
+    }
+    return key;
+}
+
 } // namespace
 
 using Util::ptr_shared;
@@ -228,7 +257,10 @@ gchar const *SimpleNode::content() const {
 gchar const *SimpleNode::attribute(gchar const *name) const {
     g_return_val_if_fail(name != nullptr, NULL);
 
-    GQuark const key = g_quark_from_string(name);
+    GQuark const key = lookup_attribute_key(name);
+    if (!key) {
+        return nullptr;
+    }
 
     for (const auto & iter : _attributes)
     {
@@ -319,16 +351,20 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
     g_assert(std::none_of(name, name + strlen(name), [](char c) { return g_ascii_isspace(c); }));
 
     // Check usefulness of attributes on elements in the svg namespace, optionally don't add them to tree.
-    Glib::ustring element = g_quark_to_string(_name);
-    //g_message("setAttribute:  %s: %s: %s", element.c_str(), name, value);
-    gchar* cleaned_value = g_strdup( value );
+    gchar const *element_name = g_quark_to_string(_name);
+    //g_message("setAttribute:  %s: %s: %s", element_name, name, value);
+
+    // Only copied if cleaning changes it.
+    Glib::ustring cleaned_style;
+    gchar const *cleaned_value = value;
 
     // Only check elements in SVG name space and don't block setting attribute to NULL.
-    if( element.substr(0,4) == "svg:" && value != nullptr) {
+    if (std::strncmp(element_name, "svg:", 4) == 0 && value != nullptr) {
 
         Inkscape::Preferences *prefs = Inkscape::Preferences::get();
         if( prefs->getBool("/options/svgoutput/check_on_editing") ) {
 
+            Glib::ustring element = element_name;
             gchar const *id_char = attribute("id");
             Glib::ustring id = (id_char == nullptr ? "" : id_char );
             unsigned int flags = sp_attribute_clean_get_prefs();
@@ -339,7 +375,6 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
             if( (attr_warn || attr_remove) && value != nullptr ) {
                 bool is_useful = sp_attribute_check_attribute( element, id, name, attr_warn );
                 if( !is_useful && attr_remove ) {
-                    g_free( cleaned_value );
                     return; // Don't add to tree.
                 }
             }
@@ -347,8 +382,8 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
             // Check style properties -- Note: if element is not yet inserted into
             // tree (and thus has no parent), default values will not be tested.
             if( !strcmp( name, "style" ) && (flags >= SP_ATTRCLEAN_STYLE_WARN) ) {
-                g_free( cleaned_value );
-                cleaned_value = g_strdup( sp_attribute_clean_style( this, value, flags ).c_str() );
+                cleaned_style = sp_attribute_clean_style( this, value, flags );
+                cleaned_value = cleaned_style.c_str();
                 // if( g_strcmp0( value, cleaned_value ) ) {
                 //     g_warning( "SimpleNode::setAttribute: %s", id.c_str() );
                 //     g_warning( "     original: %s", value);
@@ -360,39 +395,38 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
 
     GQuark const key = g_quark_from_string(name);
 
-    AttributeRecord *ref = nullptr;
-    for ( auto & existing : _attributes ) {
-        if ( existing.key == key ) {
-            ref = &existing;
-            break;
-        }
-    }
+    auto ref = std::find_if(_attributes.begin(), _attributes.end(),
+                            [=] (AttributeRecord const &existing) { return existing.key == key; });
+    bool const found = ref != _attributes.end();
     Debug::EventTracker<> tracker;
 
-    ptr_shared old_value=( ref ? ref->value : ptr_shared() );
+    ptr_shared old_value=( found ? ref->value : ptr_shared() );
 
     ptr_shared new_value=ptr_shared();
     if (cleaned_value) { // set value of attribute
         new_value = share_string(cleaned_value);
         tracker.set<DebugSetAttribute>(*this, key, new_value);
-        if (!ref) {
-	    _attributes.emplace_back(key, new_value);
+        if (!found) {
+            if (_attributes.empty()) {
+                // Avoid regrowing the vector for the first few attributes, which each allocate.
+                _attributes.reserve(4);
+            }
+            _attributes.emplace_back(key, new_value);
         } else {
             ref->value = new_value;
         }
     } else { //clearing attribute
         tracker.set<DebugClearAttribute>(*this, key);
-        if (ref) {
-	    _attributes.erase(std::find(_attributes.begin(),_attributes.end(),(*ref)));
+        if (found) {
+            _attributes.erase(ref);
         }
     }
 
     if ( new_value != old_value && (!old_value || !new_value || strcmp(old_value, new_value))) {
         _document->logger()->notifyAttributeChanged(*this, key, old_value, new_value);
         _observers.notifyAttributeChanged(*this, key, old_value, new_value);
-        //g_warning( "setAttribute notified: %s: %s: %s: %s", name, element.c_str(), old_value, new_value ); 
+        //g_warning( "setAttribute notified: %s: %s: %s: %s", name, element_name, old_value, new_value ); 
     }
-    g_free( cleaned_value );
 }
 
 void SimpleNode::setCodeUnsafe(int code) {
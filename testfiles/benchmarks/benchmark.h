@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Helpers for the benchmark executables.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_TESTFILES_BENCHMARK_H
+#define INKSCAPE_TESTFILES_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Inkscape {
+namespace Benchmark {
+
+/// Keep the compiler from optimizing away a result that is otherwise unused.
+template <typename T>
+inline void keep(T const &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Run f the given number of times after one warm-up run, and return the median time of a run
+ * in milliseconds. The median is less affected by other activity on the machine than the mean.
+ */
+template <typename F>
+double median_ms(F &&f, int runs = 10)
+{
+    using Clock = std::chrono::steady_clock;
+    f();
+    std::vector<double> times;
+    for (int i = 0; i < runs; ++i) {
+        auto const start = Clock::now();
+        f();
+        times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/// Print one line of results, aligned with the others.
+inline void report(std::string const &name, double ms, std::string const &note = {})
+{
+    std::printf("%-40s %10.3f ms%s%s\n", name.c_str(), ms, note.empty() ? "" : "   ", note.c_str());
+    std::fflush(stdout);
+}
+
+} // namespace Benchmark
+} // namespace Inkscape
+
+#endif // INKSCAPE_TESTFILES_BENCHMARK_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of the pixel row kernels at each instruction set level.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "display/cairo-simd.h"
+#include "display/cairo-utils.h"
+
+using namespace Inkscape::Display;
+using Inkscape::Benchmark::keep;
+using Inkscape::Benchmark::median_ms;
+using Inkscape::Benchmark::report;
+
+namespace {
+
+constexpr int size = 1 << 20;
+
+/// The sRGB to linearRGB conversion as it was done before the lookup tables, for comparison.
+guint32 srgb_to_linear_pow(guint32 c, guint32 a)
+{
+    double cc = unpremul_alpha(c, a) / 255.0;
+    if (cc < 0.04045) {
+        cc /= 12.92;
+    } else {
+        cc = std::pow((cc + 0.055) / 1.055, 2.4);
+    }
+    return premul_alpha(static_cast<guint32>(cc * 255.0), a);
+}
+
+char const *level_name(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::SSE41: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::vector<guint32> in1(size), in2(size), out(size);
+    for (int i = 0; i < size; ++i) {
+        // Random colors, premultiplied so that the kernels see valid pixels.
+        guint32 const a = rng() & 0xff;
+        guint32 const px = rng();
+        in1[i] = (a << 24) | (premul_alpha((px >> 16) & 0xff, a) << 16) | (premul_alpha((px >> 8) & 0xff, a) << 8) | premul_alpha(px & 0xff, a);
+        in2[i] = (a << 24) | (premul_alpha(px & 0xff, a) << 16) | (premul_alpha((px >> 8) & 0xff, a) << 8) | premul_alpha((px >> 16) & 0xff, a);
+    }
+    gint32 matrix[20];
+    for (int i = 0; i < 20; ++i) {
+        matrix[i] = std::uniform_int_distribution<gint32>(-3 * 255, 3 * 255)(rng) * (i % 5 == 4 ? 255 : 1);
+    }
+    gint32 const k[4] = {128, 255 * 255 / 2, -255 * 255 / 3, 255 * 255 * 20};
+
+    std::vector<std::pair<char const *, std::function<void ()>>> const kernels = {
+        {"premultiply", [&] { premultiply_row(in1.data(), out.data(), size); }},
+        {"unpremultiply", [&] { unpremultiply_row(in1.data(), out.data(), size); }},
+        {"color matrix", [&] { color_matrix_row(matrix, in1.data(), out.data(), size); }},
+        {"arithmetic", [&] { composite_arithmetic_row(k, in1.data(), in2.data(), out.data(), size); }},
+        {"sRGB to linear", [&] { srgb_to_linear_row(in1.data(), out.data(), size); }},
+        {"linear to sRGB", [&] { linear_to_srgb_row(in1.data(), out.data(), size); }},
+    };
+
+    std::printf("%d pixels per run, median of 20 runs\n", size);
+    for (auto const &[name, kernel] : kernels) {
+        double scalar_ms = 0.0;
+        for (auto level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2}) {
+            if (level > simd_level_supported()) {
+                continue;
+            }
+            set_simd_level(level);
+            double const ms = median_ms([&] { kernel(); keep(out); }, 20);
+            if (level == SimdLevel::Scalar) {
+                scalar_ms = ms;
+            }
+            char speedup[32] = "";
+            if (level != SimdLevel::Scalar) {
+                std::snprintf(speedup, sizeof(speedup), "%.1fx", scalar_ms / ms);
+            }
+            report(std::string(name) + " (" + level_name(level) + ")", ms, speedup);
+        }
+    }
+
+    double const pow_ms = median_ms([&] {
+        for (int i = 0; i < size; ++i) {
+            EXTRACT_ARGB32(in1[i], a, r, g, b);
+            if (a != 0) {
+                r = srgb_to_linear_pow(r, a);
+                g = srgb_to_linear_pow(g, a);
+                b = srgb_to_linear_pow(b, a);
+            }
+            ASSEMBLE_ARGB32(px, a, r, g, b);
+            out[i] = px;
+        }
+        keep(out);
+    }, 20);
+    report("sRGB to linear (pow per channel)", pow_ms);
+
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of livarot's stroke to path and offset, with and without the scratch arena.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <string>
+
+#include "benchmark.h"
+#include "livarot/Path.h"
+#include "livarot/Shape.h"
+#include "livarot/arena.h"
+
+using Inkscape::Benchmark::keep;
+using Inkscape::Benchmark::median_ms;
+using Inkscape::Benchmark::report;
+
+// Count heap allocations, including the buffers of the arena.
+static std::atomic<long> allocations = 0;
+static std::atomic<long> allocated_bytes = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+/// A closed polygon with the given number of nodes, finely sampling a wavy circle.
+void wavy_path(Path &path, int nodes)
+{
+    path.MoveTo(Geom::Point(1000, 0));
+    for (int i = 1; i < nodes; i++) {
+        double const a = 2 * M_PI * i / nodes;
+        double const r = 1000 + 40 * std::sin(50 * a);
+        path.LineTo(Geom::Point(r * std::cos(a), r * std::sin(a)));
+    }
+    path.Close();
+}
+
+/// The livarot part of stroke to path, as in item_find_paths().
+void stroke_to_path(Path &origin, bool use_arena)
+{
+    Path offset;
+    offset.SetBackData(false);
+    origin.Outline(&offset, 5, join_round, butt_round, 20);
+    offset.ConvertWithBackData(1.0);
+
+    std::optional<ArenaScope> arena;
+    if (use_arena) {
+        arena.emplace(Shape::ArenaSizeHint(offset.pts.size()));
+    }
+    Shape shape;
+    offset.Fill(&shape, 0);
+    Shape result;
+    result.ConvertToShape(&shape, fill_positive);
+    Path forme;
+    Path *paths[] = { &offset };
+    result.ConvertToForme(&forme, 1, paths);
+    keep(forme);
+}
+
+/// The livarot part of inset, as in sp_selected_path_do_offset().
+void inset(Path &orig, bool use_arena)
+{
+    orig.ConvertWithBackData(0.03);
+
+    std::optional<ArenaScope> arena;
+    if (use_arena) {
+        arena.emplace(Shape::ArenaSizeHint(orig.pts.size()));
+    }
+    Shape shape;
+    Shape res;
+    orig.Fill(&shape, 0);
+    res.ConvertToShape(&shape, fill_nonZero);
+    shape.MakeOffset(&res, -5, join_round, 20);
+    res.ConvertToShape(&shape, fill_positive);
+
+    Path result;
+    res.ConvertToForme(&result);
+    keep(result);
+}
+
+} // namespace
+
+int main()
+{
+    int const nodes = 10000;
+    int const runs = 10;
+
+    std::printf("Paths of %d nodes, median of %d runs\n", nodes, runs);
+    for (auto [name, op] : { std::make_pair("stroke to path", &stroke_to_path), std::make_pair("inset", &inset) }) {
+        for (bool use_arena : { false, true }) {
+            Path path;
+            wavy_path(path, nodes);
+
+            op(path, use_arena); // Warm up, which also gives the arena its buffer.
+            long const count = allocations;
+            long const bytes = allocated_bytes;
+            op(path, use_arena);
+            char note[96];
+            std::snprintf(note, sizeof(note), "%ld allocations, %.1f MiB",
+                          allocations - count, (allocated_bytes - bytes) / 1048576.0);
+
+            double const ms = median_ms([&] { op(path, use_arena); }, runs);
+            report(std::string(name) + (use_arena ? " (arena)" : " (heap)"), ms, note);
+        }
+    }
+
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
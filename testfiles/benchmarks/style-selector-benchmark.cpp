@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of style resolution with the selector index, against matching the whole cascade.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <giomm/init.h>
+
+#include "benchmark.h"
+#include "document.h"
+#include "inkgc/gc-core.h"
+#include "style-selector-index.h"
+#include "util/statics.h"
+#include "xml/croco-node-iface.h"
+#include "xml/node.h"
+
+using Inkscape::Benchmark::keep;
+using Inkscape::Benchmark::median_ms;
+using Inkscape::Benchmark::report;
+using Inkscape::XML::Node;
+
+namespace {
+
+constexpr int rules = 10000;
+constexpr int elements = 100000;
+
+/// A document with one class rule per class and elements spread evenly over the classes.
+std::string make_svg()
+{
+    std::string svg = "<svg xmlns='http://www.w3.org/2000/svg'><style>";
+    for (int i = 0; i < rules; i++) {
+        svg += ".c" + std::to_string(i) + " { fill: #" + std::to_string(100000 + i % 900000) + "; }\n";
+    }
+    svg += "</style>";
+    for (int i = 0; i < elements; i++) {
+        svg += "<rect class='c" + std::to_string(i % rules) + "' width='1' height='1'/>";
+    }
+    svg += "</svg>";
+    return svg;
+}
+
+void collect_elements(Node *node, std::vector<Node *> &nodes)
+{
+    if (node->type() == Inkscape::XML::NodeType::ELEMENT_NODE) {
+        nodes.push_back(node);
+    }
+    for (auto child = node->firstChild(); child; child = child->next()) {
+        collect_elements(child, nodes);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    Gio::init();
+    Inkscape::GC::init();
+
+    auto const svg = make_svg();
+    std::printf("%d class rules, %d elements\n", rules, elements);
+
+    // Loading styles every element, through the index.
+    double const load_ms = median_ms([&] {
+        std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(svg.c_str(), static_cast<int>(svg.size()), false));
+        doc->ensureUpToDate();
+        keep(doc);
+    }, 3);
+    report("load and style document", load_ms);
+
+    std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(svg.c_str(), static_cast<int>(svg.size()), false));
+    doc->ensureUpToDate();
+    std::vector<Node *> nodes;
+    collect_elements(doc->getReprRoot(), nodes);
+    auto sel_eng = cr_sel_eng_new(&Inkscape::XML::croco_node_iface);
+
+    auto const index = doc->getStyleSelectorIndex();
+    double const index_ms = median_ms([&] {
+        for (auto node : nodes) {
+            keep(index->match(sel_eng, node));
+        }
+    }, 5);
+    report("match all elements (index)", index_ms);
+
+    // Matching against the whole cascade takes too long for every element, so time a sample.
+    int const sample = 1000;
+    double const cascade_ms = median_ms([&] {
+        for (int i = 0; i < sample; i++) {
+            CRPropList *props = nullptr;
+            cr_sel_eng_get_matched_properties_from_cascade(sel_eng, doc->getStyleCascade(), nodes[i * nodes.size() / sample], &props);
+            cr_prop_list_destroy(props);
+        }
+    }, 3) * nodes.size() / sample;
+    char speedup[32];
+    std::snprintf(speedup, sizeof(speedup), "%.0fx, from %d elements", cascade_ms / index_ms, sample);
+    report("match all elements (cascade)", cascade_ms, speedup);
+
+    cr_sel_eng_destroy(sel_eng);
+    doc.reset();
+    Inkscape::Util::StaticsBin::get().destroy();
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of writing numbers and path data in SVG.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstdio>
+#include <locale>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <2geom/bezier-curve.h>
+#include <2geom/path.h>
+#include <2geom/pathvector.h>
+
+#include "benchmark.h"
+#include "svg/stringstream.h"
+#include "svg/strip-trailing-zeros.h"
+#include "svg/svg.h"
+
+using Inkscape::Benchmark::keep;
+using Inkscape::Benchmark::median_ms;
+using Inkscape::Benchmark::report;
+
+namespace {
+
+constexpr int count = 1000000;
+constexpr int precision = 8;
+
+} // namespace
+
+int main()
+{
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> coord(0, 1000);
+    std::vector<double> values(count);
+    for (auto &value : values) {
+        value = coord(rng);
+    }
+    std::printf("%d values in [0, 1000), precision %d\n", count, precision);
+
+    double const write_ms = median_ms([&] {
+        std::string out;
+        for (auto value : values) {
+            out += sp_svg_number_write_de(value, precision, -8);
+            out += ' ';
+        }
+        keep(out);
+    });
+    report("sp_svg_number_write_de", write_ms);
+
+    double const append_ms = median_ms([&] {
+        std::string out;
+        for (auto value : values) {
+            sp_svg_number_append_de(out, value, precision, -8);
+            out += ' ';
+        }
+        keep(out);
+    });
+    report("sp_svg_number_append_de", append_ms);
+
+    // SVGOStringStream, against what it did before: a stream per number and strip_trailing_zeros.
+    double const stream_strip_ms = median_ms([&] {
+        std::ostringstream out;
+        out.imbue(std::locale::classic());
+        for (auto value : values) {
+            std::ostringstream s;
+            s.imbue(std::locale::classic());
+            s.setf(std::ios::showpoint);
+            s.precision(precision);
+            s << value;
+            out << strip_trailing_zeros(s.str()) << ' ';
+        }
+        keep(out);
+    });
+    report("ostringstream and strip_trailing_zeros", stream_strip_ms);
+
+    double const stream_ms = median_ms([&] {
+        Inkscape::SVGOStringStream out;
+        out.precision(precision);
+        for (auto value : values) {
+            out << value << ' ';
+        }
+        keep(out);
+    });
+    char note[32];
+    std::snprintf(note, sizeof(note), "%.1fx", stream_strip_ms / stream_ms);
+    report("SVGOStringStream", stream_ms, note);
+
+    // Whole path data, as written for a path with many nodes.
+    Geom::Path path(Geom::Point(values[0], values[1]));
+    for (int i = 2; i + 5 < count; i += 6) {
+        path.appendNew<Geom::CubicBezier>(Geom::Point(values[i], values[i + 1]), Geom::Point(values[i + 2], values[i + 3]),
+                                          Geom::Point(values[i + 4], values[i + 5]));
+    }
+    Geom::PathVector const pathv(path);
+    double const path_ms = median_ms([&] { keep(sp_svg_write_path(pathv)); });
+    report("sp_svg_write_path (" + std::to_string(path.size()) + " cubics)", path_ms);
+
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of XML attribute lookups and edits on a large document.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstdio>
+#include <iterator>
+#include <string>
+
+#include <glib.h>
+
+#include "benchmark.h"
+#include "gc-anchored.h"
+#include "inkgc/gc-core.h"
+#include "xml/repr.h"
+
+using Inkscape::Benchmark::keep;
+using Inkscape::Benchmark::median_ms;
+using Inkscape::Benchmark::report;
+using Inkscape::XML::Node;
+
+namespace {
+
+constexpr int nodes = 200000;
+
+// Four names every node has, and two that none has.
+char const *const names[] = {"id", "x", "height", "transform", "inkscape:label", "clip-path"};
+
+std::string make_svg()
+{
+    std::string svg = "<svg>";
+    for (int i = 0; i < nodes; i++) {
+        auto n = std::to_string(i);
+        svg += "<rect id='r" + n + "' x='" + n + "' y='1' width='2' height='3' style='fill:red' transform='scale(2)'/>";
+    }
+    svg += "</svg>";
+    return svg;
+}
+
+/// Node::attribute() as it was before the quark cache: intern the name, then scan.
+char const *attribute_interned(Node const &node, char const *name)
+{
+    GQuark const key = g_quark_from_string(name);
+    for (auto const &record : node.attributeList()) {
+        if (record.key == key) {
+            return record.value;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main()
+{
+    Inkscape::GC::init();
+
+    auto const svg = make_svg();
+    std::printf("%d nodes with 7 attributes, 6 names looked up per node\n", nodes);
+
+    double const load_ms = median_ms([&] {
+        auto doc = sp_repr_read_buf(svg, SP_SVG_NS_URI);
+        keep(doc);
+        Inkscape::GC::release(doc);
+    }, 3);
+    report("load", load_ms);
+
+    auto doc = sp_repr_read_buf(svg, SP_SVG_NS_URI);
+    auto root = doc->root();
+
+    double const lookup_ms = median_ms([&] {
+        std::size_t found = 0;
+        for (auto &child : *root) {
+            for (auto name : names) {
+                found += child.attribute(name) != nullptr;
+            }
+        }
+        keep(found);
+    });
+    report("lookups", lookup_ms);
+
+    double const interned_ms = median_ms([&] {
+        std::size_t found = 0;
+        for (auto &child : *root) {
+            for (auto name : names) {
+                found += attribute_interned(child, name) != nullptr;
+            }
+        }
+        keep(found);
+    });
+    char note[32];
+    std::snprintf(note, sizeof(note), "%.1fx", interned_ms / lookup_ms);
+    report("lookups, interning the name", interned_ms, note);
+
+    // What is left once the name is a key: the scan of the attribute vector.
+    GQuark keys[std::size(names)];
+    for (std::size_t i = 0; i < std::size(names); i++) {
+        keys[i] = g_quark_from_string(names[i]);
+    }
+    double const scan_ms = median_ms([&] {
+        std::size_t found = 0;
+        for (auto &child : *root) {
+            for (auto key : keys) {
+                for (auto const &record : child.attributeList()) {
+                    if (record.key == key) {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        keep(found);
+    });
+    report("lookups, scan only", scan_ms);
+
+    double const edit_ms = median_ms([&] {
+        for (auto &child : *root) {
+            child.setAttribute("x", "5");
+            child.setAttribute("inkscape:label", "label");
+            child.setAttribute("inkscape:label", nullptr);
+        }
+    });
+    report("edits (set x, set and clear label)", edit_ms);
+
+    Inkscape::GC::release(doc);
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
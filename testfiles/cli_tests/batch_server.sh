@@ -0,0 +1,22 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+# Send two requests to "inkscape --batch-server=2" and check that both were served by worker processes.
+
+inkscape=$1
+input=$2
+
+test -f "${input}" || { echo "batch_server.sh: input '${input}' not found."; exit 1; }
+
+output=$(printf 'render a 0 file-open:%s;query-all\nrender b 0 file-open:%s;query-all\nquit\n' "${input}" "${input}" \
+         | "${inkscape}" --batch-server=2 2>&1) || { echo "${output}"; echo "batch_server.sh: server failed."; exit 1; }
+echo "${output}"
+
+if ! grep -q "ready (2 jobs)" <<< "${output}"; then
+    echo "batch_server.sh: no worker processes were started."
+    exit 1
+fi
+if [ "$(grep -cE '^result [ab] ok' <<< "${output}")" != 2 ]; then
+    echo "batch_server.sh: not all requests succeeded."
+    exit 1
+fi
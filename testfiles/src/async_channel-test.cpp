@@ -74,3 +74,15 @@ TEST(Channel, channel)
         test_one(x, false, true);
     }
 }
+
+TEST(Channel, reassign)
+{
+    auto [src, dst] = Channel::create();
+    EXPECT_TRUE(src.run([] {}));
+
+    // Overwriting a Dest closes the channel it held, just as destroying it does.
+    dst = Channel::Dest();
+    EXPECT_FALSE(dst);
+    EXPECT_FALSE(src);
+    EXPECT_FALSE(src.run([] {}));
+}
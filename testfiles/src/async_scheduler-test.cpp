@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include "async/scheduler.h"
+using namespace Inkscape::Async;
+
+TEST(SchedulerTest, nested)
+{
+    Scheduler scheduler;
+    scheduler.setConcurrency(4);
+
+    std::vector<std::atomic<int>> hits(100 * 100);
+    scheduler.parallel_for(0, 100, [&] (int i) {
+        scheduler.parallel_for(0, 100, [&] (int j) {
+            hits[i * 100 + j]++;
+        });
+    });
+
+    for (auto &h : hits) {
+        EXPECT_EQ(h, 1);
+    }
+}
+
+TEST(SchedulerTest, exception)
+{
+    Scheduler scheduler;
+    scheduler.setConcurrency(4);
+
+    EXPECT_THROW(scheduler.parallel_for(0, 1000, [] (int i) {
+        if (i == 567) {
+            throw std::runtime_error("test");
+        }
+    }), std::runtime_error);
+}
+
+TEST(SchedulerTest, cancel)
+{
+    Scheduler scheduler;
+    TaskGroup group(scheduler);
+    std::atomic<int> count = 0;
+
+    group.cancel();
+    for (int i = 0; i < 100; i++) {
+        group.run([&] { count++; });
+    }
+    group.wait();
+    EXPECT_EQ(count, 0);
+
+    // Waiting resets the cancellation.
+    group.run([&] { count++; });
+    group.wait();
+    EXPECT_EQ(count, 1);
+}
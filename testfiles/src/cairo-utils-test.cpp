@@ -9,9 +9,23 @@
  * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
+#include <src/display/cairo-simd.h>
 #include <src/display/cairo-utils.h>
+#include <src/display/drawing-image.h>
+#include <src/display/glyph-cache.h>
 #include <src/inkscape.h>
+#include <2geom/pathvector.h>
+#include <2geom/rect.h>
+#include <2geom/transforms.h>
 
 
 class PixbufTest : public ::testing::Test {
@@ -48,4 +62,210 @@ TEST_F(PixbufTest, creatingFromSvgUriWithoutViewboxOrWidthAndHeightReturnsNull)
     double default_dpi = 96.0;
 
     ASSERT_EQ(Inkscape::Pixbuf::create_from_data_uri(uri_data.c_str(), default_dpi), nullptr);
-}
\ No newline at end of file
+}
+
+class CairoSimdTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        std::mt19937 rng(42);
+        in1.resize(size);
+        in2.resize(size);
+        for (int i = 0; i < size; ++i) {
+            in1[i] = rng();
+            in2[i] = rng();
+        }
+        // Every combination of channel and alpha value, to also cover the divisions exhaustively.
+        for (int i = 0; i < 65536; ++i) {
+            guint32 a = i >> 8, c = i & 0xff;
+            in1[i] = (a << 24) | (c << 16) | ((255 - c) << 8) | (c / 2);
+        }
+        for (int i = 0; i < 20; ++i) {
+            matrix[i] = std::uniform_int_distribution<gint32>(-3 * 255, 3 * 255)(rng) * (i % 5 == 4 ? 255 : 1);
+        }
+    }
+
+    void TearDown() override
+    {
+        Inkscape::Display::set_simd_level(Inkscape::Display::simd_level_supported());
+    }
+
+    using Kernel = std::function<void (guint32 *, int)>;
+
+    static std::vector<guint32> run(Kernel const &kernel, int n)
+    {
+        std::vector<guint32> out(n);
+        kernel(out.data(), n);
+        return out;
+    }
+
+    void forEachKernel(std::function<void (char const *, Kernel const &)> const &f)
+    {
+        using namespace Inkscape::Display;
+        f("premultiply", [this] (guint32 *out, int n) { premultiply_row(in1.data(), out, n); });
+        f("unpremultiply", [this] (guint32 *out, int n) { unpremultiply_row(in1.data(), out, n); });
+        f("color matrix", [this] (guint32 *out, int n) { color_matrix_row(matrix, in1.data(), out, n); });
+        f("arithmetic", [this] (guint32 *out, int n) { composite_arithmetic_row(k, in1.data(), in2.data(), out, n); });
+        f("sRGB to linear", [this] (guint32 *out, int n) { srgb_to_linear_row(in1.data(), out, n); });
+        f("linear to sRGB", [this] (guint32 *out, int n) { linear_to_srgb_row(in1.data(), out, n); });
+    }
+
+    static constexpr int size = 1 << 20;
+    std::vector<guint32> in1, in2;
+    gint32 matrix[20];
+    gint32 k[4] = {128, 255 * 255 / 2, -255 * 255 / 3, 255 * 255 * 20};
+};
+
+TEST_F(CairoSimdTest, VectorKernelsMatchScalar)
+{
+    using namespace Inkscape::Display;
+
+    forEachKernel([this] (char const *name, Kernel const &kernel) {
+        // Odd lengths also exercise the scalar tail of the vector kernels.
+        for (int n : {size, size - 5, 7}) {
+            set_simd_level(SimdLevel::Scalar);
+            auto expected = run(kernel, n);
+            for (auto level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+                set_simd_level(level);
+                EXPECT_EQ(run(kernel, n), expected) << name << " at level " << static_cast<int>(simd_level());
+            }
+        }
+    });
+
+    // The per-pixel versions are used for the other surface formats.
+    set_simd_level(SimdLevel::Scalar);
+    for (int i = 0; i < 65536; ++i) {
+        guint32 px = in1[i];
+        guint32 out;
+        color_matrix_row(matrix, &px, &out, 1);
+        ASSERT_EQ(color_matrix_pixel(matrix, px), out);
+        srgb_to_linear_row(&px, &out, 1);
+        ASSERT_EQ(srgb_to_linear_pixel(px), out);
+    }
+}
+
+TEST(GlyphCacheTest, SharesMasksOfSameGlyph)
+{
+    Inkscape::GlyphCache cache;
+    cache.setBudget(1 << 20);
+
+    auto font = std::make_shared<int>(0);
+    auto const outline = Geom::PathVector(Geom::Path(Geom::Rect(0, -0.7, 0.5, 0)));
+    auto const draw = [&] (Geom::Affine const &transform, Geom::IntPoint &position) {
+        return cache.lookup(font, 1, outline, transform, 1, CAIRO_FILL_RULE_NONZERO, CAIRO_ANTIALIAS_DEFAULT, position);
+    };
+
+    Geom::IntPoint p1, p2, p3;
+    auto m1 = draw(Geom::Scale(12) * Geom::Translate(10, 20), p1);
+    auto m2 = draw(Geom::Scale(12) * Geom::Translate(110.01, 20), p2);
+    ASSERT_TRUE(m1);
+    EXPECT_EQ(m1, m2); // Same glyph, whole pixels apart.
+    EXPECT_EQ(p2 - p1, Geom::IntPoint(100, 0));
+
+    auto m3 = draw(Geom::Scale(12) * Geom::Translate(10.5, 20), p3);
+    EXPECT_NE(m1, m3); // Different subpixel position.
+    EXPECT_EQ(cairo_image_surface_get_width(m1), 6);
+
+    for (auto m : {m1, m2, m3}) {
+        cairo_surface_destroy(m);
+    }
+
+    // Large glyphs are not cached.
+    EXPECT_FALSE(draw(Geom::Scale(1000), p1));
+
+    cache.setBudget(0);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+namespace {
+
+/// Get a mip level of a pixbuf once it is built, or null on timeout.
+cairo_surface_t *wait_for_mipmap(Inkscape::Pixbuf const &pixbuf, int level)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        int got = level;
+        auto surface = pixbuf.getMipmap(got);
+        if (got == level) {
+            return surface;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(PixbufMipmapTest, HalvesOddSizes)
+{
+    // A 5x3 image whose channels all hold 10x + 50y at (x, y).
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 5, 3);
+    auto const stride = cairo_image_surface_get_stride(surface);
+    auto data = cairo_image_surface_get_data(surface);
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 5; x++) {
+            std::fill_n(data + y * stride + 4 * x, 4, 10 * x + 50 * y);
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    auto const pixbuf = Inkscape::Pixbuf(surface);
+
+    int level = 0;
+    EXPECT_EQ(pixbuf.getMipmap(level), pixbuf.getSurfaceRaw());
+    EXPECT_EQ(level, 0);
+
+    // Each level has half the size, rounded up.
+    auto const level1 = wait_for_mipmap(pixbuf, 1);
+    ASSERT_TRUE(level1);
+    EXPECT_EQ(cairo_image_surface_get_width(level1), 3);
+    EXPECT_EQ(cairo_image_surface_get_height(level1), 2);
+
+    auto const level2 = wait_for_mipmap(pixbuf, 2);
+    ASSERT_TRUE(level2);
+    EXPECT_EQ(cairo_image_surface_get_width(level2), 2);
+    EXPECT_EQ(cairo_image_surface_get_height(level2), 1);
+
+    auto const level3 = wait_for_mipmap(pixbuf, 3);
+    ASSERT_TRUE(level3);
+    EXPECT_EQ(cairo_image_surface_get_width(level3), 1);
+    EXPECT_EQ(cairo_image_surface_get_height(level3), 1);
+
+    // There are no levels beyond a single pixel.
+    level = 10;
+    EXPECT_EQ(pixbuf.getMipmap(level), level3);
+    EXPECT_EQ(level, 3);
+
+    // Pixels are the rounded average of 2x2 blocks; the odd last row and column are repeated.
+    auto const pixel = [] (cairo_surface_t *s, int x, int y) {
+        return cairo_image_surface_get_data(s)[y * cairo_image_surface_get_stride(s) + 4 * x];
+    };
+    EXPECT_EQ(pixel(level1, 0, 0), 30);  // (0 + 10 + 50 + 60 + 2) / 4
+    EXPECT_EQ(pixel(level1, 1, 0), 50);  // (20 + 30 + 70 + 80 + 2) / 4
+    EXPECT_EQ(pixel(level1, 2, 0), 65);  // (40 + 40 + 90 + 90 + 2) / 4
+    EXPECT_EQ(pixel(level1, 1, 1), 125); // (120 + 130 + 120 + 130 + 2) / 4
+    EXPECT_EQ(pixel(level1, 2, 1), 140); // The corner pixel, repeated.
+    EXPECT_EQ(pixel(level1, 0, 1), 105); // (100 + 110 + 100 + 110 + 2) / 4
+    EXPECT_EQ(pixel(level2, 0, 0), 78);  // (30 + 50 + 105 + 125 + 2) / 4
+    EXPECT_EQ(pixel(level2, 1, 0), 103); // (65 + 65 + 140 + 140 + 2) / 4
+    EXPECT_EQ(pixel(level3, 0, 0), 91);  // (78 + 103 + 78 + 103 + 2) / 4
+}
+
+TEST(PixbufMipmapTest, SelectsLevelForScale)
+{
+    using Inkscape::DrawingImage;
+
+    // Drawn at half size or more, the full image is used.
+    EXPECT_EQ(DrawingImage::mipLevel(2.0), 0);
+    EXPECT_EQ(DrawingImage::mipLevel(1.0), 0);
+    EXPECT_EQ(DrawingImage::mipLevel(0.5), 0);
+
+    // Below that, the coarsest level whose pixels are no larger than device pixels.
+    EXPECT_EQ(DrawingImage::mipLevel(0.4), 1);
+    EXPECT_EQ(DrawingImage::mipLevel(0.25), 2);
+    EXPECT_EQ(DrawingImage::mipLevel(0.2), 2);
+    EXPECT_EQ(DrawingImage::mipLevel(1.0 / 1000), 9);
+
+    // Degenerate transforms.
+    EXPECT_EQ(DrawingImage::mipLevel(0.0), 0);
+    EXPECT_EQ(DrawingImage::mipLevel(std::nan("")), 0);
+}
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for the cache of filter primitive results.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include <cairo.h>
+#include <gtest/gtest.h>
+#include <2geom/rect.h>
+
+#include "display/nr-filter-cache.h"
+
+using Inkscape::Filters::FilterCache;
+
+namespace {
+
+/// An image whose pixels differ by position, so that parts of it can be told apart.
+cairo_surface_t *make_surface(int width, int height, std::uint32_t seed = 0)
+{
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    auto data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            std::uint32_t const pixel = 0xff000000 | (seed << 16) | (y << 8) | x;
+            std::memcpy(data + y * stride + x * 4, &pixel, 4);
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+std::uint32_t pixel(cairo_surface_t *surface, int x, int y)
+{
+    cairo_surface_flush(surface);
+    std::uint32_t result;
+    std::memcpy(&result, cairo_image_surface_get_data(surface) + y * cairo_image_surface_get_stride(surface) + x * 4, 4);
+    return result;
+}
+
+FilterCache::Key make_key(std::uint64_t filter)
+{
+    FilterCache::Key key;
+    key.filter = filter;
+    key.filter_area = Geom::Rect(0, 0, 100, 100);
+    key.resolution_x = key.resolution_y = 100;
+    return key;
+}
+
+std::size_t bytes(int width, int height)
+{
+    return cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width) * height;
+}
+
+bool cached(FilterCache &cache, FilterCache::Key const &key, Geom::Rect const &area)
+{
+    auto result = cache.lookup(key, area);
+    if (result) {
+        cairo_surface_destroy(result->surface);
+    }
+    return bool(result);
+}
+
+} // namespace
+
+TEST(FilterCacheTest, ReusesPartsOfLargerResults)
+{
+    FilterCache cache(1 << 20);
+    auto const key = make_key(1);
+    auto surface = make_surface(16, 8);
+    auto const id = cache.store(key, Geom::Rect::from_xywh(10, 20, 16, 8), surface);
+    cairo_surface_destroy(surface);
+
+    // An area inside, as when part of the canvas is redrawn or panned within the result.
+    auto result = cache.lookup(key, Geom::Rect::from_xywh(13, 22, 4, 5));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->id, id);
+    EXPECT_EQ(cairo_image_surface_get_width(result->surface), 4);
+    EXPECT_EQ(cairo_image_surface_get_height(result->surface), 5);
+    EXPECT_EQ(pixel(result->surface, 0, 0), 0xff000000u | (2 << 8) | 3);
+    EXPECT_EQ(pixel(result->surface, 3, 4), 0xff000000u | (6 << 8) | 6);
+    cairo_surface_destroy(result->surface);
+
+    // Areas reaching outside, or not on the pixel grid of the result.
+    EXPECT_FALSE(cached(cache, key, Geom::Rect::from_xywh(20, 20, 8, 8)));
+    EXPECT_FALSE(cached(cache, key, Geom::Rect::from_xywh(10.5, 20, 4, 4)));
+
+    // A different key, even if only in one input.
+    auto other = key;
+    other.inputs.push_back(7);
+    EXPECT_FALSE(cached(cache, other, Geom::Rect::from_xywh(10, 20, 16, 8)));
+    other = key;
+    other.ctm = Geom::Affine(2, 0, 0, 2, 0, 0);
+    EXPECT_FALSE(cached(cache, other, Geom::Rect::from_xywh(10, 20, 16, 8)));
+    EXPECT_TRUE(cached(cache, key, Geom::Rect::from_xywh(10, 20, 16, 8)));
+}
+
+TEST(FilterCacheTest, IdentifiesEqualImages)
+{
+    FilterCache cache(1 << 20);
+    auto key = make_key(1);
+    key.primitive = -1;
+
+    auto surface = make_surface(16, 16);
+    auto const id = cache.identify(key, Geom::Rect::from_xywh(0, 0, 16, 16), surface);
+    EXPECT_EQ(cache.identify(key, Geom::Rect::from_xywh(0, 0, 16, 16), surface), id);
+    cairo_surface_destroy(surface);
+
+    // The same pixels over part of the area.
+    auto part = make_surface(8, 8);
+    EXPECT_EQ(cache.identify(key, Geom::Rect::from_xywh(0, 0, 8, 8), part), id);
+
+    // Other pixels over the same area.
+    auto changed = make_surface(8, 8, 1);
+    EXPECT_NE(cache.identify(key, Geom::Rect::from_xywh(0, 0, 8, 8), changed), id);
+    cairo_surface_destroy(changed);
+
+    // The same pixels at a different place.
+    EXPECT_NE(cache.identify(key, Geom::Rect::from_xywh(4, 4, 8, 8), part), id);
+    cairo_surface_destroy(part);
+}
+
+TEST(FilterCacheTest, EvictsLeastRecentlyUsed)
+{
+    FilterCache cache(2 * bytes(8, 8));
+    auto const area = Geom::Rect::from_xywh(0, 0, 8, 8);
+    auto surface = make_surface(8, 8);
+
+    cache.store(make_key(1), area, surface);
+    cache.store(make_key(2), area, surface);
+    EXPECT_EQ(cache.count(), 2u);
+
+    // Using the first makes the second the least recently used.
+    EXPECT_TRUE(cached(cache, make_key(1), area));
+    cache.store(make_key(3), area, surface);
+    EXPECT_EQ(cache.count(), 2u);
+    EXPECT_TRUE(cached(cache, make_key(1), area));
+    EXPECT_FALSE(cached(cache, make_key(2), area));
+    EXPECT_TRUE(cached(cache, make_key(3), area));
+
+    // Looking up the third made the first the least recently used.
+    cache.store(make_key(4), area, surface);
+    EXPECT_FALSE(cached(cache, make_key(1), area));
+    EXPECT_TRUE(cached(cache, make_key(3), area));
+    EXPECT_TRUE(cached(cache, make_key(4), area));
+
+    cairo_surface_destroy(surface);
+}
+
+TEST(FilterCacheTest, StaysWithinBudget)
+{
+    FilterCache cache(3 * bytes(8, 8));
+    auto small = make_surface(8, 8);
+    auto large = make_surface(16, 16);
+
+    for (int i = 1; i <= 3; i++) {
+        cache.store(make_key(i), Geom::Rect::from_xywh(0, 0, 8, 8), small);
+        EXPECT_EQ(cache.size(), i * bytes(8, 8));
+    }
+
+    // Larger than the budget: not stored, nothing evicted.
+    cache.store(make_key(4), Geom::Rect::from_xywh(0, 0, 16, 16), large);
+    EXPECT_EQ(cache.count(), 3u);
+    EXPECT_FALSE(cached(cache, make_key(4), Geom::Rect::from_xywh(0, 0, 16, 16)));
+
+    // Not of the size of its area: not stored either.
+    cache.store(make_key(5), Geom::Rect::from_xywh(0, 0, 4, 4), small);
+    EXPECT_EQ(cache.count(), 3u);
+
+    // Lowering the budget evicts the least recently used.
+    cache.setBudget(bytes(8, 8) + 1);
+    EXPECT_EQ(cache.count(), 1u);
+    EXPECT_EQ(cache.size(), bytes(8, 8));
+    EXPECT_TRUE(cached(cache, make_key(3), Geom::Rect::from_xywh(0, 0, 8, 8)));
+
+    cache.clear();
+    EXPECT_EQ(cache.count(), 0u);
+    EXPECT_EQ(cache.size(), 0u);
+
+    cairo_surface_destroy(small);
+    cairo_surface_destroy(large);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
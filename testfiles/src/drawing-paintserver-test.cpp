@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for the paint servers used when rendering.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <cairo.h>
+
+#include "display/cairo-utils.h"
+#include "display/drawing-paintserver.h"
+
+using Inkscape::DrawingMeshGradient;
+
+namespace {
+
+/// Two straight-sided patches covering [0, 128] x [0, 64], with a different colour at each corner.
+std::unique_ptr<DrawingMeshGradient> two_patch_mesh()
+{
+    std::vector<std::vector<DrawingMeshGradient::PatchData>> patches(1);
+    std::array<float, 3> const colors[] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 0}, {0, 1, 1}, {1, 0, 1}};
+    // Corner colours of each patch, clockwise from the top left; the patches share their middle side.
+    int const corner_colors[2][4] = {{0, 1, 4, 3}, {1, 2, 5, 4}};
+
+    for (int p = 0; p < 2; p++) {
+        double const x0 = 64 * p;
+        Geom::Point const corners[4] = {{x0, 0}, {x0 + 64, 0}, {x0 + 64, 64}, {x0, 64}};
+        auto &data = patches[0].emplace_back();
+        for (int k = 0; k < 4; k++) {
+            auto const &start = corners[k];
+            auto const &end = corners[(k + 1) % 4];
+            data.points[k][0] = start;
+            data.points[k][1] = Geom::lerp(1.0 / 3.0, start, end);
+            data.points[k][2] = Geom::lerp(2.0 / 3.0, start, end);
+            data.points[k][3] = end;
+            data.pathtype[k] = 'L';
+            data.tensorIsSet[k] = false;
+            data.color[k] = colors[corner_colors[p][k]];
+            data.opacity[k] = 1.0;
+        }
+    }
+
+    return std::make_unique<DrawingMeshGradient>(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE,
+                                                 Geom::identity(), 1, 2, std::move(patches));
+}
+
+/// Paint a pattern over an image surface of the size of the mesh, with the given user to device transform.
+cairo_surface_t *paint(cairo_pattern_t *pattern, Geom::Affine const &transform = Geom::identity())
+{
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 128, 64);
+    auto ct = cairo_create(surface);
+    ink_cairo_transform(ct, transform);
+    cairo_set_source(ct, pattern);
+    cairo_paint(ct);
+    cairo_destroy(ct);
+    cairo_surface_flush(surface);
+    return surface;
+}
+
+/// The largest difference between the channels of two surfaces painted by paint(), inside a margin.
+int max_difference(cairo_surface_t *a, cairo_surface_t *b, int margin)
+{
+    int const stride = cairo_image_surface_get_stride(a);
+    auto const a_data = cairo_image_surface_get_data(a);
+    auto const b_data = cairo_image_surface_get_data(b);
+    int max_difference = 0;
+    for (int y = margin; y < 64 - margin; y++) {
+        auto const a_row = reinterpret_cast<std::uint32_t const *>(a_data + y * stride);
+        auto const b_row = reinterpret_cast<std::uint32_t const *>(b_data + y * stride);
+        for (int x = margin; x < 128 - margin; x++) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                int const p = (a_row[x] >> shift) & 0xff;
+                int const q = (b_row[x] >> shift) & 0xff;
+                max_difference = std::max(max_difference, std::abs(p - q));
+            }
+        }
+    }
+    return max_difference;
+}
+
+} // namespace
+
+TEST(DrawingMeshGradientTest, RasterMatchesCairoMesh)
+{
+    auto const mesh = two_patch_mesh();
+
+    // Drawing to an image surface gets the mesh rasterised by Inkscape.
+    auto image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 128, 64);
+    auto image_ct = cairo_create(image);
+    auto raster_pattern = mesh->create_pattern(image_ct, {}, 1.0);
+    EXPECT_EQ(cairo_pattern_get_type(raster_pattern), CAIRO_PATTERN_TYPE_SURFACE);
+
+    // Other surfaces, as used for vector export, get the mesh itself.
+    auto recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+    auto recording_ct = cairo_create(recording);
+    auto mesh_pattern = mesh->create_pattern(recording_ct, {}, 1.0);
+    EXPECT_EQ(cairo_pattern_get_type(mesh_pattern), CAIRO_PATTERN_TYPE_MESH);
+
+    auto const ours = paint(raster_pattern);
+    auto const cairos = paint(mesh_pattern);
+
+    // Cairo's rasteriser samples differently at the edges of the mesh, so compare the inside, and
+    // allow for sample positions up to a pixel apart, across 255 levels per 64 pixels.
+    EXPECT_LE(max_difference(ours, cairos, 2), 6);
+
+    cairo_surface_destroy(ours);
+    cairo_surface_destroy(cairos);
+    cairo_pattern_destroy(raster_pattern);
+    cairo_pattern_destroy(mesh_pattern);
+    cairo_destroy(recording_ct);
+    cairo_surface_destroy(recording);
+    cairo_destroy(image_ct);
+    cairo_surface_destroy(image);
+}
+
+TEST(DrawingMeshGradientTest, CapsRasterWhenZoomedIn)
+{
+    auto const mesh = two_patch_mesh();
+
+    // At this zoom, the mesh would span 12800 x 6400 device pixels. Look at where its patches meet.
+    auto const zoom = Geom::Scale(100) * Geom::Translate(-6350, -3000);
+
+    auto image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 128, 64);
+    auto image_ct = cairo_create(image);
+    ink_cairo_transform(image_ct, zoom);
+    auto raster_pattern = mesh->create_pattern(image_ct, {}, 1.0);
+    ASSERT_EQ(cairo_pattern_get_type(raster_pattern), CAIRO_PATTERN_TYPE_SURFACE);
+
+    // The mesh is still rasterised, but at a lower resolution.
+    cairo_surface_t *raster = nullptr;
+    cairo_pattern_get_surface(raster_pattern, &raster);
+    ASSERT_TRUE(raster);
+    int const width = cairo_image_surface_get_width(raster);
+    int const height = cairo_image_surface_get_height(raster);
+    EXPECT_LE(width * height, 2048 * 2048);
+    EXPECT_GE(width * height, 1024 * 1024);
+    EXPECT_NEAR((double)width / height, 2.0, 0.05);
+
+    auto recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+    auto recording_ct = cairo_create(recording);
+    auto mesh_pattern = mesh->create_pattern(recording_ct, {}, 1.0);
+    ASSERT_EQ(cairo_pattern_get_type(mesh_pattern), CAIRO_PATTERN_TYPE_MESH);
+
+    // Scaled up, it still matches the mesh, which varies little from one device pixel to the next.
+    auto const ours = paint(raster_pattern, zoom);
+    auto const cairos = paint(mesh_pattern, zoom);
+    EXPECT_LE(max_difference(ours, cairos, 0), 4);
+
+    cairo_surface_destroy(ours);
+    cairo_surface_destroy(cairos);
+    cairo_pattern_destroy(raster_pattern);
+    cairo_pattern_destroy(mesh_pattern);
+    cairo_destroy(recording_ct);
+    cairo_surface_destroy(recording);
+    cairo_destroy(image_ct);
+    cairo_surface_destroy(image);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
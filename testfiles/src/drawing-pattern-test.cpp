@@ -11,6 +11,8 @@
  *
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
+#include <regex>
+#include <sstream>
 #include <gtest/gtest.h>
 
 #include <cairomm/surface.h>
@@ -24,49 +26,84 @@
 #include "display/drawing-surface.h"
 #include "display/drawing-context.h"
 
-TEST(DrawingPatternTest, fragments)
+namespace {
+
+class Display
 {
-    if (!Inkscape::Application::exists()) {
-        Inkscape::Application::create(false);
+public:
+    Display(SPDocument *doc, double scale = 1.0) {
+        root = doc->getRoot();
+        dkey = SPItem::display_key_new(1);
+        rootitem = root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY);
+        rootitem->setTransform(Geom::Scale(scale));
+        drawing.setRoot(rootitem);
+        drawing.update();
     }
 
-    auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDoc(INKSCAPE_TESTS_DIR "/rendering_tests/drawing-pattern-test.svg", false));
-    ASSERT_TRUE((bool)doc);
-    ASSERT_TRUE((bool)doc->getRoot());
+    ~Display()
+    {
+        root->invoke_hide(dkey);
+    }
 
-    doc->ensureUpToDate();
+    auto draw(Geom::IntRect const &rect)
+    {
+        auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width(), rect.height());
+        auto ds = Inkscape::DrawingSurface(cs->cobj(), rect.min());
+        auto dc = Inkscape::DrawingContext(ds);
+        drawing.render(dc, rect);
+        return cs;
+    }
 
-    class Display
+    /// The number of times the pattern tiles have been rendered, or parts of them.
+    unsigned pattern_renders() const
     {
-    public:
-        Display(SPDocument *doc) {
-            root = doc->getRoot();
-            dkey = SPItem::display_key_new(1);
-            rootitem = root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY);
-            drawing.setRoot(rootitem);
-            drawing.update();
+        std::ostringstream os;
+        drawing.writeStats(os);
+        auto const stats = os.str();
+        static std::regex const re(R"("role": "fill", "depth": \d+, "renders": (\d+))");
+        unsigned renders = 0;
+        for (auto it = std::sregex_iterator(stats.begin(), stats.end(), re); it != std::sregex_iterator(); ++it) {
+            renders += std::stoul((*it)[1]);
         }
+        return renders;
+    }
 
-        ~Display()
-        {
-            root->invoke_hide(dkey);
-        }
+    Inkscape::Drawing drawing;
+
+private:
+    SPRoot *root;
+    Inkscape::DrawingItem *rootitem;
+    unsigned dkey;
+};
 
-        auto draw(Geom::IntRect const &rect)
-        {
-            auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width(), rect.height());
-            auto ds = Inkscape::DrawingSurface(cs->cobj(), rect.min());
-            auto dc = Inkscape::DrawingContext(ds);
-            drawing.render(dc, rect);
-            return cs;
+/// The largest difference between the channels of part and the area of whole at offset.
+int max_difference(Cairo::RefPtr<Cairo::ImageSurface> const &whole, Cairo::RefPtr<Cairo::ImageSurface> const &part,
+                   Geom::IntPoint const &offset = {})
+{
+    int maxdiff = 0;
+    for (int y = 0; y < part->get_height(); y++) {
+        auto p = whole->get_data() + (offset.y() + y) * whole->get_stride() + offset.x() * 4;
+        auto q = part->get_data() + y * part->get_stride();
+        for (int x = 0; x < part->get_width() * 4; x++) {
+            maxdiff = std::max(maxdiff, std::abs((int)p[x] - (int)q[x]));
         }
+    }
+    return maxdiff;
+}
 
-    private:
-        Inkscape::Drawing drawing;
-        SPRoot *root;
-        Inkscape::DrawingItem *rootitem;
-        unsigned dkey;
-    };
+} // namespace
+
+TEST(DrawingPatternTest, fragments)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDoc(INKSCAPE_TESTS_DIR "/rendering_tests/drawing-pattern-test.svg", false));
+    ASSERT_TRUE((bool)doc);
+    ASSERT_TRUE((bool)doc->getRoot());
+
+    doc->ensureUpToDate();
 
     auto const tile = Geom::IntPoint(30, 30);
     auto const area = Geom::IntRect::from_xywh(0, 0, 100, 100);
@@ -115,3 +152,56 @@ TEST(DrawingPatternTest, fragments)
 
     ASSERT_LE(maxdiff, 10);
 }
+
+TEST(DrawingPatternTest, cellreuse)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDoc(INKSCAPE_TESTS_DIR "/rendering_tests/drawing-pattern-test.svg", false));
+    ASSERT_TRUE((bool)doc);
+    doc->ensureUpToDate();
+
+    // Scaled so that the 30px tile spans 360px, which is split into 2x2 cells.
+    double const scale = 12;
+    auto const area = Geom::IntRect::from_xywh(0, 0, 720, 720);
+    auto const part = Geom::IntRect::from_xywh(300, 420, 100, 80);
+
+    auto const reference = Display(doc.get(), scale).draw(area);
+
+    auto d = Display(doc.get(), scale);
+    d.drawing.setRecordStats(true);
+
+    // Drawing part of the pattern renders only the cells it needs.
+    auto const first = d.draw(part);
+    auto const renders = d.pattern_renders();
+    EXPECT_GT(renders, 0);
+    EXPECT_LE(max_difference(reference, first, part.min()), 10);
+
+    // Drawing it again reuses those cells, and gives the same result.
+    auto const second = d.draw(part);
+    EXPECT_EQ(d.pattern_renders(), renders);
+    EXPECT_EQ(max_difference(first, second), 0);
+
+    // The remaining cells are rendered as needed, and mixed with the reused ones.
+    auto const whole = d.draw(area);
+    EXPECT_GT(d.pattern_renders(), renders);
+    EXPECT_LE(max_difference(reference, whole), 10);
+
+    auto const all_renders = d.pattern_renders();
+    auto const again = d.draw(area);
+    EXPECT_EQ(d.pattern_renders(), all_renders);
+    EXPECT_EQ(max_difference(whole, again), 0);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
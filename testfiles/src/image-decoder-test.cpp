@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for the background decoding of images.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <glibmm/main.h>
+
+#include "async/scheduler.h"
+#include "display/cairo-utils.h"
+#include "object/image-decoder.h"
+
+using Inkscape::ImageDecoder;
+using Inkscape::Pixbuf;
+
+namespace {
+
+Pixbuf *make_pixbuf(int width)
+{
+    return new Pixbuf(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, 1));
+}
+
+/// Run the main loop until cond holds, as the results of decodes are delivered through it.
+template <typename F>
+bool iterate_until(F const &cond)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        if (!Glib::MainContext::get_default()->iteration(false)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(ImageDecoderTest, SharesDecodes)
+{
+    auto &decoder = ImageDecoder::get();
+
+    std::atomic<int> decodes = 0;
+    std::atomic<bool> release = false;
+    auto decode = [&] {
+        decodes++;
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return make_pixbuf(7);
+    };
+
+    // A second request for the same key waits for the first decode rather than starting another.
+    ImageDecoder::Result first, second;
+    auto request1 = decoder.decode("shared", decode, [&] (ImageDecoder::Result r) { first = std::move(r); });
+    auto request2 = decoder.decode("shared", decode, [&] (ImageDecoder::Result r) { second = std::move(r); });
+    release = true;
+    ASSERT_TRUE(iterate_until([&] { return first && second; }));
+    EXPECT_EQ(decodes, 1);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->width(), 7);
+
+    // The result is shared for as long as it is in use, and no longer.
+    EXPECT_EQ(decoder.lookup("shared"), first);
+    EXPECT_FALSE(decoder.lookup("other"));
+    first.reset();
+    second.reset();
+    request1 = {};
+    request2 = {};
+    EXPECT_FALSE(decoder.lookup("shared"));
+
+    // A different key is a different decode.
+    ImageDecoder::Result third;
+    auto request3 = decoder.decode("shared-2", decode, [&] (ImageDecoder::Result r) { third = std::move(r); });
+    ASSERT_TRUE(iterate_until([&] { return (bool)third; }));
+    EXPECT_EQ(decodes, 2);
+}
+
+TEST(ImageDecoderTest, CancelsNotification)
+{
+    auto &decoder = ImageDecoder::get();
+
+    std::atomic<bool> release = false;
+    std::atomic<bool> decoded = false;
+    bool notified = false;
+    auto request = decoder.decode("cancelled", [&] {
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        decoded = true;
+        return make_pixbuf(1);
+    }, [&] (ImageDecoder::Result) { notified = true; });
+
+    // Dropping the request stops the notification, but the image is still decoded for others.
+    request = {};
+    ImageDecoder::Result other;
+    auto request2 = decoder.decode("cancelled", [] { return make_pixbuf(2); },
+                                   [&] (ImageDecoder::Result r) { other = std::move(r); });
+    release = true;
+    ASSERT_TRUE(iterate_until([&] { return (bool)other; }));
+    EXPECT_TRUE(decoded);
+    EXPECT_FALSE(notified);
+    EXPECT_EQ(other->width(), 1);
+
+    // Waiting returns the result without notifying.
+    bool waited_notified = false;
+    auto request3 = decoder.decode("waited", [] { return make_pixbuf(3); },
+                                   [&] (ImageDecoder::Result) { waited_notified = true; });
+    auto result = ImageDecoder::wait(request3);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->width(), 3);
+    iterate_until([] { return !Glib::MainContext::get_default()->pending(); });
+    EXPECT_FALSE(waited_notified);
+
+    // A failed decode gives a null result.
+    auto failed = decoder.decode("failed", [] () -> Pixbuf * { return nullptr; }, [] (ImageDecoder::Result) {});
+    EXPECT_FALSE(ImageDecoder::wait(failed));
+}
+
+TEST(ImageDecoderTest, LimitsConcurrentDecodes)
+{
+    auto &decoder = ImageDecoder::get();
+    int const limit = std::max(Inkscape::Async::Scheduler::get().concurrency() / 2, 1);
+
+    std::atomic<int> running = 0;
+    std::atomic<int> most_running = 0;
+    auto decode = [&] {
+        int const now = ++running;
+        int most = most_running;
+        while (now > most && !most_running.compare_exchange_weak(most, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        running--;
+        return make_pixbuf(1);
+    };
+
+    std::vector<ImageDecoder::Request> requests;
+    for (int i = 0; i < 4 * limit + 4; i++) {
+        requests.push_back(decoder.decode("limited-" + std::to_string(i), decode, [] (ImageDecoder::Result) {}));
+    }
+    for (auto &request : requests) {
+        EXPECT_TRUE(ImageDecoder::wait(request));
+    }
+
+    EXPECT_GE(most_running, 1);
+    EXPECT_LE(most_running, limit);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for the scratch arena of livarot shapes.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cmath>
+#include <optional>
+
+#include <gtest/gtest.h>
+#include <2geom/path.h>
+#include <2geom/pathvector.h>
+
+#include <src/livarot/Path.h>
+#include <src/livarot/Shape.h>
+#include <src/livarot/arena.h>
+#include <src/util/pool.h>
+
+namespace {
+
+/// A wavy closed path with the given number of nodes.
+Geom::PathVector wavy_path(int nodes)
+{
+    Geom::Path path(Geom::Point(1000, 0));
+    for (int i = 1; i <= nodes; i++) {
+        double const a = 2 * M_PI * i / nodes;
+        double const r = 1000 + (i % 2 ? 40 : -40);
+        path.appendNew<Geom::LineSegment>(Geom::Point(r * std::cos(a), r * std::sin(a)));
+    }
+    path.close();
+    return Geom::PathVector(path);
+}
+
+/// The livarot part of stroke to path, as in item_find_paths().
+Geom::PathVector stroke_to_path(Geom::PathVector const &pathv, bool use_arena)
+{
+    Path origin;
+    Path offset;
+    origin.LoadPathVector(pathv);
+    offset.SetBackData(false);
+    origin.Outline(&offset, 5, join_round, butt_round, 20);
+    offset.ConvertWithBackData(1.0);
+
+    std::optional<ArenaScope> arena;
+    if (use_arena) {
+        arena.emplace(Shape::ArenaSizeHint(offset.pts.size()));
+    }
+    Shape shape;
+    offset.Fill(&shape, 0);
+    Shape result;
+    result.ConvertToShape(&shape, fill_positive);
+    Path *paths[] = { &offset };
+    result.ConvertToForme(&origin, 1, paths);
+    return origin.MakePathVector();
+}
+
+/// The livarot part of inset, as in sp_selected_path_do_offset().
+Geom::PathVector inset(Geom::PathVector const &pathv, bool use_arena)
+{
+    Path orig;
+    orig.LoadPathVector(pathv);
+    orig.ConvertWithBackData(0.03);
+
+    std::optional<ArenaScope> arena;
+    if (use_arena) {
+        arena.emplace(Shape::ArenaSizeHint(orig.pts.size()));
+    }
+    Shape shape;
+    Shape res;
+    orig.Fill(&shape, 0);
+    res.ConvertToShape(&shape, fill_nonZero);
+    shape.MakeOffset(&res, -5, join_round, 20);
+    res.ConvertToShape(&shape, fill_positive);
+
+    Path result;
+    res.ConvertToForme(&result);
+    return result.MakePathVector();
+}
+
+} // namespace
+
+TEST(LivarotArenaTest, SameResultAsHeap)
+{
+    auto const pathv = wavy_path(200);
+    EXPECT_EQ(stroke_to_path(pathv, true), stroke_to_path(pathv, false));
+    EXPECT_EQ(inset(pathv, true), inset(pathv, false));
+}
+
+TEST(LivarotArenaTest, ScopesNest)
+{
+    EXPECT_EQ(ArenaScope::current(), nullptr);
+    {
+        auto const outer = ArenaScope();
+        auto const pool = ArenaScope::current();
+        EXPECT_NE(pool, nullptr);
+        {
+            auto const inner = ArenaScope();
+            EXPECT_EQ(ArenaScope::current(), pool);
+            {
+                auto const heap = ArenaSuspension();
+                EXPECT_EQ(ArenaScope::current(), nullptr);
+            }
+            EXPECT_EQ(ArenaScope::current(), pool);
+        }
+        EXPECT_EQ(ArenaScope::current(), pool);
+    }
+    EXPECT_EQ(ArenaScope::current(), nullptr);
+}
+
+TEST(LivarotArenaTest, ReleasesLargeBuffers)
+{
+    Inkscape::Util::Pool *pool = nullptr;
+    {
+        auto const arena = ArenaScope();
+        pool = ArenaScope::current();
+        pool->allocate(1000, 8);
+    }
+    EXPECT_GT(pool->buffer_size(), 0u);
+
+    {
+        auto const arena = ArenaScope();
+        pool->allocate(64 << 20, 8);
+    }
+    EXPECT_EQ(pool->buffer_size(), 0u);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -83,4 +83,35 @@ TEST_F(PathBoolopTest, DifferenceOutside){
     comparePaths(pvRectangleDifference, pvBothPaths);
 }
 
+TEST_F(PathBoolopTest, UnionMany){
+    // test that the union of many objects merges the overlapping ones and keeps the others apart
+    std::vector<Geom::PathVector> pvs = { pvRectangleSmaller, pvRectangleBigger * Geom::Translate(10, 0), pvRectangleBigger, pvRectangleOutside };
+    Geom::PathVector pvUnion = sp_pathvector_boolop(pvs, bool_op_union, std::vector<FillRule>(pvs.size(), fill_oddEven));
+    EXPECT_EQ(pvUnion.size(), 2u);
+    EXPECT_EQ(pvUnion.boundsExact(), Geom::OptRect(Geom::Rect(0, 0, 12, 2.5)));
+}
+
+TEST_F(PathBoolopTest, IntersectionManyApart){
+    // test that the intersection of many objects is empty when some of them are apart
+    std::vector<Geom::PathVector> pvs = { pvRectangleSmaller, pvRectangleBigger, pvRectangleBigger * Geom::Translate(10, 0) };
+    Geom::PathVector pvIntersection = sp_pathvector_boolop(pvs, bool_op_inters, std::vector<FillRule>(pvs.size(), fill_oddEven));
+    comparePaths(pvIntersection, pvEmpty);
+}
+
+TEST_F(PathBoolopTest, Batch){
+    // test that a batch of boolean operations gives the same results as running them one by one
+    std::vector<Geom::PathVector> pvs = { pvRectangleBigger, pvRectangleOutside, pvRectangleSmaller, pvRectangleBigger };
+    std::vector<BoolOpBatchStep> steps = {
+        { bool_op_union, 0, { 1 } },
+        { bool_op_diff, 3, { 2 } },
+        { bool_op_union, 2, { 0 } },
+    };
+    auto results = sp_pathvector_boolop_batch(pvs, std::vector<FillRule>(pvs.size(), fill_oddEven), steps);
+    ASSERT_EQ(results.size(), pvs.size());
+    comparePaths(results[0], sp_pathvector_boolop(pvRectangleOutside, pvRectangleBigger, bool_op_union, fill_oddEven, fill_oddEven));
+    comparePaths(results[1], pvRectangleOutside);
+    comparePaths(results[2], sp_pathvector_boolop(results[0], pvRectangleSmaller, bool_op_union, fill_nonZero, fill_oddEven));
+    comparePaths(results[3], sp_pathvector_boolop(pvRectangleSmaller, pvRectangleBigger, bool_op_diff, fill_oddEven, fill_oddEven));
+}
+
 //
\ No newline at end of file
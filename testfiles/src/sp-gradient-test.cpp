@@ -10,9 +10,13 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <string>
+
 #include <gtest/gtest.h>
 #include <doc-per-case-test.h>
+#include <src/document.h>
 #include <src/object/sp-gradient.h>
+#include <src/object/sp-root.h>
 #include <src/attributes.h>
 #include <2geom/transforms.h>
 #include <src/xml/node.h>
@@ -128,3 +132,30 @@ TEST_F(SPGradientTest, GetG2dGetGs2dSetGs2) {
         EXPECT_TRUE(Geom::are_near(user_gs2d, gr->gradientTransform * user_g2d, 1e-12));
     }
 }
+
+/*
+ * The users of a gradient are notified when it changes, not each time the document is modified.
+ */
+TEST_F(SPGradientTest, NotifiesUsersOfItsChanges) {
+    std::string svg = "<svg xmlns='http://www.w3.org/2000/svg'><defs><linearGradient id='lg'>"
+                      "<stop id='s1' offset='0' style='stop-color:red'/><stop offset='1' style='stop-color:blue'/>"
+                      "</linearGradient></defs>";
+    for (int i = 0; i < 100; i++) {
+        svg += "<rect width='10' height='10' style='fill:url(#lg)'/>";
+    }
+    svg += "</svg>";
+    std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(svg.c_str(), static_cast<int>(svg.size()), false));
+    ASSERT_TRUE(doc != nullptr);
+    doc->ensureUpToDate();
+
+    // The gradient only receives the modification of its parents.
+    doc->getRoot()->requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG);
+    doc->ensureUpToDate();
+    EXPECT_EQ(doc->getLastUpdateStats().dependents, 0u);
+    EXPECT_EQ(doc->getLastUpdateStats().passes, 1u);
+
+    // One of its stops changes.
+    doc->getObjectById("s1")->setAttribute("style", "stop-color:green");
+    doc->ensureUpToDate();
+    EXPECT_EQ(doc->getLastUpdateStats().dependents, 100u);
+}
@@ -11,12 +11,18 @@
  * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
  */
 
+#include <functional>
+#include <set>
+#include <string>
+
 #include <gtest/gtest.h>
 #include <doc-per-case-test.h>
 
 #include <src/style.h>
+#include <src/style-selector-index.h>
 #include <src/object/sp-root.h>
 #include <src/object/sp-style-elem.h>
+#include <src/xml/croco-node-iface.h>
 
 using namespace Inkscape;
 using namespace Inkscape::XML;
@@ -69,3 +75,144 @@ TEST_F(ObjectTest, StyleElems) {
         EXPECT_EQ(style->fill.get_value(), Glib::ustring("#008000"));
     }
 }
+
+static void collect_elements(Node *node, std::vector<Node *> &nodes)
+{
+    if (node->type() == NodeType::ELEMENT_NODE) {
+        nodes.push_back(node);
+    }
+    for (auto child = node->firstChild(); child; child = child->next()) {
+        collect_elements(child, nodes);
+    }
+}
+
+/*
+ * The selector index must give the same declarations, in the same order, as libcroco's matching
+ * of the whole cascade.
+ */
+TEST(StyleSelectorIndexTest, MatchesCascade) {
+    char const *docString = "\
+<svg xmlns='http://www.w3.org/2000/svg'>\
+<style>\
+* { stroke-width: 1; }\
+rect { fill: red; opacity: 0.5; }\
+g rect, .a { fill: blue; }\
+.a.b { fill: green !important; }\
+#r1, .b, rect.c { stroke: black; }\
+g > .c { opacity: 0.25; }\
+rect:first-child { stroke-width: 2; }\
+[class] { stroke-dasharray: 1; }\
+#r1 { fill: yellow; }\
+</style>\
+<style>\
+.a { fill: purple; }\
+</style>\
+<g id='g1' class='a'>\
+  <rect id='r1' class='c'/>\
+  <rect id='r2' class='a b'/>\
+  <circle id='c1' class='b  a'/>\
+</g>\
+<rect id='r3' class='c'/>\
+<path id='p1'/>\
+</svg>";
+    std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(docString, static_cast<int>(strlen(docString)), false));
+    ASSERT_TRUE(doc != nullptr);
+
+    auto index = doc->getStyleSelectorIndex();
+    ASSERT_TRUE(index != nullptr);
+    EXPECT_EQ(index->size(), 13u);
+
+    auto sel_eng = cr_sel_eng_new(&Inkscape::XML::croco_node_iface);
+    std::vector<Node *> nodes;
+    collect_elements(doc->getReprRoot(), nodes);
+
+    for (auto node : nodes) {
+        CRPropList *props = nullptr;
+        ASSERT_EQ(cr_sel_eng_get_matched_properties_from_cascade(sel_eng, doc->getStyleCascade(), node, &props), CR_OK);
+        std::vector<CRDeclaration *> expected;
+        for (auto p = props; p; p = cr_prop_list_get_next(p)) {
+            CRDeclaration *decl = nullptr;
+            cr_prop_list_get_decl(p, &decl);
+            expected.push_back(decl);
+        }
+        cr_prop_list_destroy(props);
+
+        EXPECT_EQ(index->match(sel_eng, node), expected) << node->name() << " " << (node->attribute("id") ? node->attribute("id") : "");
+    }
+    cr_sel_eng_destroy(sel_eng);
+
+    // Style sheet changes rebuild the index.
+    auto style = cast<SPStyleElem>(doc->getRoot()->firstChild());
+    ASSERT_TRUE(style != nullptr);
+    style->getRepr()->firstChild()->setContent(".a { fill: red; }");
+    index = doc->getStyleSelectorIndex();
+    ASSERT_TRUE(index != nullptr);
+    EXPECT_EQ(index->size(), 2u);
+}
+
+static void mark_styles(SPObject &object, std::vector<SPObject *> &objects)
+{
+    // Reading the style again from the style sheets clears the mark.
+    object.style->opacity.value = 1;
+    objects.push_back(&object);
+    for (auto &child : object.children) {
+        mark_styles(child, objects);
+    }
+}
+
+/// The ids of the objects whose style was read again by the update after an edit.
+static std::set<std::string> restyled_ids(SPDocument &doc, std::function<void()> const &edit)
+{
+    doc.ensureUpToDate();
+    std::vector<SPObject *> objects;
+    mark_styles(*doc.getRoot(), objects);
+    edit();
+    doc.ensureUpToDate();
+
+    std::set<std::string> ids;
+    for (auto object : objects) {
+        if (object->getId() && object->style->opacity.value != 1) {
+            ids.insert(object->getId());
+        }
+    }
+    return ids;
+}
+
+/*
+ * Editing a style sheet only restyles the objects its rules can match, and their descendants.
+ */
+TEST(StyleSelectorIndexTest, RestylesMatchingObjects) {
+    std::string svg = "<svg xmlns='http://www.w3.org/2000/svg' id='root'><style id='sheet'>.a { fill: red; }</style>";
+    svg += "<g id='g1' class='a'><rect id='r1'/><rect id='r2'/></g><rect id='r3' class='a'/>";
+    std::set<std::string> all = {"root", "sheet", "g1", "r1", "r2", "r3"};
+    for (int i = 0; i < 100; i++) {
+        svg += "<rect id='b" + std::to_string(i) + "' class='b'/>";
+        all.insert("b" + std::to_string(i));
+    }
+    svg += "</svg>";
+    std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(svg.c_str(), static_cast<int>(svg.size()), false));
+    ASSERT_TRUE(doc != nullptr);
+
+    auto style = cast<SPStyleElem>(doc->getObjectById("sheet"));
+    ASSERT_TRUE(style != nullptr);
+    auto set_sheet = [&](char const *text) {
+        return [=] { style->getRepr()->firstChild()->setContent(text); };
+    };
+
+    EXPECT_EQ(restyled_ids(*doc, set_sheet(".a { fill: blue; }")), std::set<std::string>({"g1", "r1", "r2", "r3"}));
+    EXPECT_EQ(doc->getLastUpdateStats().restyled, 4u);
+    EXPECT_EQ(doc->getObjectById("r3")->style->fill.get_value(), Glib::ustring("#0000ff"));
+
+    // The objects the old rules matched, and those the new ones match.
+    auto old_and_new = all;
+    old_and_new.erase("root");
+    old_and_new.erase("sheet");
+    EXPECT_EQ(restyled_ids(*doc, set_sheet(".b { fill: blue; }")), old_and_new);
+
+    // A rule that may match any element restyles everything.
+    EXPECT_EQ(restyled_ids(*doc, set_sheet("* { opacity: 0.5; }")), all);
+
+    // So does a font face, which may change the font of any text.
+    restyled_ids(*doc, set_sheet(".a { fill: blue; }"));
+    EXPECT_EQ(restyled_ids(*doc, set_sheet("@font-face { font-family: Face; src: url(face.woff); }")), all);
+}
@@ -220,6 +220,55 @@ TEST(SvgLengthTest, testPlaces)
     }
 }
 
+TEST(SvgLengthTest, testAppendPlaces)
+{
+    struct testd_t
+    {
+        char const *str;
+        double val;
+        int prec;
+        int minexp;
+    };
+
+    testd_t const precTests[] = {
+        // Negative exponents, where the exponent form is shorter
+        {"1.5e-5", 1.5e-5, 8, -8},
+        {"-1.5e-5", -1.5e-5, 8, -8},
+        {"1.2345679e-7", 1.23456789e-7, 8, -8},
+        {"-1.2e-4", -0.00012, 2, -8},
+        {"0.001", 0.001, 8, -8},
+        // The minimum exponent cutoff
+        {"1e-8", 1e-8, 8, -8},
+        {"1.1e-8", 1.1e-8, 8, -8},
+        {"0", 9.9e-9, 8, -8},
+        {"0", 1e-9, 8, -8},
+        {"5e-4", 5e-4, 3, -4},
+        {"0", 5e-4, 3, -3},
+        {"0", -2e-5, 8, -4},
+        {"0", 0.0, 8, -8},
+        // Rounding up to the next digit
+        {"1", 0.99999999999, 8, -8},
+        {"10", 9.9999999999, 8, -8},
+        {"100", 99.99999999, 8, -8},
+        {"200", 199.996, 4, -8},
+        {"0.01", 0.0099999999999, 8, -8},
+        {"-0.5", -0.499999999999, 8, -8},
+        {"123456790", 123456789, 8, -8},
+        // The exponent is taken before rounding, so the mantissa can reach 10
+        {"10e-6", 9.99996e-6, 4, -8},
+        // Large values
+        {"1.5e12", 1.5e12, 8, -8},
+    };
+
+    for (auto const &test : precTests) {
+        // Appends to what is there already, and gives the same as sp_svg_number_write_de
+        std::string buf = "M ";
+        sp_svg_number_append_de(buf, test.val, test.prec, test.minexp);
+        EXPECT_EQ(buf, std::string("M ") + test.str) << test.val << " at precision " << test.prec;
+        EXPECT_EQ(sp_svg_number_write_de(test.val, test.prec, test.minexp), test.str);
+    }
+}
+
 // TODO: More tests
 
 // vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -15,9 +15,12 @@
 #include "2geom/point.h"
 #include "svg/css-ostringstream.h"
 #include "svg/stringstream.h"
+#include "svg/strip-trailing-zeros.h"
 
 #include "gtest/gtest.h"
 #include <glibmm/ustring.h>
+#include <locale>
+#include <sstream>
 
 template <typename S, typename T>
 static void assert_tostring_eq(T value, const char *expected)
@@ -125,6 +128,48 @@ TEST(SVGOStringStreamTest, tostring)
     assert_tostring_eq<S, double>(-3.5e9, "-3.5e+09");
 }
 
+/// How SVGOStringStream formatted doubles before "%.Ng": a showpoint stream, then strip the zeros.
+static std::string stream_and_strip(double value, int precision, std::ios::fmtflags floatfield)
+{
+    std::ostringstream os;
+    os.imbue(std::locale::classic());
+    os.setf(std::ios::showpoint);
+    os.setf(floatfield, std::ios::floatfield);
+    os.precision(precision);
+    os << value;
+    return strip_trailing_zeros(os.str());
+}
+
+TEST(SVGOStringStreamTest, matchesStrippedStream)
+{
+    double const values[] = {0.1, 1.0 / 3, -2.0 / 3, -0.5, 1e-5, 2.5e-7, 1.5e-12, 0.00099999999, 0.000123456789,
+                             99999.5, 123456.789, 9.9999999e10, 1e21};
+
+    for (int precision = 1; precision <= 17; precision++) {
+        for (auto value : values) {
+            for (auto floatfield : {std::ios::fmtflags{}, std::ios::fixed, std::ios::scientific}) {
+                Inkscape::SVGOStringStream os;
+                os.precision(precision);
+                os.setf(floatfield, std::ios::floatfield);
+                os << value;
+                EXPECT_EQ(os.str(), stream_and_strip(value, precision, floatfield))
+                    << value << " at precision " << precision << ", floatfield " << floatfield;
+            }
+        }
+    }
+}
+
+TEST(SVGOStringStreamTest, fixed)
+{
+    // As the LaTeX exporters use it: never in exponent form.
+    using S = Inkscape::SVGOStringStream;
+    S os;
+    os.precision(8);
+    os.setf(std::ios::fixed);
+    os << 1.5e-12 << ' ' << 2.5e-7 << ' ' << 3e9 << ' ' << 12.25 << ' ' << -0.125;
+    ASSERT_EQ(os.str(), "0 0.00000025 3000000000 12.25 -0.125");
+}
+
 template <typename S>
 void test_concat()
 {
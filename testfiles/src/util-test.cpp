@@ -13,8 +13,11 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <random>
+
 #include "gtest/gtest.h"
 #include "util/longest-common-suffix.h"
+#include "util/packed-rtree.h"
 #include "util/parse-int-range.h"
 
 TEST(UtilTest, NearestCommonAncestor)
@@ -112,4 +115,57 @@ TEST(UtilTest, ParseIntRangeTest)
     ASSERT_EQ(Inkscape::parseIntRange("2-4,7-9", 1, 10), std::set<unsigned int>({2,3,4,7,8,9}));
 }
 
+TEST(UtilTest, PackedRTreeTest)
+{
+    using Inkscape::Util::PackedRTree;
+
+    // Empty tree
+    PackedRTree<unsigned> empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_TRUE(empty.collect(Geom::Rect(0, 0, 100, 100)).empty());
+    ASSERT_FALSE(empty.bounds());
+
+    // Compare queries against a linear scan, for sizes around the node fanout
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    std::uniform_real_distribution<double> extent(0.0, 50.0);
+
+    for (unsigned n : {1u, 15u, 16u, 17u, 300u, 5000u}) {
+        std::vector<PackedRTree<unsigned>::Entry> entries;
+        for (unsigned i = 0; i < n; i++) {
+            auto const x = coord(gen), y = coord(gen);
+            entries.emplace_back(Geom::Rect(x, y, x + extent(gen), y + extent(gen)), i);
+        }
+        auto const tree = PackedRTree<unsigned>(entries);
+        ASSERT_EQ(tree.size(), n);
+
+        Geom::OptRect bounds;
+        for (auto const &entry : entries) {
+            bounds.unionWith(entry.first);
+        }
+        ASSERT_EQ(tree.bounds(), bounds);
+
+        for (int q = 0; q < 100; q++) {
+            auto const x = coord(gen), y = coord(gen);
+            auto const area = Geom::Rect(x, y, x + extent(gen), y + extent(gen));
+
+            auto found = tree.collect(area);
+            std::sort(found.begin(), found.end());
+
+            std::vector<unsigned> expected;
+            for (auto const &[rect, value] : entries) {
+                if (rect.intersects(area)) {
+                    expected.push_back(value);
+                }
+            }
+            ASSERT_EQ(found, expected);
+        }
+    }
+
+    // Point queries include the boundary
+    auto const tree = PackedRTree<unsigned>({{Geom::Rect(0, 0, 10, 10), 7}});
+    ASSERT_EQ(tree.collect(Geom::Rect(Geom::Point(10, 10), Geom::Point(10, 10))), std::vector<unsigned>{7});
+    ASSERT_TRUE(tree.collect(Geom::Rect(Geom::Point(11, 0), Geom::Point(11, 0))).empty());
+}
+
 // vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
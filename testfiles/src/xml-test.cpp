@@ -13,6 +13,7 @@
  */
 
 #include "gtest/gtest.h"
+#include "gc-anchored.h"
 #include "xml/repr.h"
 
 TEST(XmlTest, nodeiter)
@@ -72,6 +73,91 @@ TEST(XmlTest, nodeiter)
     ASSERT_EQ(testdoc->root()->findChildPath(path), nullptr);
 }
 
+TEST(XmlTest, readbuf)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(R"""(<?xml version="1.0"?>
+<!-- before -->
+<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink">
+  <text xml:space="preserve"> <tspan>  </tspan></text>
+  <style><![CDATA[ rect > g {} ]]></style>
+  <use xlink:href="#a"/>
+  <g>  </g>
+</svg>
+<?pi data?>)""", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+
+    auto first = testdoc->firstChild();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->type(), Inkscape::XML::NodeType::COMMENT_NODE);
+    EXPECT_STREQ(first->content(), " before ");
+    ASSERT_TRUE(first->next());
+    EXPECT_EQ(first->next(), testdoc->root());
+    ASSERT_TRUE(testdoc->lastChild());
+    EXPECT_EQ(testdoc->lastChild()->type(), Inkscape::XML::NodeType::PI_NODE);
+
+    auto root = testdoc->root();
+    ASSERT_EQ(root->childCount(), 4u);
+
+    // Whitespace is only kept with xml:space="preserve".
+    auto text = root->firstChild();
+    EXPECT_STREQ(text->name(), "svg:text");
+    ASSERT_EQ(text->childCount(), 2u);
+    EXPECT_STREQ(text->firstChild()->content(), " ");
+    EXPECT_STREQ(text->lastChild()->firstChild()->content(), "  ");
+
+    auto style = text->next();
+    ASSERT_EQ(style->childCount(), 1u);
+    EXPECT_STREQ(style->firstChild()->content(), " rect > g {} ");
+
+    EXPECT_STREQ(style->next()->attribute("xlink:href"), "#a");
+    EXPECT_EQ(root->lastChild()->childCount(), 0u);
+
+    // Documents which are not well-formed are recovered where possible.
+    testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf("<svg><g><rect></g></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    EXPECT_STREQ(testdoc->root()->firstChild()->firstChild()->name(), "svg:rect");
+}
+
+TEST(XmlTest, documentcopy)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(R"""(<?xml version="1.0"?>
+<!-- before -->
+<svg xmlns="http://www.w3.org/2000/svg" id="svg">
+  <g id="a" style="fill:red"><rect id="b"/></g>
+  <text xml:space="preserve">text</text>
+</svg>
+<?pi data?>)""", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+
+    auto copy = std::shared_ptr<Inkscape::XML::Document>(sp_repr_document_copy(testdoc.get()));
+    ASSERT_TRUE(copy);
+    EXPECT_EQ(sp_repr_save_buf(copy.get()), sp_repr_save_buf(testdoc.get()));
+    EXPECT_EQ(copy->firstChild()->type(), Inkscape::XML::NodeType::COMMENT_NODE);
+    EXPECT_EQ(copy->lastChild()->type(), Inkscape::XML::NodeType::PI_NODE);
+
+    // The copy is made of new nodes belonging to the copy.
+    auto root = copy->root();
+    ASSERT_TRUE(root);
+    EXPECT_NE(root, testdoc->root());
+    EXPECT_EQ(root->document(), copy.get());
+    EXPECT_EQ(root->firstChild()->firstChild()->document(), copy.get());
+
+    // Changing either document leaves the other as it was.
+    auto const saved = sp_repr_save_buf(copy.get());
+    testdoc->root()->firstChild()->setAttribute("style", "fill:blue");
+    testdoc->root()->lastChild()->firstChild()->setContent("changed");
+    auto circle = testdoc->createElement("svg:circle");
+    testdoc->root()->appendChild(circle);
+    Inkscape::GC::release(circle);
+    EXPECT_EQ(sp_repr_save_buf(copy.get()), saved);
+    EXPECT_STREQ(root->firstChild()->attribute("style"), "fill:red");
+    EXPECT_STREQ(root->lastChild()->firstChild()->content(), "text");
+
+    root->firstChild()->removeChild(root->firstChild()->firstChild());
+    ASSERT_TRUE(testdoc->root()->firstChild()->firstChild());
+    EXPECT_STREQ(testdoc->root()->firstChild()->firstChild()->attribute("id"), "b");
+}
+
 /*
   Local Variables:
   mode:c++